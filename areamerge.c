@@ -0,0 +1,426 @@
+/*
+ * Cost model driven dirty area merging
+ *
+ * LVGL joins two invalidated areas when their bounding box is smaller than
+ * their sum, which minimises rendered pixels. On an SPI panel every area
+ * also costs a CASET/PASET/RAMWR sequence per flushed strip, so two small
+ * areas a few rows apart are cheaper sent as one, while an L-shaped pair is
+ * cheaper kept apart. Here the areas are recorded as requested
+ * (LV_EVENT_INVALIDATE_AREA) and handed to a strategy at
+ * LV_EVENT_RENDER_START, whose result replaces what LVGL joined.
+ *
+ * LVGL has already picked the index of the last area to render (it flags
+ * the last flush) when RENDER_START is sent, so the new areas are written to
+ * end at that index and may not outnumber it; otherwise LVGL's areas stay.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl/src/display/lv_display_private.h"
+#include "lvgl/src/misc/lv_area_private.h"
+
+#include "areamerge.h"
+#include "bench.h"
+
+static struct {
+	lv_display_t *disp;
+	areamerge_cb_t cb;
+	void *ctx;
+	const struct areamerge_cost *model;
+	lv_area_t raw[LV_INV_BUF_SIZE];
+	int nraw;
+	bool overflow;
+	struct areamerge_stats stats;
+} am;
+
+static uint64_t area_ns(const struct areamerge_cost *c, const lv_area_t *a)
+{
+	uint32_t w = lv_area_get_width(a);
+	uint32_t h = lv_area_get_height(a);
+	uint32_t rows;
+	uint32_t xfers = 1;
+
+	// The partial buffer is flushed in strips of as many rows as fit
+	if (c->buf_bytes) {
+		rows = LV_MAX(1, c->buf_bytes / (w * c->px_size));
+		xfers = (h + rows - 1) / rows;
+	}
+
+	return (uint64_t)xfers * c->tx_ns + (uint64_t)w * h * c->px_ns;
+}
+
+uint64_t areamerge_cost_ns(const struct areamerge_cost *c,
+			   const lv_area_t *areas, int n)
+{
+	uint64_t ns = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+		ns += area_ns(c, &areas[i]);
+	}
+
+	return ns;
+}
+
+void areamerge_cost_init(struct areamerge_cost *c, lv_display_t *disp,
+			 uint32_t tx_ns, uint32_t px_ns)
+{
+	c->tx_ns = tx_ns;
+	c->px_ns = px_ns;
+	c->px_size = lv_color_format_get_size(lv_display_get_color_format(disp));
+	c->buf_bytes = 0;
+	if (disp->render_mode == LV_DISPLAY_RENDER_MODE_PARTIAL && disp->buf_1) {
+		c->buf_bytes = disp->buf_1->data_size;
+	}
+}
+
+static int drop_contained(lv_area_t *a, int n)
+{
+	int i;
+	int j;
+
+	for (i = 0; i < n; i++) {
+		for (j = 0; j < n; j++) {
+			if (j != i && lv_area_is_in(&a[i], &a[j], 0)) {
+				a[i--] = a[--n];
+				break;
+			}
+		}
+	}
+
+	return n;
+}
+
+/*
+ * Merge the pair whose bounding box saves the most, counting areas the box
+ * swallows, until nothing saves anything and the count fits.
+ */
+int areamerge_cost_cb(void *ctx, lv_area_t *a, int n, int max)
+{
+	const struct areamerge_cost *c = ctx;
+	lv_area_t best_u = { 0 };
+	lv_area_t u;
+	int64_t best;
+	int64_t gain;
+	int bi = 0;
+	int bj = 0;
+	int i;
+	int j;
+	int k;
+
+	n = drop_contained(a, n);
+	while (n > 1) {
+		best = INT64_MIN;
+		for (i = 0; i < n; i++) {
+			for (j = i + 1; j < n; j++) {
+				lv_area_join(&u, &a[i], &a[j]);
+				gain = area_ns(c, &a[i]) + area_ns(c, &a[j]) -
+				       area_ns(c, &u);
+				for (k = 0; k < n; k++) {
+					if (k != i && k != j &&
+					    lv_area_is_in(&a[k], &u, 0)) {
+						gain += area_ns(c, &a[k]);
+					}
+				}
+				if (gain > best) {
+					best = gain;
+					best_u = u;
+					bi = i;
+					bj = j;
+				}
+			}
+		}
+		if (best <= 0 && n <= max) {
+			break;
+		}
+		a[bi] = best_u;
+		a[bj] = a[--n];
+		n = drop_contained(a, n);
+	}
+
+	return n;
+}
+
+static void render_start(void)
+{
+	lv_display_t *disp = am.disp;
+	lv_area_t stock[LV_INV_BUF_SIZE];
+	lv_area_t work[LV_INV_BUF_SIZE];
+	int nstock = 0;
+	int last = -1;
+	int n = -1;
+	int i;
+
+	for (i = 0; i < (int)disp->inv_p; i++) {
+		if (!disp->inv_area_joined[i]) {
+			stock[nstock++] = disp->inv_areas[i];
+			last = i;
+		}
+	}
+	if (last < 0) {
+		return;
+	}
+
+	if (!am.overflow && am.nraw) {
+		memcpy(work, am.raw, am.nraw * sizeof(work[0]));
+		n = am.cb(am.ctx, work, am.nraw, last + 1);
+	}
+
+	am.stats.frames++;
+	am.stats.stock_areas += nstock;
+	if (am.model) {
+		am.stats.stock_ns += areamerge_cost_ns(am.model, stock, nstock);
+	}
+	if (n <= 0 || n > last + 1) {
+		am.stats.areas += nstock;
+		if (am.model) {
+			am.stats.ns += areamerge_cost_ns(am.model, stock, nstock);
+		}
+		return;
+	}
+
+	for (i = 0; i <= last; i++) {
+		disp->inv_area_joined[i] = i <= last - n;
+		if (i > last - n) {
+			disp->inv_areas[i] = work[i - (last - n + 1)];
+		}
+	}
+	am.stats.merged++;
+	am.stats.areas += n;
+	if (am.model) {
+		am.stats.ns += areamerge_cost_ns(am.model, work, n);
+	}
+}
+
+static void areamerge_event_cb(lv_event_t *e)
+{
+	switch (lv_event_get_code(e)) {
+	case LV_EVENT_INVALIDATE_AREA:
+		if (am.nraw < LV_INV_BUF_SIZE) {
+			am.raw[am.nraw++] = *(lv_area_t *)lv_event_get_param(e);
+		} else {
+			am.overflow = true;
+		}
+		break;
+	case LV_EVENT_RENDER_START:
+		render_start();
+		break;
+	case LV_EVENT_REFR_READY:
+		am.nraw = 0;
+		am.overflow = false;
+		break;
+	default:
+		break;
+	}
+}
+
+/* Register after vscroll_init(), so its shrunk areas are recorded */
+void areamerge_init(lv_display_t *disp, areamerge_cb_t cb, void *ctx,
+		    const struct areamerge_cost *model)
+{
+	memset(&am, 0, sizeof(am));
+	am.disp = disp;
+	am.cb = cb;
+	am.ctx = ctx;
+	am.model = model;
+	lv_display_add_event_cb(disp, areamerge_event_cb, LV_EVENT_ALL, NULL);
+}
+
+void areamerge_deinit(void)
+{
+	if (am.disp) {
+		lv_display_remove_event_cb_with_user_data(am.disp,
+							  areamerge_event_cb,
+							  NULL);
+	}
+	memset(&am, 0, sizeof(am));
+}
+
+void areamerge_get_stats(struct areamerge_stats *stats)
+{
+	*stats = am.stats;
+}
+
+/*
+ * Benchmark: interactions on the main.c screen plus four corner readouts,
+ * each run once with LVGL's joining and once with the cost model, on
+ * fresh displays. Reported is the modelled bus time per frame; the final
+ * frames of both runs must be identical.
+ */
+#define AREAMERGE_BENCH_FRAMES 60
+
+enum scenario {
+	SCENARIO_CLOCK,
+	SCENARIO_BUTTON,
+	SCENARIO_SLIDER,
+	SCENARIO_DASHBOARD,
+	SCENARIO_COUNT,
+};
+
+struct scene {
+	lv_obj_t *button;
+	lv_obj_t *button_label;
+	lv_obj_t *slider;
+	lv_obj_t *slider_label;
+	lv_obj_t *status;
+	lv_obj_t *corner[4];
+};
+
+static int keep_stock(void *ctx, lv_area_t *areas, int n, int max)
+{
+	return -1;
+}
+
+static void scene_create(struct scene *s, lv_obj_t *scr)
+{
+	static const lv_align_t corners[4] = {
+		LV_ALIGN_TOP_LEFT, LV_ALIGN_TOP_RIGHT,
+		LV_ALIGN_BOTTOM_LEFT, LV_ALIGN_BOTTOM_RIGHT,
+	};
+	lv_obj_t *obj;
+	int i;
+
+	obj = lv_label_create(scr);
+	lv_label_set_text(obj, "Light and Versatile Graphics Library");
+	lv_obj_align(obj, LV_ALIGN_CENTER, 0, 75);
+	s->button = lv_button_create(scr);
+	lv_obj_set_size(s->button, 100, 50);
+	lv_obj_align(s->button, LV_ALIGN_TOP_MID, 0, 0);
+	s->button_label = lv_label_create(s->button);
+	lv_label_set_text(s->button_label, "Button");
+	lv_obj_center(s->button_label);
+	s->slider = lv_slider_create(scr);
+	lv_obj_set_size(s->slider, 200, 50);
+	lv_obj_center(s->slider);
+	s->slider_label = lv_label_create(scr);
+	lv_label_set_text(s->slider_label, "0");
+	lv_obj_align_to(s->slider_label, s->slider, LV_ALIGN_OUT_BOTTOM_MID,
+			0, 0);
+	s->status = lv_label_create(scr);
+	lv_label_set_text(s->status, "");
+	lv_obj_align(s->status, LV_ALIGN_CENTER, 0, 100);
+	for (i = 0; i < 4; i++) {
+		s->corner[i] = lv_label_create(scr);
+		lv_label_set_text(s->corner[i], "0.0");
+		lv_obj_align(s->corner[i], corners[i], 0, 0);
+	}
+}
+
+static void scene_step(struct scene *s, enum scenario sc, uint32_t i)
+{
+	int c;
+
+	switch (sc) {
+	case SCENARIO_CLOCK:
+		lv_label_set_text_fmt(s->status, "12:%02u:%02u", i / 60, i % 60);
+		break;
+	case SCENARIO_BUTTON:
+		if (i & 1) {
+			lv_obj_remove_state(s->button, LV_STATE_PRESSED);
+			lv_label_set_text_fmt(s->button_label, "Button (%u)",
+					      i / 2 % 256);
+		} else {
+			lv_obj_add_state(s->button, LV_STATE_PRESSED);
+		}
+		lv_label_set_text_fmt(s->status, "12:%02u:%02u", i / 60, i % 60);
+		break;
+	case SCENARIO_SLIDER:
+		lv_slider_set_value(s->slider, i % 101, LV_ANIM_OFF);
+		lv_label_set_text_fmt(s->slider_label, "%u", i % 101);
+		lv_obj_align_to(s->slider_label, s->slider,
+				LV_ALIGN_OUT_BOTTOM_MID, 0, 0);
+		break;
+	case SCENARIO_DASHBOARD:
+		for (c = 0; c < 4; c++) {
+			lv_label_set_text_fmt(s->corner[c], "%u.%u",
+					      (i * (c + 3)) % 100, i % 10);
+		}
+		lv_label_set_text_fmt(s->status, "12:%02u:%02u", i / 60, i % 60);
+		break;
+	default:
+		break;
+	}
+}
+
+static int bench_run_one(enum scenario sc, bool merge,
+			 struct areamerge_stats *st, uint64_t *hash)
+{
+	struct areamerge_cost cost;
+	struct scene s;
+	lv_display_t *disp;
+	uint32_t stride;
+	uint8_t *fb;
+	uint32_t i;
+	size_t k;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	scene_create(&s, lv_display_get_screen_active(disp));
+	lv_refr_now(disp);
+
+	areamerge_cost_init(&cost, disp, AREAMERGE_SPI32_TX_NS,
+			    AREAMERGE_SPI32_PX_NS);
+	areamerge_init(disp, merge ? areamerge_cost_cb : keep_stock, &cost,
+		       &cost);
+	for (i = 0; i < AREAMERGE_BENCH_FRAMES; i++) {
+		scene_step(&s, sc, i);
+		lv_refr_now(disp);
+	}
+	areamerge_get_stats(st);
+	areamerge_deinit();
+
+	fb = bench_display_framebuffer(disp, &stride);
+	*hash = 0xcbf29ce484222325ULL;
+	for (k = 0; k < (size_t)stride * BENCH_VER_RES; k++) {
+		*hash = (*hash ^ fb[k]) * 0x100000001b3ULL;
+	}
+	bench_display_delete(disp);
+
+	return 0;
+}
+
+int areamerge_bench(void)
+{
+	static const char *const names[SCENARIO_COUNT] = {
+		"clock tick", "button click", "slider drag", "dashboard",
+	};
+	struct areamerge_stats stock;
+	struct areamerge_stats merged;
+	uint64_t h1;
+	uint64_t h2;
+	double f1;
+	double f2;
+	int sc;
+	int err = 0;
+
+	printf("model: %u ns per transfer, %u ns per pixel\n",
+	       AREAMERGE_SPI32_TX_NS, AREAMERGE_SPI32_PX_NS);
+	printf("%-24s %13s %13s %8s\n", "scenario", "stock", "cost model",
+	       "bus time");
+	for (sc = 0; sc < SCENARIO_COUNT; sc++) {
+		if (bench_run_one(sc, false, &stock, &h1) ||
+		    bench_run_one(sc, true, &merged, &h2)) {
+			return -1;
+		}
+		f1 = stock.frames ? stock.frames : 1;
+		f2 = merged.frames ? merged.frames : 1;
+		printf("%-24s %4.1f %6.0f us %4.1f %6.0f us %+7.1f%%%s\n",
+		       names[sc], stock.areas / f1, stock.ns / f1 / 1000,
+		       merged.areas / f2, merged.ns / f2 / 1000,
+		       stock.ns ? 100.0 * ((double)merged.ns / f2 /
+					   (stock.ns / f1) - 1) : 0.0,
+		       h1 == h2 ? "" : "  FRAME DIFFERS");
+		err |= h1 != h2;
+	}
+	printf("(areas per frame and modelled bus time per frame)\n");
+
+	return err ? -1 : 0;
+}
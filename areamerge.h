@@ -0,0 +1,61 @@
+/*
+ * Cost model driven dirty area merging
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef AREAMERGE_H
+#define AREAMERGE_H
+
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+/* ILI9341 over 32 MHz SPI, RGB565 */
+#define AREAMERGE_SPI32_TX_NS	50000	// CASET/PASET/RAMWR, DC and CS
+#define AREAMERGE_SPI32_PX_NS	500	// 16 bits at 32 MHz
+
+/*
+ * A strategy rewrites the n invalidated areas of a frame in place, as they
+ * were requested, into at most max areas that cover them all. Returns the
+ * new count, or < 0 to keep what LVGL joined.
+ */
+typedef int (*areamerge_cb_t)(void *ctx, lv_area_t *areas, int n, int max);
+
+/* Bus cost of one area: tx_ns per transfer plus px_ns per pixel */
+struct areamerge_cost {
+	uint32_t tx_ns;
+	uint32_t px_ns;
+	uint32_t px_size;
+	uint32_t buf_bytes;	// partial render buffer, 0: one transfer per area
+};
+
+struct areamerge_stats {
+	uint32_t frames;
+	uint32_t merged;	// frames where the strategy's areas were used
+	uint64_t stock_areas;
+	uint64_t areas;
+	uint64_t stock_ns;	// modelled bus time of LVGL's joined areas
+	uint64_t ns;		// ... of the areas that were rendered
+};
+
+/* Fills in px_size and buf_bytes from the display */
+void areamerge_cost_init(struct areamerge_cost *c, lv_display_t *disp,
+			 uint32_t tx_ns, uint32_t px_ns);
+uint64_t areamerge_cost_ns(const struct areamerge_cost *c,
+			   const lv_area_t *areas, int n);
+/* Greedy strategy: ctx is a struct areamerge_cost */
+int areamerge_cost_cb(void *ctx, lv_area_t *areas, int n, int max);
+
+/* model prices both the stock and the merged areas in the stats, or NULL */
+void areamerge_init(lv_display_t *disp, areamerge_cb_t cb, void *ctx,
+		    const struct areamerge_cost *model);
+void areamerge_deinit(void);
+void areamerge_get_stats(struct areamerge_stats *stats);
+
+int areamerge_bench(void);
+
+#endif /* AREAMERGE_H */
@@ -0,0 +1,668 @@
+/*
+ * Image decoding on a worker pool with placeholders
+ *
+ * LVGL decodes an image when it is first drawn, inside the refresh that
+ * lv_timer_handler() runs, so the first frame of a screen with several
+ * images stalls for all of their decode times. Here the application hands
+ * an lv_image a decode callback instead of a source. The image is sized
+ * and drawn as a grey placeholder right away, and the decode runs in bands
+ * of ASYNCIMG_BAND rows on a worker thread into an ARGB8888 draw buffer.
+ * With lowres, the workers first decode a 1/lowres preview, shown stretched
+ * to the image. asyncimg_drain() runs from the main loop like mailbox_drain(). It
+ * hands finished buffers to their images with lv_image_set_src(), which
+ * invalidates the image's area only, because the object size is already
+ * final.
+ *
+ * At most queue decodes are queued or running; the others wait without
+ * buffers. Admission and the workers both take visible images
+ * (lv_obj_is_visible()) first and then submission order. Visibility is
+ * re-evaluated at every drain with something to do, i.e. on each
+ * submission, completion or cancellation. Deleting an image, also as part
+ * of its screen, drops a waiting or queued decode and stops a running one
+ * at the next band. Buffers are only allocated, shown and freed on the UI
+ * thread; workers never call LVGL. They come from aligned_alloc(), not the
+ * LVGL heap, which at its default 64 KB holds a single 150x100 image. A
+ * decode that cannot get its buffers while another one is in flight waits
+ * for that one to complete; with none in flight it fails with -ENOMEM.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "asyncimg.h"
+#include "bench.h"
+#include "rt.h"
+
+#define ASYNCIMG_ALIGN	64
+
+enum job_state {
+	JOB_FREE,
+	JOB_WAITING,	// not admitted yet, no buffers
+	JOB_QUEUED,
+	JOB_RUNNING,
+	JOB_DONE,	// decoded or failed, not shown yet
+	JOB_SHOWN,
+};
+
+struct job {
+	enum job_state state;
+	lv_obj_t *img;		// NULL once deleted
+	asyncimg_decode_cb_t cb;
+	void *src;
+	int32_t w;
+	int32_t h;
+	uint32_t seq;
+	bool visible;
+	bool preview_shown;
+	atomic_bool cancel;
+	atomic_bool preview_ready;
+	int result;
+	uint64_t submit_us;
+	lv_draw_buf_t *buf;
+	lv_draw_buf_t *preview;
+	lv_draw_buf_t buf_dsc;
+	lv_draw_buf_t preview_dsc;
+};
+
+static struct {
+	struct asyncimg_cfg cfg;
+	bool active;
+	bool stop;
+	pthread_t threads[ASYNCIMG_THREADS_MAX];
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct job jobs[ASYNCIMG_JOBS];
+	uint32_t seq;
+	atomic_bool pending;
+	struct asyncimg_stats stats;
+} ai = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+static int decode(struct job *job, lv_draw_buf_t *buf, uint32_t scale)
+{
+	int32_t y, h = buf->header.h;
+	int ret;
+
+	for (y = 0; y < h; y += ASYNCIMG_BAND) {
+		if (atomic_load_explicit(&job->cancel, memory_order_relaxed)) {
+			return -ECANCELED;
+		}
+		ret = job->cb(job->src, buf, scale, y, LV_MIN(y + ASYNCIMG_BAND,
+							       h));
+		if (ret) {
+			return ret;
+		}
+	}
+
+	return 0;
+}
+
+/* Visible first, then oldest; ai.lock held */
+static struct job *next_job(enum job_state state)
+{
+	struct job *best = NULL, *job;
+
+	for (job = ai.jobs; job < ai.jobs + ASYNCIMG_JOBS; job++) {
+		if (job->state != state) {
+			continue;
+		}
+		if (!best || job->visible > best->visible ||
+		    (job->visible == best->visible &&
+		     (int32_t)(job->seq - best->seq) < 0)) {
+			best = job;
+		}
+	}
+
+	return best;
+}
+
+static void *worker_thread(void *arg)
+{
+	struct job *job;
+	uint64_t t0;
+	int ret;
+
+	rt_background();
+	pthread_mutex_lock(&ai.lock);
+	for (;;) {
+		while (!ai.stop && !(job = next_job(JOB_QUEUED))) {
+			pthread_cond_wait(&ai.cond, &ai.lock);
+		}
+		if (ai.stop) {
+			break;
+		}
+		job->state = JOB_RUNNING;
+		pthread_mutex_unlock(&ai.lock);
+
+		t0 = bench_now_us();
+		ret = 0;
+		if (job->preview) {
+			ret = decode(job, job->preview, ai.cfg.lowres);
+			if (!ret) {
+				atomic_store(&job->preview_ready, true);
+				atomic_store(&ai.pending, true);
+			}
+		}
+		if (!ret) {
+			ret = decode(job, job->buf, 1);
+		}
+
+		pthread_mutex_lock(&ai.lock);
+		job->result = ret;
+		job->state = JOB_DONE;
+		ai.stats.decode_us += bench_now_us() - t0;
+		atomic_store(&ai.pending, true);
+	}
+	pthread_mutex_unlock(&ai.lock);
+
+	return NULL;
+}
+
+static lv_draw_buf_t *create_buf(lv_draw_buf_t *buf, int32_t w, int32_t h)
+{
+	uint32_t stride = lv_draw_buf_width_to_stride(w,
+					LV_COLOR_FORMAT_ARGB8888);
+	uint32_t size = LV_ALIGN_UP(stride * h, ASYNCIMG_ALIGN);
+	void *data = aligned_alloc(ASYNCIMG_ALIGN, size);
+
+	if (!data) {
+		return NULL;
+	}
+	lv_draw_buf_init(buf, w, h, LV_COLOR_FORMAT_ARGB8888, stride, data,
+			 size);
+
+	return buf;
+}
+
+static void destroy_buf(lv_draw_buf_t **buf)
+{
+	if (*buf) {
+		lv_image_cache_drop(*buf);
+		free((*buf)->unaligned_data);
+		*buf = NULL;
+	}
+}
+
+/* UI thread, job not running */
+static void release(struct job *job)
+{
+	destroy_buf(&job->buf);
+	destroy_buf(&job->preview);
+	job->img = NULL;
+	job->state = JOB_FREE;
+}
+
+static int alloc_bufs(struct job *job)
+{
+	uint32_t l = ai.cfg.threads ? ai.cfg.lowres : 0;
+
+	job->buf = create_buf(&job->buf_dsc, job->w, job->h);
+	if (job->buf && l > 1) {
+		job->preview = create_buf(&job->preview_dsc,
+					  (job->w + l - 1) / l,
+					  (job->h + l - 1) / l);
+	}
+	if (!job->buf || (l > 1 && !job->preview)) {
+		destroy_buf(&job->buf);
+		destroy_buf(&job->preview);
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void show_preview(struct job *job)
+{
+	// Scaling would pivot about the centre and round the size up
+	lv_image_set_src(job->img, job->preview);
+	lv_image_set_inner_align(job->img, LV_IMAGE_ALIGN_STRETCH);
+	job->preview_shown = true;
+	ai.stats.previews++;
+}
+
+static void finish(struct job *job)
+{
+	uint32_t ms = (bench_now_us() - job->submit_us) / 1000;
+
+	if (job->result) {
+		lv_image_set_src(job->img, NULL);
+		destroy_buf(&job->buf);
+	} else {
+		lv_image_set_src(job->img, job->buf);
+		lv_obj_set_style_bg_opa(job->img, LV_OPA_TRANSP, 0);
+		ai.stats.decoded++;
+	}
+	lv_image_set_inner_align(job->img, LV_IMAGE_ALIGN_DEFAULT);
+	lv_image_set_scale(job->img, LV_SCALE_NONE);
+	destroy_buf(&job->preview);
+	ai.stats.wait_max_ms = LV_MAX(ai.stats.wait_max_ms, ms);
+	job->state = JOB_SHOWN;
+}
+
+/* UI thread: drop or stop the image's decode; ai.lock held */
+static void cancel(struct job *job)
+{
+	job->img = NULL;
+	switch (job->state) {
+	case JOB_RUNNING:
+		// The worker ends at the next band, the drain frees the buffers
+		atomic_store(&job->cancel, true);
+		ai.stats.cancelled++;
+		break;
+	case JOB_WAITING:
+	case JOB_QUEUED:
+	case JOB_DONE:
+		ai.stats.cancelled++;
+		release(job);
+		break;
+	default:
+		release(job);
+		break;
+	}
+	atomic_store(&ai.pending, true);
+}
+
+static void delete_cb(lv_event_t *e)
+{
+	struct job *job = lv_event_get_user_data(e);
+
+	pthread_mutex_lock(&ai.lock);
+	cancel(job);
+	pthread_mutex_unlock(&ai.lock);
+}
+
+int asyncimg_init(const struct asyncimg_cfg *cfg)
+{
+	uint32_t i;
+
+	if (ai.active) {
+		return -EBUSY;
+	}
+	if (cfg->threads > ASYNCIMG_THREADS_MAX || !cfg->queue) {
+		return -EINVAL;
+	}
+	memset(ai.jobs, 0, sizeof(ai.jobs));
+	memset(&ai.stats, 0, sizeof(ai.stats));
+	ai.cfg = *cfg;
+	ai.stop = false;
+	atomic_store(&ai.pending, false);
+	for (i = 0; i < cfg->threads; i++) {
+		if (pthread_create(&ai.threads[i], NULL, worker_thread, NULL)) {
+			ai.cfg.threads = i;
+			asyncimg_deinit();
+			return -EAGAIN;
+		}
+	}
+	ai.active = true;
+
+	return 0;
+}
+
+void asyncimg_deinit(void)
+{
+	struct job *job;
+	uint32_t i;
+
+	pthread_mutex_lock(&ai.lock);
+	ai.stop = true;
+	for (job = ai.jobs; job < ai.jobs + ASYNCIMG_JOBS; job++) {
+		atomic_store(&job->cancel, true);
+	}
+	pthread_cond_broadcast(&ai.cond);
+	pthread_mutex_unlock(&ai.lock);
+	for (i = 0; i < ai.cfg.threads; i++) {
+		pthread_join(ai.threads[i], NULL);
+	}
+	for (job = ai.jobs; job < ai.jobs + ASYNCIMG_JOBS; job++) {
+		if (job->img) {
+			lv_obj_remove_event_cb_with_user_data(job->img,
+							      delete_cb, job);
+			lv_image_set_src(job->img, NULL);
+		}
+		if (job->state != JOB_FREE) {
+			release(job);
+		}
+	}
+	ai.active = false;
+}
+
+int asyncimg_set_src(lv_obj_t *img, asyncimg_decode_cb_t cb, void *src,
+		     int32_t w, int32_t h)
+{
+	struct job *job, *free_job = NULL;
+	uint64_t t0;
+
+	pthread_mutex_lock(&ai.lock);
+	for (job = ai.jobs; job < ai.jobs + ASYNCIMG_JOBS; job++) {
+		if (job->state != JOB_FREE && job->img == img) {
+			lv_obj_remove_event_cb_with_user_data(img, delete_cb,
+							      job);
+			cancel(job);
+		}
+		if (!free_job && job->state == JOB_FREE) {
+			free_job = job;
+		}
+	}
+	if (!ai.active || !free_job) {
+		pthread_mutex_unlock(&ai.lock);
+		return ai.active ? -ENOSPC : -EINVAL;
+	}
+	job = free_job;
+	job->img = img;
+	job->cb = cb;
+	job->src = src;
+	job->w = w;
+	job->h = h;
+	job->seq = ai.seq++;
+	job->visible = false;
+	job->preview_shown = false;
+	job->result = 0;
+	job->submit_us = bench_now_us();
+	atomic_store(&job->cancel, false);
+	atomic_store(&job->preview_ready, false);
+	job->state = JOB_WAITING;
+	ai.stats.submitted++;
+	pthread_mutex_unlock(&ai.lock);
+
+	lv_image_set_src(img, NULL);
+	lv_image_set_inner_align(img, LV_IMAGE_ALIGN_DEFAULT);
+	lv_image_set_scale(img, LV_SCALE_NONE);
+	lv_obj_set_size(img, w, h);
+	lv_obj_set_style_bg_color(img, lv_palette_main(LV_PALETTE_GREY), 0);
+	lv_obj_set_style_bg_opa(img, LV_OPA_COVER, 0);
+	lv_obj_add_event_cb(img, delete_cb, LV_EVENT_DELETE, job);
+
+	if (ai.cfg.threads) {
+		atomic_store(&ai.pending, true);
+		return 0;
+	}
+
+	// No workers: decode right here, as LVGL would in the next refresh
+	job->result = alloc_bufs(job);
+	if (!job->result) {
+		t0 = bench_now_us();
+		job->result = decode(job, job->buf, 1);
+		ai.stats.decode_us += bench_now_us() - t0;
+	}
+	finish(job);
+
+	return 0;
+}
+
+void asyncimg_drain(void)
+{
+	bool admitted = false;
+	uint32_t active = 0;
+	struct job *job;
+
+	if (!ai.active || !atomic_exchange(&ai.pending, false)) {
+		return;
+	}
+
+	lv_lock();
+	pthread_mutex_lock(&ai.lock);
+	for (job = ai.jobs; job < ai.jobs + ASYNCIMG_JOBS; job++) {
+		switch (job->state) {
+		case JOB_WAITING:
+		case JOB_QUEUED:
+			lv_obj_update_layout(job->img);
+			job->visible = lv_obj_is_visible(job->img);
+			active += job->state == JOB_QUEUED;
+			break;
+		case JOB_RUNNING:
+			active++;
+			if (job->img && !job->preview_shown &&
+			    atomic_load(&job->preview_ready)) {
+				show_preview(job);
+			}
+			break;
+		case JOB_DONE:
+			if (atomic_load(&job->cancel)) {
+				release(job);
+			} else {
+				finish(job);
+			}
+			break;
+		default:
+			break;
+		}
+	}
+	while (active < ai.cfg.queue && (job = next_job(JOB_WAITING))) {
+		if (alloc_bufs(job)) {
+			if (active) {
+				break;	// retried at the next completion
+			}
+			job->result = -ENOMEM;
+			finish(job);
+			continue;
+		}
+		job->state = JOB_QUEUED;
+		active++;
+		admitted = true;
+	}
+	if (admitted) {
+		pthread_cond_broadcast(&ai.cond);
+	}
+	pthread_mutex_unlock(&ai.lock);
+	lv_unlock();
+}
+
+void asyncimg_get_stats(struct asyncimg_stats *stats)
+{
+	pthread_mutex_lock(&ai.lock);
+	*stats = ai.stats;
+	pthread_mutex_unlock(&ai.lock);
+}
+
+/*
+ * Benchmark: a switch from a home screen to one with ten 150x100 images in
+ * two columns, of which the first three rows are on screen, driven at 60 Hz
+ * the way the main loop would (drain, refresh, sleep). The stand-in decoder
+ * costs a few milliseconds per image. Reported are the longest main loop
+ * iteration from the start of the switch, and the time until the visible
+ * and all images are decoded: in place (LVGL's behaviour), on one or two
+ * workers, and with a 1/4 preview. Then the screen is loaded again and
+ * deleted right away, which must cancel its decodes and leave no job or
+ * buffer behind.
+ */
+#define ASYNCIMG_BENCH_IMAGES	10
+#define ASYNCIMG_BENCH_VISIBLE	6
+#define ASYNCIMG_BENCH_W	150
+#define ASYNCIMG_BENCH_H	100
+#define ASYNCIMG_BENCH_ROUNDS	48	// xorshift rounds per pixel
+#define ASYNCIMG_BENCH_PERIOD	16	// [ms]
+#define ASYNCIMG_BENCH_TIMEOUT	5000	// [ms]
+
+static int bench_decode(void *src, lv_draw_buf_t *buf, uint32_t scale,
+			int32_t y0, int32_t y1)
+{
+	uint32_t seed = (uintptr_t)src * 0x9e3779b1;
+	uint32_t x, v, r, *row;
+	int32_t y;
+
+	for (y = y0; y < y1; y++) {
+		row = (uint32_t *)(buf->data + y * buf->header.stride);
+		for (x = 0; x < buf->header.w; x++) {
+			v = seed ^ (x * scale) << 16 ^ (y * scale);
+			for (r = 0; r < ASYNCIMG_BENCH_ROUNDS; r++) {
+				v ^= v << 13;
+				v ^= v >> 17;
+				v ^= v << 5;
+			}
+			row[x] = 0xff000000 | (seed & 0xff0000) |
+				 ((x * scale) & 0xff) << 8 |
+				 (((y * scale) ^ v) & 0x3f);
+		}
+	}
+
+	return 0;
+}
+
+static bool bench_decoded(const lv_obj_t *img)
+{
+	const struct job *job;
+
+	for (job = ai.jobs; job < ai.jobs + ASYNCIMG_JOBS; job++) {
+		if (job->img == img) {
+			return job->state == JOB_SHOWN && job->buf;
+		}
+	}
+
+	return false;
+}
+
+static uint32_t bench_jobs_in_use(void)
+{
+	const struct job *job;
+	uint32_t n = 0;
+
+	for (job = ai.jobs; job < ai.jobs + ASYNCIMG_JOBS; job++) {
+		n += job->state != JOB_FREE;
+	}
+
+	return n;
+}
+
+static lv_obj_t *bench_screen(lv_obj_t **imgs)
+{
+	lv_obj_t *scr = lv_obj_create(NULL);
+	int i;
+
+	lv_obj_set_flex_flow(scr, LV_FLEX_FLOW_ROW_WRAP);
+	lv_obj_set_style_pad_all(scr, 4, 0);
+	lv_obj_set_style_pad_gap(scr, 4, 0);
+	for (i = 0; i < ASYNCIMG_BENCH_IMAGES; i++) {
+		imgs[i] = lv_image_create(scr);
+		asyncimg_set_src(imgs[i], bench_decode, (void *)(uintptr_t)i,
+				 ASYNCIMG_BENCH_W, ASYNCIMG_BENCH_H);
+	}
+
+	return scr;
+}
+
+/* One 60 Hz main loop iteration; returns its duration in us */
+static uint32_t bench_iteration(lv_display_t *disp, uint64_t start)
+{
+	struct timespec ts;
+	uint64_t end;
+
+	asyncimg_drain();
+	lv_refr_now(disp);
+	end = bench_now_us();
+	ts.tv_sec = 0;
+	ts.tv_nsec = ASYNCIMG_BENCH_PERIOD * 1000000L;
+	nanosleep(&ts, NULL);
+
+	return end - start;
+}
+
+static int bench_pass(const char *label, const struct asyncimg_cfg *cfg)
+{
+	uint32_t worst = 0, visible_ms = 0, all_ms = 0, n, i;
+	lv_obj_t *imgs[ASYNCIMG_BENCH_IMAGES];
+	struct asyncimg_stats st;
+	lv_mem_monitor_t before, after;
+	lv_obj_t *home, *scr;
+	lv_display_t *disp;
+	uint64_t t0, t;
+	int ret = 0;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp || asyncimg_init(cfg)) {
+		bench_display_delete(disp);
+		return -1;
+	}
+	home = lv_display_get_screen_active(disp);
+	lv_label_set_text(lv_label_create(home), "Home");
+	lv_refr_now(disp);
+	lv_mem_monitor(&before);
+
+	t0 = bench_now_us();
+	t = t0;
+	scr = bench_screen(imgs);
+	lv_screen_load(scr);
+	while (!all_ms && t - t0 < ASYNCIMG_BENCH_TIMEOUT * 1000ULL) {
+		worst = LV_MAX(worst, bench_iteration(disp, t));
+		t = bench_now_us();
+		for (n = 0; n < ASYNCIMG_BENCH_IMAGES &&
+			    bench_decoded(imgs[n]); n++) {
+		}
+		if (!visible_ms && n >= ASYNCIMG_BENCH_VISIBLE) {
+			visible_ms = (t - t0) / 1000;
+		}
+		if (n == ASYNCIMG_BENCH_IMAGES) {
+			all_ms = (t - t0) / 1000;
+		}
+	}
+	asyncimg_get_stats(&st);
+
+	printf("%-24s worst iteration %6.1f ms, visible decoded %4u ms, "
+	       "all %4u ms\n", label, worst / 1000.0, visible_ms, all_ms);
+	printf("  %.1f ms decode/image, %llu previews\n",
+	       st.decoded ? st.decode_us / 1000.0 / st.decoded : 0.0,
+	       (unsigned long long)st.previews);
+	if (!all_ms) {
+		printf("  not all images decoded\n");
+		ret = -1;
+	}
+
+	// Back home, then in and straight out again
+	lv_screen_load(home);
+	lv_obj_delete(scr);
+	scr = bench_screen(imgs);
+	lv_screen_load(scr);
+	bench_iteration(disp, bench_now_us());
+	lv_screen_load(home);
+	lv_obj_delete(scr);
+	for (i = 0; i < 10 && bench_jobs_in_use(); i++) {
+		bench_iteration(disp, bench_now_us());
+	}
+	asyncimg_get_stats(&st);
+	lv_mem_monitor(&after);
+	printf("  cancelled %llu of %llu, %u jobs left, heap %+d bytes\n",
+	       (unsigned long long)st.cancelled,
+	       (unsigned long long)st.submitted, bench_jobs_in_use(),
+	       (int)(before.free_size - after.free_size));
+	if (bench_jobs_in_use()) {
+		ret = -1;
+	}
+
+	asyncimg_deinit();
+	bench_display_delete(disp);
+
+	return ret;
+}
+
+int asyncimg_bench(void)
+{
+	static const struct asyncimg_cfg cfgs[] = {
+		{ .threads = 0, .queue = 1 },
+		{ .threads = 1, .queue = 2 },
+		{ .threads = 2, .queue = 4 },
+		{ .threads = 2, .queue = 4, .lowres = 4 },
+	};
+	static const char *const labels[] = {
+		"in place", "1 worker", "2 workers", "2 workers, preview",
+	};
+	size_t i;
+
+	for (i = 0; i < sizeof(cfgs) / sizeof(cfgs[0]); i++) {
+		if (bench_pass(labels[i], &cfgs[i])) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Image decoding on a worker pool with placeholders
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef ASYNCIMG_H
+#define ASYNCIMG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+#define ASYNCIMG_JOBS		64	// images pending or shown at a time
+#define ASYNCIMG_THREADS_MAX	8
+#define ASYNCIMG_BAND		16	// rows per decode call
+
+/*
+ * Fill rows y0 to y1 - 1 of buf, an ARGB8888 draw buffer of the image's size
+ * divided by scale (rounded up), from src. Runs on a worker thread and must
+ * not call LVGL. Returns 0 or -errno.
+ */
+typedef int (*asyncimg_decode_cb_t)(void *src, lv_draw_buf_t *buf,
+				    uint32_t scale, int32_t y0, int32_t y1);
+
+struct asyncimg_cfg {
+	uint32_t threads;	// 0: decode in asyncimg_set_src()
+	uint32_t queue;		// decodes queued or running at a time
+	uint32_t lowres;	// show a 1/lowres preview first, 0: off
+};
+
+struct asyncimg_stats {
+	uint64_t submitted;
+	uint64_t decoded;
+	uint64_t cancelled;
+	uint64_t previews;
+	uint64_t decode_us;
+	uint32_t wait_max_ms;	// asyncimg_set_src() to the decoded image
+};
+
+int asyncimg_init(const struct asyncimg_cfg *cfg);
+void asyncimg_deinit(void);
+
+/*
+ * Size img (an lv_image) to w x h and show a placeholder until src is
+ * decoded. Visible images are decoded first; deleting img (or its screen)
+ * cancels the decode. Returns -ENOSPC when ASYNCIMG_JOBS are in use.
+ */
+int asyncimg_set_src(lv_obj_t *img, asyncimg_decode_cb_t cb, void *src,
+		     int32_t w, int32_t h);
+
+/* UI thread, once per lv_timer_handler() cycle */
+void asyncimg_drain(void);
+
+void asyncimg_get_stats(struct asyncimg_stats *stats);
+
+int asyncimg_bench(void);
+
+#endif /* ASYNCIMG_H */
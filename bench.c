@@ -0,0 +1,312 @@
+/*
+ * Headless display and benchmark scenarios
+ *
+ * Scenarios run against an in-memory display instead of DRM, so they can be
+ * used on a build host as well as on the target. Select one with '-b name'.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "areamerge.h"
+#include "asyncimg.h"
+#include "bench.h"
+#include "capture.h"
+#include "chartfeed.h"
+#include "drawbuf.h"
+#include "governor.h"
+#include "kbdinc.h"
+#include "layerpool.h"
+#include "layoutinc.h"
+#include "lvctx.h"
+#include "mailbox.h"
+#include "mirror.h"
+#include "multipanel.h"
+#include "objscale.h"
+#include "primcache.h"
+#include "refrstat.h"
+#include "rotate.h"
+#include "rt.h"
+#include "shmpub.h"
+#include "timerheap.h"
+#include "touchfilt.h"
+#include "vlist.h"
+#include "vscroll.h"
+#include "vsync.h"
+
+#define BENCH_BUF_LINES 40
+
+struct headless {
+	uint8_t *fb;
+	uint8_t *buf;
+	uint32_t stride;
+	uint32_t px_size;
+	uint64_t flushed_px;
+};
+
+struct bench {
+	const char *name;
+	int (*run)(void);
+	const char *help;
+};
+
+static const struct bench benches[] = {
+	{ "areamerge", areamerge_bench,
+	  "modelled SPI bus time, cost model vs. LVGL area joining" },
+	{ "asyncimg", asyncimg_bench,
+	  "worst frame of a switch to ten images, worker pool vs. in place" },
+	{ "capture", capture_bench,
+	  "screenshots while animating: frame cost, match with display" },
+	{ "chart", chartfeed_bench,
+	  "1 kHz / 10 kHz chart feed, lock-free ring vs. locked per sample" },
+	{ "drawbuf", drawbuf_bench,
+	  "fill/blend/image Mpx/s by buffer alignment and stride" },
+	{ "governor", governor_bench,
+	  "frame time with and without the render quality governor" },
+	{ "jitter", rt_bench,
+	  "timer handler wake-up lateness with the rt_* settings" },
+	{ "kbdinc", kbdinc_bench,
+	  "typing trace on lv_keyboard: px flushed and latency per keystroke" },
+	{ "layerpool", layerpool_bench,
+	  "layer buffer allocations and frame time, pool vs. LVGL heap" },
+	{ "layoutinc", layoutinc_bench,
+	  "flex/grid passes per frame of a settings page, skip unchanged" },
+	{ "lvctx", lvctx_bench,
+	  "screens/s rendered by 1-8 threads with isolated LVGL instances" },
+	{ "mailbox", mailbox_bench,
+	  "10k subject updates/s from workers, mailbox vs. lv_lock" },
+	{ "mirror", mirror_bench,
+	  "dirty rectangle mirror stream: cost, bandwidth, drops" },
+	{ "multipanel", multipanel_bench,
+	  "two panels in one process: input routing, fps vs. two processes" },
+	{ "objscale", objscale_bench,
+	  "wide/deep/mixed trees: layout, style lookup with cache, events, render" },
+	{ "primcache", primcache_bench,
+	  "full redraws with cached corner and shadow bitmaps vs. LVGL" },
+	{ "refrstat", refrstat_bench,
+	  "invalidation and overdraw of the main.c screen updates" },
+	{ "rotate", rotate_bench,
+	  "90/180/270 degree flush cost: LVGL, blocked kernel, MADCTL" },
+	{ "shmpub", shmpub_bench,
+	  "publish rate and latency from a producer process via shared memory" },
+	{ "timerheap", timerheap_bench,
+	  "lv_timer_handler() cost with 10-10k timers, heap vs. LVGL list" },
+	{ "touchfilt", touchfilt_bench,
+	  "drag traces: slider callbacks and finger error per filter stage" },
+	{ "vlist", vlist_bench,
+	  "lv_table/lv_list vs. virtualized rows at 100, 10k and 1M rows" },
+	{ "vscroll", vscroll_bench,
+	  "list scrolling on a mock ILI9341 with hardware scroll" },
+	{ "vsync", vsync_bench,
+	  "present intervals against a fake 60 Hz vblank, timer vs. paced" },
+};
+
+uint64_t bench_now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void bench_frames_reset(struct bench_frames *f)
+{
+	memset(f, 0, sizeof(*f));
+	f->min_us = UINT32_MAX;
+}
+
+void bench_frames_add(struct bench_frames *f, uint32_t us)
+{
+	f->count++;
+	f->total_us += us;
+	if (us < f->min_us) {
+		f->min_us = us;
+	}
+	if (us > f->max_us) {
+		f->max_us = us;
+	}
+}
+
+void bench_frames_print(const char *label, const struct bench_frames *f)
+{
+	if (!f->count) {
+		printf("%-24s no frames\n", label);
+		return;
+	}
+	printf("%-24s frames %6u  avg %7.3f ms  min %7.3f ms  max %7.3f ms\n",
+	       label, f->count, f->total_us / 1000.0 / f->count,
+	       f->min_us / 1000.0, f->max_us / 1000.0);
+}
+
+static void frames_event_cb(lv_event_t *e)
+{
+	struct bench_frames *f = lv_event_get_user_data(e);
+
+	if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+		f->start_us = bench_now_us();
+	} else {
+		bench_frames_add(f, bench_now_us() - f->start_us);
+	}
+}
+
+void bench_frames_attach(lv_display_t *disp, struct bench_frames *f)
+{
+	lv_display_add_event_cb(disp, frames_event_cb, LV_EVENT_REFR_START, f);
+	lv_display_add_event_cb(disp, frames_event_cb, LV_EVENT_REFR_READY, f);
+}
+
+void bench_frames_detach(lv_display_t *disp, struct bench_frames *f)
+{
+	lv_display_remove_event_cb_with_user_data(disp, frames_event_cb, f);
+}
+
+static void headless_flush_cb(lv_display_t *disp, const lv_area_t *area,
+			      uint8_t *px_map)
+{
+	struct headless *hl = lv_display_get_user_data(disp);
+	uint32_t w = area->x2 - area->x1 + 1;
+	uint32_t src_stride = lv_draw_buf_width_to_stride(w,
+				lv_display_get_color_format(disp));
+	uint8_t *dst = hl->fb + area->y1 * hl->stride + area->x1 * hl->px_size;
+	int32_t y;
+
+	for (y = area->y1; y <= area->y2; y++) {
+		memcpy(dst, px_map, w * hl->px_size);
+		dst += hl->stride;
+		px_map += src_stride;
+	}
+	hl->flushed_px += (uint64_t)w * (area->y2 - area->y1 + 1);
+
+	lv_display_flush_ready(disp);
+}
+
+lv_display_t *bench_display_create(int32_t hor_res, int32_t ver_res)
+{
+	struct headless *hl;
+	lv_display_t *disp;
+	lv_color_format_t cf;
+	uint32_t buf_size;
+
+	hl = calloc(1, sizeof(*hl));
+	if (!hl) {
+		return NULL;
+	}
+
+	disp = lv_display_create(hor_res, ver_res);
+	if (!disp) {
+		free(hl);
+		return NULL;
+	}
+	cf = lv_display_get_color_format(disp);
+	hl->px_size = lv_color_format_get_size(cf);
+	hl->stride = hor_res * hl->px_size;
+	hl->fb = calloc(ver_res, hl->stride);
+	buf_size = lv_draw_buf_width_to_stride(hor_res, cf) * BENCH_BUF_LINES;
+	hl->buf = aligned_alloc(64, buf_size);
+	if (!hl->fb || !hl->buf) {
+		lv_display_delete(disp);
+		free(hl->fb);
+		free(hl->buf);
+		free(hl);
+		return NULL;
+	}
+
+	lv_display_set_user_data(disp, hl);
+	lv_display_set_flush_cb(disp, headless_flush_cb);
+	lv_display_set_buffers(disp, hl->buf, NULL, buf_size,
+			       LV_DISPLAY_RENDER_MODE_PARTIAL);
+	lv_display_set_default(disp);
+
+	return disp;
+}
+
+void bench_display_delete(lv_display_t *disp)
+{
+	struct headless *hl = lv_display_get_user_data(disp);
+
+	lv_display_delete(disp);
+	free(hl->fb);
+	free(hl->buf);
+	free(hl);
+}
+
+uint8_t *bench_display_framebuffer(lv_display_t *disp, uint32_t *stride)
+{
+	struct headless *hl = lv_display_get_user_data(disp);
+
+	if (stride) {
+		*stride = hl->stride;
+	}
+
+	return hl->fb;
+}
+
+uint64_t bench_display_flushed_px(lv_display_t *disp)
+{
+	struct headless *hl = lv_display_get_user_data(disp);
+
+	return hl->flushed_px;
+}
+
+int bench_display_compare(lv_display_t *disp, uint8_t **ref, uint32_t *diff,
+			  uint32_t *max)
+{
+	struct headless *hl = lv_display_get_user_data(disp);
+	size_t size = (size_t)hl->stride *
+		      lv_display_get_vertical_resolution(disp);
+	size_t k;
+
+	*diff = 0;
+	*max = 0;
+	if (!*ref) {
+		*ref = malloc(size);
+		if (!*ref) {
+			return -1;
+		}
+		memcpy(*ref, hl->fb, size);
+		return 0;
+	}
+	for (k = 0; k < size; k++) {
+		if (hl->fb[k] != (*ref)[k]) {
+			(*diff)++;
+			*max = LV_MAX(*max,
+				      (uint32_t)LV_ABS(hl->fb[k] - (*ref)[k]));
+		}
+	}
+
+	return 0;
+}
+
+int bench_run(const char *name)
+{
+	size_t i;
+
+	for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+		if (!strcmp(name, benches[i].name)) {
+			printf("bench: %s\n", benches[i].name);
+			return benches[i].run();
+		}
+	}
+
+	fprintf(stderr, "bench: unknown scenario '%s'\n", name);
+	bench_list(stderr);
+
+	return -1;
+}
+
+void bench_list(FILE *fp)
+{
+	size_t i;
+
+	fprintf(fp, "scenarios:\n");
+	for (i = 0; i < sizeof(benches) / sizeof(benches[0]); i++) {
+		fprintf(fp, "  %-16s %s\n", benches[i].name, benches[i].help);
+	}
+}
@@ -0,0 +1,53 @@
+/*
+ * Headless display and benchmark scenarios
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+#define BENCH_HOR_RES 320
+#define BENCH_VER_RES 240
+
+struct bench_frames {
+	uint32_t count;
+	uint32_t min_us;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint64_t start_us;
+};
+
+uint64_t bench_now_us(void);
+
+void bench_frames_reset(struct bench_frames *f);
+void bench_frames_add(struct bench_frames *f, uint32_t us);
+void bench_frames_print(const char *label, const struct bench_frames *f);
+/* Time every refresh of disp (REFR_START to REFR_READY) into f */
+void bench_frames_attach(lv_display_t *disp, struct bench_frames *f);
+void bench_frames_detach(lv_display_t *disp, struct bench_frames *f);
+
+/* In-memory display: every flushed area is copied into a full framebuffer */
+lv_display_t *bench_display_create(int32_t hor_res, int32_t ver_res);
+void bench_display_delete(lv_display_t *disp);
+uint8_t *bench_display_framebuffer(lv_display_t *disp, uint32_t *stride);
+uint64_t bench_display_flushed_px(lv_display_t *disp);
+/*
+ * Bytes of the framebuffer that differ from *ref, and by how much at most.
+ * With *ref NULL the framebuffer is copied to a new *ref instead; free() it.
+ */
+int bench_display_compare(lv_display_t *disp, uint8_t **ref, uint32_t *diff,
+			  uint32_t *max);
+
+int bench_run(const char *name);
+void bench_list(FILE *fp);
+
+#endif /* BENCH_H */
@@ -0,0 +1,857 @@
+/*
+ * Screenshot capture of the presented frame
+ *
+ * A capture copies the frame that is already on the panel once and leaves
+ * all encoding to a background thread; nothing is rendered again. On a
+ * request the thread sets a flag that the render thread checks at
+ * LV_EVENT_REFR_READY, after the last flush of a frame and before the next
+ * one starts. If no frame completes within CAPTURE_IDLE_MS the display is
+ * idle and the thread copies the frame itself, retrying if a refresh
+ * started meanwhile (seq is odd while one is in progress).
+ *
+ * Requests come from SIGUSR1 (written to a file) or from a unix socket
+ * (returned to the client). PNG output uses stored deflate blocks, which
+ * needs no zlib and costs little more than a PPM on the device.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "lvgl/src/display/lv_display_private.h"
+
+#include "bench.h"
+#include "capture.h"
+#include "rt.h"
+
+#define CAPTURE_IDLE_MS		50
+#define CAPTURE_STORED_MAX	65535
+
+static struct {
+	lv_display_t *disp;
+	capture_fb_cb_t fb_cb;
+	uint32_t hor_res;
+	uint32_t ver_res;
+	uint32_t px_size;
+	uint32_t cf;
+	char dir[PATH_MAX];
+	bool ppm;
+
+	uint8_t *snap;		// hor_res * px_size stride
+	uint8_t *rgb;
+	uint8_t *out;
+	size_t out_size;
+
+	atomic_uint seq;
+	atomic_bool want;	// claimed by whoever clears it first
+	atomic_bool sig_pending;
+	atomic_bool stop;
+	int efd;		// wakes the thread: signal, stop
+	int dfd;		// render thread copy done
+	int lfd;
+	pthread_t thread;
+	uint32_t files;
+
+	struct capture_stats stats;
+} cap = { .efd = -1, .dfd = -1, .lfd = -1 };
+
+static uint32_t crc_table[256];
+
+/* Render thread */
+
+static const uint8_t *presented(uint32_t *stride)
+{
+	lv_display_t *disp = cap.disp;
+	lv_draw_buf_t *buf = disp->buf_act;
+
+	if (cap.fb_cb) {
+		return cap.fb_cb(disp, stride);
+	}
+	// Double buffered: buf_act was swapped after the last flush
+	if (disp->buf_2) {
+		buf = buf == disp->buf_1 ? disp->buf_2 : disp->buf_1;
+	}
+	*stride = buf->header.stride;
+
+	return buf->data;
+}
+
+/*
+ * Eventfd signalling. An eventfd write is all or nothing and only fails
+ * with EAGAIN, when the counter is saturated and the reader is woken
+ * anyway; a read fails when there is nothing to drain. Both are retried on
+ * EINTR. Also used from the SIGUSR1 handler.
+ */
+static void efd_signal(int fd)
+{
+	uint64_t one = 1;
+
+	while (write(fd, &one, sizeof(one)) < 0 && errno == EINTR) {
+	}
+}
+
+static void efd_drain(int fd)
+{
+	uint64_t v;
+
+	while (read(fd, &v, sizeof(v)) < 0 && errno == EINTR) {
+	}
+}
+
+static void copy_frame(void)
+{
+	uint32_t row = cap.hor_res * cap.px_size;
+	const uint8_t *src;
+	uint32_t stride;
+	uint32_t y;
+
+	src = presented(&stride);
+	for (y = 0; y < cap.ver_res; y++) {
+		memcpy(cap.snap + y * row, src + y * stride, row);
+	}
+}
+
+static void capture_event_cb(lv_event_t *e)
+{
+	uint64_t t0;
+
+	if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+		atomic_fetch_add(&cap.seq, 1);
+		return;
+	}
+
+	if (atomic_load_explicit(&cap.want, memory_order_relaxed) &&
+	    atomic_exchange(&cap.want, false)) {
+		t0 = bench_now_us();
+		copy_frame();
+		cap.stats.copy_us += bench_now_us() - t0;
+		cap.stats.render_copies++;
+		efd_signal(cap.dfd);
+	}
+	atomic_fetch_add(&cap.seq, 1);
+}
+
+/* Encoder thread */
+
+static int grab(void)
+{
+	struct pollfd pfd = { .fd = cap.dfd, .events = POLLIN };
+	unsigned int seq;
+
+	while (!atomic_load(&cap.stop)) {
+		atomic_store(&cap.want, true);
+		if (poll(&pfd, 1, CAPTURE_IDLE_MS) > 0) {
+			efd_drain(cap.dfd);
+			return 0;
+		}
+		if (!atomic_exchange(&cap.want, false)) {
+			// The render thread claimed it and is copying
+			poll(&pfd, 1, -1);
+			efd_drain(cap.dfd);
+			return 0;
+		}
+
+		seq = atomic_load(&cap.seq);
+		if (!(seq & 1)) {
+			copy_frame();
+			if (atomic_load(&cap.seq) == seq) {
+				cap.stats.idle_copies++;
+				return 0;
+			}
+		}
+		cap.stats.retries++;
+	}
+
+	return -1;
+}
+
+static void to_rgb(uint8_t *rgb, const uint8_t *px, uint32_t n)
+{
+	uint16_t v;
+	uint32_t i;
+
+	for (i = 0; i < n; i++, rgb += 3, px += cap.px_size) {
+		if (cap.px_size == 2) {
+			v = px[0] | px[1] << 8;
+			rgb[0] = (v >> 11) * 255 / 31;
+			rgb[1] = (v >> 5 & 0x3f) * 255 / 63;
+			rgb[2] = (v & 0x1f) * 255 / 31;
+		} else {
+			// RGB888 and (A/X)RGB8888 are stored B, G, R(, A)
+			rgb[0] = px[2];
+			rgb[1] = px[1];
+			rgb[2] = px[0];
+		}
+	}
+}
+
+static uint32_t crc32(uint32_t crc, const uint8_t *p, size_t len)
+{
+	crc = ~crc;
+	while (len--) {
+		crc = crc_table[(crc ^ *p++) & 0xff] ^ crc >> 8;
+	}
+
+	return ~crc;
+}
+
+static uint8_t *put32be(uint8_t *p, uint32_t v)
+{
+	p[0] = v >> 24;
+	p[1] = v >> 16;
+	p[2] = v >> 8;
+	p[3] = v;
+
+	return p + 4;
+}
+
+/* Chunk data is already at p + 8; fills in length, type and CRC */
+static uint8_t *png_chunk(uint8_t *p, const char *type, size_t len)
+{
+	put32be(p, len);
+	memcpy(p + 4, type, 4);
+
+	return put32be(p + 8 + len, crc32(0, p + 4, len + 4));
+}
+
+static size_t encode_png(uint8_t *out, const uint8_t *rgb)
+{
+	static const uint8_t sig[8] = { 0x89, 'P', 'N', 'G', '\r', '\n',
+					0x1a, '\n' };
+	size_t row = cap.hor_res * 3;
+	size_t raw = (row + 1) * cap.ver_res;
+	uint32_t a = 1;
+	uint32_t b = 0;
+	uint8_t *p = out;
+	uint8_t *d;
+	uint8_t *blk = NULL;
+	size_t left = 0;
+	size_t pos;
+	uint32_t x;
+	uint32_t y;
+
+	memcpy(p, sig, sizeof(sig));
+	p += sizeof(sig);
+
+	d = put32be(p + 8, cap.hor_res);
+	d = put32be(d, cap.ver_res);
+	memcpy(d, "\x08\x02\x00\x00\x00", 5);	// 8 bit RGB
+	p = png_chunk(p, "IHDR", 13);
+
+	// zlib stream of stored blocks: one filter byte (none) per row
+	d = p + 8;
+	*d++ = 0x78;
+	*d++ = 0x01;
+	for (pos = 0, y = 0; y < cap.ver_res; y++) {
+		for (x = 0; x <= row; x++, pos++, left--) {
+			uint8_t c = x ? rgb[y * row + x - 1] : 0;
+
+			if (!left) {
+				left = LV_MIN(raw - pos, CAPTURE_STORED_MAX);
+				blk = d;
+				blk[0] = raw - pos == left;	// BFINAL
+				blk[1] = left;
+				blk[2] = left >> 8;
+				blk[3] = ~left;
+				blk[4] = ~left >> 8;
+				d += 5;
+			}
+			*d++ = c;
+			a = (a + c) % 65521;
+			b = (b + a) % 65521;
+		}
+	}
+	d = put32be(d, b << 16 | a);
+	p = png_chunk(p, "IDAT", d - (p + 8));
+	p = png_chunk(p, "IEND", 0);
+
+	return p - out;
+}
+
+static size_t encode(uint8_t *out, enum capture_format fmt)
+{
+	int n;
+
+	to_rgb(cap.rgb, cap.snap, cap.hor_res * cap.ver_res);
+	if (fmt == CAPTURE_PNG) {
+		return encode_png(out, cap.rgb);
+	}
+
+	n = sprintf((char *)out, "P6\n%u %u\n255\n", cap.hor_res, cap.ver_res);
+	memcpy(out + n, cap.rgb, cap.hor_res * cap.ver_res * 3);
+
+	return n + cap.hor_res * cap.ver_res * 3;
+}
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len) {
+		n = send(fd, buf, len, MSG_NOSIGNAL);
+		if (n < 0 && errno == ENOTSOCK) {
+			n = write(fd, buf, len);
+		}
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+/* Grab, encode and write one capture; fd < 0 writes a file to cap.dir */
+static void serve(int fd, enum capture_format fmt)
+{
+	char path[PATH_MAX + 64];
+	char stamp[32];
+	time_t t = time(NULL);
+	uint64_t t0;
+	size_t len;
+
+	if (grab()) {
+		return;
+	}
+	t0 = bench_now_us();
+	len = encode(cap.out, fmt);
+	cap.stats.encode_us += bench_now_us() - t0;
+	cap.stats.captures++;
+
+	if (fd < 0) {
+		strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", localtime(&t));
+		snprintf(path, sizeof(path), "%s/capture-%s-%u.%s", cap.dir,
+			 stamp, cap.files++, fmt == CAPTURE_PNG ? "png" : "ppm");
+		fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+		if (fd < 0) {
+			fprintf(stderr, "capture: %s: %s\n", path,
+				strerror(errno));
+			return;
+		}
+		if (write_all(fd, cap.out, len)) {
+			fprintf(stderr, "capture: %s: %s\n", path,
+				strerror(errno));
+		}
+		close(fd);
+		return;
+	}
+	if (write_all(fd, cap.out, len)) {
+		fprintf(stderr, "capture: client: %s\n", strerror(errno));
+	}
+}
+
+static void serve_client(void)
+{
+	struct timeval tv = { .tv_sec = 1 };
+	char req[4];
+	int fd;
+
+	fd = accept4(cap.lfd, NULL, NULL, SOCK_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	if (recv(fd, req, sizeof(req), MSG_WAITALL) == sizeof(req)) {
+		if (!memcmp(req, "png\n", 4)) {
+			serve(fd, CAPTURE_PNG);
+		} else if (!memcmp(req, "ppm\n", 4)) {
+			serve(fd, CAPTURE_PPM);
+		}
+	}
+	close(fd);
+}
+
+static void *capture_thread(void *arg)
+{
+	struct pollfd pfd[2] = {
+		{ .fd = cap.efd, .events = POLLIN },
+		{ .fd = cap.lfd, .events = POLLIN },
+	};
+
+	rt_background();
+	while (!atomic_load(&cap.stop)) {
+		if (poll(pfd, cap.lfd >= 0 ? 2 : 1, -1) < 0) {
+			continue;
+		}
+		if (pfd[0].revents) {
+			efd_drain(cap.efd);
+		}
+		if (atomic_exchange(&cap.sig_pending, false)) {
+			serve(-1, cap.ppm ? CAPTURE_PPM : CAPTURE_PNG);
+		}
+		if (cap.lfd >= 0 && pfd[1].revents) {
+			serve_client();
+		}
+	}
+
+	return NULL;
+}
+
+static void capture_signal(int sig)
+{
+	int err = errno;
+
+	atomic_store(&cap.sig_pending, true);
+	efd_signal(cap.efd);
+	errno = err;
+}
+
+static void crc_init(void)
+{
+	uint32_t c;
+	int n;
+	int k;
+
+	for (n = 0; n < 256; n++) {
+		for (c = n, k = 0; k < 8; k++) {
+			c = c & 1 ? 0xedb88320 ^ c >> 1 : c >> 1;
+		}
+		crc_table[n] = c;
+	}
+}
+
+int capture_start(lv_display_t *disp, capture_fb_cb_t fb_cb, const char *addr,
+		  const char *dir, bool ppm)
+{
+	struct sockaddr_un un = { .sun_family = AF_UNIX };
+	struct sigaction sa = { .sa_handler = capture_signal };
+	size_t raw;
+
+	if (!fb_cb && disp->render_mode == LV_DISPLAY_RENDER_MODE_PARTIAL) {
+		fprintf(stderr, "capture: partial render mode needs a framebuffer\n");
+		return -1;
+	}
+	if (addr && strlen(addr) >= sizeof(un.sun_path)) {
+		fprintf(stderr, "capture: socket path too long\n");
+		return -1;
+	}
+
+	crc_init();
+	cap.disp = disp;
+	cap.fb_cb = fb_cb;
+	cap.hor_res = lv_display_get_horizontal_resolution(disp);
+	cap.ver_res = lv_display_get_vertical_resolution(disp);
+	cap.cf = lv_display_get_color_format(disp);
+	cap.px_size = lv_color_format_get_size(cap.cf);
+	cap.ppm = ppm;
+	if (dir) {
+		snprintf(cap.dir, sizeof(cap.dir), "%s", dir);
+	}
+
+	raw = (size_t)(cap.hor_res * 3 + 1) * cap.ver_res;
+	cap.out_size = 64 + raw + (raw / CAPTURE_STORED_MAX + 1) * 5;
+	cap.snap = malloc((size_t)cap.hor_res * cap.px_size * cap.ver_res);
+	cap.rgb = malloc((size_t)cap.hor_res * 3 * cap.ver_res);
+	cap.out = malloc(cap.out_size);
+	cap.efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	cap.dfd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (!cap.snap || !cap.rgb || !cap.out || cap.efd < 0 || cap.dfd < 0) {
+		goto fail;
+	}
+
+	if (addr) {
+		strcpy(un.sun_path, addr);
+		unlink(addr);
+		cap.lfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC |
+				 SOCK_NONBLOCK, 0);
+		if (cap.lfd < 0 || bind(cap.lfd, (struct sockaddr *)&un,
+					sizeof(un)) || listen(cap.lfd, 4)) {
+			fprintf(stderr, "capture: %s: %s\n", addr,
+				strerror(errno));
+			goto fail;
+		}
+	}
+
+	atomic_store(&cap.stop, false);
+	if (pthread_create(&cap.thread, NULL, capture_thread, NULL)) {
+		goto fail;
+	}
+	lv_display_add_event_cb(disp, capture_event_cb, LV_EVENT_REFR_START,
+				NULL);
+	lv_display_add_event_cb(disp, capture_event_cb, LV_EVENT_REFR_READY,
+				NULL);
+	if (dir) {
+		sigemptyset(&sa.sa_mask);
+		sa.sa_flags = SA_RESTART;
+		sigaction(SIGUSR1, &sa, NULL);
+	}
+
+	return 0;
+
+fail:
+	if (cap.lfd >= 0) {
+		close(cap.lfd);
+	}
+	if (cap.efd >= 0) {
+		close(cap.efd);
+	}
+	if (cap.dfd >= 0) {
+		close(cap.dfd);
+	}
+	free(cap.snap);
+	free(cap.rgb);
+	free(cap.out);
+	memset(&cap, 0, sizeof(cap));
+	cap.efd = cap.dfd = cap.lfd = -1;
+
+	return -1;
+}
+
+void capture_stop(void)
+{
+	if (!cap.disp) {
+		return;
+	}
+	if (cap.dir[0]) {
+		signal(SIGUSR1, SIG_DFL);
+	}
+	atomic_store(&cap.stop, true);
+	efd_signal(cap.efd);
+	efd_signal(cap.dfd);
+	pthread_join(cap.thread, NULL);
+	lv_display_remove_event_cb_with_user_data(cap.disp, capture_event_cb,
+						  NULL);
+
+	if (cap.lfd >= 0) {
+		close(cap.lfd);
+	}
+	close(cap.efd);
+	close(cap.dfd);
+	free(cap.snap);
+	free(cap.rgb);
+	free(cap.out);
+	memset(&cap, 0, sizeof(cap));
+	cap.efd = cap.dfd = cap.lfd = -1;
+}
+
+void capture_get_stats(struct capture_stats *stats)
+{
+	*stats = cap.stats;
+}
+
+int capture_fetch(const char *addr, enum capture_format fmt, FILE *fp)
+{
+	struct sockaddr_un un = { .sun_family = AF_UNIX };
+	uint8_t buf[4096];
+	size_t total = 0;
+	ssize_t n;
+	int fd;
+
+	if (strlen(addr) >= sizeof(un.sun_path)) {
+		return -1;
+	}
+	strcpy(un.sun_path, addr);
+	fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *)&un, sizeof(un)) ||
+	    write(fd, fmt == CAPTURE_PNG ? "png\n" : "ppm\n", 4) != 4) {
+		fprintf(stderr, "capture: %s: %s\n", addr, strerror(errno));
+		close(fd);
+		return -1;
+	}
+	for (;;) {
+		n = read(fd, buf, sizeof(buf));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			break;
+		}
+		if (fwrite(buf, 1, n, fp) != (size_t)n) {
+			n = -1;
+			break;
+		}
+		total += n;
+	}
+	close(fd);
+	if (fflush(fp)) {
+		n = -1;
+	}
+
+	return n < 0 || !total ? -1 : 0;
+}
+
+/*
+ * Benchmark: the main.c screen on a headless display. An idle capture is
+ * fetched as PPM and PNG and compared with the framebuffer. Then the screen
+ * is animated with and without a client fetching a capture every 50 ms;
+ * frame times must not change, and every capture must be one of the frames
+ * that were rendered.
+ */
+#define CAPTURE_BENCH_SOCKET	"/tmp/capture-bench.sock"
+#define CAPTURE_BENCH_FRAMES	600
+
+struct bench_screen {
+	lv_obj_t *button_label;
+	lv_obj_t *slider;
+	lv_obj_t *status;
+};
+
+struct fetcher {
+	pthread_t thread;
+	atomic_bool stop;
+	uint32_t count;
+	uint64_t hashes[CAPTURE_BENCH_FRAMES];
+	int err;
+};
+
+static uint64_t hash(const uint8_t *p, size_t len)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+
+	while (len--) {
+		h = (h ^ *p++) * 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+/* The framebuffer as the RGB a capture of it must contain */
+static uint64_t fb_rgb_hash(lv_display_t *disp, uint8_t *rgb)
+{
+	uint32_t stride;
+	uint8_t *fb = bench_display_framebuffer(disp, &stride);
+	uint32_t y;
+
+	for (y = 0; y < BENCH_VER_RES; y++) {
+		to_rgb(rgb + y * BENCH_HOR_RES * 3, fb + y * stride,
+		       BENCH_HOR_RES);
+	}
+
+	return hash(rgb, BENCH_HOR_RES * BENCH_VER_RES * 3);
+}
+
+/* Pixels of a PPM, or NULL */
+static const uint8_t *ppm_pixels(const char *img, size_t len)
+{
+	char hdr[32];
+	int n;
+
+	n = snprintf(hdr, sizeof(hdr), "P6\n%u %u\n255\n", BENCH_HOR_RES,
+		     BENCH_VER_RES);
+	if (len != (size_t)n + BENCH_HOR_RES * BENCH_VER_RES * 3 ||
+	    memcmp(img, hdr, n)) {
+		return NULL;
+	}
+
+	return (const uint8_t *)img + n;
+}
+
+/* Unpack the stored blocks of an encode_png() image and compare with rgb */
+static int png_check(const uint8_t *img, size_t len, const uint8_t *rgb)
+{
+	size_t row = BENCH_HOR_RES * 3;
+	const uint8_t *p = img + 8 + 25 + 8 + 2;
+	uint32_t n;
+	size_t pos = 0;
+	uint8_t c;
+
+	if (len < 8 + 25 + 12 + 6 + 12 || memcmp(img + 12, "IHDR", 4) ||
+	    memcmp(img + 37, "IDAT", 4) ||
+	    crc32(0, img + 37, len - 12 - 37 - 4) !=
+	    (uint32_t)(img[len - 16] << 24 | img[len - 15] << 16 |
+		       img[len - 14] << 8 | img[len - 13])) {
+		return -1;
+	}
+	do {
+		n = p[1] | p[2] << 8;
+		c = p[0];
+		p += 5;
+		for (; n; n--, pos++, p++) {
+			if (pos % (row + 1) ? *p != rgb[pos / (row + 1) * row +
+						       pos % (row + 1) - 1] :
+			    *p != 0) {
+				return -1;
+			}
+		}
+	} while (!(c & 1));
+
+	return pos == (row + 1) * BENCH_VER_RES ? 0 : -1;
+}
+
+static int fetch_mem(enum capture_format fmt, char **img, size_t *len)
+{
+	FILE *fp = open_memstream(img, len);
+	int ret;
+
+	if (!fp) {
+		return -1;
+	}
+	ret = capture_fetch(CAPTURE_BENCH_SOCKET, fmt, fp);
+	fclose(fp);
+
+	return ret;
+}
+
+static void *fetcher_thread(void *arg)
+{
+	struct fetcher *f = arg;
+	const uint8_t *px;
+	char *img;
+	size_t len;
+
+	while (!atomic_load(&f->stop) && f->count < CAPTURE_BENCH_FRAMES) {
+		usleep(50000);
+		img = NULL;
+		if (fetch_mem(CAPTURE_PPM, &img, &len) ||
+		    !(px = ppm_pixels(img, len))) {
+			f->err = -1;
+		} else {
+			f->hashes[f->count++] = hash(px, BENCH_HOR_RES *
+						     BENCH_VER_RES * 3);
+		}
+		free(img);
+	}
+
+	return NULL;
+}
+
+static void animate(lv_display_t *disp, struct bench_screen *s,
+		    struct bench_frames *f, uint64_t *hashes, uint8_t *rgb)
+{
+	uint32_t i;
+
+	bench_frames_reset(f);
+	for (i = 0; i < CAPTURE_BENCH_FRAMES; i++) {
+		lv_slider_set_value(s->slider, i % 101, LV_ANIM_OFF);
+		lv_label_set_text_fmt(s->button_label, "Button (%u)", i % 256);
+		lv_label_set_text_fmt(s->status, "frame %u", i);
+		lv_refr_now(disp);
+		if (hashes) {
+			hashes[i] = fb_rgb_hash(disp, rgb);
+		}
+		usleep(2000);
+	}
+}
+
+int capture_bench(void)
+{
+	static uint64_t frames[CAPTURE_BENCH_FRAMES];
+	static struct fetcher fetcher;
+	struct bench_screen s;
+	struct bench_frames f;
+	struct capture_stats st;
+	lv_display_t *disp;
+	lv_obj_t *scr;
+	lv_obj_t *obj;
+	uint8_t *rgb;
+	char *img = NULL;
+	size_t len;
+	uint32_t i;
+	uint32_t j;
+	uint32_t unknown = 0;
+	int err = 0;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	rgb = malloc(BENCH_HOR_RES * BENCH_VER_RES * 3);
+	if (!disp || !rgb) {
+		free(rgb);
+		return -1;
+	}
+	scr = lv_display_get_screen_active(disp);
+	obj = lv_label_create(scr);
+	lv_label_set_text(obj, "Light and Versatile Graphics Library");
+	lv_obj_align(obj, LV_ALIGN_CENTER, 0, 75);
+	obj = lv_button_create(scr);
+	lv_obj_set_size(obj, 100, 50);
+	lv_obj_align(obj, LV_ALIGN_TOP_MID, 0, 0);
+	s.button_label = lv_label_create(obj);
+	lv_obj_center(s.button_label);
+	s.slider = lv_slider_create(scr);
+	lv_obj_set_size(s.slider, 200, 50);
+	lv_obj_center(s.slider);
+	s.status = lv_label_create(scr);
+	lv_obj_align(s.status, LV_ALIGN_CENTER, 0, 100);
+	lv_label_set_text(s.button_label, "Button");
+	lv_label_set_text(s.status, "idle");
+	lv_refr_now(disp);
+
+	if (capture_start(disp, bench_display_framebuffer,
+			  CAPTURE_BENCH_SOCKET, NULL, false)) {
+		bench_display_delete(disp);
+		free(rgb);
+		return -1;
+	}
+
+	// Idle: the capture thread copies the frame itself
+	fb_rgb_hash(disp, rgb);
+	if (fetch_mem(CAPTURE_PPM, &img, &len) || !ppm_pixels(img, len) ||
+	    memcmp(ppm_pixels(img, len), rgb, BENCH_HOR_RES * BENCH_VER_RES * 3)) {
+		printf("idle PPM capture DIFFERS from the display\n");
+		err = -1;
+	} else {
+		printf("idle PPM capture matches the display (%zu bytes)\n",
+		       len);
+	}
+	free(img);
+	img = NULL;
+	if (fetch_mem(CAPTURE_PNG, &img, &len) ||
+	    png_check((uint8_t *)img, len, rgb)) {
+		printf("idle PNG capture DIFFERS from the display\n");
+		err = -1;
+	} else {
+		printf("idle PNG capture matches the display (%zu bytes)\n",
+		       len);
+	}
+	free(img);
+
+	bench_frames_attach(disp, &f);
+	animate(disp, &s, &f, NULL, NULL);
+	bench_frames_print("no capture", &f);
+
+	pthread_create(&fetcher.thread, NULL, fetcher_thread, &fetcher);
+	animate(disp, &s, &f, frames, rgb);
+	atomic_store(&fetcher.stop, true);
+	pthread_join(fetcher.thread, NULL);
+	bench_frames_print("capture every 50 ms", &f);
+	bench_frames_detach(disp, &f);
+
+	for (i = 0; i < fetcher.count; i++) {
+		for (j = 0; j < CAPTURE_BENCH_FRAMES; j++) {
+			if (fetcher.hashes[i] == frames[j]) {
+				break;
+			}
+		}
+		unknown += j == CAPTURE_BENCH_FRAMES;
+	}
+
+	capture_get_stats(&st);
+	capture_stop();
+	printf("%u captures: %u at REFR_READY, %u while idle (%u retries)\n",
+	       st.captures, st.render_copies, st.idle_copies, st.retries);
+	printf("render thread copy %.1f us/capture, encode %.1f us/capture\n",
+	       st.render_copies ? (double)st.copy_us / st.render_copies : 0.0,
+	       st.captures ? (double)st.encode_us / st.captures : 0.0);
+	printf("captures that match no rendered frame: %u of %u\n", unknown,
+	       fetcher.count);
+
+	bench_display_delete(disp);
+	free(rgb);
+
+	return err || fetcher.err || unknown ? -1 : 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * Screenshot capture of the presented frame
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+enum capture_format {
+	CAPTURE_PNG,
+	CAPTURE_PPM,
+};
+
+struct capture_stats {
+	uint32_t captures;
+	uint32_t render_copies;	// taken at LV_EVENT_REFR_READY
+	uint32_t idle_copies;	// taken by the encoder while nothing rendered
+	uint32_t retries;	// idle copies spoiled by a new frame
+	uint64_t copy_us;	// render thread time spent copying
+	uint64_t encode_us;
+};
+
+/*
+ * The presented frame is the display's last flushed draw buffer. Displays
+ * in partial render mode have none and must pass fb_cb to return their
+ * full framebuffer.
+ */
+typedef uint8_t *(*capture_fb_cb_t)(lv_display_t *disp, uint32_t *stride);
+
+/*
+ * addr: unix socket answering "png\n" / "ppm\n" with an image, or NULL.
+ * dir: where SIGUSR1 writes capture-<time>-<n>.png (.ppm with ppm set),
+ * or NULL for no signal handler.
+ */
+int capture_start(lv_display_t *disp, capture_fb_cb_t fb_cb, const char *addr,
+		  const char *dir, bool ppm);
+void capture_stop(void);
+void capture_get_stats(struct capture_stats *stats);
+
+/* Client: ask the capture socket at addr for one image and write it to fp */
+int capture_fetch(const char *addr, enum capture_format fmt, FILE *fp);
+
+int capture_bench(void);
+
+#endif /* CAPTURE_H */
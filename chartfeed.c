@@ -0,0 +1,323 @@
+/*
+ * Streaming chart feed with per-column min/max decimation
+ *
+ * An acquisition thread pushes raw samples into a single-producer ring
+ * buffer without touching LVGL or its lock. Once per frame (at the chart
+ * display's LV_EVENT_REFR_START, already under the LVGL lock) the UI side
+ * drains the ring and reduces every samples_per_column samples to one
+ * min/max pair, one chart point per pixel column.
+ *
+ * The chart runs in circular (sweep) update mode, where lv_chart only
+ * invalidates the columns around the newly written points instead of the
+ * whole plot area.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <pthread.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "bench.h"
+#include "chartfeed.h"
+
+struct chartfeed {
+	alignas(64) atomic_uint head;		// producer
+	atomic_uint_fast64_t pushed;
+	atomic_uint_fast64_t dropped;
+	alignas(64) atomic_uint tail;		// consumer
+	uint64_t consumed;
+	uint64_t columns;
+	uint32_t n;
+	int32_t min;
+	int32_t max;
+	uint32_t spc;
+	uint32_t mask;
+	int32_t *ring;
+	lv_obj_t *chart;
+	lv_display_t *disp;
+	lv_chart_series_t *ser_min;
+	lv_chart_series_t *ser_max;
+};
+
+bool chartfeed_push(struct chartfeed *feed, int32_t value)
+{
+	uint32_t head = atomic_load_explicit(&feed->head, memory_order_relaxed);
+	uint32_t tail = atomic_load_explicit(&feed->tail, memory_order_acquire);
+
+	if (head - tail > feed->mask) {
+		atomic_fetch_add_explicit(&feed->dropped, 1, memory_order_relaxed);
+		return false;
+	}
+	feed->ring[head & feed->mask] = value;
+	atomic_store_explicit(&feed->head, head + 1, memory_order_release);
+	atomic_fetch_add_explicit(&feed->pushed, 1, memory_order_relaxed);
+
+	return true;
+}
+
+static void feed_frame_cb(lv_event_t *e)
+{
+	struct chartfeed *feed = lv_event_get_user_data(e);
+	uint32_t tail = atomic_load_explicit(&feed->tail, memory_order_relaxed);
+	uint32_t head = atomic_load_explicit(&feed->head, memory_order_acquire);
+	int32_t v;
+
+	feed->consumed += head - tail;
+	while (tail != head) {
+		v = feed->ring[tail++ & feed->mask];
+		if (!feed->n++) {
+			feed->min = feed->max = v;
+		} else if (v < feed->min) {
+			feed->min = v;
+		} else if (v > feed->max) {
+			feed->max = v;
+		}
+		if (feed->n == feed->spc) {
+			lv_chart_set_next_value(feed->chart, feed->ser_max,
+						feed->max);
+			lv_chart_set_next_value(feed->chart, feed->ser_min,
+						feed->min);
+			feed->columns++;
+			feed->n = 0;
+		}
+	}
+	atomic_store_explicit(&feed->tail, tail, memory_order_release);
+}
+
+static void feed_delete_cb(lv_event_t *e)
+{
+	struct chartfeed *feed = lv_event_get_user_data(e);
+
+	lv_display_remove_event_cb_with_user_data(feed->disp, feed_frame_cb,
+						  feed);
+	feed->chart = NULL;
+}
+
+/*
+ * ring_size is rounded up to a power of two. The producer must be stopped
+ * before chartfeed_delete(); the chart may be deleted first.
+ */
+struct chartfeed *chartfeed_create(lv_obj_t *chart, uint32_t ring_size,
+				   uint32_t samples_per_column)
+{
+	struct chartfeed *feed;
+	uint32_t size = 1;
+	int32_t w;
+
+	while (size < ring_size) {
+		size <<= 1;
+	}
+
+	feed = aligned_alloc(64, sizeof(*feed));
+	if (!feed) {
+		return NULL;
+	}
+	memset(feed, 0, sizeof(*feed));
+	feed->ring = malloc(size * sizeof(*feed->ring));
+	if (!feed->ring) {
+		free(feed);
+		return NULL;
+	}
+	feed->mask = size - 1;
+	feed->spc = samples_per_column ? samples_per_column : 1;
+	feed->chart = chart;
+	feed->disp = lv_obj_get_display(chart);
+
+	lv_obj_update_layout(chart);
+	w = lv_obj_get_content_width(chart);
+	lv_chart_set_type(chart, LV_CHART_TYPE_LINE);
+	lv_chart_set_update_mode(chart, LV_CHART_UPDATE_MODE_CIRCULAR);
+	lv_chart_set_point_count(chart, w > 0 ? w : 1);
+	lv_obj_set_style_size(chart, 0, 0, LV_PART_INDICATOR);
+	lv_obj_set_style_line_width(chart, 1, LV_PART_ITEMS);
+	feed->ser_max = lv_chart_add_series(chart,
+					    lv_palette_main(LV_PALETTE_RED),
+					    LV_CHART_AXIS_PRIMARY_Y);
+	feed->ser_min = lv_chart_add_series(chart,
+					    lv_palette_main(LV_PALETTE_BLUE),
+					    LV_CHART_AXIS_PRIMARY_Y);
+
+	lv_display_add_event_cb(feed->disp, feed_frame_cb, LV_EVENT_REFR_START,
+				feed);
+	lv_obj_add_event_cb(chart, feed_delete_cb, LV_EVENT_DELETE, feed);
+
+	return feed;
+}
+
+void chartfeed_delete(struct chartfeed *feed)
+{
+	if (feed->chart) {
+		lv_display_remove_event_cb_with_user_data(feed->disp,
+							  feed_frame_cb, feed);
+		lv_obj_remove_event_cb_with_user_data(feed->chart,
+						      feed_delete_cb, feed);
+	}
+	free(feed->ring);
+	free(feed);
+}
+
+void chartfeed_get_stats(struct chartfeed *feed, struct chartfeed_stats *stats)
+{
+	stats->pushed = atomic_load_explicit(&feed->pushed,
+					     memory_order_relaxed);
+	stats->dropped = atomic_load_explicit(&feed->dropped,
+					      memory_order_relaxed);
+	stats->consumed = feed->consumed;
+	stats->columns = feed->columns;
+}
+
+/*
+ * Benchmark: an acquisition stand-in produces a noisy triangle wave at 1 kHz
+ * and 10 kHz, paced by CLOCK_MONOTONIC in 1 ms batches, while the UI runs the
+ * main loop pattern on a headless display. The same load is also pushed the
+ * way main.c would today, lv_lock() + lv_chart_set_next_value() per sample,
+ * for comparison.
+ */
+#define CHARTFEED_BENCH_SECONDS	3
+#define CHARTFEED_COLUMN_MS	10
+
+struct producer {
+	pthread_t thread;
+	atomic_bool stop;
+	uint32_t rate;
+	struct chartfeed *feed;		// NULL: locked per-sample path
+	lv_obj_t *chart;
+	lv_chart_series_t *ser;
+	uint64_t samples;
+	uint64_t lock_wait_us;
+};
+
+static int32_t sample(uint64_t i, uint32_t *seed)
+{
+	int32_t tri = i % 200;
+
+	*seed = *seed * 1103515245 + 12345;
+	tri = tri < 100 ? tri : 200 - tri;
+
+	return tri + (int32_t)((*seed >> 16) % 11) - 5;
+}
+
+static void *producer_thread(void *arg)
+{
+	struct producer *p = arg;
+	struct timespec next;
+	uint32_t seed = 1;
+	uint32_t batch = p->rate / 1000;
+	uint32_t i;
+	uint64_t t0;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (!atomic_load(&p->stop)) {
+		for (i = 0; i < batch; i++, p->samples++) {
+			if (p->feed) {
+				chartfeed_push(p->feed, sample(p->samples, &seed));
+				continue;
+			}
+			t0 = bench_now_us();
+			lv_lock();
+			p->lock_wait_us += bench_now_us() - t0;
+			lv_chart_set_next_value(p->chart, p->ser,
+						sample(p->samples, &seed));
+			lv_unlock();
+		}
+		next.tv_nsec += 1000000;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	return NULL;
+}
+
+static int bench_one(uint32_t rate, bool locked)
+{
+	struct producer p = { .rate = rate };
+	struct bench_frames frames;
+	struct chartfeed_stats stats;
+	lv_display_t *disp;
+	lv_obj_t *chart;
+	uint64_t end;
+	uint32_t idle;
+	char label[32];
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	chart = lv_chart_create(lv_display_get_screen_active(disp));
+	lv_obj_set_size(chart, BENCH_HOR_RES, 160);
+	lv_obj_center(chart);
+	lv_chart_set_axis_range(chart, LV_CHART_AXIS_PRIMARY_Y, -10, 110);
+
+	p.chart = chart;
+	if (locked) {
+		lv_chart_set_point_count(chart, BENCH_HOR_RES);
+		p.ser = lv_chart_add_series(chart, lv_palette_main(LV_PALETTE_RED),
+					    LV_CHART_AXIS_PRIMARY_Y);
+	} else {
+		p.feed = chartfeed_create(chart, 16384,
+					  rate * CHARTFEED_COLUMN_MS / 1000);
+		if (!p.feed) {
+			bench_display_delete(disp);
+			return -1;
+		}
+	}
+
+	bench_frames_reset(&frames);
+	bench_frames_attach(disp, &frames);
+	pthread_create(&p.thread, NULL, producer_thread, &p);
+
+	end = bench_now_us() + CHARTFEED_BENCH_SECONDS * 1000000ULL;
+	while (bench_now_us() < end) {
+		idle = lv_timer_handler();
+		lv_delay_ms(LV_MIN(idle, 5));
+	}
+	atomic_store(&p.stop, true);
+	pthread_join(p.thread, NULL);
+
+	snprintf(label, sizeof(label), "%u Hz %s", rate,
+		 locked ? "locked" : "ring");
+	bench_frames_print(label, &frames);
+	printf("%-24s %.0f samples/s", "",
+	       (double)p.samples / CHARTFEED_BENCH_SECONDS);
+	if (locked) {
+		printf("  producer lock wait %.1f ms\n",
+		       p.lock_wait_us / 1000.0);
+	} else {
+		chartfeed_get_stats(p.feed, &stats);
+		printf("  columns %llu  dropped %llu\n",
+		       (unsigned long long)stats.columns,
+		       (unsigned long long)stats.dropped);
+	}
+
+	bench_display_delete(disp);
+	if (p.feed) {
+		chartfeed_delete(p.feed);
+	}
+
+	return 0;
+}
+
+int chartfeed_bench(void)
+{
+	static const uint32_t rates[] = { 1000, 10000 };
+	size_t i;
+
+	for (i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+		if (bench_one(rates[i], false) || bench_one(rates[i], true)) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,38 @@
+/*
+ * Streaming chart feed with per-column min/max decimation
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef CHARTFEED_H
+#define CHARTFEED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+struct chartfeed;
+
+struct chartfeed_stats {
+	uint64_t pushed;
+	uint64_t dropped;	// ring full, producer outran the UI
+	uint64_t consumed;
+	uint64_t columns;
+};
+
+struct chartfeed *chartfeed_create(lv_obj_t *chart, uint32_t ring_size,
+				   uint32_t samples_per_column);
+void chartfeed_delete(struct chartfeed *feed);
+
+/* Producer side: lock-free, a single thread only */
+bool chartfeed_push(struct chartfeed *feed, int32_t value);
+
+void chartfeed_get_stats(struct chartfeed *feed, struct chartfeed_stats *stats);
+
+int chartfeed_bench(void);
+
+#endif /* CHARTFEED_H */
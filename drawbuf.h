@@ -0,0 +1,47 @@
+/*
+ * 64 byte aligned draw buffers from a pre-faulted arena
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef DRAWBUF_H
+#define DRAWBUF_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+#define DRAWBUF_ALIGN 64
+
+struct drawbuf_stats {
+	size_t arena;		// [bytes] mapped
+	size_t used;		// [bytes] handed out
+	size_t peak;
+	uint64_t allocs;
+	uint64_t fallbacks;	// arena full: served by the LVGL heap
+	bool huge;		// backed by MAP_HUGETLB pages
+	bool locked;
+};
+
+/*
+ * Map a pre-faulted arena (huge pages and mlock() on request) and serve
+ * the default and image draw buffer handlers from it, with buffer starts and
+ * image row strides aligned to DRAWBUF_ALIGN. Layer and display strides
+ * stay packed.
+ */
+int drawbuf_init(size_t arena, bool huge, bool lock);
+void drawbuf_deinit(void);
+void drawbuf_get_stats(struct drawbuf_stats *stats);
+
+/* Arena blocks, DRAWBUF_ALIGN aligned; NULL when full */
+void *drawbuf_alloc(size_t size);
+void drawbuf_free(void *ptr);
+
+int drawbuf_bench(void);
+
+#endif /* DRAWBUF_H */
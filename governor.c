@@ -0,0 +1,471 @@
+/*
+ * Frame deadline governor (adaptive render quality)
+ *
+ * Render time of every refresh is measured from LV_EVENT_REFR_START to
+ * LV_EVENT_REFR_READY. After a run of frames over budget the quality level
+ * steps down (anti-aliasing, then shadows/gradients, then translucency);
+ * after a longer run of frames with headroom it steps back up. Level changes
+ * are decided at REFR_READY and applied at the next REFR_START, which
+ * invalidates the screen so the whole frame is drawn at the new level.
+ *
+ * Styles are left alone: a degrade style would be outranked by local and
+ * state specific theme values. Instead, while shadows and gradients are off,
+ * the objects send their draw tasks here (LV_EVENT_DRAW_TASK_ADDED). A box
+ * shadow gets zero opacity, so LVGL skips it, and a gradient fill loses its
+ * direction and becomes a solid fill of the base color. At the flat level
+ * translucent fills, borders, text, images and layer blends are drawn opaque.
+ * Layers themselves are still rendered; only their blend becomes a copy.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl/src/misc/lv_event_private.h"
+
+#include "bench.h"
+#include "governor.h"
+#include "tune.h"
+
+static const char *const level_name[GOVERNOR_LEVELS] = {
+	"full", "no-aa", "no-effects", "flat",
+};
+
+static struct {
+	lv_display_t *disp;
+	bool active;
+	bool rendered;
+	bool settle;
+	uint32_t budget_us;
+	uint32_t level;
+	uint32_t pending;
+	uint32_t over;
+	uint32_t under;
+	uint32_t last_us;
+	uint64_t start_us;
+	struct governor_stats stats;
+} gov;
+
+static void opaque(uint8_t *opa)
+{
+	if (*opa > LV_OPA_MIN && *opa < LV_OPA_COVER) {
+		*opa = LV_OPA_COVER;
+		gov.stats.opaque++;
+	}
+}
+
+static void draw_task_cb(lv_event_t *e)
+{
+	lv_draw_task_t *t = lv_event_get_draw_task(e);
+	void *dsc = lv_draw_task_get_draw_dsc(t);
+	lv_draw_box_shadow_dsc_t *shadow;
+	lv_draw_fill_dsc_t *fill;
+
+	if (gov.level < GOVERNOR_NO_EFFECTS) {
+		return;
+	}
+	switch (lv_draw_task_get_type(t)) {
+	case LV_DRAW_TASK_TYPE_BOX_SHADOW:
+		shadow = dsc;
+		if (shadow->opa > LV_OPA_MIN) {
+			shadow->opa = LV_OPA_TRANSP;
+			gov.stats.shadows++;
+		}
+		return;
+	case LV_DRAW_TASK_TYPE_FILL:
+		fill = dsc;
+		if (fill->grad.dir != LV_GRAD_DIR_NONE) {
+			fill->grad.dir = LV_GRAD_DIR_NONE;
+			gov.stats.gradients++;
+		}
+		if (gov.level >= GOVERNOR_FLAT) {
+			opaque(&fill->opa);
+		}
+		return;
+	default:
+		break;
+	}
+	if (gov.level < GOVERNOR_FLAT) {
+		return;
+	}
+	switch (lv_draw_task_get_type(t)) {
+	case LV_DRAW_TASK_TYPE_BORDER:
+		opaque(&((lv_draw_border_dsc_t *)dsc)->opa);
+		break;
+	case LV_DRAW_TASK_TYPE_LABEL:
+		opaque(&((lv_draw_label_dsc_t *)dsc)->opa);
+		break;
+	case LV_DRAW_TASK_TYPE_IMAGE:
+	case LV_DRAW_TASK_TYPE_LAYER:
+		opaque(&((lv_draw_image_dsc_t *)dsc)->opa);
+		break;
+	default:
+		break;
+	}
+}
+
+/* primcache and kbdinc share the flag; keep it while they listen */
+static bool other_draw_task_cb(lv_obj_t *obj)
+{
+	lv_event_dsc_t *dsc;
+	uint32_t i;
+
+	for (i = 0; i < lv_obj_get_event_count(obj); i++) {
+		dsc = lv_obj_get_event_dsc(obj, i);
+		if (dsc->cb != draw_task_cb &&
+		    (dsc->filter & ~LV_EVENT_PREPROCESS) ==
+		    LV_EVENT_DRAW_TASK_ADDED) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static lv_obj_tree_walk_res_t hook_cb(lv_obj_t *obj, void *user_data)
+{
+	lv_obj_remove_event_cb(obj, draw_task_cb);
+	if (user_data) {
+		lv_obj_add_event_cb(obj, draw_task_cb,
+				    LV_EVENT_DRAW_TASK_ADDED, NULL);
+		lv_obj_add_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+	} else if (!other_draw_task_cb(obj)) {
+		lv_obj_remove_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+	}
+
+	return LV_OBJ_TREE_WALK_NEXT;
+}
+
+/*
+ * The draw task hook goes on when shadows and gradients go off and comes
+ * off when they come back; objects created in between get it at the next
+ * change. Levels that only toggle anti-aliasing or flatness touch no object.
+ */
+static void set_level(uint32_t level)
+{
+	lv_obj_t *scr = lv_display_get_screen_active(gov.disp);
+	bool hook = level >= GOVERNOR_NO_EFFECTS;
+
+	fprintf(stderr, "governor: %s -> %s (frame %u us, budget %u us)\n",
+		level_name[gov.level], level_name[level], gov.last_us,
+		gov.budget_us);
+
+	if (level > gov.level) {
+		gov.stats.degrades++;
+	} else {
+		gov.stats.restores++;
+	}
+
+	lv_display_set_antialiasing(gov.disp,
+			level < GOVERNOR_NO_AA ? tune.antialias : false);
+	if (hook != (gov.level >= GOVERNOR_NO_EFFECTS)) {
+		lv_obj_tree_walk(scr, hook_cb, (void *)(uintptr_t)hook);
+		lv_obj_tree_walk(lv_display_get_layer_top(gov.disp), hook_cb,
+				 (void *)(uintptr_t)hook);
+	}
+	lv_obj_invalidate(scr);
+
+	gov.level = level;
+	gov.stats.level = level;
+	gov.over = 0;
+	gov.under = 0;
+	gov.settle = true;
+}
+
+static void frame_done(uint32_t us)
+{
+	gov.last_us = us;
+	gov.stats.frames++;
+	gov.stats.last_us = us;
+	gov.stats.total_us += us;
+	if (us > gov.stats.max_us) {
+		gov.stats.max_us = us;
+	}
+	if (us > gov.budget_us) {
+		gov.stats.overruns++;
+	}
+
+	// The frame after a change redraws everything, do not judge it
+	if (!gov.active || gov.settle) {
+		gov.settle = false;
+		return;
+	}
+
+	if (us > gov.budget_us) {
+		gov.under = 0;
+		if (++gov.over >= tune.governor_degrade_frames &&
+		    gov.level < GOVERNOR_FLAT) {
+			gov.pending = gov.level + 1;
+		}
+	} else if (us < gov.budget_us / 4 * 3) {
+		gov.over = 0;
+		if (++gov.under >= tune.governor_restore_frames &&
+		    gov.level > GOVERNOR_FULL) {
+			gov.pending = gov.level - 1;
+		}
+	} else {
+		gov.over = 0;
+		gov.under = 0;
+	}
+}
+
+static void governor_event_cb(lv_event_t *e)
+{
+	switch (lv_event_get_code(e)) {
+	case LV_EVENT_REFR_START:
+		if (gov.pending != gov.level) {
+			set_level(gov.pending);
+		}
+		gov.rendered = false;
+		gov.start_us = bench_now_us();
+		break;
+	case LV_EVENT_RENDER_START:
+		gov.rendered = true;
+		break;
+	case LV_EVENT_REFR_READY:
+		if (gov.rendered) {
+			frame_done(bench_now_us() - gov.start_us);
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void governor_init(lv_display_t *disp)
+{
+	memset(&gov, 0, sizeof(gov));
+	gov.disp = disp;
+	gov.active = tune.governor;
+	gov.budget_us = (tune.governor_budget ? tune.governor_budget
+					      : tune.refr_period) * 1000;
+
+	lv_display_add_event_cb(disp, governor_event_cb, LV_EVENT_ALL, NULL);
+}
+
+/* Inactive: keep measuring, stop changing levels, and restore full quality */
+void governor_set_active(bool active)
+{
+	gov.active = active;
+	if (!active) {
+		gov.pending = GOVERNOR_FULL;
+	}
+}
+
+void governor_set_budget(uint32_t budget_us)
+{
+	gov.budget_us = budget_us;
+}
+
+void governor_reset_stats(void)
+{
+	memset(&gov.stats, 0, sizeof(gov.stats));
+	gov.stats.level = gov.level;
+}
+
+void governor_get_stats(struct governor_stats *stats)
+{
+	*stats = gov.stats;
+}
+
+/*
+ * Stress scenario: shadowed, gradient filled, rounded cards under a
+ * semi-transparent overlay, with a slider "drag" and a scrolling chart that
+ * force a full redraw each frame. The budget defaults to 3/4 of the
+ * ungoverned average so that the host is overloaded the same way a target is.
+ * Afterwards every level draws one frame while a second hook, added after
+ * the governor's, counts the shadow, gradient and translucent draw tasks that
+ * still reach the draw unit: none may be left where the level removes them.
+ */
+#define GOVERNOR_BENCH_FRAMES 600
+
+static lv_obj_t *bench_slider;
+static lv_obj_t *bench_chart;
+static lv_chart_series_t *bench_ser;
+
+static void bench_screen(lv_obj_t *scr)
+{
+	lv_obj_t *obj;
+	lv_obj_t *label;
+	int i;
+
+	for (i = 0; i < 12; i++) {
+		obj = lv_obj_create(scr);
+		lv_obj_set_size(obj, 70, 40);
+		lv_obj_set_pos(obj, 8 + (i % 4) * 78, 8 + (i / 4) * 48);
+		lv_obj_set_style_radius(obj, 10, 0);
+		lv_obj_set_style_shadow_width(obj, 16, 0);
+		lv_obj_set_style_bg_grad_color(obj, lv_palette_main(LV_PALETTE_BLUE), 0);
+		lv_obj_set_style_bg_grad_dir(obj, LV_GRAD_DIR_VER, 0);
+		label = lv_label_create(obj);
+		lv_label_set_text_fmt(label, "%d", i);
+		lv_obj_center(label);
+	}
+
+	obj = lv_obj_create(scr);
+	lv_obj_set_size(obj, 200, 80);
+	lv_obj_align(obj, LV_ALIGN_CENTER, 0, -20);
+	lv_obj_set_style_opa(obj, LV_OPA_50, 0);
+	lv_obj_set_style_radius(obj, 20, 0);
+
+	bench_chart = lv_chart_create(scr);
+	lv_obj_set_size(bench_chart, 200, 60);
+	lv_obj_align(bench_chart, LV_ALIGN_BOTTOM_LEFT, 4, -4);
+	lv_chart_set_point_count(bench_chart, 50);
+	bench_ser = lv_chart_add_series(bench_chart,
+					lv_palette_main(LV_PALETTE_RED),
+					LV_CHART_AXIS_PRIMARY_Y);
+
+	bench_slider = lv_slider_create(scr);
+	lv_obj_set_size(bench_slider, 100, 20);
+	lv_obj_align(bench_slider, LV_ALIGN_BOTTOM_RIGHT, -10, -24);
+}
+
+static void bench_frames_run(lv_display_t *disp, struct bench_frames *f)
+{
+	lv_obj_t *scr = lv_display_get_screen_active(disp);
+	uint64_t t0;
+	int i;
+
+	bench_frames_reset(f);
+	for (i = 0; i < GOVERNOR_BENCH_FRAMES; i++) {
+		lv_slider_set_value(bench_slider, i % 100, LV_ANIM_OFF);
+		lv_chart_set_next_value(bench_chart, bench_ser, rand() % 100);
+		lv_obj_invalidate(scr);
+		t0 = bench_now_us();
+		lv_refr_now(disp);
+		bench_frames_add(f, bench_now_us() - t0);
+	}
+}
+
+struct bench_tasks {
+	uint32_t shadows;
+	uint32_t gradients;
+	uint32_t translucent;
+};
+
+static void bench_count_cb(lv_event_t *e)
+{
+	struct bench_tasks *n = lv_event_get_user_data(e);
+	lv_draw_task_t *t = lv_event_get_draw_task(e);
+	lv_draw_fill_dsc_t *fill;
+
+	switch (lv_draw_task_get_type(t)) {
+	case LV_DRAW_TASK_TYPE_BOX_SHADOW:
+		n->shadows += ((lv_draw_box_shadow_dsc_t *)
+			       lv_draw_task_get_draw_dsc(t))->opa > LV_OPA_MIN;
+		break;
+	case LV_DRAW_TASK_TYPE_FILL:
+		fill = lv_draw_task_get_draw_dsc(t);
+		n->gradients += fill->grad.dir != LV_GRAD_DIR_NONE;
+		n->translucent += fill->opa > LV_OPA_MIN &&
+				  fill->opa < LV_OPA_COVER;
+		break;
+	default:
+		break;
+	}
+}
+
+static lv_obj_tree_walk_res_t bench_count_hook(lv_obj_t *obj, void *user_data)
+{
+	lv_obj_remove_event_cb(obj, bench_count_cb);
+	if (user_data) {
+		lv_obj_add_event_cb(obj, bench_count_cb,
+				    LV_EVENT_DRAW_TASK_ADDED, user_data);
+		lv_obj_add_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+	}
+
+	return LV_OBJ_TREE_WALK_NEXT;
+}
+
+static int bench_levels(lv_display_t *disp)
+{
+	lv_obj_t *scr = lv_display_get_screen_active(disp);
+	struct bench_tasks n;
+	int ret = 0;
+	uint32_t l;
+
+	gov.active = false;
+	for (l = GOVERNOR_FULL; l < GOVERNOR_LEVELS; l++) {
+		gov.pending = l;
+		lv_refr_now(disp);
+
+		memset(&n, 0, sizeof(n));
+		lv_obj_tree_walk(scr, bench_count_hook, &n);
+		lv_obj_invalidate(scr);
+		lv_refr_now(disp);
+		lv_obj_tree_walk(scr, bench_count_hook, NULL);
+
+		printf("%-10s %u shadows, %u gradients, %u translucent fills\n",
+		       level_name[l], n.shadows, n.gradients, n.translucent);
+		if (l >= GOVERNOR_NO_EFFECTS && (n.shadows || n.gradients)) {
+			ret = -1;
+		}
+		if (l >= GOVERNOR_FLAT && n.translucent) {
+			ret = -1;
+		}
+		if (l == GOVERNOR_FULL && (!n.shadows || !n.gradients)) {
+			ret = -1;
+		}
+	}
+	if (ret) {
+		printf("governor: draw tasks left at a level that drops them\n");
+	}
+
+	return ret;
+}
+
+int governor_bench(void)
+{
+	struct governor_stats stats;
+	struct bench_frames base;
+	struct bench_frames governed;
+	lv_display_t *disp;
+	uint32_t budget_us;
+	int ret;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	bench_screen(lv_display_get_screen_active(disp));
+	governor_init(disp);
+
+	governor_set_active(false);
+	bench_frames_run(disp, &base);
+	governor_get_stats(&stats);
+
+	budget_us = tune.governor_budget ? tune.governor_budget * 1000
+					 : base.total_us / base.count / 4 * 3;
+	governor_set_budget(budget_us);
+	printf("budget %u us\n", budget_us);
+
+	governor_reset_stats();
+	governor_set_active(true);
+	bench_frames_run(disp, &governed);
+	governor_get_stats(&stats);
+
+	bench_frames_print("ungoverned", &base);
+	bench_frames_print("governed", &governed);
+	printf("overruns %u  degrades %u  restores %u  final level %s\n",
+	       stats.overruns, stats.degrades, stats.restores,
+	       level_name[stats.level]);
+	printf("dropped %llu shadows, %llu gradients, %llu made opaque\n",
+	       (unsigned long long)stats.shadows,
+	       (unsigned long long)stats.gradients,
+	       (unsigned long long)stats.opaque);
+
+	ret = bench_levels(disp);
+
+	governor_set_active(false);
+	lv_refr_now(disp);
+	lv_display_remove_event_cb_with_user_data(disp, governor_event_cb, NULL);
+	bench_display_delete(disp);
+
+	return ret;
+}
@@ -0,0 +1,48 @@
+/*
+ * Frame deadline governor (adaptive render quality)
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+enum governor_level {
+	GOVERNOR_FULL = 0,	// everything LV_DRAW_SW_COMPLEX can do
+	GOVERNOR_NO_AA,		// anti-aliasing off
+	GOVERNOR_NO_EFFECTS,	// + shadows and gradients off
+	GOVERNOR_FLAT,		// + translucent draws made opaque
+	GOVERNOR_LEVELS,
+};
+
+struct governor_stats {
+	uint32_t frames;
+	uint32_t overruns;
+	uint32_t degrades;
+	uint32_t restores;
+	uint32_t level;
+	uint32_t last_us;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint64_t shadows;	// box shadow draw tasks dropped
+	uint64_t gradients;	// gradient fills drawn solid
+	uint64_t opaque;	// translucent draw tasks drawn opaque
+};
+
+void governor_init(lv_display_t *disp);
+void governor_set_active(bool active);
+void governor_set_budget(uint32_t budget_us);
+void governor_reset_stats(void);
+void governor_get_stats(struct governor_stats *stats);
+
+int governor_bench(void);
+
+#endif /* GOVERNOR_H */
@@ -0,0 +1,161 @@
+/*
+ * ILI9341 command level helpers (window writes, scrolling and rotation)
+ *
+ * Commands are handed to a send callback, so the same code drives a spidev
+ * transport or the mock panel used by the headless scenarios.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include "ili9341.h"
+
+static void send_range(struct ili9341 *lcd, uint8_t cmd, uint16_t start,
+		       uint16_t end)
+{
+	uint8_t param[4] = { start >> 8, start, end >> 8, end };
+
+	lcd->send(lcd->ctx, cmd, param, sizeof(param));
+}
+
+void ili9341_init(struct ili9341 *lcd, uint16_t hor_res, uint16_t ver_res,
+		  uint32_t px_size, ili9341_send_cb_t send, void *ctx)
+{
+	lcd->send = send;
+	lcd->ctx = ctx;
+	lcd->px_size = px_size;
+	lcd->hor_res = hor_res;
+	lcd->ver_res = ver_res;
+	lcd->tfa = 0;
+	lcd->vsa = ver_res;
+	lcd->bfa = 0;
+	lcd->vsp = 0;
+	lcd->vsp_next = 0;
+	lcd->madctl = ILI9341_MADCTL_BGR;
+	lcd->rotation = LV_DISPLAY_ROTATION_0;
+}
+
+/* Clockwise, matching lv_display_rotate_area() */
+void ili9341_set_rotation(struct ili9341 *lcd, lv_display_rotation_t rot)
+{
+	static const uint8_t scan[] = {
+		[LV_DISPLAY_ROTATION_0] = 0,
+		[LV_DISPLAY_ROTATION_90] = ILI9341_MADCTL_MV |
+					   ILI9341_MADCTL_MX,
+		[LV_DISPLAY_ROTATION_180] = ILI9341_MADCTL_MX |
+					    ILI9341_MADCTL_MY,
+		[LV_DISPLAY_ROTATION_270] = ILI9341_MADCTL_MV |
+					    ILI9341_MADCTL_MY,
+	};
+	uint16_t res;
+
+	// Scrolling is only used unrotated; leave the GRAM rows unscrolled
+	if (lcd->rotation == LV_DISPLAY_ROTATION_0 &&
+	    (lcd->vsa != lcd->ver_res || lcd->vsp_next != lcd->tfa)) {
+		ili9341_set_scroll_area(lcd, 0, lcd->ver_res);
+	}
+	if ((scan[rot] ^ scan[lcd->rotation]) & ILI9341_MADCTL_MV) {
+		res = lcd->hor_res;
+		lcd->hor_res = lcd->ver_res;
+		lcd->ver_res = res;
+	}
+	lcd->rotation = rot;
+	lcd->madctl = (lcd->madctl & ILI9341_MADCTL_BGR) | scan[rot];
+	lcd->send(lcd->ctx, ILI9341_MADCTL, &lcd->madctl, 1);
+}
+
+/* Redefining the scroll area resets the start address, so the caller must
+ * redraw everything afterwards. */
+void ili9341_set_scroll_area(struct ili9341 *lcd, uint16_t tfa, uint16_t vsa)
+{
+	uint8_t param[6];
+
+	lcd->tfa = tfa;
+	lcd->vsa = vsa;
+	lcd->bfa = lcd->ver_res - tfa - vsa;
+
+	param[0] = lcd->tfa >> 8;
+	param[1] = lcd->tfa;
+	param[2] = lcd->vsa >> 8;
+	param[3] = lcd->vsa;
+	param[4] = lcd->bfa >> 8;
+	param[5] = lcd->bfa;
+	lcd->send(lcd->ctx, ILI9341_VSCRDEF, param, sizeof(param));
+
+	lcd->vsp = lcd->vsp_next = tfa;
+	param[0] = tfa >> 8;
+	param[1] = tfa;
+	lcd->send(lcd->ctx, ILI9341_VSCRSADD, param, 2);
+}
+
+/* Move the scroll area content by dy rows (negative: up) */
+void ili9341_scroll(struct ili9341 *lcd, int32_t dy)
+{
+	int32_t ofs = (int32_t)lcd->vsp_next - lcd->tfa - dy;
+
+	ofs %= lcd->vsa;
+	if (ofs < 0) {
+		ofs += lcd->vsa;
+	}
+	lcd->vsp_next = lcd->tfa + ofs;
+}
+
+/* Show the new start address once the exposed rows are in GRAM */
+void ili9341_commit(struct ili9341 *lcd)
+{
+	uint8_t param[2] = { lcd->vsp_next >> 8, lcd->vsp_next };
+
+	if (lcd->vsp == lcd->vsp_next) {
+		return;
+	}
+	lcd->send(lcd->ctx, ILI9341_VSCRSADD, param, sizeof(param));
+	lcd->vsp = lcd->vsp_next;
+}
+
+uint16_t ili9341_gram_row(const struct ili9341 *lcd, uint16_t row,
+			  uint16_t vsp)
+{
+	if (row < lcd->tfa || row >= lcd->tfa + lcd->vsa) {
+		return row;
+	}
+
+	return lcd->tfa + (vsp - lcd->tfa + row - lcd->tfa) % lcd->vsa;
+}
+
+/*
+ * Write an area, translating panel rows into GRAM rows. Each run of rows that
+ * is contiguous in GRAM costs one CASET/PASET/RAMWR sequence, so an area only
+ * splits where it crosses the scroll area wrap point or its edges.
+ */
+void ili9341_write(struct ili9341 *lcd, const lv_area_t *area,
+		   const uint8_t *px_map, uint32_t stride)
+{
+	uint32_t row_bytes = (area->x2 - area->x1 + 1) * lcd->px_size;
+	int32_t y = area->y1;
+	int32_t end;
+	uint16_t g;
+
+	send_range(lcd, ILI9341_CASET, area->x1, area->x2);
+
+	while (y <= area->y2) {
+		g = ili9341_gram_row(lcd, y, lcd->vsp_next);
+		end = y;
+		while (end < area->y2 &&
+		       ili9341_gram_row(lcd, end + 1, lcd->vsp_next) ==
+		       g + (end + 1 - y)) {
+			end++;
+		}
+		if (stride != row_bytes) {
+			end = y;
+		}
+
+		send_range(lcd, ILI9341_PASET, g, g + (end - y));
+		lcd->send(lcd->ctx, ILI9341_RAMWR, px_map,
+			  row_bytes * (end - y + 1));
+
+		px_map += stride * (end - y + 1);
+		y = end + 1;
+	}
+}
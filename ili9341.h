@@ -0,0 +1,69 @@
+/*
+ * ILI9341 command level helpers (window writes, scrolling and rotation)
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef ILI9341_H
+#define ILI9341_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+#define ILI9341_CASET		0x2A
+#define ILI9341_PASET		0x2B
+#define ILI9341_RAMWR		0x2C
+#define ILI9341_VSCRDEF		0x33
+#define ILI9341_VSCRSADD	0x37
+#define ILI9341_MADCTL		0x36
+
+#define ILI9341_MADCTL_MY	0x80	// row address order
+#define ILI9341_MADCTL_MX	0x40	// column address order
+#define ILI9341_MADCTL_MV	0x20	// row/column exchange
+#define ILI9341_MADCTL_BGR	0x08
+
+typedef void (*ili9341_send_cb_t)(void *ctx, uint8_t cmd,
+				  const uint8_t *param, size_t len);
+
+/*
+ * Vertical scrolling splits the panel into a top fixed area (tfa rows), a
+ * scroll area (vsa rows) and a bottom fixed area (bfa rows). Row r of the
+ * scroll area shows GRAM row tfa + ((vsp - tfa + r - tfa) mod vsa).
+ */
+struct ili9341 {
+	ili9341_send_cb_t send;
+	void *ctx;
+	uint32_t px_size;
+	uint16_t hor_res;
+	uint16_t ver_res;
+	uint16_t tfa;
+	uint16_t vsa;
+	uint16_t bfa;
+	uint16_t vsp;		// last sent with VSCRSADD
+	uint16_t vsp_next;	// used by writes of the frame being drawn
+	uint8_t madctl;		// last sent with MADCTL
+	lv_display_rotation_t rotation;	// of the scan relative to init
+};
+
+void ili9341_init(struct ili9341 *lcd, uint16_t hor_res, uint16_t ver_res,
+		  uint32_t px_size, ili9341_send_cb_t send, void *ctx);
+/*
+ * Let the panel's address generator rotate: hor_res and ver_res become the
+ * rotated size and writes need no pixel shuffling. Vertical scrolling works
+ * on GRAM rows, so it is only used at LV_DISPLAY_ROTATION_0.
+ */
+void ili9341_set_rotation(struct ili9341 *lcd, lv_display_rotation_t rot);
+void ili9341_set_scroll_area(struct ili9341 *lcd, uint16_t tfa, uint16_t vsa);
+void ili9341_scroll(struct ili9341 *lcd, int32_t dy);
+void ili9341_commit(struct ili9341 *lcd);
+uint16_t ili9341_gram_row(const struct ili9341 *lcd, uint16_t row,
+			  uint16_t vsp);
+void ili9341_write(struct ili9341 *lcd, const lv_area_t *area,
+		   const uint8_t *px_map, uint32_t stride);
+
+#endif /* ILI9341_H */
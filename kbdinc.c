@@ -0,0 +1,973 @@
+/*
+ * Key level redraws for button matrices and keyboards
+ *
+ * lv_buttonmatrix draws its keys itself and invalidates just the key cells
+ * it selects, but a press or release also adds or removes LV_STATE_PRESSED
+ * on the whole matrix. The theme styles LV_PART_ITEMS | LV_STATE_PRESSED,
+ * so LVGL's style state compare reports a redraw and invalidates the whole
+ * object twice, before and after the change: every keystroke on a
+ * 320x240 lv_keyboard redraws and flushes the keyboard, though only the
+ * selected key looks different.
+ *
+ * lv_obj_add_state(), lv_obj_remove_state(), lv_obj_set_state() and
+ * lv_obj_invalidate() are wrapped at link time (-Wl,--wrap=...). A wrap
+ * only sees calls between translation units: the matrix and indev code
+ * calling into lv_obj.c is seen, lv_obj_add_state() calling
+ * lv_obj_set_state() inside lv_obj.c is not, hence all three setters. That
+ * suffices here because every change to catch enters through them. The
+ * same wrappers flush objscale's style value cache.
+ *
+ * While the PRESSED state of an attached matrix changes, and none of its
+ * styles ties a part other than the items to PRESSED, the whole object
+ * invalidation is replaced with the selected key's cell grown by the gaps,
+ * as LVGL's own per key invalidation does. The matrix's press and release
+ * handlers add the cells of the keys whose selection changed. Map, size and
+ * style changes still redraw everything.
+ *
+ * After kbdinc_init() each key face, the draw tasks of one key of the items
+ * part, is also rendered once per look into an ARGB8888 bitmap of its cell,
+ * keyed by the matrix, key text, control bits, state, cell size and
+ * inherited opacity. The next time the key is drawn the bitmap is blended
+ * in its place and LVGL's tasks are left with zero opacity. Faces are
+ * captured from keys drawn whole within one render area and rendered after
+ * the frame; keys with an outline or shadow past their cell stay with LVGL.
+ * Bitmaps live outside the LVGL heap under a byte budget and are evicted
+ * least recently used first.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "kbdinc.h"
+#include "objscale.h"
+
+#include "lvgl/src/core/lv_obj_class_private.h"
+#include "lvgl/src/core/lv_obj_private.h"
+#include "lvgl/src/misc/lv_area_private.h"
+#include "lvgl/src/widgets/buttonmatrix/lv_buttonmatrix_private.h"
+
+#define KBDINC_RECORDS	8	// faces captured per frame
+#define KBDINC_TASKS	6	// draw tasks of one face
+#define KBDINC_ALIGN	64
+
+// Matrix states LVGL hands down to the selected key only
+#define KBDINC_SEL_STATES	(LV_STATE_PRESSED | LV_STATE_FOCUSED | \
+				 LV_STATE_FOCUS_KEY | LV_STATE_EDITED)
+
+struct face {
+	lv_draw_buf_t buf;	// ARGB8888, one key cell
+	uint8_t *data;		// NULL: drawn by LVGL
+	const lv_obj_t *obj;	// NULL: free
+	uint64_t key;
+	uint32_t bytes;
+	uint32_t last;		// frame of the last use
+};
+
+struct record {
+	const lv_obj_t *obj;
+	uint64_t key;
+	lv_area_t cell;
+	uint32_t n;
+	bool bad;		// a task LVGL has to draw
+	struct {
+		lv_draw_task_type_t type;
+		lv_area_t area;
+		union {
+			lv_draw_dsc_base_t base;
+			lv_draw_fill_dsc_t fill;
+			lv_draw_border_dsc_t border;
+			lv_draw_box_shadow_dsc_t shadow;
+			lv_draw_label_dsc_t label;
+		} dsc;
+	} task[KBDINC_TASKS];
+};
+
+static struct {
+	lv_obj_t *objs[KBDINC_OBJS];
+	const lv_obj_t *changing;	// attached, its PRESSED state changing
+	lv_display_t *disp;
+	lv_obj_t *canvas;
+	uint32_t budget;
+	uint32_t frame;
+	// Key whose draw tasks are being added
+	const lv_obj_t *main;
+	const lv_obj_t *draw_obj;
+	uint32_t draw_id;
+	struct face *draw_face;
+	struct record *draw_rec;
+	struct record recs[KBDINC_RECORDS];
+	uint32_t nrecs;
+	struct face faces[KBDINC_FACES];
+	struct kbdinc_stats stats;
+} kc;
+
+static bool attached(const lv_obj_t *obj)
+{
+	int i;
+
+	for (i = 0; obj && i < KBDINC_OBJS; i++) {
+		if (kc.objs[i] == obj) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/* Only the items may depend on PRESSED, and only the selected one does */
+static bool press_only(const lv_obj_t *obj, lv_state_t state)
+{
+	lv_style_selector_t sel;
+	uint32_t i;
+
+	if (state != LV_STATE_PRESSED || !attached(obj)) {
+		return false;
+	}
+	for (i = 0; i < obj->style_cnt; i++) {
+		sel = obj->styles[i].selector;
+		if ((lv_obj_style_get_selector_state(sel) & LV_STATE_PRESSED) &&
+		    lv_obj_style_get_selector_part(sel) != LV_PART_ITEMS) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* The cell with the gaps around it, for outlines and shadows */
+static void invalidate_key(const lv_obj_t *obj, uint32_t id)
+{
+	const lv_buttonmatrix_t *btnm = (const lv_buttonmatrix_t *)obj;
+	int32_t dpi = lv_display_get_dpi(lv_obj_get_display(obj));
+	int32_t row = lv_obj_get_style_pad_row(obj, LV_PART_MAIN);
+	int32_t col = lv_obj_get_style_pad_column(obj, LV_PART_MAIN);
+	lv_area_t a;
+
+	if (id >= btnm->btn_cnt) {
+		return;
+	}
+	a = btnm->button_areas[id];
+	lv_area_move(&a, obj->coords.x1, obj->coords.y1);
+	lv_area_increase(&a, LV_MAX(col, dpi / 10), LV_MAX(row, dpi / 10));
+	lv_obj_invalidate_area(obj, &a);
+}
+
+void __real_lv_obj_add_state(lv_obj_t *obj, lv_state_t state);
+void __real_lv_obj_remove_state(lv_obj_t *obj, lv_state_t state);
+void __real_lv_obj_set_state(lv_obj_t *obj, lv_state_t state, bool v);
+void __real_lv_obj_invalidate(const lv_obj_t *obj);
+
+void __wrap_lv_obj_add_state(lv_obj_t *obj, lv_state_t state)
+{
+	const lv_obj_t *prev = kc.changing;
+
+	if (press_only(obj, state)) {
+		kc.changing = obj;
+	}
+	__real_lv_obj_add_state(obj, state);
+	kc.changing = prev;
+	objscale_cache_flush();
+}
+
+void __wrap_lv_obj_remove_state(lv_obj_t *obj, lv_state_t state)
+{
+	const lv_obj_t *prev = kc.changing;
+
+	if (press_only(obj, state)) {
+		kc.changing = obj;
+	}
+	__real_lv_obj_remove_state(obj, state);
+	kc.changing = prev;
+	objscale_cache_flush();
+}
+
+void __wrap_lv_obj_set_state(lv_obj_t *obj, lv_state_t state, bool v)
+{
+	const lv_obj_t *prev = kc.changing;
+
+	if (press_only(obj, state)) {
+		kc.changing = obj;
+	}
+	__real_lv_obj_set_state(obj, state, v);
+	kc.changing = prev;
+	objscale_cache_flush();
+}
+
+void __wrap_lv_obj_invalidate(const lv_obj_t *obj)
+{
+	objscale_cache_flush();
+	if (!obj || obj != kc.changing) {
+		__real_lv_obj_invalidate(obj);
+		return;
+	}
+	kc.stats.narrowed++;
+	invalidate_key(obj, ((const lv_buttonmatrix_t *)obj)->btn_id_sel);
+}
+
+static uint64_t mix(uint64_t h, const void *p, size_t n)
+{
+	const uint8_t *b = p;
+
+	while (n--) {
+		h = (h ^ *b++) * 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+/* Everything LVGL builds the key's draw descriptors from */
+static uint64_t face_key(const lv_obj_t *obj, uint32_t id,
+			 const lv_area_t *cell)
+{
+	const lv_buttonmatrix_t *btnm = (const lv_buttonmatrix_t *)obj;
+	const char *text = lv_buttonmatrix_get_button_text(obj, id);
+	lv_opa_t opa = lv_obj_get_style_opa_recursive(obj, LV_PART_ITEMS);
+	lv_state_t state = obj->state;
+	int32_t w = lv_area_get_width(cell);
+	int32_t h = lv_area_get_height(cell);
+	uint64_t k = 0xcbf29ce484222325ULL;
+
+	if (id != btnm->btn_id_sel) {
+		state &= ~KBDINC_SEL_STATES;
+	}
+	text = text ? text : "";
+	k = mix(k, &obj, sizeof(obj));
+	k = mix(k, text, strlen(text) + 1);
+	k = mix(k, &btnm->ctrl_bits[id], sizeof(btnm->ctrl_bits[id]));
+	k = mix(k, &state, sizeof(state));
+	k = mix(k, &w, sizeof(w));
+	k = mix(k, &h, sizeof(h));
+
+	return mix(k, &opa, sizeof(opa));
+}
+
+static void face_free(struct face *f)
+{
+	if (f->data) {
+		lv_image_cache_drop(&f->buf);
+		free(f->data);
+		kc.stats.bytes -= f->bytes;
+	}
+	kc.stats.entries--;
+	memset(f, 0, sizeof(*f));
+}
+
+static void flush(const lv_obj_t *obj)
+{
+	int i;
+
+	for (i = 0; i < KBDINC_FACES; i++) {
+		if (kc.faces[i].obj && (!obj || kc.faces[i].obj == obj)) {
+			face_free(&kc.faces[i]);
+		}
+	}
+}
+
+static struct face *lookup(const lv_obj_t *obj, uint64_t key)
+{
+	int i;
+
+	for (i = 0; i < KBDINC_FACES; i++) {
+		if (kc.faces[i].obj == obj && kc.faces[i].key == key) {
+			return &kc.faces[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Least recently used face not drawn in the current frame */
+static struct face *lru(void)
+{
+	struct face *victim = NULL;
+	int i;
+
+	for (i = 0; i < KBDINC_FACES; i++) {
+		struct face *f = &kc.faces[i];
+
+		if (f->obj && f->last != kc.frame &&
+		    (!victim || f->last < victim->last)) {
+			victim = f;
+		}
+	}
+
+	return victim;
+}
+
+static struct face *face_alloc(uint32_t bytes)
+{
+	struct face *f = NULL;
+	struct face *victim;
+	int i;
+
+	while (kc.stats.bytes + bytes > kc.budget && (victim = lru())) {
+		kc.stats.evictions++;
+		face_free(victim);
+	}
+	for (i = 0; i < KBDINC_FACES && !f; i++) {
+		f = kc.faces[i].obj ? NULL : &kc.faces[i];
+	}
+	if (!f && (victim = lru())) {
+		kc.stats.evictions++;
+		face_free(victim);
+		f = victim;
+	}
+	if (!f || kc.stats.bytes + bytes > kc.budget) {
+		return NULL;
+	}
+	if (bytes) {
+		f->data = aligned_alloc(KBDINC_ALIGN,
+					LV_ALIGN_UP(bytes, KBDINC_ALIGN));
+		if (!f->data) {
+			return NULL;
+		}
+	}
+	f->bytes = bytes;
+	f->last = kc.frame;
+	kc.stats.entries++;
+	kc.stats.bytes += bytes;
+	kc.stats.peak = LV_MAX(kc.stats.peak, kc.stats.bytes);
+
+	return f;
+}
+
+/* Replay the captured tasks into a bitmap of the cell */
+static void render(const struct record *r)
+{
+	int32_t w = lv_area_get_width(&r->cell);
+	int32_t h = lv_area_get_height(&r->cell);
+	uint32_t stride = lv_draw_buf_width_to_stride(w,
+					LV_COLOR_FORMAT_ARGB8888);
+	struct face *f;
+	lv_layer_t layer;
+	lv_area_t a;
+	uint32_t i;
+
+	if (lookup(r->obj, r->key)) {
+		return;
+	}
+	f = face_alloc(r->bad ? 0 : stride * h);
+	if (!f) {
+		kc.stats.bypass++;
+		return;
+	}
+	f->obj = r->obj;
+	f->key = r->key;
+	if (r->bad) {
+		return;
+	}
+
+	memset(f->data, 0, f->bytes);
+	lv_draw_buf_init(&f->buf, w, h, LV_COLOR_FORMAT_ARGB8888, stride,
+			 f->data, f->bytes);
+	lv_canvas_set_draw_buf(kc.canvas, &f->buf);
+	lv_canvas_init_layer(kc.canvas, &layer);
+	for (i = 0; i < r->n; i++) {
+		a = r->task[i].area;
+		lv_area_move(&a, -r->cell.x1, -r->cell.y1);
+		switch (r->task[i].type) {
+		case LV_DRAW_TASK_TYPE_FILL:
+			lv_draw_fill(&layer, &r->task[i].dsc.fill, &a);
+			break;
+		case LV_DRAW_TASK_TYPE_BORDER:
+			lv_draw_border(&layer, &r->task[i].dsc.border, &a);
+			break;
+		case LV_DRAW_TASK_TYPE_BOX_SHADOW:
+			lv_draw_box_shadow(&layer, &r->task[i].dsc.shadow, &a);
+			break;
+		case LV_DRAW_TASK_TYPE_LABEL:
+			lv_draw_label(&layer, &r->task[i].dsc.label, &a);
+			break;
+		default:
+			break;
+		}
+	}
+	lv_canvas_finish_layer(kc.canvas, &layer);
+	kc.stats.misses++;
+}
+
+static void record(struct record *r, lv_draw_task_t *t,
+		   const lv_draw_dsc_base_t *base)
+{
+	lv_draw_task_type_t type = lv_draw_task_get_type(t);
+	lv_area_t a;
+	size_t size;
+
+	lv_draw_task_get_area(t, &a);
+	if (r->bad || r->n == KBDINC_TASKS || !lv_area_is_in(&a, &r->cell, 0)) {
+		r->bad = true;
+		return;
+	}
+	switch (type) {
+	case LV_DRAW_TASK_TYPE_FILL:
+		size = sizeof(lv_draw_fill_dsc_t);
+		break;
+	case LV_DRAW_TASK_TYPE_BORDER:
+		size = sizeof(lv_draw_border_dsc_t);
+		break;
+	case LV_DRAW_TASK_TYPE_BOX_SHADOW:
+		size = sizeof(lv_draw_box_shadow_dsc_t);
+		break;
+	case LV_DRAW_TASK_TYPE_LABEL:
+		size = sizeof(lv_draw_label_dsc_t);
+		// The text must still be there after the frame
+		if (((const lv_draw_label_dsc_t *)base)->text_local) {
+			r->bad = true;
+			return;
+		}
+		break;
+	default:
+		r->bad = true;
+		return;
+	}
+	memcpy(&r->task[r->n].dsc, base, size);
+	// Replayed tasks must not come back here
+	r->task[r->n].dsc.base.obj = NULL;
+	r->task[r->n].type = type;
+	r->task[r->n].area = a;
+	r->n++;
+}
+
+static void mute(lv_draw_task_t *t, lv_draw_dsc_base_t *base)
+{
+	switch (lv_draw_task_get_type(t)) {
+	case LV_DRAW_TASK_TYPE_FILL:
+		((lv_draw_fill_dsc_t *)base)->opa = LV_OPA_TRANSP;
+		break;
+	case LV_DRAW_TASK_TYPE_BORDER:
+		((lv_draw_border_dsc_t *)base)->opa = LV_OPA_TRANSP;
+		break;
+	case LV_DRAW_TASK_TYPE_BOX_SHADOW:
+		((lv_draw_box_shadow_dsc_t *)base)->opa = LV_OPA_TRANSP;
+		break;
+	case LV_DRAW_TASK_TYPE_LABEL:
+		((lv_draw_label_dsc_t *)base)->opa = LV_OPA_TRANSP;
+		break;
+	default:
+		break;
+	}
+}
+
+/* First task of a key: draw its face, or capture it */
+static void key_begin(const lv_obj_t *obj, lv_draw_dsc_base_t *base)
+{
+	const lv_buttonmatrix_t *btnm = (const lv_buttonmatrix_t *)obj;
+	uint32_t id = base->id1;
+	lv_draw_image_dsc_t dsc;
+	struct record *r;
+	lv_area_t cell;
+	uint64_t key;
+	uint32_t i;
+
+	kc.draw_obj = obj;
+	kc.draw_id = id;
+	kc.draw_face = NULL;
+	kc.draw_rec = NULL;
+	if (id >= btnm->btn_cnt) {
+		return;
+	}
+	cell = btnm->button_areas[id];
+	lv_area_move(&cell, obj->coords.x1, obj->coords.y1);
+	key = face_key(obj, id, &cell);
+
+	kc.draw_face = lookup(obj, key);
+	if (kc.draw_face) {
+		kc.draw_face->last = kc.frame;
+		if (!kc.draw_face->data) {
+			kc.draw_face = NULL;
+			kc.stats.bypass++;
+			return;
+		}
+		lv_draw_image_dsc_init(&dsc);
+		dsc.src = &kc.draw_face->buf;
+		lv_draw_image(base->layer, &dsc, &cell);
+		kc.stats.hits++;
+		return;
+	}
+
+	if (kc.nrecs == KBDINC_RECORDS ||
+	    !lv_area_is_in(&cell, &base->layer->_clip_area, 0)) {
+		return;
+	}
+	for (i = 0; i < kc.nrecs; i++) {
+		if (kc.recs[i].obj == obj && kc.recs[i].key == key) {
+			return;
+		}
+	}
+	r = &kc.recs[kc.nrecs++];
+	r->obj = obj;
+	r->key = key;
+	r->cell = cell;
+	r->n = 0;
+	r->bad = false;
+	kc.draw_rec = r;
+}
+
+static void draw_task(const lv_obj_t *obj, lv_draw_task_t *t)
+{
+	lv_draw_dsc_base_t *base = lv_draw_task_get_draw_dsc(t);
+
+	if (!kc.disp || kc.main != obj || base->part != LV_PART_ITEMS) {
+		return;
+	}
+	if (obj != kc.draw_obj || base->id1 != kc.draw_id) {
+		key_begin(obj, base);
+	}
+	if (kc.draw_face) {
+		mute(t, base);
+	} else if (kc.draw_rec) {
+		record(kc.draw_rec, t, base);
+	}
+}
+
+static void obj_event_cb(lv_event_t *e)
+{
+	lv_obj_t *obj = lv_event_get_current_target_obj(e);
+	int i;
+
+	switch (lv_event_get_code(e)) {
+	case LV_EVENT_DRAW_MAIN_BEGIN:
+		kc.main = obj;
+		kc.draw_obj = NULL;
+		break;
+	case LV_EVENT_DRAW_MAIN_END:
+		kc.main = NULL;
+		kc.draw_obj = NULL;
+		break;
+	case LV_EVENT_DRAW_TASK_ADDED:
+		draw_task(obj, lv_event_get_draw_task(e));
+		break;
+	case LV_EVENT_STYLE_CHANGED:
+		flush(obj);
+		break;
+	case LV_EVENT_DELETE:
+		// The event list goes with the object
+		flush(obj);
+		for (i = 0; i < KBDINC_OBJS; i++) {
+			if (kc.objs[i] == obj) {
+				kc.objs[i] = NULL;
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void ready_cb(lv_event_t *e)
+{
+	uint32_t i;
+
+	for (i = 0; i < kc.nrecs; i++) {
+		render(&kc.recs[i]);
+	}
+	kc.nrecs = 0;
+	kc.draw_obj = NULL;
+	kc.frame++;
+	kc.stats.frames++;
+}
+
+int kbdinc_init(lv_display_t *disp, uint32_t budget)
+{
+	lv_display_t *def = lv_display_get_default();
+
+	if (kc.disp) {
+		return -EBUSY;
+	}
+	// Never loaded: a screen of its own keeps it out of every refresh
+	lv_display_set_default(disp);
+	kc.canvas = lv_canvas_create(NULL);
+	lv_display_set_default(def);
+	if (!kc.canvas) {
+		return -ENOMEM;
+	}
+	memset(kc.faces, 0, sizeof(kc.faces));
+	memset(&kc.stats, 0, sizeof(kc.stats));
+	kc.nrecs = 0;
+	kc.budget = budget;
+	kc.frame = 1;
+	kc.disp = disp;
+	lv_display_add_event_cb(disp, ready_cb, LV_EVENT_REFR_READY, NULL);
+
+	return 0;
+}
+
+/* Call between frames; attached objects keep their key level redraws */
+void kbdinc_deinit(void)
+{
+	if (!kc.disp) {
+		return;
+	}
+	lv_display_remove_event_cb_with_user_data(kc.disp, ready_cb, NULL);
+	flush(NULL);
+	lv_obj_delete(kc.canvas);
+	kc.canvas = NULL;
+	kc.nrecs = 0;
+	kc.draw_obj = NULL;
+	kc.disp = NULL;
+}
+
+int kbdinc_attach(lv_obj_t *obj)
+{
+	const lv_obj_class_t *c = lv_obj_get_class(obj);
+	int i;
+
+	while (c && c != &lv_buttonmatrix_class) {
+		c = c->base_class;
+	}
+	if (!c) {
+		return -EINVAL;
+	}
+	if (attached(obj)) {
+		return 0;
+	}
+	for (i = 0; i < KBDINC_OBJS && kc.objs[i]; i++) {
+	}
+	if (i == KBDINC_OBJS) {
+		return -ENOSPC;
+	}
+	kc.objs[i] = obj;
+	lv_obj_add_event_cb(obj, obj_event_cb, LV_EVENT_ALL, NULL);
+	lv_obj_add_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+
+	return 0;
+}
+
+void kbdinc_detach(lv_obj_t *obj)
+{
+	int i;
+
+	for (i = 0; i < KBDINC_OBJS; i++) {
+		if (kc.objs[i] == obj) {
+			kc.objs[i] = NULL;
+			lv_obj_remove_event_cb(obj, obj_event_cb);
+			lv_obj_remove_flag(obj,
+					   LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+			flush(obj);
+			lv_obj_invalidate(obj);
+		}
+	}
+}
+
+void kbdinc_get_stats(struct kbdinc_stats *stats)
+{
+	*stats = kc.stats;
+}
+
+/* Counters only; cached faces stay */
+void kbdinc_reset(void)
+{
+	kc.stats.narrowed = 0;
+	kc.stats.hits = 0;
+	kc.stats.misses = 0;
+	kc.stats.evictions = 0;
+	kc.stats.bypass = 0;
+	kc.stats.frames = 0;
+	kc.stats.peak = kc.stats.bytes;
+}
+
+static double hit_pct(const struct kbdinc_stats *st)
+{
+	uint64_t n = st->hits + st->misses + st->bypass;
+
+	return n ? 100.0 * st->hits / n : 0.0;
+}
+
+void kbdinc_report(FILE *fp)
+{
+	struct kbdinc_stats st;
+
+	kbdinc_get_stats(&st);
+	fprintf(fp, "kbdinc: %llu invalidations cut to a key, faces %.1f%% "
+		"hits, %llu rendered, %llu evictions, %llu bypassed\n",
+		(unsigned long long)st.narrowed, hit_pct(&st),
+		(unsigned long long)st.misses,
+		(unsigned long long)st.evictions,
+		(unsigned long long)st.bypass);
+	fprintf(fp, "  %u faces, %u bytes (peak %u) of %u\n", st.entries,
+		st.bytes, st.peak, kc.budget);
+}
+
+/*
+ * Benchmark: a text area above an lv_keyboard on the 320x240 panel, and a
+ * typing trace replayed through a pointer at the key centres (backspaces
+ * and the "1#"/"abc" mode keys included), refreshed after each press and
+ * each release. Pixels flushed per keystroke and the refresh times of the
+ * press (key feedback) and of the release (character shown), by LVGL
+ * alone, with key level invalidation and with cached faces too. The text
+ * must come out as typed and both later passes must flush fewer pixels
+ * than LVGL. With key level invalidation every frame must be identical to
+ * LVGL's; with faces, which blend once more, the last frame must match to
+ * rounding and the frames that differ are counted.
+ */
+#define KBDINC_BENCH_BUDGET	(512 * 1024)
+#define KBDINC_BENCH_TRACE	"lvgl on spi\b\b\bili9341 at 320x240, " \
+				"typed key by key."
+#define KBDINC_BENCH_ROUNDS	4
+// Two keys per character at most, two refreshes per key
+#define KBDINC_BENCH_REFRESHES	(sizeof(KBDINC_BENCH_TRACE) * \
+				 KBDINC_BENCH_ROUNDS * 4)
+
+static struct {
+	lv_point_t point;
+	lv_indev_state_t state;
+	bool record;		// LVGL pass: keep each frame's hash
+	uint32_t frames;
+	uint32_t differ;	// frames unlike LVGL's
+	uint64_t hash[KBDINC_BENCH_REFRESHES];
+} bench;
+
+static uint64_t fb_hash(lv_display_t *disp)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	uint32_t stride;
+	uint8_t *fb = bench_display_framebuffer(disp, &stride);
+	size_t i;
+
+	for (i = 0; i < (size_t)stride * BENCH_VER_RES; i++) {
+		h = (h ^ fb[i]) * 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+/* Outside the timed refresh: record or check the frame just drawn */
+static void bench_check(lv_display_t *disp)
+{
+	uint64_t h;
+
+	if (bench.frames >= KBDINC_BENCH_REFRESHES) {
+		return;
+	}
+	h = fb_hash(disp);
+	if (bench.record) {
+		bench.hash[bench.frames] = h;
+	} else {
+		bench.differ += bench.hash[bench.frames] != h;
+	}
+	bench.frames++;
+}
+
+static void bench_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+	data->point = bench.point;
+	data->state = bench.state;
+}
+
+static uint32_t bench_find(lv_obj_t *kb, const char *text)
+{
+	const lv_buttonmatrix_t *btnm = (const lv_buttonmatrix_t *)kb;
+	const char *t;
+	uint32_t i;
+
+	for (i = 0; i < btnm->btn_cnt; i++) {
+		t = lv_buttonmatrix_get_button_text(kb, i);
+		if (t && !strcmp(t, text)) {
+			return i;
+		}
+	}
+
+	return LV_BUTTONMATRIX_BUTTON_NONE;
+}
+
+/* Press and release key id, one refresh each */
+static void bench_key(lv_display_t *disp, lv_indev_t *indev, lv_obj_t *kb,
+		      uint32_t id, struct bench_frames *press,
+		      struct bench_frames *release)
+{
+	const lv_buttonmatrix_t *btnm = (const lv_buttonmatrix_t *)kb;
+	lv_area_t a = btnm->button_areas[id];
+	uint64_t t0;
+
+	lv_area_move(&a, kb->coords.x1, kb->coords.y1);
+	bench.point.x = (a.x1 + a.x2) / 2;
+	bench.point.y = (a.y1 + a.y2) / 2;
+
+	t0 = bench_now_us();
+	bench.state = LV_INDEV_STATE_PRESSED;
+	lv_indev_read(indev);
+	lv_refr_now(disp);
+	bench_frames_add(press, bench_now_us() - t0);
+	bench_check(disp);
+
+	t0 = bench_now_us();
+	bench.state = LV_INDEV_STATE_RELEASED;
+	lv_indev_read(indev);
+	lv_refr_now(disp);
+	bench_frames_add(release, bench_now_us() - t0);
+	bench_check(disp);
+}
+
+/* Type one character, switching the keyboard mode first if needed */
+static uint32_t bench_type(lv_display_t *disp, lv_indev_t *indev,
+			   lv_obj_t *kb, char c, struct bench_frames *press,
+			   struct bench_frames *release)
+{
+	char text[2] = { c, '\0' };
+	const char *s = c == '\b' ? LV_SYMBOL_BACKSPACE : text;
+	uint32_t id = bench_find(kb, s);
+	uint32_t keys = 1;
+
+	if (id == LV_BUTTONMATRIX_BUTTON_NONE) {
+		id = bench_find(kb, "1#");
+		if (id == LV_BUTTONMATRIX_BUTTON_NONE) {
+			id = bench_find(kb, "abc");
+		}
+		if (id == LV_BUTTONMATRIX_BUTTON_NONE) {
+			return 0;
+		}
+		bench_key(disp, indev, kb, id, press, release);
+		id = bench_find(kb, s);
+		if (id == LV_BUTTONMATRIX_BUTTON_NONE) {
+			return 0;
+		}
+		keys++;
+	}
+	bench_key(disp, indev, kb, id, press, release);
+
+	return keys;
+}
+
+/* The first pass, LVGL's, sets the reference frames and lvgl_px */
+static int bench_pass(const char *label, bool cells, uint32_t budget,
+		      uint8_t **ref, uint32_t tolerance, double *lvgl_px)
+{
+	struct bench_frames press, release;
+	char expect[sizeof(KBDINC_BENCH_TRACE) * KBDINC_BENCH_ROUNDS];
+	struct kbdinc_stats st;
+	lv_display_t *disp;
+	lv_indev_t *indev;
+	lv_obj_t *ta, *kb;
+	uint64_t px, kb_px;
+	uint32_t keys = 0, n, diff, max;
+	const char *c;
+	size_t len = 0;
+	int round;
+	int ret = 0;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	indev = lv_indev_create();
+	if (!indev) {
+		bench_display_delete(disp);
+		return -1;
+	}
+	lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
+	lv_indev_set_read_cb(indev, bench_read_cb);
+	lv_indev_set_display(indev, disp);
+	bench.state = LV_INDEV_STATE_RELEASED;
+
+	ta = lv_textarea_create(lv_display_get_screen_active(disp));
+	lv_obj_set_size(ta, BENCH_HOR_RES - 20, 90);
+	lv_obj_align(ta, LV_ALIGN_TOP_MID, 0, 10);
+	kb = lv_keyboard_create(lv_display_get_screen_active(disp));
+	lv_keyboard_set_textarea(kb, ta);
+	if (cells) {
+		kbdinc_attach(kb);
+	}
+	if (budget) {
+		kbdinc_init(disp, budget);
+	}
+	lv_refr_now(disp);
+	kbdinc_reset();
+	kb_px = (uint64_t)lv_obj_get_width(kb) * lv_obj_get_height(kb);
+
+	bench_frames_reset(&press);
+	bench_frames_reset(&release);
+	bench.record = !*ref;
+	bench.frames = 0;
+	bench.differ = 0;
+	px = bench_display_flushed_px(disp);
+	for (round = 0; round < KBDINC_BENCH_ROUNDS; round++) {
+		for (c = KBDINC_BENCH_TRACE; *c; c++) {
+			n = bench_type(disp, indev, kb, *c, &press, &release);
+			if (!n) {
+				printf("  no key for '%c'\n", *c);
+				ret = -1;
+				goto out;
+			}
+			keys += n;
+			if (*c != '\b') {
+				expect[len++] = *c;
+			} else if (len) {
+				len--;
+			}
+		}
+	}
+	expect[len] = '\0';
+	px = bench_display_flushed_px(disp) - px;
+
+	printf("%s: %u keystrokes, %.0f px flushed each, %.1f%% of the "
+	       "keyboard\n", label, keys, (double)px / keys,
+	       100.0 * px / keys / kb_px);
+	if (bench.record) {
+		*lvgl_px = (double)px / keys;
+	} else {
+		printf("  %.1fx fewer px than LVGL, %u of %u frames differ\n",
+		       *lvgl_px * keys / LV_MAX(px, 1), bench.differ,
+		       bench.frames);
+		if ((double)px / keys >= *lvgl_px) {
+			ret = -1;
+		}
+		if (!tolerance && bench.differ) {
+			ret = -1;
+		}
+	}
+	bench_frames_print("  press", &press);
+	bench_frames_print("  release", &release);
+	kbdinc_get_stats(&st);
+	if (cells) {
+		printf("  %.1f invalidations cut to a key per keystroke\n",
+		       (double)st.narrowed / keys);
+	}
+	if (budget) {
+		printf("  faces: %.1f%% hits, %llu rendered, %llu bypassed, "
+		       "%u faces, peak %u of %u bytes\n", hit_pct(&st),
+		       (unsigned long long)st.misses,
+		       (unsigned long long)st.bypass, st.entries, st.peak,
+		       budget);
+	}
+	if (strcmp(lv_textarea_get_text(ta), expect)) {
+		printf("  typed \"%s\"\n", lv_textarea_get_text(ta));
+		ret = -1;
+	}
+	if (bench_display_compare(disp, ref, &diff, &max)) {
+		ret = -1;
+	} else if (diff) {
+		printf("  %u bytes of the last frame differ from LVGL's, "
+		       "by up to %u\n", diff, max);
+		ret = max > tolerance ? -1 : ret;
+	}
+out:
+	kbdinc_deinit();
+	kbdinc_detach(kb);
+	lv_indev_delete(indev);
+	bench_display_delete(disp);
+
+	return ret;
+}
+
+int kbdinc_bench(void)
+{
+	uint8_t *ref = NULL;
+	double lvgl_px = 0;
+	int ret;
+
+	// Faces are blended once more than LVGL's own drawing: allow rounding
+	ret = bench_pass("LVGL", false, 0, &ref, 0, &lvgl_px) ||
+	      bench_pass("key cells", true, 0, &ref, 0, &lvgl_px) ||
+	      bench_pass("key cells + faces", true, KBDINC_BENCH_BUDGET, &ref,
+			 2, &lvgl_px) ? -1 : 0;
+	free(ref);
+
+	return ret;
+}
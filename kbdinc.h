@@ -0,0 +1,50 @@
+/*
+ * Key level redraws for button matrices and keyboards
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef KBDINC_H
+#define KBDINC_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+#define KBDINC_OBJS	4	// attached button matrices
+#define KBDINC_FACES	128	// cached key faces
+
+struct kbdinc_stats {
+	uint64_t narrowed;	// whole matrix invalidations cut to one key
+	uint64_t hits;		// keys drawn from a cached face
+	uint64_t misses;	// faces rendered and cached
+	uint64_t evictions;
+	uint64_t bypass;	// left to LVGL: outline or shadow past the cell
+	uint32_t frames;
+	uint32_t entries;
+	uint32_t bytes;
+	uint32_t peak;		// [bytes]
+};
+
+/* Cache at most budget bytes of key faces for matrices drawn on disp */
+int kbdinc_init(lv_display_t *disp, uint32_t budget);
+void kbdinc_deinit(void);
+
+/*
+ * Redraw only the keys that change when obj (an lv_buttonmatrix or
+ * lv_keyboard) is pressed and released, from cached faces after kbdinc_init()
+ */
+int kbdinc_attach(lv_obj_t *obj);
+void kbdinc_detach(lv_obj_t *obj);
+
+void kbdinc_get_stats(struct kbdinc_stats *stats);
+void kbdinc_reset(void);
+void kbdinc_report(FILE *fp);
+
+int kbdinc_bench(void);
+
+#endif /* KBDINC_H */
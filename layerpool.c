@@ -0,0 +1,423 @@
+/*
+ * Pooled layer buffer allocator with a hard memory budget
+ *
+ * Opacity and transform layers get their buffers from the default draw
+ * buffer handlers, i.e. from the 64 KB LVGL heap, and give them back at the
+ * end of every frame. Here those handlers are replaced: requests are
+ * rounded up to size classes (four per power of two) and freed buffers stay
+ * cached for the next frame, outside the LVGL heap.
+ *
+ * Only requests made while the display renders are pooled: those are the
+ * layers. Canvases, asyncimg decode buffers and anything else created
+ * between frames stay with LVGL's handler, as they may live for good.
+ *
+ * Cached plus handed out pool bytes never exceed the budget. A request that
+ * does not fit first evicts cached buffers. If the buffers in use still
+ * leave no room, or the request is larger than the budget, it gets a buffer
+ * of its own from aligned_alloc(), freed again when returned and counted as
+ * over budget. Failing it instead would stall the draw unit: nothing may be
+ * in flight to free a buffer, and a nested layer waits on the parent holding
+ * the rest of the budget. Neither goes to the LVGL heap, which is where the
+ * default handlers would put it. Simple layers arrive in
+ * LV_DRAW_LAYER_SIMPLE_BUF_SIZE strips, so a budget of a few strips plus the
+ * largest transformed object keeps these rare.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl/src/draw/lv_draw_buf_private.h"
+
+#include "bench.h"
+#include "layerpool.h"
+
+#define LAYERPOOL_MAX_BUFS	32
+#define LAYERPOOL_MIN_CLASS	1024
+#define LAYERPOOL_ALIGN		64
+
+struct buf {
+	void *ptr;
+	uint32_t size;
+	bool in_use;
+};
+
+/* Header of an over budget buffer; the data follows LAYERPOOL_ALIGN later */
+struct loose {
+	struct loose *next;
+};
+
+static struct {
+	lv_display_t *disp;
+	lv_draw_buf_handlers_t *handlers;
+	lv_draw_buf_malloc_cb malloc_cb;
+	lv_draw_buf_free_cb free_cb;
+	uint32_t budget;
+	bool rendering;		// between REFR_START and REFR_READY
+	pthread_mutex_t lock;
+	struct buf bufs[LAYERPOOL_MAX_BUFS];
+	struct loose *loose;	// over budget buffers handed out
+	struct layerpool_stats stats;
+} pool = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static uint32_t class_size(size_t size)
+{
+	uint32_t base;
+	uint32_t quarter;
+
+	if (size <= LAYERPOOL_MIN_CLASS) {
+		return LAYERPOOL_MIN_CLASS;
+	}
+	base = 1U << (31 - __builtin_clz(size - 1));
+	quarter = base / 4;
+
+	return base + (size - base + quarter - 1) / quarter * quarter;
+}
+
+static struct buf *find_free(uint32_t size)
+{
+	int i;
+
+	for (i = 0; i < LAYERPOOL_MAX_BUFS; i++) {
+		if (pool.bufs[i].ptr && !pool.bufs[i].in_use &&
+		    pool.bufs[i].size == size) {
+			return &pool.bufs[i];
+		}
+	}
+
+	return NULL;
+}
+
+/* Free the largest cached buffer, or the one in slot b if given */
+static bool evict(struct buf *b)
+{
+	struct buf *largest = NULL;
+	int i;
+
+	for (i = 0; !b && i < LAYERPOOL_MAX_BUFS; i++) {
+		if (pool.bufs[i].ptr && !pool.bufs[i].in_use &&
+		    (!largest || pool.bufs[i].size > largest->size)) {
+			largest = &pool.bufs[i];
+		}
+	}
+	b = b ? b : largest;
+	if (!b) {
+		return false;
+	}
+	free(b->ptr);
+	pool.stats.cached -= b->size;
+	pool.stats.evictions++;
+	memset(b, 0, sizeof(*b));
+
+	return true;
+}
+
+/* A buffer outside the pool and the LVGL heap; pool.lock held */
+static void *loose_alloc(size_t size)
+{
+	struct loose *l;
+
+	l = aligned_alloc(LAYERPOOL_ALIGN,
+			  LV_ALIGN_UP(LAYERPOOL_ALIGN + size, LAYERPOOL_ALIGN));
+	if (!l) {
+		return NULL;
+	}
+	l->next = pool.loose;
+	pool.loose = l;
+
+	return (uint8_t *)l + LAYERPOOL_ALIGN;
+}
+
+/* pool.lock held */
+static bool loose_free(void *ptr)
+{
+	struct loose **p, *l;
+
+	for (p = &pool.loose; *p; p = &(*p)->next) {
+		if ((uint8_t *)*p + LAYERPOOL_ALIGN == ptr) {
+			l = *p;
+			*p = l->next;
+			free(l);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static void *pool_malloc(size_t size, lv_color_format_t cf)
+{
+	struct buf *b;
+	uint32_t csize;
+	void *ptr;
+	int i;
+
+	pthread_mutex_lock(&pool.lock);
+	if (!pool.rendering) {
+		pool.stats.others++;
+		pthread_mutex_unlock(&pool.lock);
+		return pool.malloc_cb(size, cf);
+	}
+	pool.stats.requests++;
+
+	// The handlers align the pointer themselves; leave them the room
+	csize = class_size(size + LV_DRAW_BUF_ALIGN - 1);
+	if (!pool.budget) {
+		pthread_mutex_unlock(&pool.lock);
+		return pool.malloc_cb(size, cf);
+	}
+	if (csize > pool.budget) {
+		pool.stats.oversize++;
+		goto loose;
+	}
+
+	b = find_free(csize);
+	if (b) {
+		pool.stats.reuses++;
+		pool.stats.cached -= csize;
+		goto out;
+	}
+
+	while (pool.stats.used + pool.stats.cached + csize > pool.budget &&
+	       evict(NULL)) {
+	}
+	if (pool.stats.used + pool.stats.cached + csize > pool.budget) {
+		pool.stats.fallbacks++;
+		goto loose;
+	}
+
+	for (i = 0; i < LAYERPOOL_MAX_BUFS && pool.bufs[i].ptr; i++) {
+	}
+	if (i == LAYERPOOL_MAX_BUFS) {
+		// Out of slots: recycle the smallest cached one, if any
+		for (i = 0, b = NULL; i < LAYERPOOL_MAX_BUFS; i++) {
+			if (!pool.bufs[i].in_use &&
+			    (!b || pool.bufs[i].size < b->size)) {
+				b = &pool.bufs[i];
+			}
+		}
+		if (!b) {
+			pool.stats.fallbacks++;
+			goto loose;
+		}
+		evict(b);
+	} else {
+		b = &pool.bufs[i];
+	}
+
+	b->ptr = aligned_alloc(LAYERPOOL_ALIGN, csize);
+	if (!b->ptr) {
+		pool.stats.fallbacks++;
+		goto loose;
+	}
+	b->size = csize;
+	pool.stats.heap_allocs++;
+
+out:
+	b->in_use = true;
+	pool.stats.used += csize;
+	pool.stats.peak = LV_MAX(pool.stats.peak,
+				 pool.stats.used + pool.stats.cached);
+	pthread_mutex_unlock(&pool.lock);
+
+	return b->ptr;
+
+loose:
+	ptr = loose_alloc(size + LV_DRAW_BUF_ALIGN - 1);
+	pthread_mutex_unlock(&pool.lock);
+
+	return ptr;
+}
+
+static void pool_free(void *ptr)
+{
+	int i;
+
+	pthread_mutex_lock(&pool.lock);
+	for (i = 0; i < LAYERPOOL_MAX_BUFS; i++) {
+		if (pool.bufs[i].ptr == ptr && pool.bufs[i].in_use) {
+			pool.bufs[i].in_use = false;
+			pool.stats.used -= pool.bufs[i].size;
+			pool.stats.cached += pool.bufs[i].size;
+			pthread_mutex_unlock(&pool.lock);
+			return;
+		}
+	}
+	if (loose_free(ptr)) {
+		pthread_mutex_unlock(&pool.lock);
+		return;
+	}
+	pthread_mutex_unlock(&pool.lock);
+
+	pool.free_cb(ptr);
+}
+
+static void layerpool_event_cb(lv_event_t *e)
+{
+	pthread_mutex_lock(&pool.lock);
+	pool.rendering = lv_event_get_code(e) == LV_EVENT_REFR_START;
+	pool.stats.frames += !pool.rendering;
+	pthread_mutex_unlock(&pool.lock);
+}
+
+int layerpool_init(lv_display_t *disp, uint32_t budget)
+{
+	if (pool.handlers) {
+		return -1;
+	}
+	memset(&pool.stats, 0, sizeof(pool.stats));
+	memset(pool.bufs, 0, sizeof(pool.bufs));
+	pool.loose = NULL;
+	pool.disp = disp;
+	pool.budget = budget;
+	pool.handlers = lv_draw_buf_get_handlers();
+	pool.malloc_cb = pool.handlers->buf_malloc_cb;
+	pool.free_cb = pool.handlers->buf_free_cb;
+	pool.handlers->buf_malloc_cb = pool_malloc;
+	pool.handlers->buf_free_cb = pool_free;
+	pool.rendering = false;
+	lv_display_add_event_cb(disp, layerpool_event_cb, LV_EVENT_REFR_START,
+				NULL);
+	lv_display_add_event_cb(disp, layerpool_event_cb, LV_EVENT_REFR_READY,
+				NULL);
+
+	return 0;
+}
+
+void layerpool_deinit(void)
+{
+	int i;
+
+	if (!pool.handlers) {
+		return;
+	}
+	lv_display_remove_event_cb_with_user_data(pool.disp,
+						  layerpool_event_cb, NULL);
+	pool.handlers->buf_malloc_cb = pool.malloc_cb;
+	pool.handlers->buf_free_cb = pool.free_cb;
+	pool.handlers = NULL;
+	for (i = 0; i < LAYERPOOL_MAX_BUFS; i++) {
+		free(pool.bufs[i].ptr);
+	}
+	memset(pool.bufs, 0, sizeof(pool.bufs));
+	while (pool.loose) {
+		loose_free((uint8_t *)pool.loose + LAYERPOOL_ALIGN);
+	}
+}
+
+void layerpool_get_stats(struct layerpool_stats *stats)
+{
+	pthread_mutex_lock(&pool.lock);
+	*stats = pool.stats;
+	pthread_mutex_unlock(&pool.lock);
+}
+
+void layerpool_report(FILE *fp)
+{
+	struct layerpool_stats st;
+	double frames;
+
+	layerpool_get_stats(&st);
+	frames = st.frames ? st.frames : 1;
+	fprintf(fp, "layerpool: %.1f requests/frame, %.1f%% reused, "
+		"%.2f heap allocs/frame, %llu over budget, %llu oversize, "
+		"%llu between frames, peak %u of %u bytes\n",
+		st.requests / frames,
+		st.requests ? 100.0 * st.reuses / st.requests : 0.0,
+		st.heap_allocs / frames, (unsigned long long)st.fallbacks,
+		(unsigned long long)st.oversize, (unsigned long long)st.others,
+		st.peak, pool.budget);
+}
+
+/*
+ * Benchmark: six semi-transparent panels (simple layers) and one rotated
+ * panel (transform layer) overlapping and moving every frame, plus a canvas
+ * buffer created between frames that must stay out of the pool. Compared
+ * are LVGL's own allocation, the pool with room for all layers of a frame
+ * and the pool with a budget below that, which must still draw every frame.
+ */
+#define LAYERPOOL_BENCH_FRAMES	200
+#define LAYERPOOL_BENCH_PANELS	7
+
+static int bench_pass(const char *label, uint32_t budget)
+{
+	lv_obj_t *panels[LAYERPOOL_BENCH_PANELS];
+	struct layerpool_stats st;
+	struct bench_frames f;
+	lv_mem_monitor_t mon;
+	lv_draw_buf_t *canvas;
+	lv_display_t *disp;
+	lv_obj_t *scr;
+	double frames;
+	uint32_t i;
+	int p;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	scr = lv_display_get_screen_active(disp);
+	for (p = 0; p < LAYERPOOL_BENCH_PANELS; p++) {
+		panels[p] = lv_obj_create(scr);
+		lv_obj_set_size(panels[p], 100, 80);
+		lv_obj_set_style_bg_color(panels[p],
+					  lv_color_hsv_to_rgb(p * 50, 70, 90), 0);
+		lv_obj_set_style_opa(panels[p], LV_OPA_60, 0);
+		lv_label_set_text_fmt(lv_label_create(panels[p]), "Panel %d", p);
+	}
+	lv_obj_set_style_transform_rotation(panels[LAYERPOOL_BENCH_PANELS - 1],
+					    150, 0);
+
+	layerpool_init(disp, budget);
+	canvas = lv_draw_buf_create(64, 64, LV_COLOR_FORMAT_ARGB8888, 0);
+	bench_frames_attach(disp, &f);
+	bench_frames_reset(&f);
+	for (i = 0; i < LAYERPOOL_BENCH_FRAMES; i++) {
+		for (p = 0; p < LAYERPOOL_BENCH_PANELS; p++) {
+			lv_obj_set_pos(panels[p],
+				       (i * (p + 1) * 3 + p * 40) % 220,
+				       (i * 2 + p * 23) % 160);
+		}
+		lv_refr_now(disp);
+	}
+	bench_frames_detach(disp, &f);
+	layerpool_get_stats(&st);
+	lv_mem_monitor(&mon);
+	if (canvas) {
+		lv_draw_buf_destroy(canvas);
+	}
+	layerpool_deinit();
+
+	frames = st.frames ? st.frames : 1;
+	bench_frames_print(label, &f);
+	printf("  %.1f layer buffers/frame, %.2f from the heap, %.1f%% reused, "
+	       "%llu over budget\n",
+	       st.requests / frames,
+	       budget ? st.heap_allocs / frames : st.requests / frames,
+	       st.requests ? 100.0 * st.reuses / st.requests : 0.0,
+	       (unsigned long long)st.fallbacks);
+	printf("  %u of %u frames drawn, %llu buffers made between frames\n",
+	       st.frames, LAYERPOOL_BENCH_FRAMES,
+	       (unsigned long long)st.others);
+	if (budget) {
+		printf("  pool peak %u of %u bytes\n", st.peak, budget);
+	}
+	printf("  LVGL heap: %u%% fragmented, largest free block %u bytes\n",
+	       mon.frag_pct, (uint32_t)mon.free_biggest_size);
+
+	bench_display_delete(disp);
+
+	return 0;
+}
+
+int layerpool_bench(void)
+{
+	return bench_pass("LVGL heap", 0) ||
+	       bench_pass("pool 192 KB", 192 * 1024) ||
+	       bench_pass("pool 64 KB", 64 * 1024) ? -1 : 0;
+}
@@ -0,0 +1,44 @@
+/*
+ * Pooled layer buffer allocator with a hard memory budget
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef LAYERPOOL_H
+#define LAYERPOOL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+struct layerpool_stats {
+	uint32_t frames;
+	uint64_t requests;	// draw buffer allocations asked for
+	uint64_t reuses;	// served from a cached buffer
+	uint64_t heap_allocs;	// buffers the pool had to allocate
+	uint64_t evictions;	// cached buffers freed to make room
+	uint64_t fallbacks;	// over budget, allocated outside the pool
+	uint64_t oversize;	// larger than the budget, allocated outside too
+	uint64_t others;	// not a layer: created between frames
+	uint32_t used;		// [bytes] handed out
+	uint32_t cached;	// [bytes] free in the pool
+	uint32_t peak;		// [bytes] largest used + cached
+};
+
+/*
+ * Serve the layer buffers disp allocates while it renders from the pool.
+ * budget 0 only counts requests and leaves allocation to LVGL.
+ */
+int layerpool_init(lv_display_t *disp, uint32_t budget);
+/* Call with no layer buffers outstanding */
+void layerpool_deinit(void);
+void layerpool_get_stats(struct layerpool_stats *stats);
+void layerpool_report(FILE *fp);
+
+int layerpool_bench(void);
+
+#endif /* LAYERPOOL_H */
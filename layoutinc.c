@@ -0,0 +1,448 @@
+/*
+ * Incremental flex and grid layout
+ *
+ * LVGL marks an object's layout dirty on text, size and layout style
+ * changes, and its parent's on position and margin style changes (x, y,
+ * align) and when the object's size actually changed. lv_obj_refr_size()
+ * already stops there when a relayout leaves a container's size as it was,
+ * but every dirty container still runs its flex or grid pass over all its
+ * children, and a lv_obj_align_to() on a flex item, as slider_event_cb()
+ * does after each text change, dirties the row although flex ignores the
+ * item's position.
+ *
+ * The flex and grid entries of LVGL's layout list are wrapped. After a pass
+ * a 64 bit signature of its inputs is kept per container: the container's
+ * coordinates, scroll offset, padding and layout styles, and for every child
+ * its address, layout flags, size constraints, margins, grow and cell
+ * styles and current coordinates. A pass whose signature matches the one
+ * the last pass left behind would move nothing and is skipped; that holds
+ * even for a new container at a freed one's address, so deletions need no
+ * tracking. Passes, skips, children visited and time are counted per
+ * frame.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "layoutinc.h"
+
+#include "lvgl/src/core/lv_global.h"
+#include "lvgl/src/layouts/lv_layout_private.h"
+
+#define LAYOUTINC_SLOTS		256	// containers remembered, direct mapped
+
+enum {
+	KIND_FLEX,
+	KIND_GRID,
+	KINDS
+};
+
+static const lv_style_prop_t cont_props[] = {
+	LV_STYLE_PAD_TOP, LV_STYLE_PAD_BOTTOM, LV_STYLE_PAD_LEFT,
+	LV_STYLE_PAD_RIGHT, LV_STYLE_PAD_ROW, LV_STYLE_PAD_COLUMN,
+	LV_STYLE_BORDER_WIDTH, LV_STYLE_BASE_DIR,
+	LV_STYLE_FLEX_FLOW, LV_STYLE_FLEX_MAIN_PLACE, LV_STYLE_FLEX_CROSS_PLACE,
+	LV_STYLE_FLEX_TRACK_PLACE,
+	LV_STYLE_GRID_COLUMN_ALIGN, LV_STYLE_GRID_ROW_ALIGN,
+};
+
+static const lv_style_prop_t item_props[] = {
+	LV_STYLE_WIDTH, LV_STYLE_MIN_WIDTH, LV_STYLE_MAX_WIDTH,
+	LV_STYLE_HEIGHT, LV_STYLE_MIN_HEIGHT, LV_STYLE_MAX_HEIGHT,
+	LV_STYLE_MARGIN_TOP, LV_STYLE_MARGIN_BOTTOM, LV_STYLE_MARGIN_LEFT,
+	LV_STYLE_MARGIN_RIGHT, LV_STYLE_FLEX_GROW,
+	LV_STYLE_GRID_CELL_COLUMN_POS, LV_STYLE_GRID_CELL_COLUMN_SPAN,
+	LV_STYLE_GRID_CELL_ROW_POS, LV_STYLE_GRID_CELL_ROW_SPAN,
+	LV_STYLE_GRID_CELL_X_ALIGN, LV_STYLE_GRID_CELL_Y_ALIGN,
+};
+
+static const lv_obj_flag_t item_flags[] = {
+	LV_OBJ_FLAG_HIDDEN, LV_OBJ_FLAG_IGNORE_LAYOUT, LV_OBJ_FLAG_FLOATING,
+	LV_OBJ_FLAG_FLEX_IN_NEW_TRACK,
+};
+
+struct wrapped {
+	lv_layout_update_cb_t cb;
+	void *user_data;
+};
+
+struct memo {
+	const lv_obj_t *obj;
+	uint64_t sig;
+};
+
+static struct {
+	lv_display_t *disp;
+	bool active;
+	bool skip;
+	struct wrapped orig[KINDS];
+	struct memo memo[LAYOUTINC_SLOTS];
+	uint32_t frame_passes;
+	struct layoutinc_stats stats;
+} li;
+
+static inline uint64_t mix(uint64_t h, uint64_t v)
+{
+	h = (h ^ v) * 0x9e3779b97f4a7c15ULL;
+
+	return h ^ (h >> 29);
+}
+
+static uint64_t mix_area(uint64_t h, const lv_area_t *a)
+{
+	h = mix(h, (uint32_t)a->x1 | (uint64_t)(uint32_t)a->y1 << 32);
+
+	return mix(h, (uint32_t)a->x2 | (uint64_t)(uint32_t)a->y2 << 32);
+}
+
+static uint64_t mix_template(uint64_t h, const int32_t *dsc)
+{
+	if (!dsc) {
+		return mix(h, 0);
+	}
+	for (; *dsc != LV_GRID_TEMPLATE_LAST; dsc++) {
+		h = mix(h, (uint32_t)*dsc);
+	}
+
+	return mix(h, LV_GRID_TEMPLATE_LAST);
+}
+
+/*
+ * Everything the flex and grid passes read. Children sized by content or
+ * percentage were refreshed before their parent's pass, so their current
+ * coordinates stand in for the text, images and styles behind them.
+ */
+static uint64_t signature(lv_obj_t *cont, int kind, uint32_t *nodes)
+{
+	uint32_t i, j, n = lv_obj_get_child_count(cont);
+	uint64_t h = 0xcbf29ce484222325ULL + kind;
+	lv_area_t a;
+
+	lv_obj_get_coords(cont, &a);
+	h = mix_area(h, &a);
+	h = mix(h, (uint32_t)lv_obj_get_scroll_x(cont) |
+		(uint64_t)(uint32_t)lv_obj_get_scroll_y(cont) << 32);
+	for (j = 0; j < sizeof(cont_props) / sizeof(cont_props[0]); j++) {
+		h = mix(h, (uint32_t)lv_obj_get_style_prop(cont, LV_PART_MAIN,
+							   cont_props[j]).num);
+	}
+	if (kind == KIND_GRID) {
+		h = mix_template(h, lv_obj_get_style_prop(cont, LV_PART_MAIN,
+				 LV_STYLE_GRID_COLUMN_DSC_ARRAY).ptr);
+		h = mix_template(h, lv_obj_get_style_prop(cont, LV_PART_MAIN,
+				 LV_STYLE_GRID_ROW_DSC_ARRAY).ptr);
+	}
+
+	h = mix(h, n);
+	for (i = 0; i < n; i++) {
+		lv_obj_t *child = lv_obj_get_child(cont, i);
+		uint32_t flags = 0;
+
+		h = mix(h, (uintptr_t)child);
+		for (j = 0; j < sizeof(item_flags) / sizeof(item_flags[0]); j++) {
+			flags |= lv_obj_has_flag(child, item_flags[j]) << j;
+		}
+		h = mix(h, flags);
+		if (flags & 3) {	// hidden or ignored: not laid out
+			continue;
+		}
+		for (j = 0; j < sizeof(item_props) / sizeof(item_props[0]); j++) {
+			h = mix(h, (uint32_t)lv_obj_get_style_prop(child,
+					LV_PART_MAIN, item_props[j]).num);
+		}
+		lv_obj_get_coords(child, &a);
+		h = mix_area(h, &a);
+	}
+	*nodes += n;
+
+	return h;
+}
+
+static void layout_cb(lv_obj_t *cont, void *user_data)
+{
+	struct wrapped *w = user_data;
+	int kind = w - li.orig;
+	struct memo *m;
+	uint64_t t0 = bench_now_us();
+	uint32_t nodes = 0;
+	uint64_t sig;
+
+	m = &li.memo[((uintptr_t)cont >> 4) % LAYOUTINC_SLOTS];
+	li.stats.passes++;
+	li.frame_passes++;
+	if (li.skip) {
+		sig = signature(cont, kind, &nodes);
+		if (m->obj == cont && m->sig == sig) {
+			li.stats.skipped++;
+			li.stats.nodes += nodes;
+			li.stats.us += bench_now_us() - t0;
+			return;
+		}
+	}
+	w->cb(cont, w->user_data);
+	nodes += lv_obj_get_child_count(cont);
+	if (li.skip) {
+		m->obj = cont;
+		m->sig = signature(cont, kind, &nodes);
+	}
+	li.stats.nodes += nodes;
+	li.stats.us += bench_now_us() - t0;
+}
+
+static void layoutinc_event_cb(lv_event_t *e)
+{
+	if (li.frame_passes > li.stats.passes_max) {
+		li.stats.passes_max = li.frame_passes;
+	}
+	li.frame_passes = 0;
+	li.stats.frames++;
+}
+
+int layoutinc_init(lv_display_t *disp, bool skip)
+{
+	lv_layout_dsc_t *list = LV_GLOBAL_DEFAULT()->layout_list;
+	static const uint32_t ids[KINDS] = {
+		[KIND_FLEX] = LV_LAYOUT_FLEX,
+		[KIND_GRID] = LV_LAYOUT_GRID,
+	};
+	int i;
+
+	if (li.active) {
+		return -EBUSY;
+	}
+	memset(&li, 0, sizeof(li));
+	li.disp = disp;
+	li.skip = skip;
+	for (i = 0; i < KINDS; i++) {
+		li.orig[i].cb = list[ids[i]].cb;
+		li.orig[i].user_data = list[ids[i]].user_data;
+		list[ids[i]].cb = layout_cb;
+		list[ids[i]].user_data = &li.orig[i];
+	}
+	lv_display_add_event_cb(disp, layoutinc_event_cb, LV_EVENT_REFR_READY,
+				NULL);
+	li.active = true;
+
+	return 0;
+}
+
+void layoutinc_deinit(void)
+{
+	lv_layout_dsc_t *list = LV_GLOBAL_DEFAULT()->layout_list;
+
+	if (!li.active) {
+		return;
+	}
+	lv_display_remove_event_cb_with_user_data(li.disp, layoutinc_event_cb,
+						  NULL);
+	list[LV_LAYOUT_FLEX].cb = li.orig[KIND_FLEX].cb;
+	list[LV_LAYOUT_FLEX].user_data = li.orig[KIND_FLEX].user_data;
+	list[LV_LAYOUT_GRID].cb = li.orig[KIND_GRID].cb;
+	list[LV_LAYOUT_GRID].user_data = li.orig[KIND_GRID].user_data;
+	li.active = false;
+}
+
+void layoutinc_get_stats(struct layoutinc_stats *stats)
+{
+	*stats = li.stats;
+}
+
+void layoutinc_reset(void)
+{
+	memset(&li.stats, 0, sizeof(li.stats));
+}
+
+void layoutinc_report(FILE *fp)
+{
+	struct layoutinc_stats st;
+	double frames;
+
+	layoutinc_get_stats(&st);
+	frames = st.frames ? st.frames : 1;
+	fprintf(fp, "layoutinc: %.2f passes/frame (max %u), %.2f skipped, "
+		"%.1f nodes/frame, %.1f us/frame\n",
+		st.passes / frames, st.passes_max, st.skipped / frames,
+		st.nodes / frames, st.us / frames);
+}
+
+/*
+ * Benchmark: a settings page of nested flex containers (a column of
+ * sections, each a column of rows with a growing name, a value label and a
+ * slider or switch; the last section a grid) with one value label updated
+ * every frame, as a 60 Hz slider drag would. The text alone and the text
+ * followed by lv_obj_align_to(), the slider_event_cb() pattern, run with
+ * the passes counted only and with unchanged ones skipped. Each run ends
+ * with a forced relayout of every container, which must move nothing.
+ */
+#define LAYOUTINC_BENCH_FRAMES		240
+#define LAYOUTINC_BENCH_SECTIONS	4
+#define LAYOUTINC_BENCH_ROWS		4
+
+static const int32_t bench_cols[] = {
+	LV_GRID_FR(1), LV_GRID_CONTENT, LV_GRID_TEMPLATE_LAST
+};
+static const int32_t bench_rows[] = {
+	LV_GRID_CONTENT, LV_GRID_CONTENT, LV_GRID_CONTENT, LV_GRID_CONTENT,
+	LV_GRID_CONTENT, LV_GRID_TEMPLATE_LAST
+};
+
+static lv_obj_t *bench_flex(lv_obj_t *parent, lv_flex_flow_t flow)
+{
+	lv_obj_t *cont = lv_obj_create(parent);
+
+	lv_obj_set_size(cont, lv_pct(100), LV_SIZE_CONTENT);
+	lv_obj_set_flex_flow(cont, flow);
+	lv_obj_set_style_pad_all(cont, 4, 0);
+	lv_obj_set_style_pad_gap(cont, 4, 0);
+	lv_obj_remove_flag(cont, LV_OBJ_FLAG_SCROLLABLE);
+
+	return cont;
+}
+
+/* Returns the value label that the bench updates */
+static lv_obj_t *bench_build(lv_obj_t *scr, lv_obj_t **name)
+{
+	lv_obj_t *page, *sec, *row, *obj, *value = NULL;
+	int s, r;
+
+	page = bench_flex(scr, LV_FLEX_FLOW_COLUMN);
+	lv_obj_set_height(page, lv_pct(100));
+	lv_obj_add_flag(page, LV_OBJ_FLAG_SCROLLABLE);
+	for (s = 0; s < LAYOUTINC_BENCH_SECTIONS; s++) {
+		if (s == LAYOUTINC_BENCH_SECTIONS - 1) {
+			sec = lv_obj_create(page);
+			lv_obj_set_size(sec, lv_pct(100), LV_SIZE_CONTENT);
+			lv_obj_set_grid_dsc_array(sec, bench_cols, bench_rows);
+			obj = lv_label_create(sec);
+			lv_label_set_text_fmt(obj, "Section %d", s);
+			lv_obj_set_grid_cell(obj, LV_GRID_ALIGN_START, 0, 2,
+					     LV_GRID_ALIGN_CENTER, 0, 1);
+			for (r = 0; r < LAYOUTINC_BENCH_ROWS; r++) {
+				obj = lv_label_create(sec);
+				lv_label_set_text_fmt(obj, "Info %d", r);
+				lv_obj_set_grid_cell(obj, LV_GRID_ALIGN_START,
+						     0, 1, LV_GRID_ALIGN_CENTER,
+						     r + 1, 1);
+				obj = lv_label_create(sec);
+				lv_label_set_text_fmt(obj, "%d.%d", r, s);
+				lv_obj_set_grid_cell(obj, LV_GRID_ALIGN_END,
+						     1, 1, LV_GRID_ALIGN_CENTER,
+						     r + 1, 1);
+			}
+			continue;
+		}
+		sec = bench_flex(page, LV_FLEX_FLOW_COLUMN);
+		lv_label_set_text_fmt(lv_label_create(sec), "Section %d", s);
+		for (r = 0; r < LAYOUTINC_BENCH_ROWS; r++) {
+			row = bench_flex(sec, LV_FLEX_FLOW_ROW);
+			lv_obj_set_flex_align(row, LV_FLEX_ALIGN_START,
+					      LV_FLEX_ALIGN_CENTER,
+					      LV_FLEX_ALIGN_CENTER);
+			obj = lv_label_create(row);
+			lv_label_set_text_fmt(obj, "Setting %d.%d", s, r);
+			lv_obj_set_flex_grow(obj, 1);
+			if (!value) {
+				*name = obj;
+			}
+			obj = lv_label_create(row);
+			lv_label_set_text(obj, "50%");
+			if (!value) {
+				value = obj;
+			}
+			if (r & 1) {
+				lv_switch_create(row);
+			} else {
+				obj = lv_slider_create(row);
+				lv_obj_set_width(obj, 80);
+			}
+		}
+	}
+
+	return value;
+}
+
+static lv_obj_tree_walk_res_t coords_cb(lv_obj_t *obj, void *user_data)
+{
+	uint64_t *h = user_data;
+	lv_area_t a;
+
+	lv_obj_get_coords(obj, &a);
+	*h = mix_area(*h, &a);
+
+	return LV_OBJ_TREE_WALK_NEXT;
+}
+
+static lv_obj_tree_walk_res_t dirty_cb(lv_obj_t *obj, void *user_data)
+{
+	lv_obj_mark_layout_as_dirty(obj);
+
+	return LV_OBJ_TREE_WALK_NEXT;
+}
+
+static int bench_pass(const char *label, bool align, bool skip)
+{
+	lv_obj_t *scr, *value, *name = NULL;
+	struct layoutinc_stats st;
+	uint64_t before = 0, after = 0;
+	struct bench_frames f;
+	lv_display_t *disp;
+	double frames;
+	uint32_t i;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	scr = lv_display_get_screen_active(disp);
+	value = bench_build(scr, &name);
+	lv_refr_now(disp);
+
+	layoutinc_init(disp, skip);
+	bench_frames_attach(disp, &f);
+	bench_frames_reset(&f);
+	for (i = 0; i < LAYOUTINC_BENCH_FRAMES; i++) {
+		lv_label_set_text_fmt(value, "%u%%", i * 7 / 4 % 101);
+		if (align) {
+			lv_obj_align_to(value, name, LV_ALIGN_OUT_RIGHT_MID,
+					4, 0);
+		}
+		lv_refr_now(disp);
+	}
+	bench_frames_detach(disp, &f);
+	layoutinc_get_stats(&st);
+	lv_obj_tree_walk(scr, coords_cb, &before);
+	layoutinc_deinit();
+	lv_obj_tree_walk(scr, dirty_cb, NULL);
+	lv_obj_update_layout(scr);
+	lv_obj_tree_walk(scr, coords_cb, &after);
+
+	frames = st.frames ? st.frames : 1;
+	bench_frames_print(label, &f);
+	printf("  %.2f passes/frame (max %u), %.2f skipped, %.1f nodes/frame, "
+	       "%.1f us/frame in layout\n",
+	       st.passes / frames, st.passes_max, st.skipped / frames,
+	       st.nodes / frames, st.us / frames);
+	bench_display_delete(disp);
+	if (before != after) {
+		printf("  layout differs from a full relayout\n");
+		return -1;
+	}
+
+	return 0;
+}
+
+int layoutinc_bench(void)
+{
+	return bench_pass("text", false, false) ||
+	       bench_pass("text, skip unchanged", false, true) ||
+	       bench_pass("text + align_to", true, false) ||
+	       bench_pass("text + align_to, skip unchanged", true, true) ?
+	       -1 : 0;
+}
@@ -0,0 +1,41 @@
+/*
+ * Incremental flex and grid layout
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef LAYOUTINC_H
+#define LAYOUTINC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+struct layoutinc_stats {
+	uint32_t frames;
+	uint64_t passes;	// flex/grid layouts LVGL asked for
+	uint64_t skipped;	// of those, inputs unchanged since the last one
+	uint64_t nodes;		// children visited by passes that ran
+	uint64_t us;		// spent in passes and signatures
+	uint32_t passes_max;	// in one frame
+};
+
+/*
+ * Count the flex and grid passes of every display, per frame of disp. With
+ * skip, a pass over a container whose children, sizes, margins and layout
+ * styles are all as the previous pass left them is not run again.
+ */
+int layoutinc_init(lv_display_t *disp, bool skip);
+void layoutinc_deinit(void);
+void layoutinc_get_stats(struct layoutinc_stats *stats);
+void layoutinc_reset(void);
+void layoutinc_report(FILE *fp);
+
+int layoutinc_bench(void);
+
+#endif /* LAYOUTINC_H */
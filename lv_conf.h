@@ -78,8 +78,9 @@
     #define LV_MEM_ADR 0     /**< 0: unused*/
     /* Instead of an address give a memory allocator that will be called to get a memory pool for LVGL. E.g. my_malloc */
     #if LV_MEM_ADR == 0
-        #undef LV_MEM_POOL_INCLUDE
-        #undef LV_MEM_POOL_ALLOC
+        /* One pool per lvctx instance, see lvctx.c */
+        #define LV_MEM_POOL_INCLUDE "lvctx_global.h"
+        #define LV_MEM_POOL_ALLOC   lvctx_pool_alloc
     #endif
 #endif  /*LV_USE_STDLIB_MALLOC == LV_STDLIB_BUILTIN*/
 
@@ -129,7 +130,7 @@
 #define LV_DRAW_BUF_STRIDE_ALIGN                1
 
 /** Align start address of draw_buf addresses to this bytes*/
-#define LV_DRAW_BUF_ALIGN                       4
+#define LV_DRAW_BUF_ALIGN                       64
 
 /** Using matrix for transformations.
  * Requirements:
@@ -533,10 +534,10 @@
  * Others
  *-----------*/
 
-#define LV_ENABLE_GLOBAL_CUSTOM 0
+#define LV_ENABLE_GLOBAL_CUSTOM 1
 #if LV_ENABLE_GLOBAL_CUSTOM
     /** Header to include for custom 'lv_global' function" */
-    #define LV_GLOBAL_CUSTOM_INCLUDE <stdint.h>
+    #define LV_GLOBAL_CUSTOM_INCLUDE "lvctx_global.h"
 #endif
 
 /** Default cache size in bytes.
@@ -563,7 +564,7 @@
 #define LV_COLOR_MIX_ROUND_OFS  0
 
 /** Add 2 x 32-bit variables to each `lv_obj_t` to speed up getting style properties */
-#define LV_OBJ_STYLE_CACHE      0
+#define LV_OBJ_STYLE_CACHE      1
 
 /** Add `id` field to `lv_obj_t` */
 #define LV_USE_OBJ_ID           0
@@ -0,0 +1,309 @@
+/*
+ * Isolated LVGL instances, one per thread
+ *
+ * With LV_ENABLE_GLOBAL_CUSTOM, LVGL reaches all of its state through
+ * LV_GLOBAL_DEFAULT(), which lvctx_global.h points at a thread-local
+ * lv_global_t. The builtin heap comes from LV_MEM_POOL_ALLOC, so every
+ * context also gets its own LV_MEM_SIZE pool instead of the static array.
+ *
+ * LVGL starts draw threads from lv_init(). They must run in the context of
+ * the thread that created them, so pthread_create() is wrapped at link time
+ * (-Wl,--wrap=pthread_create) to hand the creator's context to the child.
+ * The same wrapper reports every new thread to a callback, which is how rt
+ * tells LVGL's draw threads from the ones other modules start.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lvgl/src/core/lv_global.h"
+
+#include "bench.h"
+#include "lvctx.h"
+
+struct lvctx {
+	lv_global_t global;		// first: lvctx_tls points here
+	void *pool;
+};
+
+_Thread_local struct _lv_global_t *lvctx_tls;
+struct _lv_global_t lvctx_default;
+
+static lvctx_thread_cb_t thread_cb;
+
+void *lvctx_pool_alloc(size_t size)
+{
+	struct lvctx *ctx = (struct lvctx *)lvctx_tls;
+	void *pool = malloc(size);
+
+	if (ctx) {
+		ctx->pool = pool;
+	}
+
+	return pool;
+}
+
+struct lvctx *lvctx_create(lv_tick_get_cb_t tick_cb, lv_delay_cb_t delay_cb)
+{
+	struct lvctx *ctx = calloc(1, sizeof(*ctx));
+
+	if (!ctx) {
+		return NULL;
+	}
+	lvctx_tls = &ctx->global;
+	lv_init();
+	if (!ctx->pool) {
+		lvctx_tls = NULL;
+		free(ctx);
+		return NULL;
+	}
+	lv_tick_set_cb(tick_cb);
+	lv_delay_set_cb(delay_cb);
+
+	return ctx;
+}
+
+void lvctx_destroy(struct lvctx *ctx)
+{
+	lv_deinit();
+	lvctx_tls = NULL;
+	free(ctx->pool);
+	free(ctx);
+}
+
+void lvctx_set_current(struct lvctx *ctx)
+{
+	lvctx_tls = ctx ? &ctx->global : NULL;
+}
+
+void lvctx_set_thread_cb(lvctx_thread_cb_t cb)
+{
+	thread_cb = cb;
+}
+
+struct start {
+	void *(*fn)(void *);
+	void *arg;
+	struct _lv_global_t *global;
+};
+
+int __real_pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+			  void *(*fn)(void *), void *arg);
+
+static void *start_thread(void *arg)
+{
+	struct start s = *(struct start *)arg;
+
+	free(arg);
+	lvctx_tls = s.global;
+
+	return s.fn(s.arg);
+}
+
+int __wrap_pthread_create(pthread_t *thread, const pthread_attr_t *attr,
+			  void *(*fn)(void *), void *arg)
+{
+	struct start *s;
+	int ret;
+
+	if (!lvctx_tls) {
+		ret = __real_pthread_create(thread, attr, fn, arg);
+		goto out;
+	}
+
+	s = malloc(sizeof(*s));
+	if (!s) {
+		return EAGAIN;
+	}
+	s->fn = fn;
+	s->arg = arg;
+	s->global = lvctx_tls;
+	ret = __real_pthread_create(thread, attr, start_thread, s);
+	if (ret) {
+		free(s);
+	}
+out:
+	if (!ret && thread_cb) {
+		thread_cb(*thread);
+	}
+
+	return ret;
+}
+
+/*
+ * Benchmark: each thread owns a context with a headless display showing the
+ * main.c screen, and renders it for a new device configuration (colors,
+ * texts, slider position) as fast as it can. Reported are screens per second
+ * for 1 to 8 threads. The first screen of every thread uses the same
+ * configuration, and the framebuffers must hash identically.
+ */
+#define LVCTX_BENCH_SECONDS 2
+
+struct render_thread {
+	pthread_t thread;
+	int index;
+	atomic_bool *stop;
+	uint32_t screens;
+	uint64_t hash;
+	int err;
+};
+
+struct preview {
+	lv_obj_t *scr;
+	lv_obj_t *title;
+	lv_obj_t *button_label;
+	lv_obj_t *slider;
+	lv_obj_t *status;
+};
+
+static uint32_t render_tick_cb(void)
+{
+	return bench_now_us() / 1000;
+}
+
+static void render_delay_cb(uint32_t ms)
+{
+	struct timespec ts = { ms / 1000, ms % 1000 * 1000000L };
+
+	nanosleep(&ts, NULL);
+}
+
+static void preview_create(struct preview *p, lv_display_t *disp)
+{
+	lv_obj_t *button;
+
+	p->scr = lv_display_get_screen_active(disp);
+
+	p->title = lv_label_create(p->scr);
+	lv_obj_align(p->title, LV_ALIGN_CENTER, 0, 75);
+
+	button = lv_button_create(p->scr);
+	lv_obj_set_size(button, 100, 50);
+	lv_obj_align(button, LV_ALIGN_TOP_MID, 0, 0);
+	p->button_label = lv_label_create(button);
+	lv_obj_center(p->button_label);
+
+	p->slider = lv_slider_create(p->scr);
+	lv_obj_set_size(p->slider, 200, 50);
+	lv_obj_center(p->slider);
+
+	p->status = lv_label_create(p->scr);
+	lv_obj_align(p->status, LV_ALIGN_CENTER, 0, 100);
+}
+
+static void preview_config(struct preview *p, uint32_t n)
+{
+	lv_obj_set_style_bg_color(p->scr,
+				  lv_color_hsv_to_rgb(n * 37 % 360, 20, 100), 0);
+	lv_obj_set_style_bg_color(p->slider,
+				  lv_color_hsv_to_rgb(n * 53 % 360, 80, 80),
+				  LV_PART_INDICATOR);
+	lv_label_set_text_fmt(p->title, "Device configuration %u", n);
+	lv_label_set_text_fmt(p->button_label, "Button (%u)", n % 256);
+	lv_label_set_text_fmt(p->status, "rev %u.%u", n / 10, n % 10);
+	lv_slider_set_value(p->slider, n % 101, LV_ANIM_OFF);
+}
+
+static uint64_t fb_hash(lv_display_t *disp)
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	uint32_t stride;
+	uint8_t *fb = bench_display_framebuffer(disp, &stride);
+	size_t i;
+
+	for (i = 0; i < (size_t)stride * BENCH_VER_RES; i++) {
+		h = (h ^ fb[i]) * 0x100000001b3ULL;
+	}
+
+	return h;
+}
+
+static void *render_thread_fn(void *arg)
+{
+	struct render_thread *rt = arg;
+	struct preview p;
+	lv_display_t *disp;
+	struct lvctx *ctx;
+	uint32_t n;
+
+	ctx = lvctx_create(render_tick_cb, render_delay_cb);
+	if (!ctx) {
+		rt->err = -1;
+		return NULL;
+	}
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		rt->err = -1;
+		lvctx_destroy(ctx);
+		return NULL;
+	}
+	preview_create(&p, disp);
+
+	preview_config(&p, 0);
+	lv_refr_now(disp);
+	rt->hash = fb_hash(disp);
+
+	for (n = rt->index * 100000; !atomic_load(rt->stop); n++) {
+		preview_config(&p, n);
+		lv_obj_invalidate(p.scr);
+		lv_refr_now(disp);
+		rt->screens++;
+	}
+
+	bench_display_delete(disp);
+	lvctx_destroy(ctx);
+
+	return NULL;
+}
+
+int lvctx_bench(void)
+{
+	static const int counts[] = { 1, 2, 4, 8 };
+	struct render_thread threads[8];
+	atomic_bool stop;
+	uint32_t screens;
+	size_t c;
+	int mismatch = 0;
+	int err = 0;
+	int i;
+
+	for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++) {
+		memset(threads, 0, sizeof(threads));
+		atomic_store(&stop, false);
+		for (i = 0; i < counts[c]; i++) {
+			threads[i].index = i;
+			threads[i].stop = &stop;
+			pthread_create(&threads[i].thread, NULL,
+				       render_thread_fn, &threads[i]);
+		}
+		lv_delay_ms(LVCTX_BENCH_SECONDS * 1000);
+		atomic_store(&stop, true);
+
+		screens = 0;
+		for (i = 0; i < counts[c]; i++) {
+			pthread_join(threads[i].thread, NULL);
+			screens += threads[i].screens;
+			err |= threads[i].err;
+			if (threads[i].hash != threads[0].hash) {
+				mismatch++;
+			}
+		}
+		printf("%d thread%s %8.1f screens/s (%.1f per thread)\n",
+		       counts[c], counts[c] > 1 ? "s" : " ",
+		       (double)screens / LVCTX_BENCH_SECONDS,
+		       (double)screens / LVCTX_BENCH_SECONDS / counts[c]);
+	}
+	printf("contexts with a different first screen: %d\n", mismatch);
+
+	return err || mismatch ? -1 : 0;
+}
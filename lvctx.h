@@ -0,0 +1,39 @@
+/*
+ * Isolated LVGL instances, one per thread
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef LVCTX_H
+#define LVCTX_H
+
+#include <pthread.h>
+
+#include "lvgl/lvgl.h"
+
+struct lvctx;
+
+typedef void (*lvctx_thread_cb_t)(pthread_t thread);
+
+/*
+ * Create a context, make it current for the calling thread and lv_init() it.
+ * Everything LVGL does on this thread, and in the threads LVGL starts from
+ * it, then uses the context's state and heap.
+ */
+struct lvctx *lvctx_create(lv_tick_get_cb_t tick_cb, lv_delay_cb_t delay_cb);
+
+/* lv_deinit() and free; ctx must be current */
+void lvctx_destroy(struct lvctx *ctx);
+
+/* NULL: back to the process default state */
+void lvctx_set_current(struct lvctx *ctx);
+
+/* Called on the creating thread after every pthread_create(); NULL: none */
+void lvctx_set_thread_cb(lvctx_thread_cb_t cb);
+
+int lvctx_bench(void);
+
+#endif /* LVCTX_H */
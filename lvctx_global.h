@@ -0,0 +1,35 @@
+/*
+ * Per-thread LVGL global state (LV_GLOBAL_CUSTOM_INCLUDE)
+ *
+ * Included from inside LVGL, so it must not include lvgl.h itself.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef LVCTX_GLOBAL_H
+#define LVCTX_GLOBAL_H
+
+#include <stddef.h>
+
+struct _lv_global_t;
+
+extern _Thread_local struct _lv_global_t *lvctx_tls;
+extern struct _lv_global_t lvctx_default;
+
+/* Threads outside any lvctx (main.c) share the process default state */
+static inline struct _lv_global_t *lvctx_global(void)
+{
+	struct _lv_global_t *g = lvctx_tls;
+
+	return g ? g : &lvctx_default;
+}
+
+#define LV_GLOBAL_CUSTOM() lvctx_global()
+
+/* LV_MEM_POOL_ALLOC: the builtin heap of the calling thread's context */
+void *lvctx_pool_alloc(size_t size);
+
+#endif /* LVCTX_GLOBAL_H */
@@ -0,0 +1,291 @@
+/*
+ * Lock-free mailbox for observer subject updates from background threads
+ *
+ * Setting a subject from a worker thread needs the LVGL lock, which the
+ * refresh holds for the whole frame. Instead, workers store the new value in
+ * the subject's slot and set its bit in a dirty bitmap; both are plain
+ * atomics, so posting never blocks and any number of threads may post. A
+ * slot holds only the latest value, so a subject updated faster than the UI
+ * drains is coalesced to one lv_subject_set_*() per drain. mailbox_drain()
+ * runs from the main loop once per lv_timer_handler() cycle and only takes
+ * the LVGL lock when something was posted.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "bench.h"
+#include "mailbox.h"
+
+#define MAILBOX_WORDS (MAILBOX_SUBJECTS / 64)
+
+struct slot {
+	lv_subject_t *subject;
+	atomic_uint value;
+};
+
+static struct slot slots[MAILBOX_SUBJECTS];
+static int slot_cnt;
+static atomic_uint_fast64_t dirty[MAILBOX_WORDS];
+static atomic_bool pending;
+static atomic_uint_fast64_t posts;
+static atomic_uint_fast64_t coalesced;
+static atomic_uint_fast64_t invalid;
+static uint64_t applied;
+
+int mailbox_add(lv_subject_t *subject)
+{
+	if (slot_cnt == MAILBOX_SUBJECTS ||
+	    (subject->type != LV_SUBJECT_TYPE_INT &&
+	     subject->type != LV_SUBJECT_TYPE_COLOR)) {
+		return -1;
+	}
+	slots[slot_cnt].subject = subject;
+
+	return slot_cnt++;
+}
+
+static void post(int id, uint32_t value)
+{
+	uint_fast64_t bit;
+
+	// slot_cnt only grows before the producers start
+	if (id < 0 || id >= slot_cnt || id >= MAILBOX_SUBJECTS) {
+		atomic_fetch_add_explicit(&invalid, 1, memory_order_relaxed);
+		return;
+	}
+	bit = 1ULL << (id % 64);
+	atomic_store_explicit(&slots[id].value, value, memory_order_relaxed);
+	if (atomic_fetch_or(&dirty[id / 64], bit) & bit) {
+		atomic_fetch_add_explicit(&coalesced, 1, memory_order_relaxed);
+	} else {
+		atomic_store(&pending, true);
+	}
+	atomic_fetch_add_explicit(&posts, 1, memory_order_relaxed);
+}
+
+void mailbox_post_int(int id, int32_t value)
+{
+	post(id, (uint32_t)value);
+}
+
+void mailbox_post_color(int id, lv_color_t color)
+{
+	post(id, lv_color_to_u32(color));
+}
+
+static void apply(struct slot *slot)
+{
+	uint32_t v = atomic_load_explicit(&slot->value, memory_order_relaxed);
+	lv_subject_t *subject = slot->subject;
+
+	// A post racing with the previous drain can leave its bit set twice
+	if (subject->type == LV_SUBJECT_TYPE_INT) {
+		if (lv_subject_get_int(subject) == (int32_t)v) {
+			return;
+		}
+		lv_subject_set_int(subject, (int32_t)v);
+	} else {
+		if (lv_color_to_u32(lv_subject_get_color(subject)) == v) {
+			return;
+		}
+		lv_subject_set_color(subject, lv_color_hex(v & 0xffffff));
+	}
+	applied++;
+}
+
+void mailbox_drain(void)
+{
+	uint_fast64_t bits;
+	int w;
+
+	if (!atomic_load_explicit(&pending, memory_order_relaxed)) {
+		return;
+	}
+
+	lv_lock();
+	// Cleared before the scan: a bit set after it re-arms pending
+	atomic_store(&pending, false);
+	for (w = 0; w < MAILBOX_WORDS; w++) {
+		bits = atomic_exchange(&dirty[w], 0);
+		while (bits) {
+			apply(&slots[w * 64 + __builtin_ctzll(bits)]);
+			bits &= bits - 1;
+		}
+	}
+	lv_unlock();
+}
+
+void mailbox_get_stats(struct mailbox_stats *stats)
+{
+	stats->posts = atomic_load_explicit(&posts, memory_order_relaxed);
+	stats->coalesced = atomic_load_explicit(&coalesced,
+						memory_order_relaxed);
+	stats->invalid = atomic_load_explicit(&invalid, memory_order_relaxed);
+	stats->applied = applied;
+}
+
+/*
+ * Benchmark: four worker threads post 10k updates/s in total to 16 integer
+ * subjects, each bound to a label on a headless display, for a few seconds.
+ * Posting through the mailbox is compared with lv_lock() +
+ * lv_subject_set_int(). Reported are the time a worker spends per update
+ * and the frame time of the UI.
+ */
+#define MAILBOX_BENCH_SUBJECTS	16
+#define MAILBOX_BENCH_THREADS	4
+#define MAILBOX_BENCH_RATE	10000
+#define MAILBOX_BENCH_SECONDS	3
+
+static lv_subject_t bench_subjects[MAILBOX_BENCH_SUBJECTS];
+static int bench_ids[MAILBOX_BENCH_SUBJECTS];
+
+struct worker {
+	pthread_t thread;
+	int index;
+	bool locked;
+	atomic_bool *stop;
+	struct bench_frames latency;
+};
+
+static void *worker_thread(void *arg)
+{
+	struct worker *w = arg;
+	long period_ns = 1000000000L / (MAILBOX_BENCH_RATE /
+					 MAILBOX_BENCH_THREADS);
+	struct timespec next;
+	int32_t value = 0;
+	uint64_t t0;
+	int n;
+
+	bench_frames_reset(&w->latency);
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while (!atomic_load(w->stop)) {
+		n = (w->index + value * MAILBOX_BENCH_THREADS) %
+		    MAILBOX_BENCH_SUBJECTS;
+		value++;
+		t0 = bench_now_us();
+		if (w->locked) {
+			lv_lock();
+			lv_subject_set_int(&bench_subjects[n], value);
+			lv_unlock();
+		} else {
+			mailbox_post_int(bench_ids[n], value);
+		}
+		bench_frames_add(&w->latency, bench_now_us() - t0);
+
+		next.tv_nsec += period_ns;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+
+	return NULL;
+}
+
+static int bench_one(bool locked)
+{
+	struct worker workers[MAILBOX_BENCH_THREADS] = { 0 };
+	struct bench_frames latency;
+	struct bench_frames frames;
+	atomic_bool stop = false;
+	lv_display_t *disp;
+	lv_obj_t *label;
+	uint64_t end;
+	uint32_t idle;
+	int i;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	for (i = 0; i < MAILBOX_BENCH_SUBJECTS; i++) {
+		label = lv_label_create(lv_display_get_screen_active(disp));
+		lv_obj_set_pos(label, (i % 4) * (BENCH_HOR_RES / 4),
+			       (i / 4) * (BENCH_VER_RES / 4));
+		lv_label_bind_text(label, &bench_subjects[i], "%d");
+	}
+
+	bench_frames_reset(&frames);
+	bench_frames_attach(disp, &frames);
+	for (i = 0; i < MAILBOX_BENCH_THREADS; i++) {
+		workers[i].index = i;
+		workers[i].locked = locked;
+		workers[i].stop = &stop;
+		pthread_create(&workers[i].thread, NULL, worker_thread,
+			       &workers[i]);
+	}
+
+	end = bench_now_us() + MAILBOX_BENCH_SECONDS * 1000000ULL;
+	while (bench_now_us() < end) {
+		mailbox_drain();
+		idle = lv_timer_handler();
+		lv_delay_ms(LV_MIN(idle, 5));
+	}
+	atomic_store(&stop, true);
+
+	bench_frames_reset(&latency);
+	for (i = 0; i < MAILBOX_BENCH_THREADS; i++) {
+		pthread_join(workers[i].thread, NULL);
+		latency.count += workers[i].latency.count;
+		latency.total_us += workers[i].latency.total_us;
+		latency.min_us = LV_MIN(latency.min_us,
+					workers[i].latency.min_us);
+		latency.max_us = LV_MAX(latency.max_us,
+					workers[i].latency.max_us);
+	}
+	mailbox_drain();
+
+	printf("%s\n", locked ? "lv_lock + lv_subject_set_int" : "mailbox");
+	bench_frames_print("  producer (per update)", &latency);
+	bench_frames_print("  UI frames", &frames);
+
+	bench_display_delete(disp);
+
+	return 0;
+}
+
+int mailbox_bench(void)
+{
+	struct mailbox_stats stats;
+	int ret;
+	int i;
+
+	for (i = 0; i < MAILBOX_BENCH_SUBJECTS; i++) {
+		lv_subject_init_int(&bench_subjects[i], 0);
+		bench_ids[i] = mailbox_add(&bench_subjects[i]);
+		if (bench_ids[i] < 0) {
+			return -1;
+		}
+	}
+
+	ret = bench_one(true) || bench_one(false) ? -1 : 0;
+	// Out of range ids must be dropped, not written past the slots
+	mailbox_post_int(-1, 1);
+	mailbox_post_int(MAILBOX_SUBJECTS, 1);
+	mailbox_get_stats(&stats);
+	printf("mailbox posts %llu, coalesced %llu, subject sets %llu, "
+	       "%llu invalid\n",
+	       (unsigned long long)stats.posts,
+	       (unsigned long long)stats.coalesced,
+	       (unsigned long long)stats.applied,
+	       (unsigned long long)stats.invalid);
+	if (stats.invalid != 2) {
+		ret = -1;
+	}
+
+	for (i = 0; i < MAILBOX_BENCH_SUBJECTS; i++) {
+		lv_subject_deinit(&bench_subjects[i]);
+	}
+
+	return ret;
+}
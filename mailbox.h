@@ -0,0 +1,40 @@
+/*
+ * Lock-free mailbox for observer subject updates from background threads
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+#define MAILBOX_SUBJECTS 256
+
+struct mailbox_stats {
+	uint64_t posts;
+	uint64_t coalesced;	// posts overwritten before a drain
+	uint64_t invalid;	// posts to an id mailbox_add() never returned
+	uint64_t applied;	// lv_subject_set_*() calls made by drains
+};
+
+/* UI thread, before producers start: returns the subject's id or -1 */
+int mailbox_add(lv_subject_t *subject);
+
+/* Any thread, lock-free; posts to unknown ids are counted and dropped */
+void mailbox_post_int(int id, int32_t value);
+void mailbox_post_color(int id, lv_color_t color);
+
+/* UI thread, once per lv_timer_handler() cycle */
+void mailbox_drain(void);
+
+void mailbox_get_stats(struct mailbox_stats *stats);
+
+int mailbox_bench(void);
+
+#endif /* MAILBOX_H */
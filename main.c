@@ -18,18 +18,49 @@
 #include <unistd.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <time.h>
 #include <sys/time.h>
 
 #include "lvgl/lvgl.h"
 #include "lvgl/src/core/lv_global.h"
 
+#include "areamerge.h"
+#include "asyncimg.h"
+#include "bench.h"
+#include "capture.h"
+#include "drawbuf.h"
+#include "governor.h"
+#include "kbdinc.h"
+#include "layerpool.h"
+#include "layoutinc.h"
+#include "mailbox.h"
+#include "mirror.h"
+#include "multipanel.h"
+#include "objscale.h"
+#include "primcache.h"
+#include "refrstat.h"
+#include "rotate.h"
+#include "rt.h"
+#include "shmpub.h"
+#include "timerheap.h"
+#include "touchfilt.h"
+#include "tune.h"
+#include "vscroll.h"
+#include "vsync.h"
+
 static lv_obj_t *background = NULL;
 static lv_obj_t *status = NULL;
 static lv_obj_t *button = NULL;
 static lv_obj_t *button_label = NULL;
 static lv_obj_t *slider = NULL;
 static lv_obj_t *slider_label = NULL;
+static lv_subject_t slider_value;
+static lv_subject_t message;
+static char message_buf[SHMPUB_STR_MAX];
+static char message_prev[SHMPUB_STR_MAX];
+static struct areamerge_cost merge_cost;
+static struct vsync_source vsync_src;
 
 static void btn_event_cb(lv_event_t *ev)
 {
@@ -43,7 +74,7 @@ static void btn_event_cb(lv_event_t *ev)
 	}
 }
 
-static void slider_event_cb(lv_event_t *ev)
+static void slider_label_update(void)
 {
 	static char text[4] = { '\0' };
 
@@ -52,27 +83,237 @@ static void slider_event_cb(lv_event_t *ev)
 	lv_obj_align_to(slider_label, slider, LV_ALIGN_OUT_BOTTOM_MID, 0, 0);
 }
 
+static void slider_event_cb(lv_event_t *ev)
+{
+	slider_label_update();
+}
+
+/* A bound subject moves the slider without LV_EVENT_VALUE_CHANGED */
+static void slider_observer_cb(lv_observer_t *observer, lv_subject_t *subject)
+{
+	slider_label_update();
+}
+
+static uint32_t tick_get_cb(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Sleep instead of spinning on the tick, which would starve SCHED_FIFO peers
+static void delay_cb(uint32_t ms)
+{
+	usleep(ms * 1000);
+}
+
+static void usage(const char *prog)
+{
+	fprintf(stderr, "usage: %s [-c profile] [-v] [-b scenario] [-p socket]\n"
+		"       [-m address] [-s socket]\n"
+		"  -c profile  runtime tuning profile (default %s)\n"
+		"  -v          report tuning settings and build limits\n"
+		"  -b scenario run a headless benchmark scenario and exit\n"
+		"  -p socket   run a demo producer for the shmpub_socket of a UI\n"
+		"  -m address  view the mirror_socket of a UI as PPM frames on stdout\n"
+		"  -s socket   write a screenshot from the capture_socket of a UI as PNG\n"
+		"              to stdout\n",
+		prog, TUNE_DEFAULT_PATH);
+	bench_list(stderr);
+}
+
 int main(int argc, char* argv[])
 {
-	uint8_t count = 0;
 	lv_indev_t *touch = NULL;
+	lv_indev_t *touch2 = NULL;
 	lv_display_t *disp = NULL;
+	lv_display_t *panel2 = NULL;
+	lv_obj_t *obj;
 	char *device = NULL;
+	const char *profile = NULL;
+	const char *scenario = NULL;
+	const char *producer = NULL;
+	const char *viewer = NULL;
+	const char *shot = NULL;
+	int verbose = 0;
+	uint32_t idle;
 	time_t t = time(NULL);
+	time_t report = t;
+	time_t refrstat_t = t;
+	int opt;
+	int ret;
+
+	while ((opt = getopt(argc, argv, "c:vb:p:m:s:")) != -1) {
+		switch (opt) {
+		case 'c':
+			profile = optarg;
+			break;
+		case 'b':
+			scenario = optarg;
+			break;
+		case 'p':
+			producer = optarg;
+			break;
+		case 'm':
+			viewer = optarg;
+			break;
+		case 's':
+			shot = optarg;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	// Producer stand-in: another process, no display of its own
+	if (producer) {
+		return shmpub_producer(producer, 1000, 0) ?
+		       EXIT_FAILURE : EXIT_SUCCESS;
+	}
+	if (viewer) {
+		return mirror_view(viewer, stdout) ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+	if (shot) {
+		return capture_fetch(shot, CAPTURE_PNG, stdout) ?
+		       EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	// Runtime tuning (before LVGL so device paths are known)
+	if (tune_load(profile) && profile) {
+		return EXIT_FAILURE;
+	}
+	if (verbose) {
+		tune_report();
+	}
+
+	// Memory locking and thread bookkeeping must precede LVGL's threads
+	rt_init();
 
 	// LVGL Setup
 	lv_init();
+	lv_tick_set_cb(tick_get_cb);
+	lv_delay_set_cb(delay_cb);
+
+	// Headless benchmark scenarios do not touch DRM or evdev
+	if (scenario) {
+		return bench_run(scenario) ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
 
 	disp = lv_linux_drm_create();
-	device = lv_linux_drm_find_device_path();
-	lv_linux_drm_set_file(disp, device, -1);
-	lv_free(device);
-	device = NULL;
+	if (tune.drm_device[0]) {
+		lv_linux_drm_set_file(disp, tune.drm_device, -1);
+	} else {
+		device = lv_linux_drm_find_device_path();
+		lv_linux_drm_set_file(disp, device, -1);
+		lv_free(device);
+		device = NULL;
+	}
 
 	// Touchscreen
-	touch = lv_evdev_create(LV_INDEV_TYPE_POINTER, "/dev/input/event1");
+	touch = lv_evdev_create(LV_INDEV_TYPE_POINTER, tune.input_device);
 	lv_indev_set_display(touch, disp);
 
+	// Apply the profile before the first frame is rendered
+	tune_apply(disp, touch);
+	// Scanout can flip the frame instead of every flush; 90 and 270 would
+	// need portrait framebuffers, which the DRM driver does not allocate
+	if (tune.rotation == 180 && tune.rotation_offload &&
+	    !rotate_drm_plane(LV_DISPLAY_ROTATION_180)) {
+		lv_display_set_rotation(disp, LV_DISPLAY_ROTATION_0);
+		rotate_indev_init(touch, LV_DISPLAY_ROTATION_180);
+	}
+	if (tune.touch_median || tune.touch_iir < 256 || tune.touch_deadband ||
+	    tune.touch_predict || tune.touch_record[0]) {
+		struct touchfilt_cfg tf = {
+			.median = tune.touch_median,
+			.iir = tune.touch_iir,
+			.deadband = tune.touch_deadband,
+			.predict_ms = tune.touch_predict,
+		};
+
+		touchfilt_init(touch, &tf, tune.touch_record[0] ?
+			       tune.touch_record : NULL);
+	}
+	governor_init(disp);
+	if (tune.layoutinc) {
+		layoutinc_init(disp, tune.layoutinc == 2);
+	}
+	if (tune.drawbuf_arena) {
+		drawbuf_init(tune.drawbuf_arena, tune.drawbuf_huge,
+			     tune.drawbuf_mlock);
+	}
+	if (tune.layer_pool) {
+		layerpool_init(disp, tune.layer_pool);
+	}
+	objscale_cache_enable(tune.style_cache);
+	timerheap_init();
+	if (tune.vscroll) {
+		vscroll_init(disp, &vscroll_drm_panel);
+	}
+	if (tune.areamerge) {
+		areamerge_cost_init(&merge_cost, disp, tune.areamerge_tx_ns,
+				    tune.areamerge_px_ns);
+		areamerge_init(disp, areamerge_cost_cb, &merge_cost, &merge_cost);
+	}
+	if (tune.refrstat || tune.refrstat_csv[0]) {
+		refrstat_start(disp, tune.refrstat_csv[0] ? tune.refrstat_csv
+							  : NULL);
+	}
+	rt_setup(disp);
+	// Only LVGL's draw threads may exist before rt_setup(); background
+	// threads started from here on drop to SCHED_OTHER themselves
+	{
+		struct asyncimg_cfg ai = {
+			.threads = tune.asyncimg_threads,
+			.queue = tune.asyncimg_queue,
+			.lowres = tune.asyncimg_lowres,
+		};
+
+		asyncimg_init(&ai);
+	}
+	if (tune.mirror_socket[0]) {
+		mirror_start(disp, tune.mirror_socket, tune.mirror_queue);
+	}
+	if (tune.capture_socket[0] || tune.capture_dir[0]) {
+		capture_start(disp, NULL,
+			      tune.capture_socket[0] ? tune.capture_socket : NULL,
+			      tune.capture_dir[0] ? tune.capture_dir : NULL,
+			      tune.capture_ppm);
+	}
+	// Started after rt_setup(): a pacing thread inherits the UI priority
+	if (tune.vsync) {
+		if (tune.vsync_fake_hz) {
+			ret = vsync_source_open_fake(&vsync_src,
+						     tune.vsync_fake_hz);
+		} else {
+			if (!tune.drm_device[0]) {
+				device = lv_linux_drm_find_device_path();
+			}
+			ret = vsync_source_open_drm(&vsync_src, device ? device
+						    : tune.drm_device,
+						    tune.vsync_crtc);
+			lv_free(device);
+			device = NULL;
+		}
+		// With two panels the multipanel scheduler does the rendering
+		if (!ret) {
+			vsync_start(disp, &vsync_src, tune.vsync == 2 &&
+				    !tune.panel2_drm_device[0]);
+		}
+	}
+	if (tune.rt_input_thread) {
+		rt_input_start(touch, tune.input_device);
+	}
+	if (tune.rt_jitter) {
+		rt_jitter_start(tune.refr_period);
+	}
+
 	// Set background text on the screen
 	background = lv_label_create(lv_screen_active());
 	lv_label_set_text(background, "Light and Versatile Graphics Library");
@@ -97,20 +338,105 @@ int main(int argc, char* argv[])
 	lv_label_set_text(slider_label, "0");
 	lv_obj_align_to(slider_label, slider, LV_ALIGN_OUT_BOTTOM_MID, 0, 0);
 
+	// Values published by other processes
+	if (tune.shmpub_socket[0] && !shmpub_server_start(tune.shmpub_socket)) {
+		lv_subject_init_int(&slider_value, 0);
+		lv_slider_bind_value(slider, &slider_value);
+		lv_subject_add_observer_obj(&slider_value, slider_observer_cb,
+					    slider_label, NULL);
+		shmpub_bind_subject("slider", &slider_value);
+		lv_subject_init_string(&message, message_buf, message_prev,
+				       sizeof(message_buf),
+				       lv_label_get_text(background));
+		lv_label_bind_text(background, &message, NULL);
+		shmpub_bind_subject("message", &message);
+	}
+
 	// Set status (time) text on the screen
 	status = lv_label_create(lv_screen_active());
 	lv_label_set_text(status, asctime(localtime(&t)));
 	lv_obj_align(status, LV_ALIGN_CENTER, 0, 100);
 
+	if (tune.primcache) {
+		primcache_init(disp, tune.primcache);
+		primcache_attach(lv_screen_active());
+	}
+	if (tune.kbdinc) {
+		kbdinc_init(disp, tune.kbdinc);
+	}
+
+	// A second panel shares the heap, draw units and caches of the first;
+	// the two take turns rendering, each with its own touchscreen
+	if (tune.panel2_drm_device[0]) {
+		panel2 = lv_linux_drm_create();
+		lv_linux_drm_set_file(panel2, tune.panel2_drm_device, -1);
+		lv_display_set_rotation(panel2, tune.rotation / 90);
+		if (tune.panel2_input_device[0]) {
+			touch2 = lv_evdev_create(LV_INDEV_TYPE_POINTER,
+						 tune.panel2_input_device);
+		}
+		multipanel_add(disp, touch, tune.refr_period);
+		multipanel_add(panel2, touch2, tune.panel2_refr_period ?
+			       tune.panel2_refr_period : tune.refr_period);
+
+		obj = lv_label_create(lv_display_get_screen_active(panel2));
+		lv_label_set_text(obj, "Light and Versatile Graphics Library");
+		lv_obj_align(obj, LV_ALIGN_CENTER, 0, 75);
+		obj = lv_slider_create(lv_display_get_screen_active(panel2));
+		lv_obj_set_size(obj, 200, 50);
+		lv_obj_center(obj);
+		lv_display_set_default(disp);
+	}
+
 	while (1) {
-		if (++count == 10) {
+		if (time(NULL) != t) {
 			t = time(NULL);
+			lv_lock();
 			lv_obj_clean(status);
 			lv_label_set_text(status, asctime(localtime(&t)));
-			count = 0;
+			lv_unlock();
+		}
+		if (tune.rt_jitter && t - report >= (time_t)tune.rt_jitter) {
+			rt_jitter_report();
+			report = t;
+		}
+		if (tune.refrstat && t - refrstat_t >= (time_t)tune.refrstat) {
+			refrstat_report(stdout);
+			if (tune.layer_pool) {
+				layerpool_report(stdout);
+			}
+			if (tune.vsync) {
+				vsync_report(stdout);
+				vsync_reset();
+			}
+			if (tune.layoutinc) {
+				layoutinc_report(stdout);
+				layoutinc_reset();
+			}
+			if (tune.primcache) {
+				primcache_report(stdout);
+				primcache_reset();
+			}
+			if (tune.kbdinc) {
+				kbdinc_report(stdout);
+				kbdinc_reset();
+			}
+			if (tune.style_cache) {
+				objscale_cache_report(stdout);
+				objscale_cache_reset();
+			}
+			if (panel2) {
+				multipanel_report(stdout);
+				multipanel_reset();
+			}
+			refrstat_reset();
+			refrstat_t = t;
 		}
-		lv_timer_handler();
-		lv_delay_ms(100);
+		mailbox_drain();
+		asyncimg_drain();
+		shmpub_update();
+		idle = lv_timer_handler();
+		shmpub_wait(LV_MIN(idle, tune.loop_period));
 	}
 
 	return 0;
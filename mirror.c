@@ -0,0 +1,1035 @@
+/*
+ * Compressed dirty rectangle mirror stream
+ *
+ * A tap in front of the display's flush callback copies every flushed area
+ * into a shadow frame and collects the frame's dirty rectangles. At
+ * LV_EVENT_REFR_READY the rectangles are packed into one of a few queue
+ * slots for the encoder thread, which XORs them against the frame the
+ * viewer already has, PackBits-encodes the result (unchanged pixels become
+ * zero runs) and writes it to the connected viewer. The render thread only
+ * copies; it never waits for the encoder or the socket.
+ *
+ * When the queue is full the frame is dropped and the next one is sent as a
+ * keyframe taken from the shadow frame. A new viewer gets a full redraw.
+ *
+ * Stream (little endian):
+ *   hello  "LVMH" u16 hor_res, ver_res, px_size, color format
+ *   frame  "LVMF" u32 seq, u16 flags (1: keyframe), u16 rects,
+ *          rects * { u16 x, y, w, h, u32 len, len bytes }
+ * Rect data is PackBits (n < 128: n + 1 literals, n >= 128: next byte
+ * n - 126 times) of the pixel rows XORed with the previous frame, or with
+ * zero for keyframes.
+ *
+ * Rows moved by vscroll are not flushed, so do not combine it with vscroll.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#define _GNU_SOURCE
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "lvgl/src/display/lv_display_private.h"
+
+#include "bench.h"
+#include "mirror.h"
+#include "rt.h"
+
+#define MIRROR_MAX_RECTS	16
+#define MIRROR_MAX_QUEUE	16
+#define MIRROR_HDR		12
+#define MIRROR_RECT_HDR		12
+#define MIRROR_KEY		1
+
+struct rect {
+	uint16_t x;
+	uint16_t y;
+	uint16_t w;
+	uint16_t h;
+};
+
+struct slot {
+	uint32_t seq;
+	bool key;
+	uint16_t nrects;
+	struct rect rects[MIRROR_MAX_RECTS];
+	uint8_t *px;		// rectangles packed row by row
+};
+
+static struct {
+	lv_display_t *disp;
+	lv_display_flush_cb_t flush_cb;
+	uint32_t hor_res;
+	uint32_t ver_res;
+	uint32_t px_size;
+	uint32_t stride;
+	uint32_t cf;
+	size_t frame;		// [bytes]
+
+	/* render thread */
+	uint8_t *shadow;
+	struct rect rects[MIRROR_MAX_RECTS];
+	uint16_t nrects;
+	size_t bytes;		// pixel bytes of rects, at most frame
+	bool key;
+	uint32_t seq;
+	uint64_t t0;
+
+	/* queue */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	struct slot slots[MIRROR_MAX_QUEUE];
+	uint32_t nslots;
+	uint32_t head;
+	uint32_t tail;
+	bool stop;
+
+	/* encoder thread */
+	pthread_t thread;
+	int lfd;
+	int cfd;
+	bool await_key;
+	uint8_t *ref;
+	uint8_t *xor;
+	uint8_t *out;
+	atomic_bool connected;
+	atomic_bool want_full;
+
+	struct mirror_stats stats;	// both threads, under lock
+} mir = { .lfd = -1, .cfd = -1 };
+
+static void put16(uint8_t *p, uint16_t v)
+{
+	p[0] = v;
+	p[1] = v >> 8;
+}
+
+static void put32(uint8_t *p, uint32_t v)
+{
+	put16(p, v);
+	put16(p + 2, v >> 16);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+	return p[0] | p[1] << 8;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+	return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
+
+static size_t packbits(uint8_t *dst, const uint8_t *src, size_t n)
+{
+	uint8_t *d = dst;
+	size_t i = 0;
+	size_t start;
+	size_t run;
+
+	while (i < n) {
+		for (run = 1; i + run < n && run < 129 &&
+		     src[i + run] == src[i]; run++) {
+		}
+		if (run >= 3) {
+			*d++ = run + 126;
+			*d++ = src[i];
+			i += run;
+			continue;
+		}
+		for (start = i; i < n && i - start < 128; i++) {
+			if (i + 2 < n && src[i] == src[i + 1] &&
+			    src[i] == src[i + 2]) {
+				break;
+			}
+		}
+		*d++ = i - start - 1;
+		memcpy(d, src + start, i - start);
+		d += i - start;
+	}
+
+	return d - dst;
+}
+
+static int unpackbits(uint8_t *dst, size_t n, const uint8_t *src, size_t len)
+{
+	const uint8_t *end = src + len;
+	size_t i = 0;
+	size_t cnt;
+	uint8_t h;
+
+	while (src < end) {
+		h = *src++;
+		if (h < 128) {
+			cnt = h + 1;
+			if (i + cnt > n || src + cnt > end) {
+				return -1;
+			}
+			memcpy(dst + i, src, cnt);
+			src += cnt;
+		} else {
+			cnt = h - 126;
+			if (i + cnt > n || src == end) {
+				return -1;
+			}
+			memset(dst + i, *src++, cnt);
+		}
+		i += cnt;
+	}
+
+	return i == n ? 0 : -1;
+}
+
+/* Render thread */
+
+static void clear_rects(void)
+{
+	mir.nrects = 0;
+	mir.bytes = 0;
+}
+
+/*
+ * LVGL does not join every overlapping pair of areas, so a frame's areas
+ * can add up to more than the frame. The slots, mir.xor and mir.out hold
+ * one frame: past that, or out of rectangles, send the bounding box.
+ */
+static void add_rect(const lv_area_t *a)
+{
+	size_t bytes = (size_t)lv_area_get_size(a) * mir.px_size;
+	struct rect *r = mir.rects;
+	int32_t x2;
+	int32_t y2;
+	int i;
+
+	if (mir.nrects < MIRROR_MAX_RECTS && mir.bytes + bytes <= mir.frame) {
+		r = &mir.rects[mir.nrects++];
+		r->x = a->x1;
+		r->y = a->y1;
+		r->w = a->x2 - a->x1 + 1;
+		r->h = a->y2 - a->y1 + 1;
+		mir.bytes += bytes;
+		return;
+	}
+
+	if (mir.nrects < MIRROR_MAX_RECTS) {
+		pthread_mutex_lock(&mir.lock);
+		mir.stats.overflows++;
+		pthread_mutex_unlock(&mir.lock);
+	}
+	x2 = a->x2;
+	y2 = a->y2;
+	for (i = 0; i < mir.nrects; i++) {
+		x2 = LV_MAX(x2, mir.rects[i].x + mir.rects[i].w - 1);
+		y2 = LV_MAX(y2, mir.rects[i].y + mir.rects[i].h - 1);
+		r->x = LV_MIN(r->x, mir.rects[i].x);
+		r->y = LV_MIN(r->y, mir.rects[i].y);
+	}
+	r->x = LV_MIN(r->x, a->x1);
+	r->y = LV_MIN(r->y, a->y1);
+	r->w = x2 - r->x + 1;
+	r->h = y2 - r->y + 1;
+	mir.nrects = 1;
+	mir.bytes = (size_t)r->w * r->h * mir.px_size;
+}
+
+static void tap_flush_cb(lv_display_t *disp, const lv_area_t *area,
+			 uint8_t *px_map)
+{
+	uint32_t w = area->x2 - area->x1 + 1;
+	uint32_t src_stride;
+	const uint8_t *src = px_map;
+	uint8_t *dst;
+	uint64_t t0;
+	int32_t y;
+
+	if (atomic_load_explicit(&mir.connected, memory_order_relaxed)) {
+		t0 = bench_now_us();
+		if (disp->render_mode == LV_DISPLAY_RENDER_MODE_PARTIAL) {
+			src_stride = lv_draw_buf_width_to_stride(w, mir.cf);
+		} else {
+			src_stride = disp->buf_act->header.stride;
+			src += area->y1 * src_stride + area->x1 * mir.px_size;
+		}
+		dst = mir.shadow + area->y1 * mir.stride +
+		      area->x1 * mir.px_size;
+		for (y = area->y1; y <= area->y2; y++) {
+			memcpy(dst, src, w * mir.px_size);
+			dst += mir.stride;
+			src += src_stride;
+		}
+		add_rect(area);
+		t0 = bench_now_us() - t0;
+		pthread_mutex_lock(&mir.lock);
+		mir.stats.tap_us += t0;
+		pthread_mutex_unlock(&mir.lock);
+	}
+
+	mir.flush_cb(disp, area, px_map);
+}
+
+static void pack(struct slot *s)
+{
+	uint8_t *dst = s->px;
+	const uint8_t *src;
+	uint32_t y;
+	int i;
+
+	s->nrects = mir.nrects;
+	memcpy(s->rects, mir.rects, mir.nrects * sizeof(mir.rects[0]));
+	for (i = 0; i < s->nrects; i++) {
+		src = mir.shadow + s->rects[i].y * mir.stride +
+		      s->rects[i].x * mir.px_size;
+		for (y = 0; y < s->rects[i].h; y++) {
+			memcpy(dst, src, s->rects[i].w * mir.px_size);
+			dst += s->rects[i].w * mir.px_size;
+			src += mir.stride;
+		}
+	}
+}
+
+static void tap_event_cb(lv_event_t *e)
+{
+	struct slot *s;
+	uint64_t t0;
+	bool full;
+
+	if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+		if (atomic_exchange(&mir.want_full, false)) {
+			lv_obj_invalidate(lv_display_get_screen_active(mir.disp));
+			mir.key = true;
+		}
+		return;
+	}
+
+	if (!atomic_load_explicit(&mir.connected, memory_order_relaxed) ||
+	    (!mir.nrects && !mir.key)) {
+		clear_rects();
+		return;
+	}
+
+	t0 = bench_now_us();
+	pthread_mutex_lock(&mir.lock);
+	full = mir.head - mir.tail == mir.nslots;
+	mir.stats.drops += full;
+	pthread_mutex_unlock(&mir.lock);
+	if (full) {
+		mir.key = true;
+		clear_rects();
+		return;
+	}
+
+	// Only this thread writes slots[head] until head moves
+	s = &mir.slots[mir.head % mir.nslots];
+	s->seq = mir.seq++;
+	s->key = mir.key;
+	if (mir.key) {
+		mir.rects[0] = (struct rect){ 0, 0, mir.hor_res, mir.ver_res };
+		mir.nrects = 1;
+	}
+	pack(s);
+	mir.key = false;
+	clear_rects();
+
+	t0 = bench_now_us() - t0;
+	pthread_mutex_lock(&mir.lock);
+	mir.head++;
+	mir.stats.tap_us += t0;
+	pthread_cond_signal(&mir.cond);
+	pthread_mutex_unlock(&mir.lock);
+}
+
+/* Encoder thread */
+
+static int write_all(int fd, const uint8_t *buf, size_t len)
+{
+	ssize_t n;
+
+	while (len) {
+		n = send(fd, buf, len, MSG_NOSIGNAL);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return -1;
+		}
+		buf += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+static void drop_client(void)
+{
+	atomic_store(&mir.connected, false);
+	close(mir.cfd);
+	mir.cfd = -1;
+}
+
+static void accept_client(void)
+{
+	struct timeval tv = { .tv_sec = 1 };
+	uint8_t hello[12] = { 'L', 'V', 'M', 'H' };
+	int one = 1;
+	int fd;
+
+	fd = accept4(mir.lfd, NULL, NULL, SOCK_CLOEXEC);
+	if (fd < 0) {
+		return;
+	}
+	if (mir.cfd >= 0) {
+		drop_client();
+	}
+	// A stalled viewer must not block the encoder forever
+	setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+	put16(hello + 4, mir.hor_res);
+	put16(hello + 6, mir.ver_res);
+	put16(hello + 8, mir.px_size);
+	put16(hello + 10, mir.cf);
+	if (write_all(fd, hello, sizeof(hello))) {
+		close(fd);
+		return;
+	}
+	mir.cfd = fd;
+	mir.await_key = true;
+	atomic_store(&mir.want_full, true);
+	atomic_store(&mir.connected, true);
+}
+
+static void encode_send(struct slot *s)
+{
+	uint8_t *p = mir.out + MIRROR_HDR;
+	uint8_t *src = s->px;
+	uint8_t *ref;
+	uint32_t row;
+	uint32_t len;
+	uint32_t raw = 0;
+	uint32_t i;
+	uint32_t x;
+	uint32_t y;
+	uint64_t t0 = bench_now_us();
+	bool sent;
+
+	if (s->key) {
+		memset(mir.ref, 0, mir.stride * mir.ver_res);
+	}
+
+	memcpy(mir.out, "LVMF", 4);
+	put32(mir.out + 4, s->seq);
+	put16(mir.out + 8, s->key ? MIRROR_KEY : 0);
+	put16(mir.out + 10, s->nrects);
+	for (i = 0; i < s->nrects; i++) {
+		struct rect *r = &s->rects[i];
+
+		row = r->w * mir.px_size;
+		ref = mir.ref + r->y * mir.stride + r->x * mir.px_size;
+		for (y = 0; y < r->h; y++) {
+			for (x = 0; x < row; x++) {
+				mir.xor[y * row + x] = src[x] ^ ref[x];
+			}
+			memcpy(ref, src, row);
+			ref += mir.stride;
+			src += row;
+		}
+		len = packbits(p + MIRROR_RECT_HDR, mir.xor, row * r->h);
+		put16(p, r->x);
+		put16(p + 2, r->y);
+		put16(p + 4, r->w);
+		put16(p + 6, r->h);
+		put32(p + 8, len);
+		p += MIRROR_RECT_HDR + len;
+		raw += row * r->h;
+	}
+
+	len = p - mir.out;
+	t0 = bench_now_us() - t0;
+	sent = !write_all(mir.cfd, mir.out, len);
+
+	pthread_mutex_lock(&mir.lock);
+	mir.stats.encode_us += t0;
+	mir.stats.encode_max_us = LV_MAX(mir.stats.encode_max_us, t0);
+	if (sent) {
+		mir.stats.frames++;
+		mir.stats.keyframes += s->key;
+		mir.stats.raw_bytes += raw;
+		mir.stats.sent_bytes += len;
+	}
+	pthread_mutex_unlock(&mir.lock);
+	if (!sent) {
+		drop_client();
+	}
+}
+
+static void *encoder_thread(void *arg)
+{
+	struct timespec ts;
+	struct slot *s;
+
+	rt_background();
+	pthread_mutex_lock(&mir.lock);
+	while (1) {
+		if (mir.head == mir.tail) {
+			if (mir.stop) {
+				break;
+			}
+			clock_gettime(CLOCK_REALTIME, &ts);
+			ts.tv_nsec += 100000000;
+			if (ts.tv_nsec >= 1000000000) {
+				ts.tv_nsec -= 1000000000;
+				ts.tv_sec++;
+			}
+			pthread_cond_timedwait(&mir.cond, &mir.lock, &ts);
+		}
+		pthread_mutex_unlock(&mir.lock);
+
+		accept_client();
+
+		pthread_mutex_lock(&mir.lock);
+		if (mir.head == mir.tail) {
+			continue;
+		}
+		s = &mir.slots[mir.tail % mir.nslots];
+		pthread_mutex_unlock(&mir.lock);
+
+		if (mir.cfd >= 0 && (s->key || !mir.await_key)) {
+			mir.await_key = false;
+			encode_send(s);
+		}
+
+		pthread_mutex_lock(&mir.lock);
+		mir.tail++;
+	}
+	pthread_mutex_unlock(&mir.lock);
+
+	return NULL;
+}
+
+static int sock_addr(const char *addr, struct sockaddr_storage *ss,
+		     socklen_t *len)
+{
+	struct sockaddr_un *un = (struct sockaddr_un *)ss;
+	struct sockaddr_in *in = (struct sockaddr_in *)ss;
+	const char *port;
+	char host[16] = "127.0.0.1";
+
+	memset(ss, 0, sizeof(*ss));
+	if (strncmp(addr, "tcp:", 4)) {
+		if (strlen(addr) >= sizeof(un->sun_path)) {
+			return -1;
+		}
+		un->sun_family = AF_UNIX;
+		strcpy(un->sun_path, addr);
+		*len = sizeof(*un);
+		return 0;
+	}
+
+	addr += 4;
+	port = strrchr(addr, ':');
+	if (port) {
+		if ((size_t)(port - addr) >= sizeof(host)) {
+			return -1;
+		}
+		memcpy(host, addr, port - addr);
+		host[port - addr] = '\0';
+		port++;
+	} else {
+		port = addr;
+	}
+	in->sin_family = AF_INET;
+	in->sin_port = htons(atoi(port));
+	*len = sizeof(*in);
+
+	return inet_pton(AF_INET, host, &in->sin_addr) == 1 ? 0 : -1;
+}
+
+int mirror_start(lv_display_t *disp, const char *addr, uint32_t queue)
+{
+	struct sockaddr_storage ss;
+	size_t frame;
+	socklen_t len;
+	uint32_t i;
+	int one = 1;
+
+	if (sock_addr(addr, &ss, &len)) {
+		fprintf(stderr, "mirror: bad address '%s'\n", addr);
+		return -1;
+	}
+
+	mir.disp = disp;
+	mir.hor_res = lv_display_get_horizontal_resolution(disp);
+	mir.ver_res = lv_display_get_vertical_resolution(disp);
+	mir.cf = lv_display_get_color_format(disp);
+	mir.px_size = lv_color_format_get_size(mir.cf);
+	mir.stride = mir.hor_res * mir.px_size;
+	mir.nslots = LV_CLAMP(1, queue, MIRROR_MAX_QUEUE);
+
+	frame = (size_t)mir.stride * mir.ver_res;
+	mir.frame = frame;
+	mir.shadow = calloc(1, frame);
+	mir.ref = calloc(1, frame);
+	mir.xor = malloc(frame);
+	mir.out = malloc(MIRROR_HDR + MIRROR_MAX_RECTS * MIRROR_RECT_HDR +
+			 frame + frame / 128 + MIRROR_MAX_RECTS);
+	if (!mir.shadow || !mir.ref || !mir.xor || !mir.out) {
+		goto fail;
+	}
+	for (i = 0; i < mir.nslots; i++) {
+		mir.slots[i].px = malloc(frame);
+		if (!mir.slots[i].px) {
+			goto fail;
+		}
+	}
+
+	mir.lfd = socket(ss.ss_family, SOCK_STREAM | SOCK_CLOEXEC |
+			 SOCK_NONBLOCK, 0);
+	if (mir.lfd < 0) {
+		goto fail;
+	}
+	if (ss.ss_family == AF_UNIX) {
+		unlink(addr);
+	} else {
+		setsockopt(mir.lfd, SOL_SOCKET, SO_REUSEADDR, &one,
+			   sizeof(one));
+	}
+	if (bind(mir.lfd, (struct sockaddr *)&ss, len) ||
+	    listen(mir.lfd, 1)) {
+		fprintf(stderr, "mirror: %s: %s\n", addr, strerror(errno));
+		goto fail;
+	}
+
+	pthread_mutex_init(&mir.lock, NULL);
+	pthread_cond_init(&mir.cond, NULL);
+	if (pthread_create(&mir.thread, NULL, encoder_thread, NULL)) {
+		goto fail;
+	}
+
+	mir.flush_cb = disp->flush_cb;
+	lv_display_set_flush_cb(disp, tap_flush_cb);
+	lv_display_add_event_cb(disp, tap_event_cb, LV_EVENT_REFR_START, NULL);
+	lv_display_add_event_cb(disp, tap_event_cb, LV_EVENT_REFR_READY, NULL);
+
+	return 0;
+
+fail:
+	if (mir.lfd >= 0) {
+		close(mir.lfd);
+	}
+	for (i = 0; i < mir.nslots; i++) {
+		free(mir.slots[i].px);
+	}
+	free(mir.shadow);
+	free(mir.ref);
+	free(mir.xor);
+	free(mir.out);
+	memset(&mir, 0, sizeof(mir));
+	mir.lfd = mir.cfd = -1;
+
+	return -1;
+}
+
+/* Sends what is queued, then disconnects the viewer */
+void mirror_stop(void)
+{
+	uint32_t i;
+
+	if (!mir.disp) {
+		return;
+	}
+	lv_display_remove_event_cb_with_user_data(mir.disp, tap_event_cb,
+						  NULL);
+	lv_display_set_flush_cb(mir.disp, mir.flush_cb);
+
+	pthread_mutex_lock(&mir.lock);
+	mir.stop = true;
+	pthread_cond_signal(&mir.cond);
+	pthread_mutex_unlock(&mir.lock);
+	pthread_join(mir.thread, NULL);
+	pthread_mutex_destroy(&mir.lock);
+	pthread_cond_destroy(&mir.cond);
+
+	if (mir.cfd >= 0) {
+		close(mir.cfd);
+	}
+	close(mir.lfd);
+	for (i = 0; i < mir.nslots; i++) {
+		free(mir.slots[i].px);
+	}
+	free(mir.shadow);
+	free(mir.ref);
+	free(mir.xor);
+	free(mir.out);
+	memset(&mir, 0, sizeof(mir));
+	mir.lfd = mir.cfd = -1;
+}
+
+void mirror_get_stats(struct mirror_stats *stats)
+{
+	pthread_mutex_lock(&mir.lock);
+	*stats = mir.stats;
+	pthread_mutex_unlock(&mir.lock);
+}
+
+/* Reference decoder */
+
+int mirror_connect(const char *addr)
+{
+	struct sockaddr_storage ss;
+	socklen_t len;
+	int fd;
+
+	if (sock_addr(addr, &ss, &len)) {
+		return -1;
+	}
+	fd = socket(ss.ss_family, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *)&ss, len)) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+static int read_all(int fd, void *buf, size_t len)
+{
+	uint8_t *p = buf;
+	ssize_t n;
+
+	while (len) {
+		n = read(fd, p, len);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return n ? -1 : 1;
+		}
+		p += n;
+		len -= n;
+	}
+
+	return 0;
+}
+
+int mirror_decode(struct mirror_decoder *d, int fd)
+{
+	uint8_t hdr[MIRROR_HDR];
+	uint8_t *enc = NULL;
+	uint8_t *xor = NULL;
+	uint8_t *dst;
+	uint32_t nrects;
+	uint32_t len;
+	uint32_t row;
+	uint32_t x, y, w, h;
+	uint32_t i, j, k;
+	int ret;
+
+	ret = read_all(fd, hdr, MIRROR_HDR);
+	if (ret) {
+		return ret > 0 ? 0 : -1;
+	}
+	if (!memcmp(hdr, "LVMH", 4)) {
+		mirror_decoder_free(d);
+		d->hor_res = get16(hdr + 4);
+		d->ver_res = get16(hdr + 6);
+		d->px_size = get16(hdr + 8);
+		d->cf = get16(hdr + 10);
+		d->fb = calloc(d->ver_res, d->hor_res * d->px_size);
+		if (!d->fb) {
+			return -1;
+		}
+		return mirror_decode(d, fd);
+	}
+	if (memcmp(hdr, "LVMF", 4) || !d->fb) {
+		return -1;
+	}
+
+	if (get16(hdr + 8) & MIRROR_KEY) {
+		memset(d->fb, 0, d->ver_res * d->hor_res * d->px_size);
+	}
+	nrects = get16(hdr + 10);
+	for (i = 0; i < nrects; i++) {
+		if (read_all(fd, hdr, MIRROR_RECT_HDR)) {
+			break;
+		}
+		x = get16(hdr);
+		y = get16(hdr + 2);
+		w = get16(hdr + 4);
+		h = get16(hdr + 6);
+		len = get32(hdr + 8);
+		row = w * d->px_size;
+		if (x + w > d->hor_res || y + h > d->ver_res ||
+		    len > row * h + row * h / 128 + 1) {
+			break;
+		}
+		enc = malloc(len);
+		xor = malloc((size_t)row * h);
+		if (!enc || !xor || read_all(fd, enc, len) ||
+		    unpackbits(xor, (size_t)row * h, enc, len)) {
+			break;
+		}
+		for (j = 0; j < h; j++) {
+			dst = d->fb + ((y + j) * d->hor_res + x) * d->px_size;
+			for (k = 0; k < row; k++) {
+				dst[k] ^= xor[j * row + k];
+			}
+		}
+		free(enc);
+		free(xor);
+		enc = xor = NULL;
+	}
+	free(enc);
+	free(xor);
+	if (i < nrects) {
+		return -1;
+	}
+	d->frames++;
+
+	return 1;
+}
+
+void mirror_decoder_free(struct mirror_decoder *d)
+{
+	free(d->fb);
+	memset(d, 0, sizeof(*d));
+}
+
+static void px_rgb(const struct mirror_decoder *d, const uint8_t *px,
+		   uint8_t *rgb)
+{
+	uint16_t v;
+
+	if (d->px_size == 2) {
+		v = px[0] | px[1] << 8;
+		rgb[0] = (v >> 11) * 255 / 31;
+		rgb[1] = (v >> 5 & 0x3f) * 255 / 63;
+		rgb[2] = (v & 0x1f) * 255 / 31;
+	} else {
+		// RGB888 and (A/X)RGB8888 are stored B, G, R(, A)
+		rgb[0] = px[2];
+		rgb[1] = px[1];
+		rgb[2] = px[0];
+	}
+}
+
+int mirror_view(const char *addr, FILE *fp)
+{
+	struct mirror_decoder d = { 0 };
+	uint8_t rgb[3];
+	uint32_t i;
+	int fd;
+	int ret;
+
+	fd = mirror_connect(addr);
+	if (fd < 0) {
+		fprintf(stderr, "mirror: %s: %s\n", addr, strerror(errno));
+		return -1;
+	}
+	while ((ret = mirror_decode(&d, fd)) > 0) {
+		fprintf(fp, "P6\n%u %u\n255\n", d.hor_res, d.ver_res);
+		for (i = 0; i < d.hor_res * d.ver_res; i++) {
+			px_rgb(&d, d.fb + i * d.px_size, rgb);
+			fwrite(rgb, 1, sizeof(rgb), fp);
+		}
+		fflush(fp);
+	}
+	close(fd);
+	mirror_decoder_free(&d);
+
+	return ret;
+}
+
+/*
+ * Benchmark: the main.c screen on a headless display with the slider,
+ * button text and status line changing every frame, mirrored to an
+ * in-process reference decoder. A second pass uses a viewer that takes
+ * 20 ms per frame, which forces drops and keyframes. A third pass flushes
+ * a left half, a right half and a full width middle stripe per frame, areas
+ * that add up to more than the frame. After each pass the decoded frame
+ * must equal the headless framebuffer.
+ */
+#define MIRROR_BENCH_SOCKET	"/tmp/mirror-bench.sock"
+#define MIRROR_BENCH_FRAMES	300
+#define MIRROR_BENCH_FPS	30
+
+struct viewer {
+	pthread_t thread;
+	struct mirror_decoder d;
+	uint32_t delay_ms;
+	atomic_bool ready;
+	int ret;
+};
+
+static void *viewer_thread(void *arg)
+{
+	struct viewer *v = arg;
+	int fd = mirror_connect(MIRROR_BENCH_SOCKET);
+
+	if (fd < 0) {
+		v->ret = -1;
+		atomic_store(&v->ready, true);
+		return NULL;
+	}
+	atomic_store(&v->ready, true);
+	while ((v->ret = mirror_decode(&v->d, fd)) > 0) {
+		if (v->delay_ms) {
+			usleep(v->delay_ms * 1000);
+		}
+	}
+	close(fd);
+
+	return NULL;
+}
+
+/* One frame of overlapping areas, as LVGL leaves them when joining costs */
+static void bench_overlap(lv_display_t *disp, uint8_t *buf, uint32_t i)
+{
+	const lv_area_t areas[] = {
+		{ 0, 0, BENCH_HOR_RES / 2 - 1, BENCH_VER_RES - 1 },
+		{ BENCH_HOR_RES / 2, 0, BENCH_HOR_RES - 1, BENCH_VER_RES - 1 },
+		{ 0, BENCH_VER_RES / 4, BENCH_HOR_RES - 1,
+		  BENCH_VER_RES * 3 / 4 - 1 },
+	};
+	uint32_t stride;
+	size_t k;
+
+	lv_display_send_event(disp, LV_EVENT_REFR_START, NULL);
+	for (k = 0; k < sizeof(areas) / sizeof(areas[0]); k++) {
+		stride = lv_draw_buf_width_to_stride(
+				lv_area_get_width(&areas[k]), mir.cf);
+		memset(buf, (i * 3 + k) * 37, (size_t)stride *
+		       lv_area_get_height(&areas[k]));
+		disp->flush_cb(disp, &areas[k], buf);
+	}
+	lv_display_send_event(disp, LV_EVENT_REFR_READY, NULL);
+}
+
+static int bench_pass(const char *label, uint32_t delay_ms, bool overlap)
+{
+	struct viewer v = { .delay_ms = delay_ms };
+	struct mirror_stats st;
+	lv_display_t *disp;
+	lv_obj_t *scr;
+	lv_obj_t *button_label;
+	lv_obj_t *slider;
+	lv_obj_t *status;
+	lv_obj_t *obj;
+	uint8_t *buf;
+	uint8_t *fb;
+	uint32_t stride;
+	uint32_t i;
+	int bad;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	buf = malloc((size_t)lv_draw_buf_width_to_stride(BENCH_HOR_RES,
+			lv_display_get_color_format(disp)) * BENCH_VER_RES);
+	if (!buf) {
+		bench_display_delete(disp);
+		return -1;
+	}
+	scr = lv_display_get_screen_active(disp);
+	obj = lv_label_create(scr);
+	lv_label_set_text(obj, "Light and Versatile Graphics Library");
+	lv_obj_align(obj, LV_ALIGN_CENTER, 0, 75);
+	obj = lv_button_create(scr);
+	lv_obj_set_size(obj, 100, 50);
+	lv_obj_align(obj, LV_ALIGN_TOP_MID, 0, 0);
+	button_label = lv_label_create(obj);
+	lv_obj_center(button_label);
+	slider = lv_slider_create(scr);
+	lv_obj_set_size(slider, 200, 50);
+	lv_obj_center(slider);
+	status = lv_label_create(scr);
+	lv_obj_align(status, LV_ALIGN_CENTER, 0, 100);
+	lv_refr_now(disp);
+
+	if (mirror_start(disp, MIRROR_BENCH_SOCKET, 4)) {
+		free(buf);
+		bench_display_delete(disp);
+		return -1;
+	}
+	pthread_create(&v.thread, NULL, viewer_thread, &v);
+	while (!atomic_load(&v.ready) || !atomic_load(&mir.connected)) {
+		if (atomic_load(&v.ready) && v.ret < 0) {
+			break;
+		}
+		usleep(1000);
+	}
+
+	for (i = 0; i < MIRROR_BENCH_FRAMES; i++) {
+		if (overlap) {
+			bench_overlap(disp, buf, i);
+		} else {
+			lv_slider_set_value(slider, i % 101, LV_ANIM_OFF);
+			lv_label_set_text_fmt(button_label, "Button (%u)",
+					      i % 256);
+			lv_label_set_text_fmt(status, "frame %u", i);
+			lv_refr_now(disp);
+		}
+		usleep(1000000 / MIRROR_BENCH_FPS / 4);
+	}
+	// A dropped last frame is owed as a keyframe once the queue drains
+	for (i = 0; mir.key && i < 100; i++) {
+		usleep(20000);
+		lv_obj_invalidate(scr);
+		lv_refr_now(disp);
+	}
+
+	mirror_get_stats(&st);
+	mirror_stop();
+	pthread_join(v.thread, NULL);
+
+	fb = bench_display_framebuffer(disp, &stride);
+	bad = !v.d.fb || memcmp(v.d.fb, fb, stride * BENCH_VER_RES);
+
+	printf("%s: %u frames sent (%u keyframes), %u dropped, %u bounded\n",
+	       label, st.frames, st.keyframes, st.drops, st.overflows);
+	printf("  tap      %7.1f us/frame on the render thread\n",
+	       (double)st.tap_us / MIRROR_BENCH_FRAMES);
+	printf("  encode   %7.1f us/frame avg, %u us max\n",
+	       st.frames ? (double)st.encode_us / st.frames : 0.0,
+	       st.encode_max_us);
+	printf("  stream   %7.0f B/frame (%.1f%% of the dirty pixels), "
+	       "%.1f kB/s at %u fps vs. %.1f kB/s raw full frames\n",
+	       st.frames ? (double)st.sent_bytes / st.frames : 0.0,
+	       st.raw_bytes ? 100.0 * st.sent_bytes / st.raw_bytes : 0.0,
+	       st.frames ? st.sent_bytes / 1024.0 / st.frames *
+	       MIRROR_BENCH_FPS : 0.0, MIRROR_BENCH_FPS,
+	       stride * BENCH_VER_RES / 1024.0 * MIRROR_BENCH_FPS);
+	printf("  decoded frame %s the display\n",
+	       bad ? "DIFFERS from" : "matches");
+
+	mirror_decoder_free(&v.d);
+	free(buf);
+	bench_display_delete(disp);
+
+	return bad || v.ret < 0 ? -1 : 0;
+}
+
+int mirror_bench(void)
+{
+	return bench_pass("fast viewer", 0, false) ||
+	       bench_pass("slow viewer", 20, false) ||
+	       bench_pass("overlapping areas", 0, true) ? -1 : 0;
+}
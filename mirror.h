@@ -0,0 +1,54 @@
+/*
+ * Compressed dirty rectangle mirror stream
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef MIRROR_H
+#define MIRROR_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+struct mirror_stats {
+	uint32_t frames;	// frames sent
+	uint32_t keyframes;
+	uint32_t drops;		// frames lost to a full queue
+	uint32_t overflows;	// frames whose areas overlapped past one frame
+	uint64_t raw_bytes;	// pixel bytes of the sent rectangles
+	uint64_t sent_bytes;
+	uint64_t tap_us;	// render thread time spent copying
+	uint64_t encode_us;
+	uint32_t encode_max_us;
+};
+
+/* Reference decoder state: the client's copy of the panel */
+struct mirror_decoder {
+	uint32_t hor_res;
+	uint32_t ver_res;
+	uint32_t px_size;
+	uint32_t cf;		// lv_color_format_t of the source
+	uint8_t *fb;
+	uint32_t frames;
+};
+
+/* addr: a unix socket path, "tcp:port" (loopback) or "tcp:a.b.c.d:port" */
+int mirror_start(lv_display_t *disp, const char *addr, uint32_t queue);
+void mirror_stop(void);
+void mirror_get_stats(struct mirror_stats *stats);
+
+int mirror_connect(const char *addr);
+/* 1: a frame was applied to d->fb, 0: end of stream, < 0: error */
+int mirror_decode(struct mirror_decoder *d, int fd);
+void mirror_decoder_free(struct mirror_decoder *d);
+/* Reference viewer: every decoded frame as a binary PPM on fp */
+int mirror_view(const char *addr, FILE *fp);
+
+int mirror_bench(void);
+
+#endif /* MIRROR_H */
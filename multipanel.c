@@ -0,0 +1,452 @@
+/*
+ * Several panels driven by one process
+ *
+ * LVGL keeps one heap, one set of draw units, one image cache and the glyph
+ * data of its fonts per process, whatever the number of displays; a second
+ * copy of the program duplicates all of them. What one process lacks is a
+ * plan for when each display renders: every display has a refresh timer of
+ * its own, and timers that expire in the same lv_timer_handler() pass render
+ * back to back, so input and the other panels wait for both.
+ *
+ * Here the refresh timers of the added displays are parked and a single
+ * scheduler timer renders them. Each panel has its own period; due times
+ * start spread over the period, and a pass renders at most one panel, the
+ * one furthest past its due time. A panel that fell a whole period behind
+ * skips that slot instead of rendering twice in a row. Input devices are
+ * bound to their panel, so a touch on one never reaches another.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <spawn.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "lvgl/src/display/lv_display_private.h"
+#include "lvgl/src/misc/lv_timer_private.h"
+
+#include "bench.h"
+#include "multipanel.h"
+
+extern char **environ;
+
+struct panel {
+	lv_display_t *disp;
+	lv_indev_t *indev;
+	uint32_t period;
+	uint32_t refr_period;	// of the parked refresh timer
+	uint32_t due;
+	struct multipanel_stats stats;
+};
+
+static struct {
+	struct panel panels[MULTIPANEL_MAX];
+	uint32_t count;
+	lv_timer_t *timer;
+} mp;
+
+static struct panel *find(lv_display_t *disp)
+{
+	uint32_t i;
+
+	for (i = 0; i < mp.count; i++) {
+		if (mp.panels[i].disp == disp) {
+			return &mp.panels[i];
+		}
+	}
+
+	return NULL;
+}
+
+static void sched_timer_cb(lv_timer_t *timer)
+{
+	uint32_t now = lv_tick_get();
+	struct panel *pick = NULL;
+	uint32_t pick_late = 0;
+	uint32_t late;
+	uint64_t t0;
+	uint32_t i;
+
+	LV_UNUSED(timer);
+
+	for (i = 0; i < mp.count; i++) {
+		late = now - mp.panels[i].due;
+		if ((int32_t)late < 0) {
+			continue;
+		}
+		if (!pick || late > pick_late) {
+			pick = &mp.panels[i];
+			pick_late = late;
+		}
+	}
+	if (!pick) {
+		return;
+	}
+
+	pick->due += pick->period;
+	while ((int32_t)(now - pick->due) >= 0) {
+		pick->due += pick->period;
+		pick->stats.skipped++;
+	}
+	if (!pick->disp->inv_p) {
+		return;
+	}
+
+	pick->stats.late_max_ms = LV_MAX(pick->stats.late_max_ms, pick_late);
+	t0 = bench_now_us();
+	lv_refr_now(pick->disp);
+	pick->stats.render_us += bench_now_us() - t0;
+	pick->stats.frames++;
+}
+
+/* Spread the due times and tick often enough to keep every slot */
+static void respread(void)
+{
+	uint32_t now = lv_tick_get();
+	uint32_t period = UINT32_MAX;
+	uint32_t i;
+
+	for (i = 0; i < mp.count; i++) {
+		mp.panels[i].due = now + mp.panels[i].period * i / mp.count;
+		period = LV_MIN(period, mp.panels[i].period);
+	}
+	lv_timer_set_period(mp.timer, LV_MAX(period / mp.count, 1));
+}
+
+int multipanel_add(lv_display_t *disp, lv_indev_t *indev, uint32_t period_ms)
+{
+	lv_timer_t *refr = lv_display_get_refr_timer(disp);
+	struct panel *p;
+
+	if (!refr || find(disp)) {
+		return -EINVAL;
+	}
+	if (mp.count == MULTIPANEL_MAX) {
+		return -ENOSPC;
+	}
+	if (!mp.timer) {
+		mp.timer = lv_timer_create(sched_timer_cb, 1, NULL);
+		if (!mp.timer) {
+			return -ENOMEM;
+		}
+	}
+
+	p = &mp.panels[mp.count++];
+	memset(p, 0, sizeof(*p));
+	p->disp = disp;
+	p->indev = indev;
+	p->period = LV_MAX(period_ms, 1);
+	// Invalidation resumes a paused refresh timer; one that never
+	// expires stays out of the way
+	p->refr_period = refr->period;
+	lv_timer_set_period(refr, UINT32_MAX);
+	if (indev) {
+		lv_indev_set_display(indev, disp);
+	}
+	respread();
+
+	return 0;
+}
+
+void multipanel_remove(lv_display_t *disp)
+{
+	struct panel *p = find(disp);
+	lv_timer_t *refr;
+
+	if (!p) {
+		return;
+	}
+
+	refr = lv_display_get_refr_timer(disp);
+	if (refr) {
+		lv_timer_set_period(refr, p->refr_period);
+	}
+	*p = mp.panels[--mp.count];
+	if (mp.count) {
+		respread();
+	} else {
+		lv_timer_delete(mp.timer);
+		mp.timer = NULL;
+	}
+}
+
+int multipanel_get_stats(lv_display_t *disp, struct multipanel_stats *stats)
+{
+	struct panel *p = find(disp);
+
+	if (!p) {
+		return -ENOENT;
+	}
+	*stats = p->stats;
+
+	return 0;
+}
+
+void multipanel_reset(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < mp.count; i++) {
+		memset(&mp.panels[i].stats, 0, sizeof(mp.panels[i].stats));
+	}
+}
+
+static void print_stats(FILE *fp, const char *label,
+			const struct multipanel_stats *st)
+{
+	fprintf(fp, "%s %u frames, render avg %.3f ms, %u skipped, "
+		"late max %u ms\n", label, st->frames,
+		st->frames ? st->render_us / 1000.0 / st->frames : 0.0,
+		st->skipped, st->late_max_ms);
+}
+
+void multipanel_report(FILE *fp)
+{
+	char label[32];
+	uint32_t i;
+
+	for (i = 0; i < mp.count; i++) {
+		snprintf(label, sizeof(label), "multipanel: %u, %u ms:", i,
+			 mp.panels[i].period);
+		print_stats(fp, label, &mp.panels[i].stats);
+	}
+}
+
+/*
+ * Two in-memory panels in one process, each with a button at the same spot
+ * and a spinner. A scripted touch on the second panel must click only its
+ * own button, and panels at 10 and 30 ms must render about three frames to
+ * one. Then both render flat out for two seconds, against two copies of
+ * this program (re-executed with MULTIPANEL_BENCH_SOLO set) driving one
+ * panel each: aggregate frames per second and peak resident memory.
+ */
+#define MULTIPANEL_BENCH_MS		2000
+#define MULTIPANEL_BENCH_PRESS_MS	200
+#define MULTIPANEL_BENCH_SOLO		"MULTIPANEL_BENCH_SOLO"
+
+static struct {
+	uint64_t t0;
+	uint32_t clicks[MULTIPANEL_MAX];
+} bench;
+
+static void bench_click_cb(lv_event_t *e)
+{
+	bench.clicks[(uintptr_t)lv_event_get_user_data(e)]++;
+}
+
+static void bench_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+	data->point.x = 60;
+	data->point.y = 30;
+	data->state = bench_now_us() - bench.t0 <
+		      MULTIPANEL_BENCH_PRESS_MS * 1000 ?
+		      LV_INDEV_STATE_PRESSED : LV_INDEV_STATE_RELEASED;
+}
+
+static void bench_screen(lv_obj_t *scr, uintptr_t n)
+{
+	lv_obj_t *obj;
+
+	obj = lv_button_create(scr);
+	lv_obj_set_size(obj, 100, 50);
+	lv_obj_set_pos(obj, 10, 5);
+	lv_obj_add_event_cb(obj, bench_click_cb, LV_EVENT_CLICKED, (void *)n);
+	obj = lv_label_create(obj);
+	lv_label_set_text_fmt(obj, "Panel %u", (unsigned int)n);
+	lv_obj_center(obj);
+	obj = lv_spinner_create(scr);
+	lv_obj_set_size(obj, 120, 120);
+	lv_obj_align(obj, LV_ALIGN_BOTTOM_RIGHT, -10, -10);
+	obj = lv_label_create(scr);
+	lv_label_set_text(obj, "Light and Versatile Graphics Library");
+	lv_obj_align(obj, LV_ALIGN_BOTTOM_LEFT, 10, -10);
+}
+
+/* Render n panels for ms; the last one gets the scripted touch */
+static int bench_panels(uint32_t n, const uint32_t *period_ms, uint32_t ms,
+			struct multipanel_stats *st)
+{
+	lv_display_t *disp[MULTIPANEL_MAX];
+	lv_indev_t *indev;
+	uint32_t idle;
+	uint32_t i;
+	int ret = 0;
+
+	indev = lv_indev_create();
+	if (!indev) {
+		return -1;
+	}
+	lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
+	lv_indev_set_read_cb(indev, bench_read_cb);
+
+	memset(bench.clicks, 0, sizeof(bench.clicks));
+	for (i = 0; i < n; i++) {
+		disp[i] = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+		if (!disp[i]) {
+			n = i;
+			ret = -1;
+			goto out;
+		}
+		bench_screen(lv_display_get_screen_active(disp[i]), i);
+		multipanel_add(disp[i], i == n - 1 ? indev : NULL,
+			       period_ms[i]);
+	}
+
+	bench.t0 = bench_now_us();
+	while (bench_now_us() - bench.t0 < ms * 1000ULL) {
+		idle = lv_timer_handler();
+		lv_delay_ms(LV_MIN(idle, 100));
+	}
+	for (i = 0; i < n; i++) {
+		multipanel_get_stats(disp[i], &st[i]);
+	}
+out:
+	lv_indev_delete(indev);
+	for (i = 0; i < n; i++) {
+		multipanel_remove(disp[i]);
+		bench_display_delete(disp[i]);
+	}
+
+	return ret;
+}
+
+static unsigned long vm_hwm_kb(void)
+{
+	unsigned long kb = 0;
+	char line[128];
+	FILE *fp;
+
+	fp = fopen("/proc/self/status", "r");
+	if (!fp) {
+		return 0;
+	}
+	while (fgets(line, sizeof(line), fp)) {
+		if (sscanf(line, "VmHWM: %lu", &kb) == 1) {
+			break;
+		}
+	}
+	fclose(fp);
+
+	return kb;
+}
+
+static int bench_solo(void)
+{
+	static const uint32_t period = 1;
+	struct multipanel_stats st = { 0 };
+
+	if (bench_panels(1, &period, MULTIPANEL_BENCH_MS, &st)) {
+		return -1;
+	}
+	printf("solo %u %lu\n", st.frames, vm_hwm_kb());
+
+	return 0;
+}
+
+/* Two copies of this program, one panel each, started together */
+static int bench_processes(uint32_t *frames, unsigned long *kb)
+{
+	char *argv[] = { "ili9341", "-b", "multipanel", NULL };
+	posix_spawn_file_actions_t fa;
+	unsigned long solo_kb;
+	uint32_t solo_frames;
+	char line[128];
+	pid_t pid[2] = { -1, -1 };
+	FILE *fp[2] = { NULL, NULL };
+	int fd[2];
+	int ret = 0;
+	int status;
+	int i;
+
+	*frames = 0;
+	*kb = 0;
+	setenv(MULTIPANEL_BENCH_SOLO, "1", 1);
+	fflush(stdout);
+	for (i = 0; i < 2; i++) {
+		if (pipe(fd)) {
+			ret = -1;
+			break;
+		}
+		posix_spawn_file_actions_init(&fa);
+		posix_spawn_file_actions_adddup2(&fa, fd[1], STDOUT_FILENO);
+		posix_spawn_file_actions_addclose(&fa, fd[0]);
+		if (posix_spawn(&pid[i], "/proc/self/exe", &fa, NULL, argv,
+				environ)) {
+			pid[i] = -1;
+			ret = -1;
+		}
+		posix_spawn_file_actions_destroy(&fa);
+		close(fd[1]);
+		fp[i] = fdopen(fd[0], "r");
+	}
+	unsetenv(MULTIPANEL_BENCH_SOLO);
+
+	for (i = 0; i < 2; i++) {
+		if (!fp[i]) {
+			continue;
+		}
+		while (fgets(line, sizeof(line), fp[i])) {
+			if (sscanf(line, "solo %u %lu", &solo_frames,
+				   &solo_kb) == 2) {
+				*frames += solo_frames;
+				*kb += solo_kb;
+			}
+		}
+		fclose(fp[i]);
+		if (pid[i] > 0 && (waitpid(pid[i], &status, 0) < 0 ||
+				   !WIFEXITED(status) ||
+				   WEXITSTATUS(status))) {
+			ret = -1;
+		}
+	}
+
+	return ret;
+}
+
+int multipanel_bench(void)
+{
+	static const uint32_t paced[] = { 10, 30 };
+	static const uint32_t flat[] = { 1, 1 };
+	struct multipanel_stats st[2];
+	unsigned long kb;
+	uint32_t frames;
+	bool ok;
+
+	if (getenv(MULTIPANEL_BENCH_SOLO)) {
+		return bench_solo();
+	}
+
+	if (bench_panels(2, paced, MULTIPANEL_BENCH_MS, st)) {
+		return -1;
+	}
+	print_stats(stdout, "panel 0, 10 ms:", &st[0]);
+	print_stats(stdout, "panel 1, 30 ms:", &st[1]);
+	ok = bench.clicks[0] == 0 && bench.clicks[1] == 1;
+	printf("touch on panel 1: %u/%u clicks, %s\n", bench.clicks[0],
+	       bench.clicks[1], ok ? "routed" : "MISROUTED");
+	if (st[0].frames < 2 * st[1].frames) {
+		printf("panel periods: NOT KEPT\n");
+		ok = false;
+	}
+
+	if (bench_panels(2, flat, MULTIPANEL_BENCH_MS, st)) {
+		return -1;
+	}
+	printf("one process:   %7.1f fps (%.1f + %.1f), peak RSS %lu kB\n",
+	       (st[0].frames + st[1].frames) * 1000.0 / MULTIPANEL_BENCH_MS,
+	       st[0].frames * 1000.0 / MULTIPANEL_BENCH_MS,
+	       st[1].frames * 1000.0 / MULTIPANEL_BENCH_MS, vm_hwm_kb());
+	if (bench_processes(&frames, &kb)) {
+		return -1;
+	}
+	printf("two processes: %7.1f fps, peak RSS %lu kB\n",
+	       frames * 1000.0 / MULTIPANEL_BENCH_MS, kb);
+
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,41 @@
+/*
+ * Several panels driven by one process
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef MULTIPANEL_H
+#define MULTIPANEL_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+#define MULTIPANEL_MAX	4
+
+struct multipanel_stats {
+	uint32_t frames;
+	uint32_t skipped;	// periods that passed without a render slot
+	uint32_t late_max_ms;	// render start after its due time
+	uint64_t render_us;
+};
+
+/*
+ * Refresh disp every period_ms from the multipanel scheduler instead of its
+ * own refresh timer, and route indev (if not NULL) to it. Panels take turns:
+ * their due times are spread over the period and one timer pass renders at
+ * most one of them, the most overdue.
+ */
+int multipanel_add(lv_display_t *disp, lv_indev_t *indev, uint32_t period_ms);
+void multipanel_remove(lv_display_t *disp);
+int multipanel_get_stats(lv_display_t *disp, struct multipanel_stats *stats);
+void multipanel_reset(void);
+void multipanel_report(FILE *fp);
+
+int multipanel_bench(void);
+
+#endif /* MULTIPANEL_H */
@@ -0,0 +1,588 @@
+/*
+ * Object count scalability and style resolution
+ *
+ * Every style property read (each draw descriptor fills a few dozen) walks
+ * the object's style list from the top: local, transition, then added and
+ * theme styles, and for inherited properties the parents' lists too.
+ * lv_conf.h enables LVGL's style bitmask (LV_OBJ_STYLE_CACHE): each object
+ * keeps a bit mask per part (main and the others) with one bit per group of
+ * eight properties that any of its styles sets; a property whose group is
+ * clear resolves to the default or the parent's value without touching the
+ * list. It caches no resolved values: a property that is set still costs a
+ * walk down to the style that sets it.
+ *
+ * With objscale_cache_enable(), lv_obj_get_style_prop() is wrapped at link
+ * time (-Wl,--wrap=...) and resolved values are kept in a direct mapped
+ * table per thread, keyed by object, part, property and the object's
+ * state. A global generation counter flushes all tables at once. It is
+ * bumped by every change that can alter a resolved value:
+ *
+ * - lv_obj_invalidate(), through kbdinc's wrapper. lv_obj_refresh_style()
+ *   invalidates the object and, for inherited properties, its children on
+ *   every style change: added, removed or replaced styles, local
+ *   properties, transition steps and lv_obj_report_style_change(). It
+ *   sends LV_EVENT_STYLE_CHANGED for layout properties only. Deleting an
+ *   object invalidates it too, so a new object at the same address starts
+ *   afresh.
+ * - lv_obj_add_state(), lv_obj_remove_state() and lv_obj_set_state(),
+ *   through kbdinc's wrappers: a parent's state selects the values its
+ *   children inherit.
+ * - lv_obj_report_style_change() and lv_theme_apply(), wrapped here.
+ * - lv_obj_enable_style_refresh(), wrapped here. While refreshes are off,
+ *   LVGL skips the invalidations above, so lookups bypass the table.
+ *
+ * Lookups during a transition's setup (skip_trans) bypass it as well.
+ * Calls inside lv_obj_style.c do not pass the wrapper and are not cached.
+ * As for LVGL's own redraw, a shared style changed with lv_style_set_*()
+ * must be reported with lv_obj_report_style_change().
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lvgl/src/core/lv_obj_private.h"
+
+#include "bench.h"
+#include "objscale.h"
+
+#define OBJSCALE_CACHE_BITS	9
+#define OBJSCALE_CACHE_SIZE	(1U << OBJSCALE_CACHE_BITS)
+
+struct cache_entry {
+	const lv_obj_t *obj;	// NULL: empty
+	uint32_t gen;
+	lv_part_t part;
+	lv_state_t state;
+	lv_style_prop_t prop;
+	lv_style_value_t value;
+};
+
+static _Thread_local struct {
+	bool refresh_off;	// lv_obj_enable_style_refresh(false)
+	uint32_t gen;		// last generation seen, to catch a wrap
+	uint32_t flush_base;	// generation at the last reset
+	struct cache_entry entries[OBJSCALE_CACHE_SIZE];
+	struct objscale_cache_stats stats;
+} cache;
+
+static atomic_bool cache_on;
+static atomic_uint cache_gen;
+
+void objscale_cache_enable(bool on)
+{
+	objscale_cache_flush();
+	atomic_store(&cache_on, on);
+}
+
+void objscale_cache_flush(void)
+{
+	atomic_fetch_add_explicit(&cache_gen, 1, memory_order_relaxed);
+}
+
+static uint32_t cache_slot(const lv_obj_t *obj, lv_part_t part,
+			   lv_style_prop_t prop)
+{
+	uint32_t h = (uint32_t)((uintptr_t)obj >> 3) * 0x9e3779b1;
+
+	h ^= ((part >> 16) << 16 | prop) * 0x85ebca6b;
+
+	return h >> (32 - OBJSCALE_CACHE_BITS);
+}
+
+lv_style_value_t __real_lv_obj_get_style_prop(const lv_obj_t *obj,
+					      lv_part_t part,
+					      lv_style_prop_t prop);
+void __real_lv_obj_report_style_change(lv_style_t *style);
+void __real_lv_theme_apply(lv_obj_t *obj);
+void __real_lv_obj_enable_style_refresh(bool en);
+
+lv_style_value_t __wrap_lv_obj_get_style_prop(const lv_obj_t *obj,
+					      lv_part_t part,
+					      lv_style_prop_t prop)
+{
+	struct cache_entry *e;
+	uint32_t gen;
+
+	if (!atomic_load_explicit(&cache_on, memory_order_relaxed)) {
+		return __real_lv_obj_get_style_prop(obj, part, prop);
+	}
+	if (cache.refresh_off || obj->skip_trans) {
+		cache.stats.bypass++;
+		return __real_lv_obj_get_style_prop(obj, part, prop);
+	}
+
+	gen = atomic_load_explicit(&cache_gen, memory_order_relaxed);
+	if (gen < cache.gen) {
+		// Wrapped: old entries could match again
+		memset(cache.entries, 0, sizeof(cache.entries));
+	}
+	cache.gen = gen;
+	e = &cache.entries[cache_slot(obj, part, prop)];
+	if (e->obj == obj && e->gen == gen && e->part == part &&
+	    e->prop == prop && e->state == obj->state) {
+		cache.stats.hits++;
+		return e->value;
+	}
+
+	cache.stats.misses++;
+	e->value = __real_lv_obj_get_style_prop(obj, part, prop);
+	e->obj = obj;
+	e->gen = gen;
+	e->part = part;
+	e->state = obj->state;
+	e->prop = prop;
+
+	return e->value;
+}
+
+void __wrap_lv_obj_report_style_change(lv_style_t *style)
+{
+	__real_lv_obj_report_style_change(style);
+	objscale_cache_flush();
+}
+
+void __wrap_lv_theme_apply(lv_obj_t *obj)
+{
+	__real_lv_theme_apply(obj);
+	objscale_cache_flush();
+}
+
+void __wrap_lv_obj_enable_style_refresh(bool en)
+{
+	__real_lv_obj_enable_style_refresh(en);
+	cache.refresh_off = !en;
+	objscale_cache_flush();
+}
+
+void objscale_cache_get_stats(struct objscale_cache_stats *stats)
+{
+	*stats = cache.stats;
+	stats->flushes = atomic_load(&cache_gen) - cache.flush_base;
+}
+
+void objscale_cache_reset(void)
+{
+	memset(&cache.stats, 0, sizeof(cache.stats));
+	cache.flush_base = atomic_load(&cache_gen);
+}
+
+void objscale_cache_report(FILE *fp)
+{
+	struct objscale_cache_stats st;
+	uint64_t n;
+
+	objscale_cache_get_stats(&st);
+	n = st.hits + st.misses;
+	fprintf(fp, "objscale: style cache %.1f%% hits of %llu lookups, "
+		"%llu bypassed, %u flushes\n",
+		n ? 100.0 * st.hits / n : 0.0, (unsigned long long)n,
+		(unsigned long long)st.bypass, st.flushes);
+}
+
+/*
+ * Benchmark: wide, deep and mixed widget trees, built until the heap runs
+ * low. Timed are creation, a relayout, style reads over every object with
+ * the cache off and on, an event bubbling up from the last object, a full
+ * redraw and deletion. Lookups on one object with a growing style stack
+ * show what the bitmask saves and what it does not: a property that no
+ * style sets costs the same for 1 or 32 styles, one set only in the bottom
+ * style still grows with the stack (build with LV_OBJ_STYLE_CACHE 0 to
+ * compare), and with the cache both stay flat. Last, cached lookups are
+ * checked against style, state, local, inherited and theme changes.
+ */
+#define OBJSCALE_HEAP_MIN	(8 * 1024)
+#define OBJSCALE_LOOKUP_ROUNDS	20
+#define OBJSCALE_EVENTS		1000
+#define OBJSCALE_FRAMES		5
+#define OBJSCALE_STYLES		32
+#define OBJSCALE_STACK_LOOKUPS	100000
+
+enum tree {
+	TREE_WIDE,
+	TREE_DEEP,
+	TREE_MIXED,
+	TREES
+};
+
+static const char *const tree_names[TREES] = {
+	[TREE_WIDE] = "wide",
+	[TREE_DEEP] = "deep",
+	[TREE_MIXED] = "mixed",
+};
+
+static struct {
+	lv_event_code_t code;
+	uint32_t events;
+	uint32_t objs;
+	uint32_t lookups;
+	volatile uint32_t sink;
+} bench;
+
+static size_t heap_free(void)
+{
+	lv_mem_monitor_t mon;
+
+	lv_mem_monitor(&mon);
+
+	return mon.free_size;
+}
+
+static lv_obj_t *create_one(lv_obj_t *root, lv_obj_t *parent, enum tree tree,
+			    uint32_t i)
+{
+	lv_obj_t *obj;
+
+	switch (tree) {
+	case TREE_WIDE:
+		obj = lv_obj_create(root);
+		lv_obj_set_size(obj, 24, 24);
+		return obj;
+	case TREE_DEEP:
+		obj = lv_obj_create(parent);
+		lv_obj_set_size(obj, LV_PCT(100), LV_PCT(100));
+		return obj;
+	default:
+		break;
+	}
+
+	switch (i % 5) {
+	case 0:
+		obj = lv_button_create(root);
+		lv_label_set_text(lv_label_create(obj), "OK");
+		return obj;
+	case 1:
+		obj = lv_slider_create(root);
+		lv_obj_set_width(obj, 80);
+		return obj;
+	case 2:
+		return lv_switch_create(root);
+	case 3:
+		obj = lv_checkbox_create(root);
+		lv_checkbox_set_text_static(obj, "Option");
+		return obj;
+	default:
+		obj = lv_label_create(root);
+		lv_label_set_text_static(obj, "Label");
+		return obj;
+	}
+}
+
+/* Up to n objects below root; returns how many, last is the last one */
+static uint32_t build(lv_obj_t *root, enum tree tree, uint32_t n,
+		      lv_obj_t **last)
+{
+	lv_obj_t *parent = root;
+	uint32_t i;
+
+	if (tree != TREE_DEEP) {
+		lv_obj_set_flex_flow(root, LV_FLEX_FLOW_ROW_WRAP);
+	}
+	*last = root;
+	for (i = 0; i < n && heap_free() >= OBJSCALE_HEAP_MIN; i++) {
+		*last = create_one(root, parent, tree, i);
+		lv_obj_add_flag(*last, LV_OBJ_FLAG_EVENT_BUBBLE);
+		parent = *last;
+	}
+
+	return i;
+}
+
+static lv_obj_tree_walk_res_t lookup_cb(lv_obj_t *obj, void *user_data)
+{
+	LV_UNUSED(user_data);
+
+	bench.sink += lv_color_to_u32(lv_obj_get_style_bg_color(obj,
+							LV_PART_MAIN));
+	bench.sink += lv_obj_get_style_bg_opa(obj, LV_PART_MAIN);
+	bench.sink += lv_obj_get_style_border_width(obj, LV_PART_MAIN);
+	bench.sink += lv_obj_get_style_radius(obj, LV_PART_MAIN);
+	bench.sink += lv_obj_get_style_pad_top(obj, LV_PART_MAIN);
+	bench.sink += lv_obj_get_style_outline_width(obj, LV_PART_MAIN);
+	bench.sink += lv_obj_get_style_transform_rotation(obj, LV_PART_MAIN);
+	bench.sink += lv_color_to_u32(lv_obj_get_style_text_color(obj,
+							LV_PART_MAIN));
+	bench.lookups += 8;
+	bench.objs++;
+
+	return LV_OBJ_TREE_WALK_NEXT;
+}
+
+/* Average ns per style read over every object below root */
+static double lookup_all(lv_obj_t *root, bool cached)
+{
+	uint64_t t0;
+	uint32_t i;
+
+	objscale_cache_enable(cached);
+	bench.lookups = 0;
+	t0 = bench_now_us();
+	for (i = 0; i < OBJSCALE_LOOKUP_ROUNDS; i++) {
+		bench.objs = 0;
+		lv_obj_tree_walk(root, lookup_cb, NULL);
+	}
+	t0 = bench_now_us() - t0;
+	objscale_cache_enable(false);
+
+	return t0 * 1000.0 / bench.lookups;
+}
+
+static void count_event_cb(lv_event_t *e)
+{
+	LV_UNUSED(e);
+
+	bench.events++;
+}
+
+static int bench_tree(lv_display_t *disp, enum tree tree, uint32_t n)
+{
+	lv_obj_t *scr = lv_display_get_screen_active(disp);
+	lv_obj_t *root;
+	lv_obj_t *last;
+	uint64_t create_us;
+	uint64_t layout_us;
+	double lookup_ns;
+	double cached_ns;
+	uint64_t event_us;
+	uint64_t delete_us;
+	uint64_t t0;
+	uint32_t built;
+	uint32_t objs;
+	uint32_t i;
+	struct bench_frames f;
+	char label[24];
+
+	t0 = bench_now_us();
+	root = lv_obj_create(scr);
+	lv_obj_set_size(root, BENCH_HOR_RES, BENCH_VER_RES);
+	built = build(root, tree, n, &last);
+	lv_obj_update_layout(root);
+	create_us = bench_now_us() - t0;
+
+	// A width change reaches every percentage size and flex row
+	lv_obj_set_width(root, BENCH_HOR_RES - 1);
+	t0 = bench_now_us();
+	lv_obj_update_layout(root);
+	layout_us = bench_now_us() - t0;
+
+	lookup_ns = lookup_all(root, false);
+	cached_ns = lookup_all(root, true);
+	objs = bench.objs;
+
+	lv_obj_add_event_cb(root, count_event_cb, bench.code, NULL);
+	bench.events = 0;
+	t0 = bench_now_us();
+	for (i = 0; i < OBJSCALE_EVENTS; i++) {
+		lv_obj_send_event(last, bench.code, NULL);
+	}
+	event_us = bench_now_us() - t0;
+
+	bench_frames_reset(&f);
+	for (i = 0; i < OBJSCALE_FRAMES; i++) {
+		lv_obj_invalidate(scr);
+		t0 = bench_now_us();
+		lv_refr_now(disp);
+		bench_frames_add(&f, bench_now_us() - t0);
+	}
+
+	t0 = bench_now_us();
+	lv_obj_delete(root);
+	delete_us = bench_now_us() - t0;
+
+	snprintf(label, sizeof(label), "%s %u", tree_names[tree], n);
+	printf("%-12s %5u%s %8.3f %8.3f %6.1f %6.1f %8.2f %8.3f %8.3f\n",
+	       label, objs, built < n ? "*" : " ", create_us / 1000.0,
+	       layout_us / 1000.0, lookup_ns, cached_ns,
+	       bench.events == OBJSCALE_EVENTS ?
+	       (double)event_us / OBJSCALE_EVENTS : -1.0,
+	       f.total_us / 1000.0 / f.count, delete_us / 1000.0);
+
+	return 0;
+}
+
+static double lookup_ns(lv_obj_t *obj, lv_style_prop_t prop)
+{
+	uint64_t t0 = bench_now_us();
+	uint32_t i;
+
+	for (i = 0; i < OBJSCALE_STACK_LOOKUPS; i++) {
+		bench.sink += lv_obj_get_style_prop(obj, LV_PART_MAIN,
+						    prop).num;
+	}
+
+	return (bench_now_us() - t0) * 1000.0 / OBJSCALE_STACK_LOOKUPS;
+}
+
+/* Style stacks of 1 to 32 styles: bottom style only vs. no style */
+static void bench_stack(lv_obj_t *scr)
+{
+	static lv_style_t styles[OBJSCALE_STYLES];
+	uint32_t depth;
+	lv_obj_t *obj;
+	uint32_t i;
+
+	for (i = 0; i < OBJSCALE_STYLES; i++) {
+		lv_style_init(&styles[i]);
+		lv_style_set_bg_opa(&styles[i], i);
+	}
+	lv_style_set_border_width(&styles[0], 2);
+
+	obj = lv_obj_create(scr);
+	lv_obj_remove_style_all(obj);
+	printf("%-8s %14s %14s %14s %14s\n", "styles", "bottom [ns]",
+	       "unset [ns]", "cached bottom", "cached unset");
+	for (i = 0, depth = 1; depth <= OBJSCALE_STYLES; i++) {
+		lv_obj_add_style(obj, &styles[i], LV_PART_MAIN);
+		if (i + 1 != depth) {
+			continue;
+		}
+		printf("%-8u %14.1f %14.1f", depth,
+		       lookup_ns(obj, LV_STYLE_BORDER_WIDTH),
+		       lookup_ns(obj, LV_STYLE_OUTLINE_WIDTH));
+		objscale_cache_enable(true);
+		printf(" %14.1f %14.1f\n",
+		       lookup_ns(obj, LV_STYLE_BORDER_WIDTH),
+		       lookup_ns(obj, LV_STYLE_OUTLINE_WIDTH));
+		objscale_cache_enable(false);
+		depth *= 2;
+	}
+	lv_obj_delete(obj);
+	for (i = 0; i < OBJSCALE_STYLES; i++) {
+		lv_style_reset(&styles[i]);
+	}
+}
+
+static bool check(const char *what, bool ok)
+{
+	printf("  %-24s %s\n", what, ok ? "ok" : "STALE");
+
+	return ok;
+}
+
+static bool bg_is(lv_obj_t *obj, lv_palette_t p)
+{
+	return lv_color_eq(lv_obj_get_style_bg_color(obj, LV_PART_MAIN),
+			   lv_palette_main(p));
+}
+
+static bool text_is(lv_obj_t *obj, lv_palette_t p)
+{
+	return lv_color_eq(lv_obj_get_style_text_color(obj, LV_PART_MAIN),
+			   lv_palette_main(p));
+}
+
+/* Every change that LVGL is told about must show in the next cached lookup */
+static bool bench_invalidation(lv_display_t *disp)
+{
+	lv_obj_t *scr = lv_display_get_screen_active(disp);
+	lv_style_t base;
+	lv_style_t top;
+	lv_style_t pressed;
+	lv_obj_t *parent;
+	lv_obj_t *child;
+	lv_obj_t *btn;
+	bool ok = true;
+
+	lv_style_init(&base);
+	lv_style_set_bg_color(&base, lv_palette_main(LV_PALETTE_RED));
+	lv_style_init(&top);
+	lv_style_set_bg_color(&top, lv_palette_main(LV_PALETTE_BLUE));
+	lv_style_init(&pressed);
+	lv_style_set_bg_color(&pressed, lv_palette_main(LV_PALETTE_GREEN));
+	lv_style_set_text_color(&pressed, lv_palette_main(LV_PALETTE_LIME));
+
+	objscale_cache_enable(true);
+	objscale_cache_reset();
+	printf("invalidation:\n");
+	parent = lv_obj_create(scr);
+	child = lv_obj_create(parent);
+	lv_obj_add_style(child, &base, LV_PART_MAIN);
+	lv_obj_add_style(child, &pressed, LV_PART_MAIN | LV_STATE_PRESSED);
+	ok &= check("style added", bg_is(child, LV_PALETTE_RED));
+	lv_obj_add_style(child, &top, LV_PART_MAIN);
+	ok &= check("style stacked", bg_is(child, LV_PALETTE_BLUE));
+	lv_obj_remove_style(child, &top, LV_PART_MAIN);
+	ok &= check("style removed", bg_is(child, LV_PALETTE_RED));
+	lv_obj_add_state(child, LV_STATE_PRESSED);
+	ok &= check("state added", bg_is(child, LV_PALETTE_GREEN));
+	lv_obj_remove_state(child, LV_STATE_PRESSED);
+	ok &= check("state removed", bg_is(child, LV_PALETTE_RED));
+	lv_style_set_bg_color(&base, lv_palette_main(LV_PALETTE_AMBER));
+	lv_obj_report_style_change(&base);
+	ok &= check("shared style changed", bg_is(child, LV_PALETTE_AMBER));
+	lv_obj_set_style_bg_color(child, lv_palette_main(LV_PALETTE_TEAL), 0);
+	ok &= check("local property", bg_is(child, LV_PALETTE_TEAL));
+	lv_obj_remove_local_style_prop(child, LV_STYLE_BG_COLOR, 0);
+	ok &= check("local removed", bg_is(child, LV_PALETTE_AMBER));
+	lv_obj_add_style(parent, &pressed, LV_PART_MAIN | LV_STATE_PRESSED);
+	ok &= check("parent style", !text_is(child, LV_PALETTE_LIME));
+	lv_obj_add_state(parent, LV_STATE_PRESSED);
+	ok &= check("parent state", text_is(child, LV_PALETTE_LIME));
+	lv_obj_remove_state(parent, LV_STATE_PRESSED);
+	ok &= check("parent state removed", !text_is(child, LV_PALETTE_LIME));
+	lv_obj_set_style_text_color(parent, lv_palette_main(LV_PALETTE_PINK),
+				    0);
+	ok &= check("inherited", text_is(child, LV_PALETTE_PINK));
+	lv_obj_delete(parent);
+
+	btn = lv_button_create(scr);
+	lv_theme_default_init(disp, lv_palette_main(LV_PALETTE_PURPLE),
+			      lv_palette_main(LV_PALETTE_RED),
+			      LV_THEME_DEFAULT_DARK, LV_FONT_DEFAULT);
+	lv_theme_apply(btn);
+	ok &= check("theme", bg_is(btn, LV_PALETTE_PURPLE));
+	lv_theme_default_init(disp, lv_palette_main(LV_PALETTE_BLUE),
+			      lv_palette_main(LV_PALETTE_RED),
+			      LV_THEME_DEFAULT_DARK, LV_FONT_DEFAULT);
+	lv_theme_apply(btn);
+	ok &= check("theme restored", bg_is(btn, LV_PALETTE_BLUE));
+	lv_obj_delete(btn);
+	objscale_cache_report(stdout);
+	objscale_cache_enable(false);
+
+	lv_style_reset(&base);
+	lv_style_reset(&top);
+	lv_style_reset(&pressed);
+
+	return ok;
+}
+
+int objscale_bench(void)
+{
+	static const uint32_t counts[] = { 100, 300, 1000 };
+	lv_display_t *disp;
+	enum tree tree;
+	bool ok;
+	size_t i;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	bench.code = lv_event_register_id();
+	lv_refr_now(disp);
+
+	printf("style bitmask (LV_OBJ_STYLE_CACHE) %s, * heap exhausted\n",
+	       LV_OBJ_STYLE_CACHE ? "on" : "off");
+	printf("%-12s %6s %8s %8s %6s %6s %8s %8s %8s\n", "tree", "objs",
+	       "create", "layout", "lookup", "cached", "event", "render",
+	       "delete");
+	printf("%-12s %6s %8s %8s %6s %6s %8s %8s %8s\n", "", "", "[ms]",
+	       "[ms]", "[ns]", "[ns]", "[us]", "[ms]", "[ms]");
+	for (tree = TREE_WIDE; tree < TREES; tree++) {
+		for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+			bench_tree(disp, tree, counts[i]);
+		}
+	}
+
+	bench_stack(lv_display_get_screen_active(disp));
+	ok = bench_invalidation(disp);
+	bench_display_delete(disp);
+
+	return ok ? 0 : -1;
+}
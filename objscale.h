@@ -0,0 +1,37 @@
+/*
+ * Object count scalability and style resolution
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef OBJSCALE_H
+#define OBJSCALE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+struct objscale_cache_stats {
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t bypass;	// style refresh off or transition setup
+	uint32_t flushes;	// by any thread
+};
+
+/* Cache the values lv_obj_get_style_prop() resolves; off by default */
+void objscale_cache_enable(bool on);
+/* Forget every cached value, in all threads */
+void objscale_cache_flush(void);
+/* Of the calling thread */
+void objscale_cache_get_stats(struct objscale_cache_stats *stats);
+void objscale_cache_reset(void);
+void objscale_cache_report(FILE *fp);
+
+int objscale_bench(void);
+
+#endif /* OBJSCALE_H */
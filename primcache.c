@@ -0,0 +1,674 @@
+/*
+ * Budgeted cache of rounded corner and shadow bitmaps
+ *
+ * The software renderer recomputes the anti-aliased radius mask of every
+ * rounded fill row by row, helped by a cache of LV_DRAW_SW_CIRCLE_CACHE_SIZE
+ * (4) radii, and blurs every box shadow again on each redraw since
+ * LV_DRAW_SW_SHADOW_CACHE_SIZE is 0. Both are build time constants without
+ * any telemetry.
+ *
+ * Attached objects send their draw tasks here (LV_EVENT_DRAW_TASK_ADDED).
+ * A rounded solid fill becomes three plain fills plus four corners blended
+ * from one cached A8 circle of that radius. A box shadow becomes one A8
+ * bitmap, keyed by the blurred box size, radius and blur width, blended in
+ * up to four bands around the part the object's background covers. The
+ * original task is left in place with zero opacity, so LVGL skips it.
+ *
+ * Bitmaps live outside the LVGL heap under a byte budget and are evicted
+ * least recently used first. A bitmap used in the current frame may still
+ * be read by the draw thread and is never evicted; when nothing else can go,
+ * the primitive is left to LVGL and counted as bypassed.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "primcache.h"
+
+#define PRIMCACHE_MAX_ENTRIES	64
+#define PRIMCACHE_MIN_RADIUS	2
+#define PRIMCACHE_ALIGN		64
+#define PRIMCACHE_MAX_SIDE	1024
+
+struct entry {
+	lv_draw_buf_t buf;	// A8
+	uint8_t *data;
+	uint8_t kind;
+	int32_t w;
+	int32_t h;
+	int32_t radius;
+	int32_t blur;
+	uint32_t bytes;
+	uint32_t last;		// frame of the last use
+};
+
+static struct {
+	lv_display_t *disp;
+	uint32_t budget;
+	uint32_t frame;
+	pthread_mutex_t lock;
+	struct entry entries[PRIMCACHE_MAX_ENTRIES];
+	struct primcache_stats stats;
+} pc = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static uint32_t isqrt64(uint64_t x)
+{
+	uint64_t bit = 1ULL << 62;
+	uint64_t res = 0;
+
+	while (bit > x) {
+		bit >>= 2;
+	}
+	while (bit) {
+		if (x >= res + bit) {
+			x -= res + bit;
+			res = (res >> 1) + bit;
+		} else {
+			res >>= 1;
+		}
+		bit >>= 2;
+	}
+
+	return res;
+}
+
+/*
+ * Coverage of a w x h box with corner radius r at (ox, oy) in a bw x bh A8
+ * bitmap, from the signed distance of each pixel centre, in 1/256 px.
+ */
+static void rrect_coverage(uint8_t *p, int32_t bw, int32_t bh, int32_t ox,
+			   int32_t oy, int32_t w, int32_t h, int32_t r)
+{
+	int32_t cx = ox * 256 + w * 128;
+	int32_t cy = oy * 256 + h * 128;
+	int32_t qx;
+	int32_t qy;
+	int32_t d;
+	int32_t x;
+	int32_t y;
+
+	for (y = 0; y < bh; y++) {
+		qy = LV_ABS(y * 256 + 128 - cy) - (h * 128 - r * 256);
+		for (x = 0; x < bw; x++, p++) {
+			qx = LV_ABS(x * 256 + 128 - cx) - (w * 128 - r * 256);
+			d = isqrt64((uint64_t)LV_MAX(qx, 0) * LV_MAX(qx, 0) +
+				    (uint64_t)LV_MAX(qy, 0) * LV_MAX(qy, 0)) +
+			    LV_MIN(LV_MAX(qx, qy), 0) - r * 256;
+			d = LV_CLAMP(0, 128 - d, 256);
+			*p = d * 255 / 256;
+		}
+	}
+}
+
+/* Box blur of n samples step apart, radius r, zero outside */
+static void blur_line(uint8_t *p, int32_t n, int32_t step, int32_t r,
+		      uint8_t *tmp)
+{
+	uint32_t sum = 0;
+	int32_t i;
+
+	for (i = 0; i < n; i++) {
+		tmp[i] = p[i * step];
+	}
+	for (i = 0; i <= r && i < n; i++) {
+		sum += tmp[i];
+	}
+	for (i = 0; i < n; i++) {
+		p[i * step] = sum / (2 * r + 1);
+		if (i + r + 1 < n) {
+			sum += tmp[i + r + 1];
+		}
+		if (i - r >= 0) {
+			sum -= tmp[i - r];
+		}
+	}
+}
+
+/*
+ * Shadow of a w x h box as LVGL lays it out: the bitmap reaches blur / 2 + 1
+ * beyond the box. Two box blurs of a quarter of the width each approach the
+ * renderer's falloff.
+ */
+static void render_shadow(uint8_t *p, int32_t bw, int32_t bh, int32_t r,
+			  int32_t blur)
+{
+	int32_t ext = blur / 2 + 1;
+	int32_t b = blur / 4;
+	uint8_t tmp[PRIMCACHE_MAX_SIDE];
+	int32_t pass;
+	int32_t i;
+
+	rrect_coverage(p, bw, bh, ext, ext, bw - 2 * ext, bh - 2 * ext, r);
+	if (!b) {
+		return;
+	}
+	for (pass = 0; pass < 2; pass++) {
+		for (i = 0; i < bh; i++) {
+			blur_line(p + i * bw, bw, 1, b, tmp);
+		}
+		for (i = 0; i < bw; i++) {
+			blur_line(p + i, bh, bw, b, tmp);
+		}
+	}
+}
+
+static void entry_free(struct entry *e)
+{
+	lv_image_cache_drop(&e->buf);
+	free(e->data);
+	pc.stats.bytes -= e->bytes;
+	pc.stats.entries--;
+	memset(e, 0, sizeof(*e));
+}
+
+/* Least recently used entry not needed by the frame being drawn */
+static struct entry *lru(void)
+{
+	struct entry *victim = NULL;
+	int i;
+
+	for (i = 0; i < PRIMCACHE_MAX_ENTRIES; i++) {
+		struct entry *e = &pc.entries[i];
+
+		if (e->data && e->last != pc.frame &&
+		    (!victim || e->last < victim->last)) {
+			victim = e;
+		}
+	}
+
+	return victim;
+}
+
+static struct entry *lookup(enum primcache_kind kind, int32_t w, int32_t h,
+			    int32_t radius, int32_t blur)
+{
+	struct primcache_counters *c = &pc.stats.kind[kind];
+	uint32_t bytes = w * h;
+	struct entry *e = NULL;
+	struct entry *victim;
+	int i;
+
+	pthread_mutex_lock(&pc.lock);
+	for (i = 0; i < PRIMCACHE_MAX_ENTRIES; i++) {
+		e = &pc.entries[i];
+		if (e->data && e->kind == kind && e->w == w && e->h == h &&
+		    e->radius == radius && e->blur == blur) {
+			e->last = pc.frame;
+			c->hits++;
+			pthread_mutex_unlock(&pc.lock);
+			return e;
+		}
+	}
+
+	// Never evict for a bitmap that could not be cached anyway
+	if (w > PRIMCACHE_MAX_SIDE || h > PRIMCACHE_MAX_SIDE ||
+	    bytes > pc.budget) {
+		c->bypass++;
+		pthread_mutex_unlock(&pc.lock);
+		return NULL;
+	}
+	while (pc.stats.bytes + bytes > pc.budget && (victim = lru())) {
+		pc.stats.kind[victim->kind].evictions++;
+		entry_free(victim);
+	}
+	for (i = 0, e = NULL; i < PRIMCACHE_MAX_ENTRIES && !e; i++) {
+		e = pc.entries[i].data ? NULL : &pc.entries[i];
+	}
+	if (!e && (victim = lru())) {
+		pc.stats.kind[victim->kind].evictions++;
+		entry_free(victim);
+		e = victim;
+	}
+	if (!e || pc.stats.bytes + bytes > pc.budget) {
+		c->bypass++;
+		pthread_mutex_unlock(&pc.lock);
+		return NULL;
+	}
+
+	e->data = aligned_alloc(PRIMCACHE_ALIGN,
+				LV_ALIGN_UP(bytes, PRIMCACHE_ALIGN));
+	if (!e->data) {
+		c->bypass++;
+		pthread_mutex_unlock(&pc.lock);
+		return NULL;
+	}
+	if (kind == PRIMCACHE_CORNER) {
+		rrect_coverage(e->data, w, h, 0, 0, w, h, radius);
+	} else {
+		render_shadow(e->data, w, h, radius, blur);
+	}
+	lv_draw_buf_init(&e->buf, w, h, LV_COLOR_FORMAT_A8, w, e->data, bytes);
+	e->kind = kind;
+	e->w = w;
+	e->h = h;
+	e->radius = radius;
+	e->blur = blur;
+	e->bytes = bytes;
+	e->last = pc.frame;
+	c->misses++;
+	pc.stats.entries++;
+	pc.stats.bytes += bytes;
+	pc.stats.peak = LV_MAX(pc.stats.peak, pc.stats.bytes);
+	pthread_mutex_unlock(&pc.lock);
+
+	return e;
+}
+
+/* Blend the A8 bitmap at img, clipped to clip and the layer's clip area */
+static void blit(lv_layer_t *layer, struct entry *e, const lv_area_t *img,
+		 const lv_area_t *clip, lv_color_t color, lv_opa_t opa)
+{
+	lv_area_t saved = layer->_clip_area;
+	lv_draw_image_dsc_t dsc;
+
+	if (!lv_area_intersect(&layer->_clip_area, &saved, clip)) {
+		layer->_clip_area = saved;
+		return;
+	}
+	lv_draw_image_dsc_init(&dsc);
+	dsc.src = &e->buf;
+	dsc.recolor = color;
+	dsc.recolor_opa = LV_OPA_COVER;
+	dsc.opa = opa;
+	lv_draw_image(layer, &dsc, img);
+	layer->_clip_area = saved;
+}
+
+static void fill_band(lv_layer_t *layer, const lv_draw_fill_dsc_t *src,
+		      int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	lv_draw_fill_dsc_t dsc;
+	lv_area_t a;
+
+	if (x1 > x2 || y1 > y2) {
+		return;
+	}
+	lv_draw_fill_dsc_init(&dsc);
+	dsc.color = src->color;
+	dsc.opa = src->opa;
+	lv_area_set(&a, x1, y1, x2, y2);
+	lv_draw_fill(layer, &dsc, &a);
+}
+
+static void draw_fill(lv_layer_t *layer, lv_draw_fill_dsc_t *dsc,
+		      const lv_area_t *a)
+{
+	int32_t w = lv_area_get_width(a);
+	int32_t h = lv_area_get_height(a);
+	int32_t r = LV_MIN(dsc->radius, LV_MIN(w, h) / 2);
+	struct entry *e;
+	lv_area_t img;
+	lv_area_t clip;
+	int corner;
+
+	if (r < PRIMCACHE_MIN_RADIUS || dsc->opa <= LV_OPA_MIN) {
+		return;
+	}
+	if (dsc->grad.dir != LV_GRAD_DIR_NONE) {
+		pthread_mutex_lock(&pc.lock);
+		pc.stats.kind[PRIMCACHE_CORNER].bypass++;
+		pthread_mutex_unlock(&pc.lock);
+		return;
+	}
+	e = lookup(PRIMCACHE_CORNER, 2 * r, 2 * r, r, 0);
+	if (!e) {
+		return;
+	}
+
+	for (corner = 0; corner < 4; corner++) {
+		img.x1 = corner & 1 ? a->x2 - 2 * r + 1 : a->x1;
+		img.y1 = corner & 2 ? a->y2 - 2 * r + 1 : a->y1;
+		img.x2 = img.x1 + 2 * r - 1;
+		img.y2 = img.y1 + 2 * r - 1;
+		clip.x1 = corner & 1 ? a->x2 - r + 1 : a->x1;
+		clip.y1 = corner & 2 ? a->y2 - r + 1 : a->y1;
+		clip.x2 = clip.x1 + r - 1;
+		clip.y2 = clip.y1 + r - 1;
+		blit(layer, e, &img, &clip, dsc->color, dsc->opa);
+	}
+	fill_band(layer, dsc, a->x1 + r, a->y1, a->x2 - r, a->y1 + r - 1);
+	fill_band(layer, dsc, a->x1, a->y1 + r, a->x2, a->y2 - r);
+	fill_band(layer, dsc, a->x1 + r, a->y2 - r + 1, a->x2 - r, a->y2);
+	dsc->opa = LV_OPA_TRANSP;
+}
+
+/* coords is the object: the box is moved by the offset and grown by spread */
+static void draw_shadow(lv_layer_t *layer, lv_draw_box_shadow_dsc_t *dsc,
+			const lv_area_t *coords)
+{
+	int32_t ext = dsc->width / 2 + 1;
+	lv_area_t core = *coords;
+	lv_area_t inner = *coords;
+	lv_area_t img;
+	lv_area_t band;
+	struct entry *e;
+	int32_t r;
+	int32_t ri;
+
+	if (dsc->opa <= LV_OPA_MIN) {
+		return;
+	}
+	lv_area_move(&core, dsc->ofs_x, dsc->ofs_y);
+	lv_area_increase(&core, dsc->spread, dsc->spread);
+	if (lv_area_get_width(&core) < 1 || lv_area_get_height(&core) < 1) {
+		return;
+	}
+	r = LV_MIN(dsc->radius, LV_MIN(lv_area_get_width(&core),
+				       lv_area_get_height(&core)) / 2);
+	img = core;
+	lv_area_increase(&img, ext, ext);
+	e = lookup(PRIMCACHE_SHADOW, lv_area_get_width(&img),
+		   lv_area_get_height(&img), r, dsc->width);
+	if (!e) {
+		return;
+	}
+
+	if (!dsc->bg_cover) {
+		blit(layer, e, &img, &img, dsc->color, dsc->opa);
+		dsc->opa = LV_OPA_TRANSP;
+		return;
+	}
+	// Skip what the background will cover: the object minus its corners
+	ri = LV_MIN(dsc->radius, LV_MIN(lv_area_get_width(coords),
+					lv_area_get_height(coords)) / 2);
+	lv_area_increase(&inner, -ri, -ri);
+	if (inner.x1 > inner.x2 || inner.y1 > inner.y2) {
+		blit(layer, e, &img, &img, dsc->color, dsc->opa);
+		dsc->opa = LV_OPA_TRANSP;
+		return;
+	}
+	lv_area_set(&band, img.x1, img.y1, img.x2, inner.y1 - 1);
+	blit(layer, e, &img, &band, dsc->color, dsc->opa);
+	lv_area_set(&band, img.x1, inner.y2 + 1, img.x2, img.y2);
+	blit(layer, e, &img, &band, dsc->color, dsc->opa);
+	lv_area_set(&band, img.x1, inner.y1, inner.x1 - 1, inner.y2);
+	blit(layer, e, &img, &band, dsc->color, dsc->opa);
+	lv_area_set(&band, inner.x2 + 1, inner.y1, img.x2, inner.y2);
+	blit(layer, e, &img, &band, dsc->color, dsc->opa);
+	dsc->opa = LV_OPA_TRANSP;
+}
+
+static void draw_task_cb(lv_event_t *e)
+{
+	lv_draw_task_t *t = lv_event_get_draw_task(e);
+	lv_draw_dsc_base_t *base = lv_draw_task_get_draw_dsc(t);
+	lv_area_t a;
+
+	if (!pc.disp) {
+		return;
+	}
+	lv_draw_task_get_area(t, &a);
+	switch (lv_draw_task_get_type(t)) {
+	case LV_DRAW_TASK_TYPE_FILL:
+		draw_fill(base->layer, (lv_draw_fill_dsc_t *)base, &a);
+		break;
+	case LV_DRAW_TASK_TYPE_BOX_SHADOW:
+		draw_shadow(base->layer, (lv_draw_box_shadow_dsc_t *)base, &a);
+		break;
+	default:
+		break;
+	}
+}
+
+static void primcache_event_cb(lv_event_t *e)
+{
+	pthread_mutex_lock(&pc.lock);
+	pc.frame++;
+	pc.stats.frames++;
+	pthread_mutex_unlock(&pc.lock);
+}
+
+int primcache_init(lv_display_t *disp, uint32_t budget)
+{
+	if (pc.disp) {
+		return -1;
+	}
+	memset(&pc.stats, 0, sizeof(pc.stats));
+	memset(pc.entries, 0, sizeof(pc.entries));
+	pc.disp = disp;
+	pc.budget = budget;
+	pc.frame = 1;
+	lv_display_add_event_cb(disp, primcache_event_cb, LV_EVENT_REFR_READY,
+				NULL);
+
+	return 0;
+}
+
+/* Call between frames, after detaching the objects */
+void primcache_deinit(void)
+{
+	int i;
+
+	if (!pc.disp) {
+		return;
+	}
+	lv_display_remove_event_cb_with_user_data(pc.disp, primcache_event_cb,
+						  NULL);
+	for (i = 0; i < PRIMCACHE_MAX_ENTRIES; i++) {
+		if (pc.entries[i].data) {
+			entry_free(&pc.entries[i]);
+		}
+	}
+	pc.disp = NULL;
+}
+
+void primcache_attach(lv_obj_t *obj)
+{
+	uint32_t i;
+
+	lv_obj_add_event_cb(obj, draw_task_cb, LV_EVENT_DRAW_TASK_ADDED, NULL);
+	lv_obj_add_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+	for (i = 0; i < lv_obj_get_child_count(obj); i++) {
+		primcache_attach(lv_obj_get_child(obj, i));
+	}
+}
+
+void primcache_detach(lv_obj_t *obj)
+{
+	uint32_t i;
+
+	lv_obj_remove_event_cb(obj, draw_task_cb);
+	lv_obj_remove_flag(obj, LV_OBJ_FLAG_SEND_DRAW_TASK_EVENTS);
+	for (i = 0; i < lv_obj_get_child_count(obj); i++) {
+		primcache_detach(lv_obj_get_child(obj, i));
+	}
+}
+
+void primcache_get_stats(struct primcache_stats *stats)
+{
+	pthread_mutex_lock(&pc.lock);
+	*stats = pc.stats;
+	pthread_mutex_unlock(&pc.lock);
+}
+
+/* Counters only; cached bitmaps stay */
+void primcache_reset(void)
+{
+	pthread_mutex_lock(&pc.lock);
+	memset(pc.stats.kind, 0, sizeof(pc.stats.kind));
+	pc.stats.frames = 0;
+	pc.stats.peak = pc.stats.bytes;
+	pthread_mutex_unlock(&pc.lock);
+}
+
+static double hit_pct(const struct primcache_counters *c)
+{
+	uint64_t n = c->hits + c->misses + c->bypass;
+
+	return n ? 100.0 * c->hits / n : 0.0;
+}
+
+void primcache_report(FILE *fp)
+{
+	static const char *const names[PRIMCACHE_KINDS] = {
+		"corner", "shadow",
+	};
+	struct primcache_stats st;
+	int k;
+
+	primcache_get_stats(&st);
+	fprintf(fp, "primcache: %u entries, %u bytes (peak %u) of %u\n",
+		st.entries, st.bytes, st.peak, pc.budget);
+	for (k = 0; k < PRIMCACHE_KINDS; k++) {
+		fprintf(fp, "  %-6s %5.1f%% hits, %llu misses, %llu evictions, "
+			"%llu bypassed\n", names[k], hit_pct(&st.kind[k]),
+			(unsigned long long)st.kind[k].misses,
+			(unsigned long long)st.kind[k].evictions,
+			(unsigned long long)st.kind[k].bypass);
+	}
+}
+
+/*
+ * Benchmark: full redraws of the main.c screen (button, slider) and of a
+ * dashboard of rounded cards with shadows in three sizes and two radii,
+ * drawn by LVGL alone, with a budget that holds every bitmap and with one
+ * that does not. The last frame of each cached pass is compared with the
+ * one LVGL drew: the corners and the two box blur shadow falloff may differ
+ * from LVGL's masks and blur by a few levels, no more.
+ */
+#define PRIMCACHE_BENCH_FRAMES		100
+#define PRIMCACHE_BENCH_COLS		4
+#define PRIMCACHE_BENCH_ROWS		3
+#define PRIMCACHE_BENCH_TOLERANCE	16	// per channel byte
+
+static lv_obj_t *bench_demo(lv_obj_t *scr)
+{
+	lv_obj_t *slider;
+	lv_obj_t *obj;
+
+	obj = lv_label_create(scr);
+	lv_label_set_text(obj, "Light and Versatile Graphics Library");
+	lv_obj_align(obj, LV_ALIGN_CENTER, 0, 75);
+	obj = lv_button_create(scr);
+	lv_obj_set_size(obj, 100, 50);
+	lv_obj_align(obj, LV_ALIGN_TOP_MID, 0, 0);
+	obj = lv_label_create(obj);
+	lv_label_set_text(obj, "Button");
+	lv_obj_center(obj);
+	slider = lv_slider_create(scr);
+	lv_obj_set_size(slider, 200, 50);
+	lv_obj_center(slider);
+
+	return slider;
+}
+
+static lv_obj_t *bench_cards(lv_obj_t *scr)
+{
+	lv_obj_t *card;
+	lv_obj_t *label = NULL;
+	int i;
+
+	for (i = 0; i < PRIMCACHE_BENCH_COLS * PRIMCACHE_BENCH_ROWS; i++) {
+		card = lv_obj_create(scr);
+		lv_obj_remove_flag(card, LV_OBJ_FLAG_SCROLLABLE);
+		lv_obj_set_size(card, 60 + i % 3 * 5, 55);
+		lv_obj_set_pos(card, 12 + i % PRIMCACHE_BENCH_COLS * 76,
+			       12 + i / PRIMCACHE_BENCH_COLS * 76);
+		lv_obj_set_style_radius(card, i % 2 ? 8 : 14, 0);
+		lv_obj_set_style_shadow_width(card, 16, 0);
+		lv_obj_set_style_shadow_offset_y(card, 4, 0);
+		lv_obj_set_style_shadow_opa(card, LV_OPA_40, 0);
+		label = lv_label_create(card);
+		lv_label_set_text_fmt(label, "%d", i);
+		lv_obj_center(label);
+	}
+
+	return label;
+}
+
+static int bench_pass(const char *label, bool cards, uint32_t budget,
+		      uint8_t **ref)
+{
+	struct primcache_stats st;
+	struct bench_frames f;
+	lv_display_t *disp;
+	lv_obj_t *scr;
+	lv_obj_t *obj;
+	uint32_t diff;
+	uint32_t max;
+	uint32_t i;
+	int ret = 0;
+	int k;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	scr = lv_display_get_screen_active(disp);
+	obj = cards ? bench_cards(scr) : bench_demo(scr);
+	if (budget) {
+		primcache_init(disp, budget);
+		primcache_attach(scr);
+	}
+	lv_refr_now(disp);
+	primcache_reset();
+
+	bench_frames_attach(disp, &f);
+	bench_frames_reset(&f);
+	for (i = 0; i < PRIMCACHE_BENCH_FRAMES; i++) {
+		if (cards) {
+			lv_label_set_text_fmt(obj, "%u", i);
+		} else {
+			lv_slider_set_value(obj, i % 101, LV_ANIM_OFF);
+		}
+		lv_obj_invalidate(scr);
+		lv_refr_now(disp);
+	}
+	bench_frames_detach(disp, &f);
+	if (bench_display_compare(disp, ref, &diff, &max)) {
+		bench_display_delete(disp);
+		return -1;
+	}
+
+	bench_frames_print(label, &f);
+	if (budget) {
+		printf("  %u bytes differ from LVGL, by %u at most\n", diff,
+		       max);
+		if (max > PRIMCACHE_BENCH_TOLERANCE) {
+			printf("  primcache: beyond the tolerance of %u\n",
+			       PRIMCACHE_BENCH_TOLERANCE);
+			ret = -1;
+		}
+		primcache_get_stats(&st);
+		for (k = 0; k < PRIMCACHE_KINDS; k++) {
+			printf("  %s: %.1f%% hits, %.2f misses/frame, "
+			       "%llu bypassed\n",
+			       k == PRIMCACHE_CORNER ? "corners" : "shadows",
+			       hit_pct(&st.kind[k]),
+			       (double)st.kind[k].misses / PRIMCACHE_BENCH_FRAMES,
+			       (unsigned long long)st.kind[k].bypass);
+		}
+		printf("  %u bitmaps, peak %u of %u bytes\n", st.entries,
+		       st.peak, budget);
+		primcache_detach(scr);
+		primcache_deinit();
+	}
+	bench_display_delete(disp);
+
+	return ret;
+}
+
+int primcache_bench(void)
+{
+	uint8_t *ref = NULL;
+	int ret;
+
+	ret = bench_pass("demo, LVGL", false, 0, &ref) ||
+	      bench_pass("demo, 64 KB", false, 64 * 1024, &ref);
+	free(ref);
+	ref = NULL;
+	ret = ret ||
+	      bench_pass("cards, LVGL", true, 0, &ref) ||
+	      bench_pass("cards, 128 KB", true, 128 * 1024, &ref) ||
+	      bench_pass("cards, 16 KB", true, 16 * 1024, &ref);
+	free(ref);
+
+	return ret ? -1 : 0;
+}
@@ -0,0 +1,51 @@
+/*
+ * Budgeted cache of rounded corner and shadow bitmaps
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef PRIMCACHE_H
+#define PRIMCACHE_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+enum primcache_kind {
+	PRIMCACHE_CORNER,	// anti-aliased circle, keyed by radius
+	PRIMCACHE_SHADOW,	// blurred box, keyed by size, radius and blur
+	PRIMCACHE_KINDS
+};
+
+struct primcache_counters {
+	uint64_t hits;
+	uint64_t misses;	// bitmap computed and cached
+	uint64_t evictions;
+	uint64_t bypass;	// left to LVGL: gradient, tiny or over budget
+};
+
+struct primcache_stats {
+	struct primcache_counters kind[PRIMCACHE_KINDS];
+	uint32_t frames;
+	uint32_t entries;
+	uint32_t bytes;
+	uint32_t peak;		// [bytes]
+};
+
+/* Cache at most budget bytes of bitmaps for objects drawn on disp */
+int primcache_init(lv_display_t *disp, uint32_t budget);
+void primcache_deinit(void);
+/* Draw the rounded fills and box shadows of obj and its children cached */
+void primcache_attach(lv_obj_t *obj);
+void primcache_detach(lv_obj_t *obj);
+void primcache_get_stats(struct primcache_stats *stats);
+void primcache_reset(void);
+void primcache_report(FILE *fp);
+
+int primcache_bench(void);
+
+#endif /* PRIMCACHE_H */
@@ -0,0 +1,578 @@
+/*
+ * Per-frame invalidation and overdraw statistics
+ *
+ * LV_USE_REFR_DEBUG only paints the redrawn areas; this counts them. Every
+ * LV_EVENT_INVALIDATE_AREA is recorded and, at LV_EVENT_RENDER_START, all of
+ * a frame's requests are attributed in one walk of the object trees, each
+ * to the smallest object whose draw area contains it. Requests beyond
+ * REFRSTAT_MAX_PENDING in one frame are counted without an object.
+ *
+ * At RENDER_START the areas LVGL kept after joining are measured as well:
+ * their distinct pixels, their summed size (what is rendered) and the
+ * bounding box pixels of the visible objects inside them. Bounding boxes
+ * include transparent parts and rounded corners, so the bounding box
+ * overdraw (box pixels per distinct pixel) is an upper bound on what the
+ * draw units write, not a measurement of it. Flushed pixels come from a
+ * wrapped flush callback.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "lvgl/src/core/lv_obj_class_private.h"
+#include "lvgl/src/display/lv_display_private.h"
+
+#include "bench.h"
+#include "refrstat.h"
+
+#define REFRSTAT_MAX_PENDING 64	// bits of a search mask
+
+struct search {
+	lv_obj_t *obj;
+	uint64_t size;
+};
+
+static struct {
+	lv_display_t *disp;
+	lv_display_flush_cb_t flush_cb;
+	FILE *csv;
+	uint64_t t0_us;
+	uint64_t start_us;
+	bool rendering;
+
+	struct refrstat_frame cur;
+	struct refrstat_frame last;
+	struct refrstat_frame total;
+	struct refrstat_blame top;	// largest single request of cur
+
+	struct refrstat_blame blame[REFRSTAT_MAX_BLAME];
+	int nblame;
+
+	lv_area_t pending[REFRSTAT_MAX_PENDING];	// not attributed yet
+	int npending;
+} rs;
+
+static int cmp_i32(const void *a, const void *b)
+{
+	int32_t x = *(const int32_t *)a;
+	int32_t y = *(const int32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static int uniq(int32_t *v, int n)
+{
+	int i;
+	int j = 0;
+
+	qsort(v, n, sizeof(*v), cmp_i32);
+	for (i = 0; i < n; i++) {
+		if (!j || v[j - 1] != v[i]) {
+			v[j++] = v[i];
+		}
+	}
+
+	return j;
+}
+
+/* Distinct pixels of up to LV_INV_BUF_SIZE areas on a compressed grid */
+static uint64_t union_px(const lv_area_t *a, int n)
+{
+	int32_t xs[LV_INV_BUF_SIZE * 2];
+	int32_t ys[LV_INV_BUF_SIZE * 2];
+	uint64_t px = 0;
+	int nx;
+	int ny;
+	int i;
+	int j;
+	int k;
+
+	for (i = 0; i < n; i++) {
+		xs[2 * i] = a[i].x1;
+		xs[2 * i + 1] = a[i].x2 + 1;
+		ys[2 * i] = a[i].y1;
+		ys[2 * i + 1] = a[i].y2 + 1;
+	}
+	nx = uniq(xs, 2 * n);
+	ny = uniq(ys, 2 * n);
+
+	for (j = 0; j + 1 < ny; j++) {
+		for (i = 0; i + 1 < nx; i++) {
+			for (k = 0; k < n; k++) {
+				if (xs[i] >= a[k].x1 && xs[i] <= a[k].x2 &&
+				    ys[j] >= a[k].y1 && ys[j] <= a[k].y2) {
+					px += (uint64_t)(xs[i + 1] - xs[i]) *
+					      (ys[j + 1] - ys[j]);
+					break;
+				}
+			}
+		}
+	}
+
+	return px;
+}
+
+static bool obj_visible(lv_obj_t *obj, lv_area_t *ext)
+{
+	int32_t ext_size;
+
+	if (lv_obj_has_flag(obj, LV_OBJ_FLAG_HIDDEN) ||
+	    lv_obj_get_style_opa(obj, LV_PART_MAIN) <= LV_OPA_MIN) {
+		return false;
+	}
+	ext_size = lv_obj_get_ext_draw_size(obj);
+	lv_obj_get_coords(obj, ext);
+	lv_area_increase(ext, ext_size, ext_size);
+
+	return true;
+}
+
+/* Search k follows pending area k while bit k of mask is set */
+static void find_objs(lv_obj_t *obj, uint64_t mask, struct search *s)
+{
+	uint64_t in = 0;
+	lv_area_t ext;
+	uint32_t i;
+	uint32_t n;
+	int k;
+
+	if (!obj || !obj_visible(obj, &ext)) {
+		return;
+	}
+	for (k = 0; k < rs.npending; k++) {
+		if (!(mask & (1ULL << k)) ||
+		    !lv_area_is_in(&rs.pending[k], &ext, 0)) {
+			continue;
+		}
+		in |= 1ULL << k;
+		// Children come later and win ties with their parent
+		if (!s[k].obj || lv_area_get_size(&ext) <= s[k].size) {
+			s[k].obj = obj;
+			s[k].size = lv_area_get_size(&ext);
+		}
+	}
+	if (!in) {
+		return;
+	}
+	n = lv_obj_get_child_count(obj);
+	for (i = 0; i < n; i++) {
+		find_objs(lv_obj_get_child(obj, i), in, s);
+	}
+}
+
+static uint64_t bbox_px(lv_obj_t *obj, const lv_area_t *area)
+{
+	lv_area_t ext;
+	lv_area_t clip;
+	uint64_t px;
+	uint32_t i;
+	uint32_t n;
+
+	if (!obj || !obj_visible(obj, &ext) ||
+	    !lv_area_intersect(&clip, &ext, area)) {
+		return 0;
+	}
+	px = lv_area_get_size(&clip);
+	n = lv_obj_get_child_count(obj);
+	for (i = 0; i < n; i++) {
+		px += bbox_px(lv_obj_get_child(obj, i), &clip);
+	}
+
+	return px;
+}
+
+static const char *class_name(lv_obj_t *obj)
+{
+	const char *name = obj ? lv_obj_get_class(obj)->name : NULL;
+
+	return name ? name : "-";
+}
+
+static void blame(lv_obj_t *obj, uint64_t px)
+{
+	struct refrstat_blame *b = NULL;
+	int j;
+
+	for (j = 0; j < rs.nblame; j++) {
+		if (rs.blame[j].obj == obj) {
+			b = &rs.blame[j];
+			break;
+		}
+	}
+	if (!b) {
+		// The last entry collects everything once the table is full
+		if (rs.nblame < REFRSTAT_MAX_BLAME) {
+			b = &rs.blame[rs.nblame++];
+			b->obj = obj;
+			b->class_name = class_name(obj);
+		} else {
+			b = &rs.blame[REFRSTAT_MAX_BLAME - 1];
+			b->obj = NULL;
+			b->class_name = "(other)";
+		}
+	}
+	b->count++;
+	b->px += px;
+
+	if (px > rs.top.px) {
+		rs.top.obj = obj;
+		rs.top.class_name = class_name(obj);
+		rs.top.px = px;
+	}
+}
+
+static void invalidated(const lv_area_t *area)
+{
+	rs.cur.inv_requests++;
+	if (rs.npending < REFRSTAT_MAX_PENDING) {
+		rs.pending[rs.npending++] = *area;
+	} else {
+		blame(NULL, lv_area_get_size(area));
+	}
+}
+
+/* Once per frame, over the trees as they are drawn */
+static void attribute(void)
+{
+	lv_obj_t *roots[] = {
+		lv_display_get_layer_bottom(rs.disp),
+		lv_display_get_screen_active(rs.disp),
+		lv_display_get_layer_top(rs.disp),
+		lv_display_get_layer_sys(rs.disp),
+	};
+	struct search s[REFRSTAT_MAX_PENDING];
+	uint64_t all;
+	size_t i;
+	int k;
+
+	if (!rs.npending) {
+		return;
+	}
+	memset(s, 0, rs.npending * sizeof(s[0]));
+	all = rs.npending == REFRSTAT_MAX_PENDING ? UINT64_MAX
+						  : (1ULL << rs.npending) - 1;
+	for (i = 0; i < sizeof(roots) / sizeof(roots[0]); i++) {
+		find_objs(roots[i], all, s);
+	}
+	for (k = 0; k < rs.npending; k++) {
+		blame(s[k].obj, lv_area_get_size(&rs.pending[k]));
+	}
+	rs.npending = 0;
+}
+
+static void render_start(void)
+{
+	lv_area_t areas[LV_INV_BUF_SIZE];
+	lv_obj_t *scr = lv_display_get_screen_active(rs.disp);
+	int n = 0;
+	uint32_t i;
+
+	attribute();
+	for (i = 0; i < rs.disp->inv_p; i++) {
+		if (!rs.disp->inv_area_joined[i]) {
+			areas[n++] = rs.disp->inv_areas[i];
+		}
+	}
+	rs.cur.areas = n;
+	rs.cur.union_px = union_px(areas, n);
+	for (i = 0; i < (uint32_t)n; i++) {
+		rs.cur.rendered_px += lv_area_get_size(&areas[i]);
+		rs.cur.bbox_px += bbox_px(lv_display_get_layer_bottom(rs.disp),
+					  &areas[i]) +
+				  bbox_px(scr, &areas[i]) +
+				  bbox_px(lv_display_get_layer_top(rs.disp),
+					  &areas[i]) +
+				  bbox_px(lv_display_get_layer_sys(rs.disp),
+					  &areas[i]);
+	}
+	rs.start_us = bench_now_us();
+	rs.rendering = true;
+}
+
+static void frame_done(void)
+{
+	struct refrstat_frame *f = &rs.cur;
+
+	f->frames = 1;
+	f->render_us = bench_now_us() - rs.start_us;
+	rs.last = *f;
+
+	rs.total.frames++;
+	rs.total.inv_requests += f->inv_requests;
+	rs.total.areas += f->areas;
+	rs.total.union_px += f->union_px;
+	rs.total.rendered_px += f->rendered_px;
+	rs.total.flushed_px += f->flushed_px;
+	rs.total.bbox_px += f->bbox_px;
+	rs.total.render_us += f->render_us;
+
+	if (rs.csv) {
+		fprintf(rs.csv, "%llu,%u,%u,%llu,%llu,%llu,%llu,%.2f,%llu,%s,%llu\n",
+			(unsigned long long)(bench_now_us() - rs.t0_us) / 1000,
+			f->inv_requests, f->areas,
+			(unsigned long long)f->union_px,
+			(unsigned long long)f->rendered_px,
+			(unsigned long long)f->flushed_px,
+			(unsigned long long)f->bbox_px,
+			refrstat_bbox_overdraw(f),
+			(unsigned long long)f->render_us,
+			rs.top.class_name ? rs.top.class_name : "-",
+			(unsigned long long)rs.top.px);
+	}
+
+	memset(&rs.cur, 0, sizeof(rs.cur));
+	memset(&rs.top, 0, sizeof(rs.top));
+	rs.rendering = false;
+}
+
+static void refrstat_event_cb(lv_event_t *e)
+{
+	switch (lv_event_get_code(e)) {
+	case LV_EVENT_INVALIDATE_AREA:
+		invalidated(lv_event_get_param(e));
+		break;
+	case LV_EVENT_RENDER_START:
+		render_start();
+		break;
+	case LV_EVENT_REFR_READY:
+		// Requests LVGL dropped without rendering still count
+		attribute();
+		if (rs.rendering) {
+			frame_done();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void refrstat_flush_cb(lv_display_t *disp, const lv_area_t *area,
+			      uint8_t *px_map)
+{
+	rs.cur.flushed_px += lv_area_get_size(area);
+	rs.flush_cb(disp, area, px_map);
+}
+
+int refrstat_start(lv_display_t *disp, const char *csv)
+{
+	memset(&rs, 0, sizeof(rs));
+	if (csv) {
+		rs.csv = fopen(csv, "w");
+		if (!rs.csv) {
+			perror(csv);
+			return -1;
+		}
+		fprintf(rs.csv, "ms,inv_requests,areas,union_px,rendered_px,"
+			"flushed_px,bbox_px,bbox_overdraw,render_us,top_class,"
+			"top_px\n");
+	}
+	rs.disp = disp;
+	rs.t0_us = bench_now_us();
+	rs.flush_cb = disp->flush_cb;
+	lv_display_set_flush_cb(disp, refrstat_flush_cb);
+	lv_display_add_event_cb(disp, refrstat_event_cb, LV_EVENT_ALL, NULL);
+
+	return 0;
+}
+
+/* Stop in reverse order of other flush callback wrappers (mirror) */
+void refrstat_stop(void)
+{
+	if (!rs.disp) {
+		return;
+	}
+	lv_display_remove_event_cb_with_user_data(rs.disp, refrstat_event_cb,
+						  NULL);
+	lv_display_set_flush_cb(rs.disp, rs.flush_cb);
+	if (rs.csv) {
+		fclose(rs.csv);
+	}
+	memset(&rs, 0, sizeof(rs));
+}
+
+void refrstat_reset(void)
+{
+	memset(&rs.last, 0, sizeof(rs.last));
+	memset(&rs.total, 0, sizeof(rs.total));
+	memset(rs.blame, 0, sizeof(rs.blame));
+	rs.nblame = 0;
+}
+
+void refrstat_get_last(struct refrstat_frame *f)
+{
+	*f = rs.last;
+}
+
+void refrstat_get_totals(struct refrstat_frame *f)
+{
+	*f = rs.total;
+}
+
+static int cmp_blame(const void *a, const void *b)
+{
+	uint64_t x = ((const struct refrstat_blame *)a)->px;
+	uint64_t y = ((const struct refrstat_blame *)b)->px;
+
+	return (x < y) - (x > y);
+}
+
+int refrstat_get_blame(struct refrstat_blame *b, int max)
+{
+	struct refrstat_blame sorted[REFRSTAT_MAX_BLAME];
+	int n = LV_MIN(max, rs.nblame);
+
+	memcpy(sorted, rs.blame, rs.nblame * sizeof(sorted[0]));
+	qsort(sorted, rs.nblame, sizeof(sorted[0]), cmp_blame);
+	memcpy(b, sorted, n * sizeof(sorted[0]));
+
+	return n;
+}
+
+double refrstat_bbox_overdraw(const struct refrstat_frame *f)
+{
+	return f->union_px ? (double)f->bbox_px / f->union_px : 0.0;
+}
+
+void refrstat_report(FILE *fp)
+{
+	struct refrstat_blame b[5];
+	struct refrstat_frame *t = &rs.total;
+	double n = t->frames ? t->frames : 1;
+	int cnt;
+	int i;
+
+	fprintf(fp, "refrstat: %u frames, per frame: %.1f invalidations, "
+		"%.1f areas, %.0f px distinct, %.0f px rendered, "
+		"%.0f px flushed, bbox overdraw %.2f, %.0f us\n",
+		t->frames, t->inv_requests / n, t->areas / n,
+		t->union_px / n, t->rendered_px / n, t->flushed_px / n,
+		refrstat_bbox_overdraw(t), t->render_us / n);
+	cnt = refrstat_get_blame(b, 5);
+	for (i = 0; i < cnt; i++) {
+		fprintf(fp, "  %-12s %p %6u invalidations %10llu px\n",
+			b[i].class_name, b[i].obj, b[i].count,
+			(unsigned long long)b[i].px);
+	}
+}
+
+/*
+ * Benchmark: the main.c screen on a headless display, with the updates
+ * main.c makes. The once-per-second status text is timed both with the
+ * lv_obj_clean() that main.c does before lv_label_set_text() and without.
+ */
+#define REFRSTAT_BENCH_FRAMES 100
+
+enum update {
+	UPDATE_CLEAN_TEXT,
+	UPDATE_TEXT,
+	UPDATE_SLIDER,
+};
+
+struct bench_screen {
+	lv_obj_t *status;
+	lv_obj_t *slider;
+	lv_obj_t *slider_label;
+};
+
+static void bench_update(struct bench_screen *s, enum update u, uint32_t i)
+{
+	time_t t = 1767225600 + i;
+	char buf[8];
+
+	switch (u) {
+	case UPDATE_CLEAN_TEXT:
+		lv_obj_clean(s->status);
+		lv_label_set_text(s->status, asctime(gmtime(&t)));
+		break;
+	case UPDATE_TEXT:
+		lv_label_set_text(s->status, asctime(gmtime(&t)));
+		break;
+	case UPDATE_SLIDER:
+		lv_slider_set_value(s->slider, i % 101, LV_ANIM_OFF);
+		snprintf(buf, sizeof(buf), "%d",
+			 (int)lv_slider_get_value(s->slider));
+		lv_label_set_text(s->slider_label, buf);
+		lv_obj_align_to(s->slider_label, s->slider,
+				LV_ALIGN_OUT_BOTTOM_MID, 0, 0);
+		break;
+	}
+}
+
+int refrstat_bench(void)
+{
+	static const char *const names[] = {
+		"clean + set_text", "set_text", "slider drag",
+	};
+	struct refrstat_blame b[3];
+	struct refrstat_frame t;
+	struct bench_screen s;
+	lv_display_t *disp;
+	lv_obj_t *scr;
+	lv_obj_t *obj;
+	double n;
+	int u;
+	int cnt;
+	int i;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	scr = lv_display_get_screen_active(disp);
+	obj = lv_label_create(scr);
+	lv_label_set_text(obj, "Light and Versatile Graphics Library");
+	lv_obj_align(obj, LV_ALIGN_CENTER, 0, 75);
+	obj = lv_button_create(scr);
+	lv_obj_set_size(obj, 100, 50);
+	lv_obj_align(obj, LV_ALIGN_TOP_MID, 0, 0);
+	obj = lv_label_create(obj);
+	lv_label_set_text(obj, "Button");
+	lv_obj_center(obj);
+	s.slider = lv_slider_create(scr);
+	lv_obj_set_size(s.slider, 200, 50);
+	lv_obj_center(s.slider);
+	s.slider_label = lv_label_create(scr);
+	lv_label_set_text(s.slider_label, "0");
+	lv_obj_align_to(s.slider_label, s.slider, LV_ALIGN_OUT_BOTTOM_MID, 0, 0);
+	s.status = lv_label_create(scr);
+	lv_label_set_text(s.status, "");
+	lv_obj_align(s.status, LV_ALIGN_CENTER, 0, 100);
+	lv_refr_now(disp);
+
+	if (refrstat_start(disp, NULL)) {
+		bench_display_delete(disp);
+		return -1;
+	}
+
+	printf("%-24s %6s %6s %8s %8s %8s %9s %8s\n", "update", "inv",
+	       "areas", "px", "rendered", "flushed", "bbox od", "us");
+	for (u = UPDATE_CLEAN_TEXT; u <= UPDATE_SLIDER; u++) {
+		refrstat_reset();
+		for (i = 0; i < REFRSTAT_BENCH_FRAMES; i++) {
+			bench_update(&s, u, i);
+			lv_refr_now(disp);
+		}
+		refrstat_get_totals(&t);
+		n = t.frames ? t.frames : 1;
+		printf("%-24s %6.1f %6.1f %8.0f %8.0f %8.0f %9.2f %8.1f\n",
+		       names[u], t.inv_requests / n, t.areas / n,
+		       t.union_px / n, t.rendered_px / n, t.flushed_px / n,
+		       refrstat_bbox_overdraw(&t), t.render_us / n);
+		cnt = refrstat_get_blame(b, 3);
+		for (i = 0; i < cnt; i++) {
+			printf("  %-22s %6.1f invalidations/frame %8.0f px\n",
+			       b[i].class_name, b[i].count / n, b[i].px / n);
+		}
+	}
+
+	refrstat_stop();
+	bench_display_delete(disp);
+
+	return 0;
+}
@@ -0,0 +1,55 @@
+/*
+ * Per-frame invalidation and overdraw statistics
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef REFRSTAT_H
+#define REFRSTAT_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+#define REFRSTAT_MAX_BLAME 32
+
+/* One rendered frame, or the sum of all of them (frames > 1) */
+struct refrstat_frame {
+	uint32_t frames;
+	uint32_t inv_requests;	// LV_EVENT_INVALIDATE_AREA count
+	uint32_t areas;		// areas left after LVGL joined them
+	uint64_t union_px;	// distinct pixels in those areas
+	uint64_t rendered_px;	// sum of area sizes (overlaps render twice)
+	uint64_t flushed_px;	// pixels handed to the flush callback
+	uint64_t bbox_px;	// visible object bounding boxes inside the areas
+	uint64_t render_us;	// RENDER_START to REFR_READY
+};
+
+/* An object that asked for redraws; obj may no longer exist */
+struct refrstat_blame {
+	const void *obj;
+	const char *class_name;
+	uint32_t count;
+	uint64_t px;		// invalidated pixels
+};
+
+/* csv: per-frame log, or NULL */
+int refrstat_start(lv_display_t *disp, const char *csv);
+void refrstat_stop(void);
+void refrstat_reset(void);
+
+void refrstat_get_last(struct refrstat_frame *f);
+void refrstat_get_totals(struct refrstat_frame *f);
+/* Largest invalidators first; returns the number of entries filled in */
+int refrstat_get_blame(struct refrstat_blame *b, int max);
+/* Bounding box pixels per distinct invalidated pixel, an upper bound */
+double refrstat_bbox_overdraw(const struct refrstat_frame *f);
+void refrstat_report(FILE *fp);
+
+int refrstat_bench(void);
+
+#endif /* REFRSTAT_H */
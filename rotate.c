@@ -0,0 +1,742 @@
+/*
+ * Display rotation offload and a blocked pixel rotation kernel
+ *
+ * With lv_display_set_rotation() every flushed area is rotated into the
+ * panel's orientation on the CPU. For 90 and 270 degrees that is a
+ * transpose: lv_draw_sw_rotate() walks the destination one row at a time
+ * and the source one column at a time, so every pixel read touches a new
+ * cache line.
+ *
+ * Rotation is better left to the hardware. A panel driven directly turns
+ * its address generator with MADCTL (ili9341_set_rotation()), and a DRM
+ * primary plane may have a "rotation" property that scanout honours. LVGL
+ * then draws in the rotated geometry with no rotation of its own. The DRM
+ * driver allocates its framebuffers in the mode's geometry, so there only
+ * 180 degrees can be offloaded; 90 and 270 would need portrait buffers.
+ *
+ * Where the copy has to happen, rotate_blocked() does it in 8x8 pixel
+ * tiles: eight source rows are read into a tile, which is written out as
+ * eight contiguous destination runs. The fixed tile size lets the compiler
+ * keep it in registers and vectorize loads and stores; partial tiles at
+ * the edges go pixel by pixel.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/sysmacros.h>
+
+#include <xf86drm.h>
+#include <xf86drmMode.h>
+
+#include "lvgl/src/display/lv_display_private.h"
+
+#include "bench.h"
+#include "ili9341.h"
+#include "rotate.h"
+
+#define ROTATE_TILE		8
+#define ROTATE_MAX_FDS		1024
+
+static struct {
+	lv_display_t *disp;
+	lv_display_flush_cb_t flush_cb;
+	bool blocked;
+	uint8_t *buf;
+	uint32_t buf_size;
+	struct rotate_stats stats;
+	lv_indev_t *indev;
+	lv_indev_read_cb_t read_cb;
+	lv_display_rotation_t indev_rot;
+} rs;
+
+/*
+ * One set of kernels per pixel size. Area-local source pixel (x, y) goes to
+ * destination (y, w - 1 - x) at 90 degrees, (w - 1 - x, h - 1 - y) at 180
+ * and (h - 1 - y, x) at 270.
+ */
+#define ROTATE_KERNELS(type)						\
+static void rotate90_##type(const uint8_t *src, uint32_t ss,		\
+			    uint8_t *dst, uint32_t ds,			\
+			    int32_t w, int32_t h)			\
+{									\
+	type t[ROTATE_TILE][ROTATE_TILE];				\
+	int32_t bx, by, x, y;						\
+									\
+	for (by = 0; by + ROTATE_TILE <= h; by += ROTATE_TILE) {	\
+		for (bx = 0; bx + ROTATE_TILE <= w; bx += ROTATE_TILE) {\
+			for (y = 0; y < ROTATE_TILE; y++) {		\
+				memcpy(t[y], src + (by + y) * ss +	\
+				       bx * sizeof(type), sizeof(t[y]));\
+			}						\
+			for (x = 0; x < ROTATE_TILE; x++) {		\
+				type *d = (type *)(dst +		\
+					(w - 1 - bx - x) * ds) + by;	\
+				for (y = 0; y < ROTATE_TILE; y++) {	\
+					d[y] = t[y][x];			\
+				}					\
+			}						\
+		}							\
+		for (x = bx; x < w; x++) {				\
+			for (y = by; y < by + ROTATE_TILE; y++) {	\
+				((type *)(dst + (w - 1 - x) * ds))[y] =	\
+					((const type *)(src + y * ss))[x];\
+			}						\
+		}							\
+	}								\
+	for (y = by; y < h; y++) {					\
+		for (x = 0; x < w; x++) {				\
+			((type *)(dst + (w - 1 - x) * ds))[y] =		\
+				((const type *)(src + y * ss))[x];	\
+		}							\
+	}								\
+}									\
+									\
+static void rotate180_##type(const uint8_t *src, uint32_t ss,		\
+			     uint8_t *dst, uint32_t ds,			\
+			     int32_t w, int32_t h)			\
+{									\
+	int32_t x, y;							\
+									\
+	for (y = 0; y < h; y++) {					\
+		const type *s = (const type *)(src + y * ss);		\
+		type *d = (type *)(dst + (h - 1 - y) * ds) + w - 1;	\
+		for (x = 0; x < w; x++) {				\
+			d[-x] = s[x];					\
+		}							\
+	}								\
+}									\
+									\
+static void rotate270_##type(const uint8_t *src, uint32_t ss,		\
+			     uint8_t *dst, uint32_t ds,			\
+			     int32_t w, int32_t h)			\
+{									\
+	type t[ROTATE_TILE][ROTATE_TILE];				\
+	int32_t bx, by, x, y;						\
+									\
+	for (by = 0; by + ROTATE_TILE <= h; by += ROTATE_TILE) {	\
+		for (bx = 0; bx + ROTATE_TILE <= w; bx += ROTATE_TILE) {\
+			for (y = 0; y < ROTATE_TILE; y++) {		\
+				memcpy(t[y], src + (by + y) * ss +	\
+				       bx * sizeof(type), sizeof(t[y]));\
+			}						\
+			for (x = 0; x < ROTATE_TILE; x++) {		\
+				type *d = (type *)(dst + (bx + x) * ds)	\
+					  + h - by - ROTATE_TILE;	\
+				for (y = 0; y < ROTATE_TILE; y++) {	\
+					d[ROTATE_TILE - 1 - y] = t[y][x];\
+				}					\
+			}						\
+		}							\
+		for (x = bx; x < w; x++) {				\
+			for (y = by; y < by + ROTATE_TILE; y++) {	\
+				((type *)(dst + x * ds))[h - 1 - y] =	\
+					((const type *)(src + y * ss))[x];\
+			}						\
+		}							\
+	}								\
+	for (y = by; y < h; y++) {					\
+		for (x = 0; x < w; x++) {				\
+			((type *)(dst + x * ds))[h - 1 - y] =		\
+				((const type *)(src + y * ss))[x];	\
+		}							\
+	}								\
+}
+
+ROTATE_KERNELS(uint16_t)
+ROTATE_KERNELS(uint32_t)
+
+void rotate_blocked(const uint8_t *src, uint32_t src_stride, uint8_t *dst,
+		    uint32_t dst_stride, int32_t w, int32_t h,
+		    lv_display_rotation_t rot, uint32_t px_size)
+{
+	int32_t y;
+
+	if (px_size == 2) {
+		switch (rot) {
+		case LV_DISPLAY_ROTATION_90:
+			rotate90_uint16_t(src, src_stride, dst, dst_stride,
+					  w, h);
+			return;
+		case LV_DISPLAY_ROTATION_180:
+			rotate180_uint16_t(src, src_stride, dst, dst_stride,
+					   w, h);
+			return;
+		case LV_DISPLAY_ROTATION_270:
+			rotate270_uint16_t(src, src_stride, dst, dst_stride,
+					   w, h);
+			return;
+		default:
+			break;
+		}
+	} else if (px_size == 4) {
+		switch (rot) {
+		case LV_DISPLAY_ROTATION_90:
+			rotate90_uint32_t(src, src_stride, dst, dst_stride,
+					  w, h);
+			return;
+		case LV_DISPLAY_ROTATION_180:
+			rotate180_uint32_t(src, src_stride, dst, dst_stride,
+					   w, h);
+			return;
+		case LV_DISPLAY_ROTATION_270:
+			rotate270_uint32_t(src, src_stride, dst, dst_stride,
+					   w, h);
+			return;
+		default:
+			break;
+		}
+	} else if (rot != LV_DISPLAY_ROTATION_0) {
+		// RGB888 and 8 bit formats are not worth kernels of their own
+		lv_draw_sw_rotate(src, dst, w, h, src_stride, dst_stride, rot,
+				  px_size == 3 ? LV_COLOR_FORMAT_RGB888
+					       : LV_COLOR_FORMAT_L8);
+		return;
+	}
+
+	for (y = 0; y < h; y++) {
+		memcpy(dst + y * dst_stride, src + y * src_stride, w * px_size);
+	}
+}
+
+static void soft_flush_cb(lv_display_t *disp, const lv_area_t *area,
+			  uint8_t *px_map)
+{
+	lv_display_rotation_t rot = lv_display_get_rotation(disp);
+	lv_color_format_t cf = lv_display_get_color_format(disp);
+	int32_t w = lv_area_get_width(area);
+	int32_t h = lv_area_get_height(area);
+	uint32_t src_stride;
+	uint32_t dst_stride;
+	uint32_t size;
+	uint64_t t0;
+	lv_area_t a;
+
+	if (rot == LV_DISPLAY_ROTATION_0) {
+		rs.flush_cb(disp, area, px_map);
+		return;
+	}
+
+	a = *area;
+	lv_display_rotate_area(disp, &a);
+	src_stride = lv_draw_buf_width_to_stride(w, cf);
+	dst_stride = lv_draw_buf_width_to_stride(lv_area_get_width(&a), cf);
+	size = dst_stride * lv_area_get_height(&a);
+	if (size > rs.buf_size) {
+		free(rs.buf);
+		rs.buf_size = 0;
+		rs.buf = aligned_alloc(64, (size + 63) & ~63u);
+		if (!rs.buf) {
+			// Nothing sensible to show; drop the area
+			lv_display_flush_ready(disp);
+			return;
+		}
+		rs.buf_size = size;
+	}
+
+	t0 = bench_now_us();
+	if (rs.blocked) {
+		rotate_blocked(px_map, src_stride, rs.buf, dst_stride, w, h,
+			       rot, lv_color_format_get_size(cf));
+	} else {
+		lv_draw_sw_rotate(px_map, rs.buf, w, h, src_stride, dst_stride,
+				  rot, cf);
+	}
+	rs.stats.us += bench_now_us() - t0;
+	rs.stats.areas++;
+	rs.stats.px += (uint64_t)w * h;
+
+	rs.flush_cb(disp, &a, rs.buf);
+}
+
+int rotate_soft_init(lv_display_t *disp, bool blocked)
+{
+	if (rs.disp) {
+		return -EBUSY;
+	}
+
+	rs.disp = disp;
+	rs.blocked = blocked;
+	rs.flush_cb = disp->flush_cb;
+	memset(&rs.stats, 0, sizeof(rs.stats));
+	lv_display_set_flush_cb(disp, soft_flush_cb);
+
+	return 0;
+}
+
+void rotate_soft_deinit(void)
+{
+	if (!rs.disp) {
+		return;
+	}
+
+	lv_display_set_flush_cb(rs.disp, rs.flush_cb);
+	free(rs.buf);
+	rs.buf = NULL;
+	rs.buf_size = 0;
+	rs.disp = NULL;
+}
+
+void rotate_get_stats(struct rotate_stats *stats)
+{
+	*stats = rs.stats;
+}
+
+/*
+ * The DRM driver keeps its descriptor to itself. Property changes need the
+ * master, and this process holds exactly one master descriptor: LVGL's.
+ */
+static int drm_master_fd(void)
+{
+	struct stat st;
+	int fd;
+
+	for (fd = 0; fd < ROTATE_MAX_FDS; fd++) {
+		if (fstat(fd, &st) || !S_ISCHR(st.st_mode) ||
+		    major(st.st_rdev) != DRM_MAJOR) {
+			continue;
+		}
+		if (drmIsMaster(fd)) {
+			return fd;
+		}
+	}
+
+	return -1;
+}
+
+struct plane_rotation {
+	uint32_t plane;
+	uint32_t prop;
+	uint64_t supported;	// DRM_MODE_ROTATE_* bits
+	bool active;
+};
+
+static bool plane_rotation(int fd, uint32_t id, struct plane_rotation *pr)
+{
+	drmModeObjectPropertiesPtr props;
+	drmModePropertyPtr prop;
+	drmModePlanePtr plane;
+	bool primary = false;
+	uint32_t i;
+	int k;
+
+	props = drmModeObjectGetProperties(fd, id, DRM_MODE_OBJECT_PLANE);
+	if (!props) {
+		return false;
+	}
+	memset(pr, 0, sizeof(*pr));
+	pr->plane = id;
+	for (i = 0; i < props->count_props; i++) {
+		prop = drmModeGetProperty(fd, props->props[i]);
+		if (!prop) {
+			continue;
+		}
+		if (!strcmp(prop->name, "type")) {
+			primary = props->prop_values[i] ==
+				  DRM_PLANE_TYPE_PRIMARY;
+		} else if (!strcmp(prop->name, "rotation")) {
+			pr->prop = prop->prop_id;
+			for (k = 0; k < prop->count_enums; k++) {
+				pr->supported |= 1ULL << prop->enums[k].value;
+			}
+		}
+		drmModeFreeProperty(prop);
+	}
+	drmModeFreeObjectProperties(props);
+
+	plane = drmModeGetPlane(fd, id);
+	if (plane) {
+		pr->active = plane->crtc_id != 0;
+		drmModeFreePlane(plane);
+	}
+
+	return primary && pr->prop;
+}
+
+int rotate_drm_plane(lv_display_rotation_t rot)
+{
+	static const uint64_t bits[] = {
+		[LV_DISPLAY_ROTATION_0] = DRM_MODE_ROTATE_0,
+		[LV_DISPLAY_ROTATION_90] = DRM_MODE_ROTATE_90,
+		[LV_DISPLAY_ROTATION_180] = DRM_MODE_ROTATE_180,
+		[LV_DISPLAY_ROTATION_270] = DRM_MODE_ROTATE_270,
+	};
+	drmModePlaneResPtr res;
+	struct plane_rotation best = { 0 };
+	struct plane_rotation pr;
+	uint32_t i;
+	int ret;
+	int fd;
+
+	fd = drm_master_fd();
+	if (fd < 0) {
+		return -ENODEV;
+	}
+
+	drmSetClientCap(fd, DRM_CLIENT_CAP_UNIVERSAL_PLANES, 1);
+	res = drmModeGetPlaneResources(fd);
+	if (!res) {
+		return -errno;
+	}
+	// The plane scanning out now; before the first commit, the first one
+	for (i = 0; i < res->count_planes; i++) {
+		if (!plane_rotation(fd, res->planes[i], &pr)) {
+			continue;
+		}
+		if (!best.plane || (pr.active && !best.active)) {
+			best = pr;
+		}
+	}
+	drmModeFreePlaneResources(res);
+
+	if (!best.plane || !(best.supported & bits[rot])) {
+		return -ENOTSUP;
+	}
+	ret = drmModeObjectSetProperty(fd, best.plane, DRM_MODE_OBJECT_PLANE,
+				       best.prop, bits[rot]);
+	if (ret) {
+		return -errno;
+	}
+
+	return 0;
+}
+
+/*
+ * The touch controller reports points on the unrotated panel, which LVGL
+ * would rotate along with the display if it knew about the rotation. The
+ * display already has the rotated size.
+ */
+static void indev_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+	lv_display_t *disp = lv_indev_get_display(indev);
+	int32_t w = lv_display_get_horizontal_resolution(disp);
+	int32_t h = lv_display_get_vertical_resolution(disp);
+	lv_point_t p;
+
+	rs.read_cb(indev, data);
+
+	p = data->point;
+	switch (rs.indev_rot) {
+	case LV_DISPLAY_ROTATION_90:
+		data->point.x = w - 1 - p.y;
+		data->point.y = p.x;
+		break;
+	case LV_DISPLAY_ROTATION_180:
+		data->point.x = w - 1 - p.x;
+		data->point.y = h - 1 - p.y;
+		break;
+	case LV_DISPLAY_ROTATION_270:
+		data->point.x = p.y;
+		data->point.y = h - 1 - p.x;
+		break;
+	default:
+		break;
+	}
+}
+
+int rotate_indev_init(lv_indev_t *indev, lv_display_rotation_t rot)
+{
+	if (rs.indev) {
+		return -EBUSY;
+	}
+
+	rs.indev = indev;
+	rs.indev_rot = rot;
+	rs.read_cb = lv_indev_get_read_cb(indev);
+	lv_indev_set_read_cb(indev, indev_read_cb);
+
+	return 0;
+}
+
+void rotate_indev_deinit(void)
+{
+	if (!rs.indev) {
+		return;
+	}
+
+	lv_indev_set_read_cb(rs.indev, rs.read_cb);
+	rs.indev = NULL;
+}
+
+/*
+ * Full screen redraws of a static screen at each rotation, rotated in the
+ * flush by lv_draw_sw_rotate() and by rotate_blocked(), and offloaded to a
+ * mock ILI9341 that applies MADCTL while decoding writes into its GRAM. The
+ * rotation cost is what the flush spends on top of the unrotated copy; the
+ * panel's GRAM must match the software rotated framebuffers exactly.
+ */
+#define ROTATE_BENCH_FRAMES	100
+
+enum bench_path {
+	BENCH_LVGL,
+	BENCH_BLOCKED,
+	BENCH_MADCTL,
+};
+
+static const char *const bench_paths[] = {
+	[BENCH_LVGL] = "lv_draw_sw_rotate",
+	[BENCH_BLOCKED] = "blocked",
+	[BENCH_MADCTL] = "MADCTL",
+};
+
+struct mock_panel {
+	struct ili9341 lcd;
+	uint8_t *buf;
+	uint8_t *gram;		// BENCH_HOR_RES x BENCH_VER_RES
+	uint32_t px_size;
+	uint8_t madctl;
+	uint16_t col[2];
+	uint16_t page[2];
+};
+
+static void mock_send(void *ctx, uint8_t cmd, const uint8_t *param,
+		      size_t len)
+{
+	struct mock_panel *m = ctx;
+	bool mv = m->madctl & ILI9341_MADCTL_MV;
+	uint32_t lw = mv ? BENCH_VER_RES : BENCH_HOR_RES;
+	uint32_t lh = mv ? BENCH_HOR_RES : BENCH_VER_RES;
+	uint32_t x, y, c, p;
+	size_t i;
+
+	switch (cmd) {
+	case ILI9341_CASET:
+		m->col[0] = param[0] << 8 | param[1];
+		m->col[1] = param[2] << 8 | param[3];
+		break;
+	case ILI9341_PASET:
+		m->page[0] = param[0] << 8 | param[1];
+		m->page[1] = param[2] << 8 | param[3];
+		break;
+	case ILI9341_MADCTL:
+		m->madctl = param[0];
+		break;
+	case ILI9341_RAMWR:
+		c = m->col[0];
+		p = m->page[0];
+		for (i = 0; i + m->px_size <= len; i += m->px_size) {
+			// Mirror the MCU addresses, then exchange them
+			x = m->madctl & ILI9341_MADCTL_MX ? lw - 1 - c : c;
+			y = m->madctl & ILI9341_MADCTL_MY ? lh - 1 - p : p;
+			if (mv) {
+				uint32_t t = x;
+
+				x = y;
+				y = t;
+			}
+			memcpy(m->gram + (y * BENCH_HOR_RES + x) * m->px_size,
+			       param + i, m->px_size);
+			if (++c > m->col[1]) {
+				c = m->col[0];
+				if (++p > m->page[1]) {
+					p = m->page[0];
+				}
+			}
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+static void mock_flush_cb(lv_display_t *disp, const lv_area_t *area,
+			  uint8_t *px_map)
+{
+	struct mock_panel *m = lv_display_get_user_data(disp);
+	uint32_t stride = lv_draw_buf_width_to_stride(lv_area_get_width(area),
+				lv_display_get_color_format(disp));
+
+	ili9341_write(&m->lcd, area, px_map, stride);
+	lv_display_flush_ready(disp);
+}
+
+static lv_display_t *mock_display_create(struct mock_panel *m,
+					 lv_display_rotation_t rot)
+{
+	lv_display_t *disp;
+	lv_color_format_t cf;
+	uint32_t buf_size;
+
+	memset(m, 0, sizeof(*m));
+	m->px_size = lv_color_format_get_size(LV_COLOR_FORMAT_NATIVE);
+	m->gram = calloc(BENCH_HOR_RES * BENCH_VER_RES, m->px_size);
+	if (!m->gram) {
+		return NULL;
+	}
+	ili9341_init(&m->lcd, BENCH_HOR_RES, BENCH_VER_RES, m->px_size,
+		     mock_send, m);
+	ili9341_set_rotation(&m->lcd, rot);
+
+	// LVGL draws in the panel's rotated geometry and rotates nothing
+	disp = lv_display_create(m->lcd.hor_res, m->lcd.ver_res);
+	if (!disp) {
+		free(m->gram);
+		return NULL;
+	}
+	cf = lv_display_get_color_format(disp);
+	buf_size = lv_draw_buf_width_to_stride(m->lcd.hor_res, cf) * 40;
+	m->buf = aligned_alloc(64, buf_size);
+	if (!m->buf) {
+		lv_display_delete(disp);
+		free(m->gram);
+		return NULL;
+	}
+	lv_display_set_user_data(disp, m);
+	lv_display_set_flush_cb(disp, mock_flush_cb);
+	lv_display_set_buffers(disp, m->buf, NULL, buf_size,
+			       LV_DISPLAY_RENDER_MODE_PARTIAL);
+	lv_display_set_default(disp);
+
+	return disp;
+}
+
+static void mock_display_delete(lv_display_t *disp)
+{
+	struct mock_panel *m = lv_display_get_user_data(disp);
+
+	lv_display_delete(disp);
+	free(m->buf);
+	free(m->gram);
+}
+
+static void bench_screen(lv_obj_t *scr)
+{
+	lv_obj_t *obj;
+	int i;
+
+	lv_obj_set_style_bg_color(scr, lv_palette_main(LV_PALETTE_BLUE), 0);
+	lv_obj_set_style_bg_grad_color(scr, lv_palette_main(LV_PALETTE_RED),
+				       0);
+	lv_obj_set_style_bg_grad_dir(scr, LV_GRAD_DIR_HOR, 0);
+	for (i = 0; i < 4; i++) {
+		obj = lv_button_create(scr);
+		lv_obj_set_size(obj, 90, 40);
+		lv_obj_set_pos(obj, 10 + i % 2 * 110, 10 + i / 2 * 60);
+		obj = lv_label_create(obj);
+		lv_label_set_text_fmt(obj, "Button %d", i);
+		lv_obj_center(obj);
+	}
+	obj = lv_label_create(scr);
+	lv_label_set_text(obj, "Light and Versatile Graphics Library");
+	lv_obj_align(obj, LV_ALIGN_BOTTOM_MID, 0, -10);
+}
+
+/* The panel image is stored into ref, or with check compared against it */
+static int bench_pass(lv_display_rotation_t rot, enum bench_path path,
+		      uint8_t *ref, bool check, bool *match)
+{
+	struct mock_panel mock;
+	struct rotate_stats st0 = { 0 };
+	struct rotate_stats st = { 0 };
+	struct bench_frames f;
+	lv_display_t *disp;
+	const uint8_t *fb;
+	char label[32];
+	uint32_t px_size;
+	uint32_t i;
+
+	if (path == BENCH_MADCTL) {
+		disp = mock_display_create(&mock, rot);
+	} else {
+		disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+		if (disp) {
+			lv_display_set_rotation(disp, rot);
+			rotate_soft_init(disp, path == BENCH_BLOCKED);
+		}
+	}
+	if (!disp) {
+		return -1;
+	}
+	bench_screen(lv_display_get_screen_active(disp));
+	lv_refr_now(disp);
+	rotate_get_stats(&st0);
+
+	bench_frames_attach(disp, &f);
+	bench_frames_reset(&f);
+	for (i = 0; i < ROTATE_BENCH_FRAMES; i++) {
+		lv_obj_invalidate(lv_display_get_screen_active(disp));
+		lv_refr_now(disp);
+	}
+	bench_frames_detach(disp, &f);
+
+	px_size = lv_color_format_get_size(lv_display_get_color_format(disp));
+	if (path == BENCH_MADCTL) {
+		fb = mock.gram;
+	} else {
+		rotate_get_stats(&st);
+		st.px -= st0.px;
+		st.us -= st0.us;
+		rotate_soft_deinit();
+		fb = bench_display_framebuffer(disp, NULL);
+	}
+	if (check) {
+		*match = !memcmp(ref, fb, BENCH_HOR_RES * BENCH_VER_RES *
+				 px_size);
+	} else {
+		memcpy(ref, fb, BENCH_HOR_RES * BENCH_VER_RES * px_size);
+		*match = true;
+	}
+
+	snprintf(label, sizeof(label), "%3u deg, %s", rot * 90,
+		 rot == LV_DISPLAY_ROTATION_0 ? "none" : bench_paths[path]);
+	bench_frames_print(label, &f);
+	if (st.px) {
+		printf("  rotate %.3f ms/frame, %.1f Mpx/s, %s\n",
+		       st.us / 1000.0 / ROTATE_BENCH_FRAMES,
+		       st.us ? (double)st.px / st.us : 0.0,
+		       *match ? "matches" : "DIFFERS");
+	} else if (rot != LV_DISPLAY_ROTATION_0) {
+		printf("  rotate 0.000 ms/frame (panel), %s\n",
+		       *match ? "matches" : "DIFFERS");
+	}
+
+	if (path == BENCH_MADCTL) {
+		mock_display_delete(disp);
+	} else {
+		bench_display_delete(disp);
+	}
+
+	return 0;
+}
+
+int rotate_bench(void)
+{
+	lv_display_rotation_t rot;
+	enum bench_path path;
+	bool ok = true;
+	bool match;
+	uint8_t *ref;
+
+	ref = malloc(BENCH_HOR_RES * BENCH_VER_RES * 4);
+	if (!ref) {
+		return -1;
+	}
+
+	if (bench_pass(LV_DISPLAY_ROTATION_0, BENCH_BLOCKED, ref, false,
+		       &match)) {
+		free(ref);
+		return -1;
+	}
+	for (rot = LV_DISPLAY_ROTATION_90; rot <= LV_DISPLAY_ROTATION_270;
+	     rot++) {
+		// lv_draw_sw_rotate() output is the reference of each angle
+		for (path = BENCH_LVGL; path <= BENCH_MADCTL; path++) {
+			if (bench_pass(rot, path, ref, path != BENCH_LVGL,
+				       &match)) {
+				free(ref);
+				return -1;
+			}
+			ok &= match;
+		}
+	}
+	free(ref);
+
+	return ok ? 0 : -1;
+}
@@ -0,0 +1,52 @@
+/*
+ * Display rotation offload and a blocked pixel rotation kernel
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef ROTATE_H
+#define ROTATE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+struct rotate_stats {
+	uint64_t areas;
+	uint64_t px;
+	uint64_t us;		// spent rotating pixels
+};
+
+/*
+ * Copy a w x h block of px_size byte pixels from src into dst rotated
+ * clockwise by rot, the way lv_display_rotate_area() moves its area.
+ */
+void rotate_blocked(const uint8_t *src, uint32_t src_stride, uint8_t *dst,
+		    uint32_t dst_stride, int32_t w, int32_t h,
+		    lv_display_rotation_t rot, uint32_t px_size);
+
+/*
+ * Rotate in the flush of a partial mode display whose flush_cb only knows
+ * the unrotated panel, with rotate_blocked() or, without blocked, with
+ * lv_draw_sw_rotate(). The rotation is the one set on disp.
+ */
+int rotate_soft_init(lv_display_t *disp, bool blocked);
+void rotate_soft_deinit(void);
+void rotate_get_stats(struct rotate_stats *stats);
+
+/*
+ * Rotate the primary plane of the DRM device this process is master of, so
+ * scanout does it. Returns -ENOTSUP when the plane has no such rotation.
+ */
+int rotate_drm_plane(lv_display_rotation_t rot);
+/* Rotate the points of indev along with an offloaded display rotation */
+int rotate_indev_init(lv_indev_t *indev, lv_display_rotation_t rot);
+void rotate_indev_deinit(void);
+
+int rotate_bench(void);
+
+#endif /* ROTATE_H */
@@ -0,0 +1,395 @@
+/*
+ * Real-time scheduling, memory locking and wake-up jitter measurement
+ *
+ * rt_init() runs before lv_init(): it locks current and future memory and
+ * starts tagging threads. Every pthread_create() passes lvctx's link time
+ * wrapper, and the threads that lv_init() starts on the rt_init() thread are
+ * LVGL's draw units; threads other modules start later are not. rt_setup()
+ * runs once the display exists: the tagged threads get the draw
+ * priority/affinity, the calling thread gets the UI settings, and the LVGL
+ * heap, the display's draw buffers and the stack are touched so no page
+ * faults remain for the first frames. Buffers allocated later outside the
+ * LVGL heap (layerpool, drawbuf, asyncimg) fault on first use unless
+ * rt_mlock is set. Priorities of 0 leave a thread in SCHED_OTHER, CPU masks
+ * of 0 leave its affinity alone.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <linux/input.h>
+#include <sys/mman.h>
+
+#include "lvgl/src/display/lv_display_private.h"
+
+#include "bench.h"
+#include "lvctx.h"
+#include "rt.h"
+#include "tune.h"
+
+#define RT_MAX_DRAW 16
+#define RT_PREFAULT_BLOCKS 32
+#define RT_STACK_PREFAULT (256 * 1024)
+
+static struct {
+	pthread_t ui;
+	pthread_t draw[RT_MAX_DRAW];
+	int count;
+} rt;
+
+/* Called on the creating thread for every successful pthread_create() */
+static void tag_thread(pthread_t thread)
+{
+	if (!lv_is_initialized() && pthread_equal(pthread_self(), rt.ui) &&
+	    rt.count < RT_MAX_DRAW) {
+		rt.draw[rt.count++] = thread;
+	}
+}
+
+static void set_thread(pthread_t thread, const char *what, uint32_t prio,
+		       uint32_t cpus)
+{
+	struct sched_param param = { .sched_priority = prio };
+	cpu_set_t set;
+	int cpu;
+	int ret;
+
+	if (prio) {
+		ret = pthread_setschedparam(thread, SCHED_FIFO, &param);
+		if (ret) {
+			fprintf(stderr, "rt: %s thread: SCHED_FIFO %u: %s\n",
+				what, prio, strerror(ret));
+		}
+	}
+	if (cpus) {
+		CPU_ZERO(&set);
+		for (cpu = 0; cpu < 32; cpu++) {
+			if (cpus & (1U << cpu)) {
+				CPU_SET(cpu, &set);
+			}
+		}
+		ret = pthread_setaffinity_np(thread, sizeof(set), &set);
+		if (ret) {
+			fprintf(stderr, "rt: %s thread: cpus 0x%x: %s\n",
+				what, cpus, strerror(ret));
+		}
+	}
+}
+
+/*
+ * Touch the whole LVGL heap once by allocating its free blocks, largest
+ * first, until none is left. The builtin allocator carves everything out of
+ * one pool, so this maps every page that later draw and layer buffers taken
+ * from the heap will use.
+ */
+static void prefault_heap(void)
+{
+	void *blocks[RT_PREFAULT_BLOCKS];
+	lv_mem_monitor_t mon;
+	int n;
+
+	for (n = 0; n < RT_PREFAULT_BLOCKS; n++) {
+		lv_mem_monitor(&mon);
+		if (!mon.free_biggest_size) {
+			break;
+		}
+		blocks[n] = lv_malloc(mon.free_biggest_size);
+		if (!blocks[n]) {
+			break;
+		}
+		memset(blocks[n], 0, mon.free_biggest_size);
+	}
+	while (n--) {
+		lv_free(blocks[n]);
+	}
+}
+
+/*
+ * The display's draw buffers may be mmap()ed DRM dumb buffers, which fault
+ * page by page on first write; rewrite one byte per page to keep the image.
+ */
+static void prefault_buf(lv_draw_buf_t *buf)
+{
+	volatile uint8_t *p;
+	size_t i;
+
+	if (!buf || !buf->data) {
+		return;
+	}
+	p = buf->data;
+	for (i = 0; i < buf->data_size; i += 4096) {
+		p[i] = p[i];
+	}
+}
+
+/*
+ * Threads started after rt_setup() inherit the UI thread's policy and CPUs.
+ * Background work (decoding, mirroring, capture) calls this first to drop
+ * back to SCHED_OTHER on the CPUs the UI and draw threads do not claim, or
+ * on all of them when those claim every CPU.
+ */
+void rt_background(void)
+{
+	struct sched_param param = { .sched_priority = 0 };
+	uint32_t claimed = tune.rt_ui_cpus | tune.rt_draw_cpus;
+	long online = sysconf(_SC_NPROCESSORS_ONLN);
+	cpu_set_t set;
+	int cpu;
+
+	pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+	if (!claimed) {
+		return;
+	}
+	CPU_ZERO(&set);
+	for (cpu = 0; cpu < online && cpu < CPU_SETSIZE; cpu++) {
+		if (cpu >= 32 || !(claimed & (1U << cpu))) {
+			CPU_SET(cpu, &set);
+		}
+	}
+	if (!CPU_COUNT(&set)) {
+		for (cpu = 0; cpu < online && cpu < CPU_SETSIZE; cpu++) {
+			CPU_SET(cpu, &set);
+		}
+	}
+	pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+static void prefault_stack(void)
+{
+	volatile uint8_t stack[RT_STACK_PREFAULT];
+	size_t i;
+
+	for (i = 0; i < sizeof(stack); i += 4096) {
+		stack[i] = 0;
+	}
+}
+
+int rt_init(void)
+{
+	rt.ui = pthread_self();
+	rt.count = 0;
+	lvctx_set_thread_cb(tag_thread);
+
+	if (tune.rt_mlock && mlockall(MCL_CURRENT | MCL_FUTURE)) {
+		fprintf(stderr, "rt: mlockall: %s\n", strerror(errno));
+		return -errno;
+	}
+
+	return 0;
+}
+
+void rt_setup(lv_display_t *disp)
+{
+	int i;
+
+	lvctx_set_thread_cb(NULL);
+	for (i = 0; i < rt.count; i++) {
+		set_thread(rt.draw[i], "draw", tune.rt_draw_prio,
+			   tune.rt_draw_cpus);
+	}
+	set_thread(pthread_self(), "ui", tune.rt_ui_prio, tune.rt_ui_cpus);
+
+	if (tune.rt_prefault) {
+		prefault_heap();
+		prefault_buf(disp->buf_1);
+		prefault_buf(disp->buf_2);
+		prefault_stack();
+	}
+}
+
+/*
+ * Optional input thread: instead of polling evdev from the indev read timer,
+ * sleep on the device and read the indev as soon as the kernel has events.
+ * A second descriptor is used for waiting only, since the evdev driver owns
+ * its own; pending events are drained so poll() does not spin. While the
+ * pointer is held the thread also wakes at the read period so that long
+ * press and repeat timing keep working without new events.
+ */
+struct rt_input {
+	lv_indev_t *indev;
+	int fd;
+};
+
+static void *input_thread(void *arg)
+{
+	struct rt_input *in = arg;
+	struct input_event ev[16];
+	struct pollfd pfd = { .fd = in->fd, .events = POLLIN };
+	int timeout;
+
+	set_thread(pthread_self(), "input", tune.rt_input_prio,
+		   tune.rt_input_cpus);
+
+	while (1) {
+		lv_lock();
+		timeout = lv_indev_get_state(in->indev) == LV_INDEV_STATE_PRESSED
+			  ? (int)tune.indev_period : -1;
+		lv_unlock();
+
+		if (poll(&pfd, 1, timeout) < 0 && errno != EINTR) {
+			break;
+		}
+		while (read(in->fd, ev, sizeof(ev)) > 0) {
+			;
+		}
+
+		lv_lock();
+		lv_indev_read(in->indev);
+		lv_unlock();
+	}
+
+	return NULL;
+}
+
+int rt_input_start(lv_indev_t *indev, const char *path)
+{
+	static struct rt_input in;
+	pthread_t thread;
+	int ret;
+
+	in.indev = indev;
+	in.fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+	if (in.fd < 0) {
+		fprintf(stderr, "rt: %s: %s\n", path, strerror(errno));
+		return -errno;
+	}
+
+	lv_indev_set_mode(indev, LV_INDEV_MODE_EVENT);
+	ret = pthread_create(&thread, NULL, input_thread, &in);
+	if (ret) {
+		lv_indev_set_mode(indev, LV_INDEV_MODE_TIMER);
+		close(in.fd);
+		return -ret;
+	}
+	pthread_detach(thread);
+
+	return 0;
+}
+
+/*
+ * Wake-up jitter: an LVGL timer records how late it runs compared to its
+ * previous run plus its period. That covers the main loop sleep, timer
+ * handler granularity and scheduling delay together.
+ */
+static const uint32_t jitter_bounds[] = {
+	50, 100, 250, 500, 1000, 2000, 5000, 10000, UINT32_MAX,
+};
+
+#define JITTER_BUCKETS (sizeof(jitter_bounds) / sizeof(jitter_bounds[0]))
+
+static struct {
+	lv_timer_t *timer;
+	uint32_t period_us;
+	uint64_t last_us;
+	uint32_t count;
+	uint32_t max_us;
+	uint64_t total_us;
+	uint32_t buckets[JITTER_BUCKETS];
+} jitter;
+
+static void jitter_cb(lv_timer_t *timer)
+{
+	uint64_t now = bench_now_us();
+	uint64_t due = jitter.last_us + jitter.period_us;
+	uint32_t late;
+	size_t i;
+
+	LV_UNUSED(timer);
+
+	if (jitter.last_us) {
+		late = now > due ? now - due : 0;
+		for (i = 0; late >= jitter_bounds[i]; i++) {
+			;
+		}
+		jitter.buckets[i]++;
+		jitter.count++;
+		jitter.total_us += late;
+		if (late > jitter.max_us) {
+			jitter.max_us = late;
+		}
+	}
+	jitter.last_us = now;
+}
+
+void rt_jitter_start(uint32_t period_ms)
+{
+	memset(&jitter, 0, sizeof(jitter));
+	jitter.period_us = period_ms * 1000;
+	jitter.timer = lv_timer_create(jitter_cb, period_ms, NULL);
+}
+
+void rt_jitter_report(void)
+{
+	uint32_t sum = 0;
+	size_t i;
+
+	if (!jitter.count) {
+		return;
+	}
+
+	printf("jitter: %u wake-ups, period %u us, avg %.1f us, max %u us\n",
+	       jitter.count, jitter.period_us,
+	       (double)jitter.total_us / jitter.count, jitter.max_us);
+	for (i = 0; i < JITTER_BUCKETS; i++) {
+		sum += jitter.buckets[i];
+		if (jitter_bounds[i] == UINT32_MAX) {
+			printf("  >= %5u us %8u  %6.2f%%\n", jitter_bounds[i - 1],
+			       jitter.buckets[i], 100.0 * sum / jitter.count);
+		} else {
+			printf("  <  %5u us %8u  %6.2f%%\n", jitter_bounds[i],
+			       jitter.buckets[i], 100.0 * sum / jitter.count);
+		}
+	}
+	fflush(stdout);
+}
+
+/*
+ * Headless jitter run: the main loop pattern with a spinner animating and
+ * the jitter timer at 5 ms, using whatever rt_* settings the profile has
+ * (main() has already called rt_init() before lv_init()).
+ */
+#define RT_BENCH_SECONDS 5
+
+int rt_bench(void)
+{
+	lv_display_t *disp;
+	lv_obj_t *spinner;
+	uint64_t end;
+	uint32_t idle;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	rt_setup(disp);
+
+	spinner = lv_spinner_create(lv_display_get_screen_active(disp));
+	lv_obj_set_size(spinner, 100, 100);
+	lv_obj_center(spinner);
+
+	rt_jitter_start(5);
+	end = bench_now_us() + RT_BENCH_SECONDS * 1000000ULL;
+	while (bench_now_us() < end) {
+		idle = lv_timer_handler();
+		lv_delay_ms(LV_MIN(idle, tune.loop_period));
+	}
+	rt_jitter_report();
+
+	lv_timer_delete(jitter.timer);
+	bench_display_delete(disp);
+
+	return 0;
+}
@@ -0,0 +1,27 @@
+/*
+ * Real-time scheduling, memory locking and wake-up jitter measurement
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef RT_H
+#define RT_H
+
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+int rt_init(void);
+void rt_setup(lv_display_t *disp);
+void rt_background(void);
+int rt_input_start(lv_indev_t *indev, const char *path);
+
+void rt_jitter_start(uint32_t period_ms);
+void rt_jitter_report(void);
+
+int rt_bench(void);
+
+#endif /* RT_H */
@@ -0,0 +1,722 @@
+/*
+ * Shared memory publish channel for external producer processes
+ *
+ * The UI process owns a memfd holding a fixed table of named values and an
+ * eventfd. Producers connect once to a unix socket, receive both fds
+ * (SCM_RIGHTS), and from then on publish without system calls: each entry
+ * is a seqlock (odd sequence while written) and a publish sets the entry's
+ * bit in a dirty bitmap. Only when the UI main loop is asleep in
+ * shmpub_wait() does a producer also write the eventfd to wake it early.
+ *
+ * shmpub_update() runs once per main loop cycle, reads only the entries
+ * whose bit is set and hands them to the lv_subject bound to their name,
+ * so widgets follow through the usual lv_*_bind_*() observers. Entries are
+ * created by name on first use; a name is expected to have one producer.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <poll.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "bench.h"
+#include "shmpub.h"
+
+#define SHMPUB_MAGIC	0x53485042	// "SHPB"
+#define SHMPUB_VERSION	1
+#define SHMPUB_WORDS	(SHMPUB_ENTRIES / 64)
+#define SHMPUB_READ_TRIES 16
+
+enum entry_state {
+	ENTRY_FREE,
+	ENTRY_CLAIMED,
+	ENTRY_READY,
+};
+
+struct shmpub_entry {
+	alignas(64) atomic_uint seq;
+	atomic_uint state;
+	uint32_t type;
+	char name[SHMPUB_NAME_MAX];
+	uint64_t stamp_ns;		// CLOCK_MONOTONIC at publish
+	union {
+		int64_t i;
+		char s[SHMPUB_STR_MAX];
+	} v;
+};
+
+struct shmpub_table {
+	uint32_t magic;
+	uint32_t version;
+	atomic_uint waiting;		// UI is (about to be) in poll()
+	atomic_uint_fast64_t published;
+	atomic_uint_fast64_t dirty[SHMPUB_WORDS];
+	struct shmpub_entry entry[SHMPUB_ENTRIES];
+};
+
+struct bind {
+	char name[SHMPUB_NAME_MAX];
+	lv_subject_t *subject;
+};
+
+static struct {
+	struct shmpub_table *tbl;
+	int memfd;
+	int efd;
+	int lfd;
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+	struct bind binds[SHMPUB_ENTRIES];
+	int nbinds;
+	lv_subject_t *bound[SHMPUB_ENTRIES];
+	struct shmpub_stats stats;
+} srv = { .memfd = -1, .efd = -1, .lfd = -1 };
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int unix_addr(struct sockaddr_un *sa, const char *path)
+{
+	memset(sa, 0, sizeof(*sa));
+	sa->sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(sa->sun_path)) {
+		return -ENAMETOOLONG;
+	}
+	strcpy(sa->sun_path, path);
+
+	return 0;
+}
+
+int shmpub_server_start(const char *path)
+{
+	struct sockaddr_un sa;
+
+	if (unix_addr(&sa, path)) {
+		fprintf(stderr, "shmpub: %s: socket path too long\n", path);
+		return -1;
+	}
+
+	srv.memfd = memfd_create("shmpub", MFD_CLOEXEC);
+	if (srv.memfd < 0 ||
+	    ftruncate(srv.memfd, sizeof(struct shmpub_table))) {
+		goto fail;
+	}
+	srv.tbl = mmap(NULL, sizeof(struct shmpub_table),
+		       PROT_READ | PROT_WRITE, MAP_SHARED, srv.memfd, 0);
+	if (srv.tbl == MAP_FAILED) {
+		srv.tbl = NULL;
+		goto fail;
+	}
+	srv.tbl->magic = SHMPUB_MAGIC;
+	srv.tbl->version = SHMPUB_VERSION;
+
+	srv.efd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (srv.efd < 0) {
+		goto fail;
+	}
+
+	srv.lfd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC |
+			 SOCK_NONBLOCK, 0);
+	if (srv.lfd < 0) {
+		goto fail;
+	}
+	unlink(path);
+	if (bind(srv.lfd, (struct sockaddr *)&sa, sizeof(sa)) ||
+	    listen(srv.lfd, 4)) {
+		goto fail;
+	}
+	strcpy(srv.path, path);
+
+	return 0;
+
+fail:
+	fprintf(stderr, "shmpub: %s: %s\n", path, strerror(errno));
+	shmpub_server_stop();
+
+	return -1;
+}
+
+void shmpub_server_stop(void)
+{
+	if (srv.lfd >= 0) {
+		close(srv.lfd);
+		if (srv.path[0]) {
+			unlink(srv.path);
+		}
+	}
+	if (srv.efd >= 0) {
+		close(srv.efd);
+	}
+	if (srv.tbl) {
+		munmap(srv.tbl, sizeof(*srv.tbl));
+	}
+	if (srv.memfd >= 0) {
+		close(srv.memfd);
+	}
+	memset(&srv, 0, sizeof(srv));
+	srv.memfd = srv.efd = srv.lfd = -1;
+}
+
+/* Bind before producers create the name, or any time after */
+int shmpub_bind_subject(const char *name, lv_subject_t *subject)
+{
+	int i;
+
+	if (srv.nbinds == SHMPUB_ENTRIES ||
+	    strlen(name) >= SHMPUB_NAME_MAX ||
+	    (subject->type != LV_SUBJECT_TYPE_INT &&
+	     subject->type != LV_SUBJECT_TYPE_STRING)) {
+		return -1;
+	}
+	strcpy(srv.binds[srv.nbinds].name, name);
+	srv.binds[srv.nbinds].subject = subject;
+	srv.nbinds++;
+	for (i = 0; i < SHMPUB_ENTRIES; i++) {
+		srv.bound[i] = NULL;
+	}
+
+	return 0;
+}
+
+static void send_fds(int fd)
+{
+	int fds[2] = { srv.memfd, srv.efd };
+	char cbuf[CMSG_SPACE(sizeof(fds))];
+	uint32_t magic = SHMPUB_MAGIC;
+	struct iovec iov = { &magic, sizeof(magic) };
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = cbuf,
+		.msg_controllen = sizeof(cbuf),
+	};
+	struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+	memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+	if (sendmsg(fd, &msg, MSG_NOSIGNAL) == sizeof(magic)) {
+		srv.stats.clients++;
+	}
+}
+
+static void accept_clients(void)
+{
+	int fd;
+
+	while ((fd = accept4(srv.lfd, NULL, NULL, SOCK_CLOEXEC)) >= 0) {
+		send_fds(fd);
+		close(fd);
+	}
+}
+
+static lv_subject_t *subject_of(int id)
+{
+	struct shmpub_entry *e = &srv.tbl->entry[id];
+	int i;
+
+	if (srv.bound[id]) {
+		return srv.bound[id];
+	}
+	for (i = 0; i < srv.nbinds; i++) {
+		if (!strncmp(srv.binds[i].name, e->name, SHMPUB_NAME_MAX)) {
+			srv.bound[id] = srv.binds[i].subject;
+			break;
+		}
+	}
+
+	return srv.bound[id];
+}
+
+/* Seqlock read; false if the writer kept the entry busy */
+static bool read_entry(struct shmpub_entry *e, uint32_t *type, int64_t *i,
+		       char *s, uint64_t *stamp)
+{
+	unsigned int s1;
+	int n;
+
+	for (n = 0; n < SHMPUB_READ_TRIES; n++) {
+		s1 = atomic_load_explicit(&e->seq, memory_order_acquire);
+		if (!(s1 & 1)) {
+			*type = e->type;
+			*stamp = e->stamp_ns;
+			if (*type == SHMPUB_STR) {
+				memcpy(s, e->v.s, SHMPUB_STR_MAX);
+				s[SHMPUB_STR_MAX - 1] = '\0';
+			} else {
+				*i = e->v.i;
+			}
+			atomic_thread_fence(memory_order_acquire);
+			if (atomic_load_explicit(&e->seq,
+						 memory_order_relaxed) == s1) {
+				return true;
+			}
+		}
+		srv.stats.retries++;
+	}
+
+	return false;
+}
+
+static void apply(int id)
+{
+	struct shmpub_entry *e = &srv.tbl->entry[id];
+	lv_subject_t *subject;
+	char s[SHMPUB_STR_MAX];
+	uint64_t stamp;
+	uint64_t lat;
+	uint32_t type;
+	int64_t i = 0;
+
+	if (atomic_load_explicit(&e->state, memory_order_acquire) !=
+	    ENTRY_READY) {
+		return;
+	}
+	if (!read_entry(e, &type, &i, s, &stamp)) {
+		// Try again next cycle
+		atomic_fetch_or(&srv.tbl->dirty[id / 64], 1ULL << (id % 64));
+		return;
+	}
+
+	subject = subject_of(id);
+	if (subject && type == SHMPUB_INT &&
+	    subject->type == LV_SUBJECT_TYPE_INT) {
+		lv_subject_set_int(subject, LV_CLAMP(INT32_MIN, i, INT32_MAX));
+	} else if (subject && type == SHMPUB_STR &&
+		   subject->type == LV_SUBJECT_TYPE_STRING) {
+		lv_subject_copy_string(subject, s);
+	}
+
+	lat = now_ns() - stamp;
+	srv.stats.applied++;
+	srv.stats.latency_total_ns += lat;
+	if (lat > srv.stats.latency_max_ns) {
+		srv.stats.latency_max_ns = lat;
+	}
+}
+
+void shmpub_update(void)
+{
+	uint_fast64_t words[SHMPUB_WORDS];
+	uint_fast64_t bits;
+	bool any = false;
+	int w;
+
+	if (!srv.tbl) {
+		return;
+	}
+	for (w = 0; w < SHMPUB_WORDS; w++) {
+		words[w] = atomic_exchange(&srv.tbl->dirty[w], 0);
+		any |= words[w] != 0;
+	}
+	if (!any) {
+		return;
+	}
+
+	lv_lock();
+	for (w = 0; w < SHMPUB_WORDS; w++) {
+		for (bits = words[w]; bits; bits &= bits - 1) {
+			apply(w * 64 + __builtin_ctzll(bits));
+		}
+	}
+	lv_unlock();
+}
+
+/*
+ * Main loop sleep: like lv_delay_ms(), but returns as soon as a producer
+ * publishes. waiting is raised before the dirty bits are checked and
+ * producers set their bit before checking waiting, so a publish is either
+ * seen here or followed by an eventfd write. Without a server this is
+ * plain lv_delay_ms().
+ */
+void shmpub_wait(uint32_t ms)
+{
+	struct pollfd pfd[2] = {
+		{ .fd = srv.efd, .events = POLLIN },
+		{ .fd = srv.lfd, .events = POLLIN },
+	};
+	uint64_t v;
+	bool dirty = false;
+	int w;
+
+	if (!srv.tbl) {
+		lv_delay_ms(ms);
+		return;
+	}
+
+	atomic_store(&srv.tbl->waiting, 1);
+	for (w = 0; w < SHMPUB_WORDS; w++) {
+		dirty |= atomic_load(&srv.tbl->dirty[w]) != 0;
+	}
+	poll(pfd, 2, dirty ? 0 : (int)ms);
+	atomic_store(&srv.tbl->waiting, 0);
+
+	if (pfd[0].revents & POLLIN && read(srv.efd, &v, sizeof(v)) > 0) {
+		srv.stats.wakeups++;
+	}
+	if (pfd[1].revents & POLLIN) {
+		accept_clients();
+	}
+}
+
+void shmpub_get_stats(struct shmpub_stats *stats)
+{
+	*stats = srv.stats;
+	if (srv.tbl) {
+		stats->published = atomic_load_explicit(&srv.tbl->published,
+							memory_order_relaxed);
+	}
+}
+
+void shmpub_reset_stats(void)
+{
+	memset(&srv.stats, 0, sizeof(srv.stats));
+	if (srv.tbl) {
+		atomic_store(&srv.tbl->published, 0);
+	}
+}
+
+int shmpub_connect(struct shmpub_client *c, const char *path)
+{
+	int fds[2];
+	char cbuf[CMSG_SPACE(sizeof(fds))];
+	uint32_t magic = 0;
+	struct iovec iov = { &magic, sizeof(magic) };
+	struct msghdr msg = {
+		.msg_iov = &iov,
+		.msg_iovlen = 1,
+		.msg_control = cbuf,
+		.msg_controllen = sizeof(cbuf),
+	};
+	struct sockaddr_un sa;
+	struct cmsghdr *cmsg;
+	void *tbl;
+	int fd;
+
+	c->tbl = NULL;
+	c->efd = -1;
+	if (unix_addr(&sa, path)) {
+		return -1;
+	}
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0) {
+		return -1;
+	}
+	if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) ||
+	    recvmsg(fd, &msg, MSG_CMSG_CLOEXEC) != sizeof(magic) ||
+	    magic != SHMPUB_MAGIC) {
+		close(fd);
+		return -1;
+	}
+	close(fd);
+
+	cmsg = CMSG_FIRSTHDR(&msg);
+	if (!cmsg || cmsg->cmsg_type != SCM_RIGHTS ||
+	    cmsg->cmsg_len != CMSG_LEN(sizeof(fds))) {
+		return -1;
+	}
+	memcpy(fds, CMSG_DATA(cmsg), sizeof(fds));
+
+	tbl = mmap(NULL, sizeof(struct shmpub_table), PROT_READ | PROT_WRITE,
+		   MAP_SHARED, fds[0], 0);
+	close(fds[0]);
+	if (tbl == MAP_FAILED) {
+		close(fds[1]);
+		return -1;
+	}
+	c->tbl = tbl;
+	c->efd = fds[1];
+
+	return 0;
+}
+
+void shmpub_disconnect(struct shmpub_client *c)
+{
+	if (c->tbl) {
+		munmap(c->tbl, sizeof(*c->tbl));
+		close(c->efd);
+	}
+	c->tbl = NULL;
+	c->efd = -1;
+}
+
+/* Entry id of name, created on first use; -1 if the table is full */
+int shmpub_lookup(struct shmpub_client *c, const char *name,
+		  enum shmpub_type type)
+{
+	struct shmpub_entry *e;
+	unsigned int state;
+	int i;
+
+	if (strlen(name) >= SHMPUB_NAME_MAX) {
+		return -1;
+	}
+	for (i = 0; i < SHMPUB_ENTRIES; i++) {
+		e = &c->tbl->entry[i];
+		if (atomic_load(&e->state) == ENTRY_READY &&
+		    !strncmp(e->name, name, SHMPUB_NAME_MAX)) {
+			return e->type == type ? i : -1;
+		}
+	}
+	for (i = 0; i < SHMPUB_ENTRIES; i++) {
+		e = &c->tbl->entry[i];
+		state = ENTRY_FREE;
+		if (atomic_compare_exchange_strong(&e->state, &state,
+						   ENTRY_CLAIMED)) {
+			e->type = type;
+			strcpy(e->name, name);
+			atomic_store(&e->state, ENTRY_READY);
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+static struct shmpub_entry *write_begin(struct shmpub_client *c, int id)
+{
+	struct shmpub_entry *e = &c->tbl->entry[id];
+	unsigned int seq = atomic_load_explicit(&e->seq, memory_order_relaxed);
+
+	atomic_store_explicit(&e->seq, seq + 1, memory_order_relaxed);
+	atomic_thread_fence(memory_order_release);
+	e->stamp_ns = now_ns();
+
+	return e;
+}
+
+static void write_end(struct shmpub_client *c, int id,
+		      struct shmpub_entry *e)
+{
+	unsigned int seq = atomic_load_explicit(&e->seq, memory_order_relaxed);
+
+	atomic_store_explicit(&e->seq, seq + 1, memory_order_release);
+	atomic_fetch_add_explicit(&c->tbl->published, 1, memory_order_relaxed);
+
+	atomic_fetch_or(&c->tbl->dirty[id / 64], 1ULL << (id % 64));
+	if (atomic_load(&c->tbl->waiting) &&
+	    atomic_exchange(&c->tbl->waiting, 0)) {
+		uint64_t one = 1;
+
+		if (write(c->efd, &one, sizeof(one)) < 0) {
+			// Counter saturated: the UI is awake anyway
+		}
+	}
+}
+
+void shmpub_publish_int(struct shmpub_client *c, int id, int64_t value)
+{
+	struct shmpub_entry *e;
+
+	// -1 from shmpub_lookup() would land on the table header
+	if ((unsigned int)id >= SHMPUB_ENTRIES) {
+		return;
+	}
+	e = write_begin(c, id);
+	e->v.i = value;
+	write_end(c, id, e);
+}
+
+void shmpub_publish_str(struct shmpub_client *c, int id, const char *value)
+{
+	struct shmpub_entry *e;
+
+	if ((unsigned int)id >= SHMPUB_ENTRIES) {
+		return;
+	}
+	e = write_begin(c, id);
+	snprintf(e->v.s, SHMPUB_STR_MAX, "%s", value);
+	write_end(c, id, e);
+}
+
+/*
+ * Producer stand-in for bring-up (-p) and the benchmark: a triangle wave on
+ * "slider", a counter on "message" and eight integers "v0".."v7".
+ */
+#define SHMPUB_DEMO_INTS 8
+
+int shmpub_producer(const char *path, uint32_t rate, uint32_t seconds)
+{
+	struct shmpub_client c;
+	struct timespec next;
+	int ids[SHMPUB_DEMO_INTS];
+	int slider;
+	int message;
+	char name[SHMPUB_NAME_MAX];
+	char text[SHMPUB_STR_MAX];
+	uint64_t end = now_ns() + seconds * 1000000000ULL;
+	uint64_t n;
+	int i;
+
+	if (shmpub_connect(&c, path)) {
+		fprintf(stderr, "shmpub: %s: cannot connect\n", path);
+		return -1;
+	}
+	slider = shmpub_lookup(&c, "slider", SHMPUB_INT);
+	message = shmpub_lookup(&c, "message", SHMPUB_STR);
+	for (i = 0; i < SHMPUB_DEMO_INTS; i++) {
+		snprintf(name, sizeof(name), "v%d", i);
+		ids[i] = shmpub_lookup(&c, name, SHMPUB_INT);
+	}
+	if (slider < 0 || message < 0 || ids[SHMPUB_DEMO_INTS - 1] < 0) {
+		shmpub_disconnect(&c);
+		return -1;
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for (n = 0; !seconds || now_ns() < end; n++) {
+		shmpub_publish_int(&c, ids[n % SHMPUB_DEMO_INTS], n);
+		if (!(n % 100)) {
+			shmpub_publish_int(&c, slider, n / 100 % 200 < 100 ?
+					   n / 100 % 100 : 100 - n / 100 % 100);
+			snprintf(text, sizeof(text), "sample %llu",
+				 (unsigned long long)n);
+			shmpub_publish_str(&c, message, text);
+		}
+		if (!rate) {
+			continue;
+		}
+		next.tv_nsec += 1000000000 / rate;
+		if (next.tv_nsec >= 1000000000) {
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+	}
+	shmpub_disconnect(&c);
+
+	return 0;
+}
+
+/*
+ * Benchmark: a forked producer process publishes into a UI on a headless
+ * display with every value bound to a label, first flat out for one
+ * second, then paced at 1 kHz. Reported are producer publishes per second,
+ * entries applied by the UI, and the latency from publish to
+ * lv_subject_set_*().
+ */
+#define SHMPUB_BENCH_SOCKET "/tmp/shmpub-bench.sock"
+
+static int bench_run_producer(lv_display_t *disp, const char *label,
+			      uint32_t rate, uint32_t seconds)
+{
+	struct shmpub_stats stats;
+	struct bench_frames frames;
+	uint64_t t0;
+	uint64_t us;
+	uint32_t idle;
+	int status;
+	pid_t pid;
+
+	shmpub_reset_stats();
+	bench_frames_reset(&frames);
+	bench_frames_attach(disp, &frames);
+
+	t0 = bench_now_us();
+	pid = fork();
+	if (pid < 0) {
+		return -1;
+	}
+	if (!pid) {
+		// The producer side does not touch LVGL or its threads
+		_exit(shmpub_producer(SHMPUB_BENCH_SOCKET, rate, seconds) ?
+		      EXIT_FAILURE : EXIT_SUCCESS);
+	}
+	while (waitpid(pid, &status, WNOHANG) == 0) {
+		shmpub_update();
+		idle = lv_timer_handler();
+		shmpub_wait(LV_MIN(idle, 5));
+	}
+	shmpub_update();
+	us = bench_now_us() - t0;
+	bench_frames_detach(disp, &frames);
+
+	shmpub_get_stats(&stats);
+	printf("%s\n", label);
+	printf("  published %.0f/s  applied %.0f/s  retries %llu  wakeups %llu\n",
+	       stats.published * 1e6 / us, stats.applied * 1e6 / us,
+	       (unsigned long long)stats.retries,
+	       (unsigned long long)stats.wakeups);
+	printf("  latency avg %.3f ms  max %.3f ms\n",
+	       stats.applied ?
+	       stats.latency_total_ns / 1e6 / stats.applied : 0.0,
+	       stats.latency_max_ns / 1e6);
+	bench_frames_print("  UI frames", &frames);
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS ?
+	       0 : -1;
+}
+
+int shmpub_bench(void)
+{
+	static lv_subject_t ints[SHMPUB_DEMO_INTS + 1];
+	static lv_subject_t message;
+	static char buf[SHMPUB_STR_MAX];
+	static char prev[SHMPUB_STR_MAX];
+	char name[SHMPUB_NAME_MAX];
+	lv_display_t *disp;
+	lv_obj_t *scr;
+	lv_obj_t *label;
+	int ret;
+	int i;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp || shmpub_server_start(SHMPUB_BENCH_SOCKET)) {
+		return -1;
+	}
+	scr = lv_display_get_screen_active(disp);
+
+	for (i = 0; i <= SHMPUB_DEMO_INTS; i++) {
+		if (i < SHMPUB_DEMO_INTS) {
+			snprintf(name, sizeof(name), "v%d", i);
+		} else {
+			snprintf(name, sizeof(name), "slider");
+		}
+		lv_subject_init_int(&ints[i], 0);
+		shmpub_bind_subject(name, &ints[i]);
+		label = lv_label_create(scr);
+		lv_obj_set_pos(label, (i % 3) * (BENCH_HOR_RES / 3),
+			       (i / 3) * 40);
+		lv_label_bind_text(label, &ints[i], "%d");
+	}
+	lv_subject_init_string(&message, buf, prev, sizeof(buf), "");
+	shmpub_bind_subject("message", &message);
+	label = lv_label_create(scr);
+	lv_obj_align(label, LV_ALIGN_BOTTOM_MID, 0, -10);
+	lv_label_bind_text(label, &message, NULL);
+
+	ret = bench_run_producer(disp, "unpaced producer", 0, 1) ||
+	      bench_run_producer(disp, "1 kHz producer", 1000, 2) ? -1 : 0;
+
+	bench_display_delete(disp);
+	shmpub_server_stop();
+	for (i = 0; i <= SHMPUB_DEMO_INTS; i++) {
+		lv_subject_deinit(&ints[i]);
+	}
+	lv_subject_deinit(&message);
+
+	return ret;
+}
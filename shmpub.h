@@ -0,0 +1,66 @@
+/*
+ * Shared memory publish channel for external producer processes
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef SHMPUB_H
+#define SHMPUB_H
+
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+#define SHMPUB_ENTRIES	128
+#define SHMPUB_NAME_MAX	32
+#define SHMPUB_STR_MAX	64
+
+enum shmpub_type {
+	SHMPUB_INT = 1,
+	SHMPUB_STR,
+};
+
+struct shmpub_table;
+
+struct shmpub_client {
+	struct shmpub_table *tbl;
+	int efd;
+};
+
+struct shmpub_stats {
+	uint64_t published;	// entries written by producers
+	uint64_t applied;	// entries read and handed to subjects
+	uint64_t retries;	// seqlock reads that raced a writer
+	uint64_t wakeups;	// eventfd wake-ups of the main loop
+	uint64_t latency_max_ns;
+	uint64_t latency_total_ns;
+	uint32_t clients;
+};
+
+/* UI side */
+int shmpub_server_start(const char *path);
+void shmpub_server_stop(void);
+int shmpub_bind_subject(const char *name, lv_subject_t *subject);
+void shmpub_update(void);
+void shmpub_wait(uint32_t ms);
+void shmpub_get_stats(struct shmpub_stats *stats);
+void shmpub_reset_stats(void);
+
+/* Producer side, no LVGL needed */
+int shmpub_connect(struct shmpub_client *c, const char *path);
+void shmpub_disconnect(struct shmpub_client *c);
+int shmpub_lookup(struct shmpub_client *c, const char *name,
+		  enum shmpub_type type);
+/* An id shmpub_lookup() did not return, such as -1, is ignored */
+void shmpub_publish_int(struct shmpub_client *c, int id, int64_t value);
+void shmpub_publish_str(struct shmpub_client *c, int id, const char *value);
+
+/* Producer stand-in: rate 0 publishes flat out, seconds 0 runs forever */
+int shmpub_producer(const char *path, uint32_t rate, uint32_t seconds);
+
+int shmpub_bench(void);
+
+#endif /* SHMPUB_H */
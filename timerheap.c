@@ -0,0 +1,650 @@
+/*
+ * Deadline ordered timers
+ *
+ * lv_timer_handler() walks every lv_timer on each call to find the due
+ * ones, and starts over whenever a callback creates or deletes a timer, so
+ * its cost grows with the number of timers even when only one of them is
+ * due. The timers here sit in a binary min-heap keyed by their next
+ * deadline: creating, deleting, pausing or re-timing one is O(log n), the
+ * next deadline is the root, and a pass only touches the timers it runs.
+ * Timers live in the C heap, not in the LVGL heap (LV_MEM_SIZE).
+ *
+ * A single lv_timer, re-armed for the root's deadline whenever the root
+ * changes, runs timerheap_handler(), so main.c's lv_timer_handler() loop
+ * and its idle time keep working unchanged. Period, repeat count, auto
+ * delete, ready and reset behave as for lv_timer; deadlines are kept in
+ * 64 bit ms so tick wrap-around needs no care. A pass runs each due timer
+ * once; LVGL restarts its walk after a callback creates or deletes a timer,
+ * which can run a period 0 timer twice. Where LVGL runs the timers due in
+ * the same pass newest first, here they run earliest deadline first.
+ *
+ * LVGL animations already share one timer, so they are unaffected.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "timerheap.h"
+
+#define TIMERHEAP_NONE	UINT32_MAX	// heap index of a paused timer
+
+struct timerheap_timer {
+	timerheap_cb_t cb;
+	void *user_data;
+	int64_t last_run;
+	uint32_t period;
+	int32_t repeat_count;
+	bool auto_delete;
+	bool paused;
+	uint32_t pass;		// handler pass of the last run
+	uint32_t seq;		// creation order
+	uint32_t index;
+};
+
+static struct {
+	struct timerheap_timer **heap;
+	uint32_t count;
+	uint32_t size;
+	uint32_t seq;
+	uint32_t pass;
+	uint32_t tick;
+	int64_t now;
+	bool running;
+	struct timerheap_timer *current;
+	bool current_deleted;
+	lv_timer_t *pump;
+	int64_t armed;		// deadline the pump is set for
+} th;
+
+static int64_t now_ms(void)
+{
+	uint32_t tick = lv_tick_get();
+
+	th.now += (uint32_t)(tick - th.tick);
+	th.tick = tick;
+
+	return th.now;
+}
+
+static inline int64_t deadline(const struct timerheap_timer *t)
+{
+	return t->last_run + t->period;
+}
+
+/*
+ * Earlier deadline first; on a tie, the one run in the oldest pass (so none
+ * runs twice in a pass while another is due), then the newest, as
+ * lv_timer_create() inserts at the list head. Neither tie-break changes
+ * as passes go by, which keeps the heap valid.
+ */
+static bool before(const struct timerheap_timer *a,
+		   const struct timerheap_timer *b)
+{
+	int64_t da = deadline(a), db = deadline(b);
+
+	if (da != db) {
+		return da < db;
+	}
+	if (a->pass != b->pass) {
+		return (int32_t)(a->pass - b->pass) < 0;
+	}
+
+	return (int32_t)(a->seq - b->seq) > 0;
+}
+
+static void place(struct timerheap_timer *t, uint32_t i)
+{
+	th.heap[i] = t;
+	t->index = i;
+}
+
+static void sift_up(uint32_t i)
+{
+	struct timerheap_timer *t = th.heap[i];
+	uint32_t parent;
+
+	while (i) {
+		parent = (i - 1) / 2;
+		if (!before(t, th.heap[parent])) {
+			break;
+		}
+		place(th.heap[parent], i);
+		i = parent;
+	}
+	place(t, i);
+}
+
+static void sift_down(uint32_t i)
+{
+	struct timerheap_timer *t = th.heap[i];
+	uint32_t child;
+
+	for (;;) {
+		child = 2 * i + 1;
+		if (child >= th.count) {
+			break;
+		}
+		if (child + 1 < th.count &&
+		    before(th.heap[child + 1], th.heap[child])) {
+			child++;
+		}
+		if (!before(th.heap[child], t)) {
+			break;
+		}
+		place(th.heap[child], i);
+		i = child;
+	}
+	place(t, i);
+}
+
+/* Restore the heap after t's deadline changed */
+static void fix(struct timerheap_timer *t)
+{
+	uint32_t i = t->index;
+
+	if (i == TIMERHEAP_NONE) {
+		return;
+	}
+	sift_up(i);
+	if (t->index == i) {
+		sift_down(i);
+	}
+}
+
+static int insert(struct timerheap_timer *t)
+{
+	struct timerheap_timer **heap;
+	uint32_t size;
+
+	if (th.count == th.size) {
+		size = th.size ? 2 * th.size : 64;
+		heap = realloc(th.heap, size * sizeof(*heap));
+		if (!heap) {
+			return -ENOMEM;
+		}
+		th.heap = heap;
+		th.size = size;
+	}
+	place(t, th.count++);
+	sift_up(t->index);
+
+	return 0;
+}
+
+static void remove_at(struct timerheap_timer *t)
+{
+	uint32_t i = t->index;
+	struct timerheap_timer *last;
+
+	if (i == TIMERHEAP_NONE) {
+		return;
+	}
+	t->index = TIMERHEAP_NONE;
+	last = th.heap[--th.count];
+	if (last != t) {
+		place(last, i);
+		fix(last);
+	}
+}
+
+/* Point the pump timer at the root's deadline, if that moved */
+static void arm(void)
+{
+	int64_t due, now;
+
+	if (!th.pump || th.running) {
+		return;
+	}
+	if (!th.count) {
+		if (th.armed != INT64_MAX) {
+			lv_timer_pause(th.pump);
+			th.armed = INT64_MAX;
+		}
+		return;
+	}
+	due = deadline(th.heap[0]);
+	if (due == th.armed) {
+		return;
+	}
+	now = now_ms();
+	th.armed = due;
+	lv_timer_set_period(th.pump, due > now ? due - now : 0);
+	lv_timer_reset(th.pump);
+	lv_timer_resume(th.pump);
+}
+
+static void pump_cb(lv_timer_t *timer)
+{
+	timerheap_handler();
+}
+
+int timerheap_init(void)
+{
+	if (th.pump) {
+		return -EBUSY;
+	}
+	th.tick = lv_tick_get();
+	th.pump = lv_timer_create(pump_cb, LV_NO_TIMER_READY, NULL);
+	if (!th.pump) {
+		return -ENOMEM;
+	}
+	lv_timer_pause(th.pump);
+	th.armed = INT64_MAX;
+	arm();
+
+	return 0;
+}
+
+void timerheap_deinit(void)
+{
+	while (th.count) {
+		timerheap_delete(th.heap[th.count - 1]);
+	}
+	if (th.pump) {
+		lv_timer_delete(th.pump);
+		th.pump = NULL;
+	}
+	free(th.heap);
+	th.heap = NULL;
+	th.size = 0;
+}
+
+struct timerheap_timer *timerheap_create(timerheap_cb_t cb, uint32_t period,
+					 void *user_data)
+{
+	struct timerheap_timer *t = calloc(1, sizeof(*t));
+
+	if (!t) {
+		return NULL;
+	}
+	t->cb = cb;
+	t->user_data = user_data;
+	t->period = period;
+	t->repeat_count = -1;
+	t->auto_delete = true;
+	t->last_run = now_ms();
+	t->pass = th.pass - 1;
+	t->seq = th.seq++;
+	if (insert(t)) {
+		free(t);
+		return NULL;
+	}
+	arm();
+
+	return t;
+}
+
+void timerheap_delete(struct timerheap_timer *timer)
+{
+	remove_at(timer);
+	if (timer == th.current) {
+		th.current_deleted = true;
+	}
+	free(timer);
+	arm();
+}
+
+void timerheap_pause(struct timerheap_timer *timer)
+{
+	timer->paused = true;
+	remove_at(timer);
+	arm();
+}
+
+void timerheap_resume(struct timerheap_timer *timer)
+{
+	if (!timer->paused) {
+		return;
+	}
+	timer->paused = false;
+	// A timer that cannot be put back would never run again
+	if (insert(timer)) {
+		timer->paused = true;
+		return;
+	}
+	arm();
+}
+
+void timerheap_set_period(struct timerheap_timer *timer, uint32_t period)
+{
+	timer->period = period;
+	fix(timer);
+	arm();
+}
+
+void timerheap_set_repeat_count(struct timerheap_timer *timer, int32_t count)
+{
+	timer->repeat_count = count;
+}
+
+void timerheap_set_auto_delete(struct timerheap_timer *timer, bool enable)
+{
+	timer->auto_delete = enable;
+}
+
+void timerheap_ready(struct timerheap_timer *timer)
+{
+	timer->last_run = now_ms() - timer->period - 1;
+	fix(timer);
+	arm();
+}
+
+void timerheap_reset(struct timerheap_timer *timer)
+{
+	timer->last_run = now_ms();
+	fix(timer);
+	arm();
+}
+
+void *timerheap_get_user_data(struct timerheap_timer *timer)
+{
+	return timer->user_data;
+}
+
+uint32_t timerheap_handler(void)
+{
+	struct timerheap_timer *t;
+	int64_t now, due;
+	int32_t count;
+
+	if (th.running) {
+		return 0;
+	}
+	th.running = true;
+	th.pass++;
+	while (th.count) {
+		t = th.heap[0];
+		if (t->pass == th.pass || deadline(t) > now_ms()) {
+			break;
+		}
+		count = t->repeat_count;
+		if (t->repeat_count > 0) {
+			t->repeat_count--;
+		}
+		t->last_run = now_ms();
+		t->pass = th.pass;
+		sift_down(0);
+
+		th.current = t;
+		th.current_deleted = false;
+		if (t->cb && count != 0) {
+			t->cb(t);
+		}
+		if (!th.current_deleted && t->repeat_count == 0) {
+			if (t->auto_delete) {
+				timerheap_delete(t);
+			} else {
+				timerheap_pause(t);
+			}
+		}
+		th.current = NULL;
+	}
+	th.running = false;
+	th.armed = INT64_MIN;	// the pump just fired, re-arm it
+	arm();
+
+	if (!th.count) {
+		return LV_NO_TIMER_READY;
+	}
+	due = deadline(th.heap[0]);
+	now = now_ms();
+
+	return due > now ? due - now : 0;
+}
+
+/*
+ * Benchmark: first the same script of timers (forever, counted, auto delete
+ * off, period 0, paused and resumed, re-timed, made ready, deleting itself
+ * and created from a callback) runs against lv_timer and timerheap on a
+ * stepped tick, and the (tick, timer) runs must match. Then 10, 1,000 and
+ * 10,000 idle timers plus one due every ms: timer creation and the
+ * lv_timer_handler() call of main.c, with lv_timers in the LVGL heap (as
+ * many as fit) and with timerheap.
+ */
+#define TIMERHEAP_SEM_TIMERS	8
+#define TIMERHEAP_SEM_TICKS	200
+#define TIMERHEAP_SEM_LOG	512
+#define TIMERHEAP_COST_CALLS	2000
+#define TIMERHEAP_HEAP_MIN	(8 * 1024)
+
+static uint32_t bench_tick;
+
+static struct {
+	bool heap;
+	void *timers[TIMERHEAP_SEM_TIMERS];
+	uint32_t runs[TIMERHEAP_SEM_TIMERS];
+	uint32_t log[TIMERHEAP_SEM_LOG];
+	uint32_t count;
+} sem;
+
+static uint32_t bench_tick_cb(void)
+{
+	return bench_tick;
+}
+
+static uint32_t real_tick_cb(void)
+{
+	return bench_now_us() / 1000;
+}
+
+static void sem_heap_cb(struct timerheap_timer *timer);
+static void sem_lv_cb(lv_timer_t *timer);
+
+static void sem_create(int id, uint32_t period, int32_t repeat,
+		       bool auto_delete)
+{
+	void *user_data = (void *)(intptr_t)id;
+
+	if (sem.heap) {
+		sem.timers[id] = timerheap_create(sem_heap_cb, period,
+						  user_data);
+		timerheap_set_repeat_count(sem.timers[id], repeat);
+		timerheap_set_auto_delete(sem.timers[id], auto_delete);
+	} else {
+		sem.timers[id] = lv_timer_create(sem_lv_cb, period, user_data);
+		lv_timer_set_repeat_count(sem.timers[id], repeat);
+		lv_timer_set_auto_delete(sem.timers[id], auto_delete);
+	}
+}
+
+#define SEM_OP(op, ...) \
+	(sem.heap ? timerheap_##op(__VA_ARGS__) : lv_timer_##op(__VA_ARGS__))
+
+static void sem_run(int id)
+{
+	uint32_t n = ++sem.runs[id];
+
+	if (sem.count < TIMERHEAP_SEM_LOG) {
+		sem.log[sem.count++] = bench_tick << 8 | id;
+	}
+	if (id == 0 && n == 3) {
+		sem_create(6, 5, 2, true);
+	} else if (id == 1 && n == 2) {
+		SEM_OP(set_period, sem.timers[0], 13);
+	} else if (id == 2 && n == 4) {
+		SEM_OP(ready, sem.timers[0]);
+	} else if (id == 2 && n == 6) {
+		SEM_OP(delete, sem.timers[2]);
+	}
+}
+
+static void sem_heap_cb(struct timerheap_timer *timer)
+{
+	sem_run((intptr_t)timerheap_get_user_data(timer));
+}
+
+static void sem_lv_cb(lv_timer_t *timer)
+{
+	sem_run((intptr_t)lv_timer_get_user_data(timer));
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void sem_script(bool heap, uint32_t *log, uint32_t *count)
+{
+	memset(&sem, 0, sizeof(sem));
+	sem.heap = heap;
+	bench_tick = 1000;
+	if (heap) {
+		timerheap_init();
+	}
+	sem_create(0, 10, -1, true);
+	sem_create(1, 25, 3, true);
+	sem_create(2, 7, -1, true);
+	sem_create(3, 0, 5, true);
+	sem_create(4, 20, -1, true);
+	SEM_OP(pause, sem.timers[4]);
+	sem_create(5, 15, 2, false);
+	for (; bench_tick < 1000 + TIMERHEAP_SEM_TICKS; bench_tick++) {
+		if (bench_tick == 1050) {
+			SEM_OP(resume, sem.timers[4]);
+		} else if (bench_tick == 1100) {
+			SEM_OP(resume, sem.timers[5]);
+		} else if (bench_tick == 1120) {
+			SEM_OP(reset, sem.timers[0]);
+		}
+		lv_timer_handler();
+	}
+	SEM_OP(delete, sem.timers[0]);
+	SEM_OP(delete, sem.timers[4]);
+	SEM_OP(delete, sem.timers[5]);
+	if (heap) {
+		timerheap_deinit();
+	}
+	// Runs due in the same pass come in list or deadline order
+	qsort(sem.log, sem.count, sizeof(sem.log[0]), cmp_u32);
+	memcpy(log, sem.log, sizeof(sem.log));
+	*count = sem.count;
+}
+
+static int bench_semantics(void)
+{
+	static uint32_t lv_log[TIMERHEAP_SEM_LOG], heap_log[TIMERHEAP_SEM_LOG];
+	uint32_t lv_count, heap_count, i;
+
+	sem_script(false, lv_log, &lv_count);
+	sem_script(true, heap_log, &heap_count);
+	for (i = 0; i < LV_MIN(lv_count, heap_count); i++) {
+		if (lv_log[i] != heap_log[i]) {
+			break;
+		}
+	}
+	if (i < lv_count || i < heap_count) {
+		printf("callbacks differ at run %u: lv_timer %u at %u ms, "
+		       "timerheap %u at %u ms\n", i,
+		       i < lv_count ? lv_log[i] & 0xff : 0,
+		       i < lv_count ? (lv_log[i] >> 8) - 1000 : 0,
+		       i < heap_count ? heap_log[i] & 0xff : 0,
+		       i < heap_count ? (heap_log[i] >> 8) - 1000 : 0);
+		return -1;
+	}
+	printf("callbacks: %u runs over %u ms, same as lv_timer\n", lv_count,
+	       TIMERHEAP_SEM_TICKS);
+
+	return 0;
+}
+
+static void cost_lv_cb(lv_timer_t *timer)
+{
+}
+
+static void cost_heap_cb(struct timerheap_timer *timer)
+{
+}
+
+static double bench_calls(void)
+{
+	uint64_t t0;
+	uint32_t i;
+
+	t0 = bench_now_us();
+	for (i = 0; i < TIMERHEAP_COST_CALLS; i++) {
+		bench_tick++;
+		lv_timer_handler();
+	}
+
+	return (double)(bench_now_us() - t0) / TIMERHEAP_COST_CALLS;
+}
+
+static int bench_cost(uint32_t n)
+{
+	double lv_create_ns, lv_call_us, heap_create_ns, heap_call_us;
+	void **timers = calloc(n + 1, sizeof(*timers));
+	lv_mem_monitor_t mon;
+	uint32_t i, fit;
+	uint64_t t0;
+
+	if (!timers) {
+		return -1;
+	}
+
+	t0 = bench_now_us();
+	timers[0] = lv_timer_create(cost_lv_cb, 1, NULL);
+	for (fit = 1; fit <= n; fit++) {
+		lv_mem_monitor(&mon);
+		if (mon.free_size < TIMERHEAP_HEAP_MIN) {
+			break;
+		}
+		timers[fit] = lv_timer_create(cost_lv_cb,
+					      60000 + fit, NULL);
+		if (!timers[fit]) {
+			break;
+		}
+	}
+	lv_create_ns = (bench_now_us() - t0) * 1000.0 / fit;
+	lv_call_us = bench_calls();
+	for (i = 0; i < fit; i++) {
+		lv_timer_delete(timers[i]);
+	}
+
+	timerheap_init();
+	t0 = bench_now_us();
+	timers[0] = timerheap_create(cost_heap_cb, 1, NULL);
+	for (i = 1; i <= n; i++) {
+		timers[i] = timerheap_create(cost_heap_cb,
+					     60000 + i, NULL);
+	}
+	heap_create_ns = (bench_now_us() - t0) * 1000.0 / (n + 1);
+	heap_call_us = bench_calls();
+	timerheap_deinit();
+	free(timers);
+
+	printf("%6u timers  lv_timer: %7.2f us/call, create %4.0f ns",
+	       n, lv_call_us, lv_create_ns);
+	if (fit <= n) {
+		printf(" (%u fit in LV_MEM_SIZE)", fit - 1);
+	}
+	printf("\n              timerheap: %6.2f us/call, create %4.0f ns\n",
+	       heap_call_us, heap_create_ns);
+
+	return 0;
+}
+
+int timerheap_bench(void)
+{
+	static const uint32_t counts[] = { 10, 1000, 10000 };
+	size_t i;
+	int ret;
+
+	lv_tick_set_cb(bench_tick_cb);
+	ret = bench_semantics();
+	for (i = 0; !ret && i < sizeof(counts) / sizeof(counts[0]); i++) {
+		ret = bench_cost(counts[i]);
+	}
+	lv_tick_set_cb(real_tick_cb);
+
+	return ret;
+}
@@ -0,0 +1,51 @@
+/*
+ * Deadline ordered timers
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef TIMERHEAP_H
+#define TIMERHEAP_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+struct timerheap_timer;
+
+typedef void (*timerheap_cb_t)(struct timerheap_timer *timer);
+
+/* Drive the timers from one LVGL timer, due when the earliest of them is */
+int timerheap_init(void);
+void timerheap_deinit(void);
+
+/*
+ * Same semantics as the lv_timer_*() counterparts: the first run is period
+ * ms after creation, a repeat count of -1 runs forever, and a timer whose
+ * count runs out is deleted (or paused without auto delete).
+ */
+struct timerheap_timer *timerheap_create(timerheap_cb_t cb, uint32_t period,
+					 void *user_data);
+void timerheap_delete(struct timerheap_timer *timer);
+void timerheap_pause(struct timerheap_timer *timer);
+void timerheap_resume(struct timerheap_timer *timer);
+void timerheap_set_period(struct timerheap_timer *timer, uint32_t period);
+void timerheap_set_repeat_count(struct timerheap_timer *timer, int32_t count);
+void timerheap_set_auto_delete(struct timerheap_timer *timer, bool enable);
+void timerheap_ready(struct timerheap_timer *timer);
+void timerheap_reset(struct timerheap_timer *timer);
+void *timerheap_get_user_data(struct timerheap_timer *timer);
+
+/*
+ * Run the due timers; returns the ms until the next one is due, or
+ * LV_NO_TIMER_READY. Called by the LVGL timer, or directly without init.
+ */
+uint32_t timerheap_handler(void);
+
+int timerheap_bench(void);
+
+#endif /* TIMERHEAP_H */
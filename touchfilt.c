@@ -0,0 +1,447 @@
+/*
+ * Touch filtering and motion prediction between evdev and LVGL
+ *
+ * The evdev read callback hands LVGL the raw panel coordinates. Their noise
+ * moves a held slider back and forth, each step a VALUE_CHANGED and a
+ * redraw, and the knob trails the finger by the read period plus a frame.
+ * This stage wraps the read callback of the pointer:
+ *
+ *   median	median of the last three samples, removes single sample spikes
+ *   iir	first order low pass, new = old + (sample - old) * iir / 256
+ *   deadband	the reported point only moves once the filtered one is at
+ *		least this far (1/16 px) away from it
+ *   predict	the reported point leads by velocity * predict_ms, to make up
+ *		for the render and flush latency
+ *
+ * Positions are kept in 1/16 px so that the low pass does not stall on
+ * integer rounding. A new press starts from its first sample; the release
+ * is reported at the filtered point without the lead.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bench.h"
+#include "touchfilt.h"
+#include "tune.h"
+
+struct pt {
+	int32_t x;
+	int32_t y;
+};
+
+static struct {
+	lv_indev_t *indev;
+	lv_indev_read_cb_t read_cb;
+	struct touchfilt_cfg cfg;
+	FILE *record;
+	int32_t max_x;		// [1/16 px]
+	int32_t max_y;
+	bool pressed;
+	uint32_t n;		// samples in this press
+	uint32_t t;		// [ms] of the previous sample
+	struct pt hist[3];
+	struct pt filt;
+	struct pt vel;		// [1/256 px/ms]
+	struct pt out;		// [1/16 px] reported
+	struct touchfilt_stats stats;
+} tf;
+
+static int32_t med3(int32_t a, int32_t b, int32_t c)
+{
+	return LV_MAX(LV_MIN(a, b), LV_MIN(LV_MAX(a, b), c));
+}
+
+static void filter(lv_indev_data_t *data, uint32_t now)
+{
+	struct pt raw = { data->point.x * 16, data->point.y * 16 };
+	struct pt prev = tf.filt;
+	struct pt m = raw;
+	struct pt p;
+	uint32_t dt;
+
+	if (data->state != LV_INDEV_STATE_PRESSED) {
+		if (tf.pressed) {
+			tf.pressed = false;
+			data->point.x = (tf.filt.x + 8) / 16;
+			data->point.y = (tf.filt.y + 8) / 16;
+		}
+		return;
+	}
+	tf.stats.samples++;
+	if (!tf.pressed) {
+		tf.pressed = true;
+		tf.n = 1;
+		tf.t = now;
+		tf.hist[0] = tf.hist[1] = tf.hist[2] = raw;
+		tf.filt = tf.out = raw;
+		tf.vel.x = tf.vel.y = 0;
+		tf.stats.moves++;
+		return;
+	}
+	tf.n++;
+
+	if (tf.cfg.median) {
+		tf.hist[0] = tf.hist[1];
+		tf.hist[1] = tf.hist[2];
+		tf.hist[2] = raw;
+		m.x = med3(tf.hist[0].x, tf.hist[1].x, tf.hist[2].x);
+		m.y = med3(tf.hist[0].y, tf.hist[1].y, tf.hist[2].y);
+	}
+	tf.filt.x += (m.x - tf.filt.x) * (int32_t)tf.cfg.iir / 256;
+	tf.filt.y += (m.y - tf.filt.y) * (int32_t)tf.cfg.iir / 256;
+
+	dt = now - tf.t;
+	tf.t = now;
+	if (dt) {
+		tf.vel.x += ((tf.filt.x - prev.x) * 16 / (int32_t)dt -
+			     tf.vel.x) / 4;
+		tf.vel.y += ((tf.filt.y - prev.y) * 16 / (int32_t)dt -
+			     tf.vel.y) / 4;
+	}
+	p = tf.filt;
+	if (tf.cfg.predict_ms && tf.n > 3) {
+		p.x += tf.vel.x * (int32_t)tf.cfg.predict_ms / 16;
+		p.y += tf.vel.y * (int32_t)tf.cfg.predict_ms / 16;
+		p.x = LV_CLAMP(0, p.x, tf.max_x);
+		p.y = LV_CLAMP(0, p.y, tf.max_y);
+	}
+
+	if ((p.x + 8) / 16 != (tf.out.x + 8) / 16 ||
+	    (p.y + 8) / 16 != (tf.out.y + 8) / 16) {
+		if (LV_ABS(p.x - tf.out.x) < (int32_t)tf.cfg.deadband &&
+		    LV_ABS(p.y - tf.out.y) < (int32_t)tf.cfg.deadband) {
+			tf.stats.held++;
+		} else {
+			tf.out = p;
+			tf.stats.moves++;
+		}
+	}
+	data->point.x = (tf.out.x + 8) / 16;
+	data->point.y = (tf.out.y + 8) / 16;
+}
+
+static void touchfilt_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+	uint32_t now = lv_tick_get();
+
+	tf.read_cb(indev, data);
+	if (tf.record && (data->state == LV_INDEV_STATE_PRESSED ||
+			  tf.pressed)) {
+		fprintf(tf.record, "%u %d %d %d\n", now, (int)data->point.x,
+			(int)data->point.y,
+			data->state == LV_INDEV_STATE_PRESSED);
+		if (data->state != LV_INDEV_STATE_PRESSED) {
+			fflush(tf.record);
+		}
+	}
+	filter(data, now);
+}
+
+static void setup(lv_indev_t *indev, const struct touchfilt_cfg *cfg)
+{
+	lv_display_t *disp = lv_indev_get_display(indev);
+
+	memset(&tf.stats, 0, sizeof(tf.stats));
+	tf.cfg = *cfg;
+	tf.cfg.iir = LV_CLAMP(1, tf.cfg.iir, 256);
+	tf.indev = indev;
+	tf.pressed = false;
+	tf.max_x = (lv_display_get_horizontal_resolution(disp) - 1) * 16;
+	tf.max_y = (lv_display_get_vertical_resolution(disp) - 1) * 16;
+}
+
+int touchfilt_init(lv_indev_t *indev, const struct touchfilt_cfg *cfg,
+		   const char *record)
+{
+	if (tf.read_cb) {
+		return -1;
+	}
+	if (record) {
+		tf.record = fopen(record, "a");
+		if (!tf.record) {
+			fprintf(stderr, "touchfilt: %s: %s\n", record,
+				strerror(errno));
+			return -errno;
+		}
+	}
+	setup(indev, cfg);
+	tf.read_cb = lv_indev_get_read_cb(indev);
+	lv_indev_set_read_cb(indev, touchfilt_read_cb);
+
+	return 0;
+}
+
+void touchfilt_deinit(void)
+{
+	if (!tf.read_cb) {
+		return;
+	}
+	lv_indev_set_read_cb(tf.indev, tf.read_cb);
+	tf.read_cb = NULL;
+	if (tf.record) {
+		fclose(tf.record);
+		tf.record = NULL;
+	}
+}
+
+void touchfilt_get_stats(struct touchfilt_stats *stats)
+{
+	*stats = tf.stats;
+}
+
+/*
+ * Benchmark: drag traces replayed into the main.c slider through a virtual
+ * pointer. Each sample also holds where the finger really is one render
+ * and flush latency later, which is where the knob should be once the
+ * frame is on the glass. Reported are the VALUE_CHANGED callbacks and how
+ * far the reported point is from that, on the larger axis.
+ *
+ * The synthetic traces are 100 Hz with +-3 px triangular noise and a 20 px
+ * spike every 41 samples. A trace recorded with touch_record is replayed
+ * too; its reference is a 7 sample moving average of the raw points.
+ */
+#define TOUCHFILT_BENCH_PERIOD_MS	10
+#define TOUCHFILT_BENCH_LATENCY_MS	40
+#define TOUCHFILT_BENCH_MAX_SAMPLES	8192
+#define TOUCHFILT_BENCH_Y		(BENCH_VER_RES / 2)
+
+struct sample {
+	uint32_t t;
+	int16_t x;
+	int16_t y;
+	int16_t ref_x;		// finger at t + latency
+	int16_t ref_y;
+	uint8_t pressed;
+};
+
+struct trace {
+	const char *name;
+	struct sample *s;
+	uint32_t n;
+};
+
+static struct {
+	const struct sample *cur;
+	uint32_t seed;
+	uint32_t callbacks;
+} bench;
+
+static int32_t noise(void)
+{
+	int32_t a;
+	int32_t b;
+
+	bench.seed = bench.seed * 1103515245 + 12345;
+	a = (bench.seed >> 16) % 7;
+	bench.seed = bench.seed * 1103515245 + 12345;
+	b = (bench.seed >> 16) % 7;
+
+	return (a + b - 6) / 2;
+}
+
+/* Smoothstep from x0 to x1 over ms, then resting at x1 */
+static int32_t path(int32_t x0, int32_t x1, uint32_t ms, uint32_t t)
+{
+	double u = t < ms ? (double)t / ms : 1.0;
+
+	return x0 + (x1 - x0) * u * u * (3 - 2 * u);
+}
+
+static uint32_t synth(struct sample *s, int32_t x0, int32_t x1, uint32_t ms)
+{
+	uint32_t n = ms / TOUCHFILT_BENCH_PERIOD_MS;
+	uint32_t i;
+
+	for (i = 0; i < n; i++) {
+		s[i].t = i * TOUCHFILT_BENCH_PERIOD_MS;
+		s[i].x = path(x0, x1, ms, s[i].t) + noise() +
+			 (i % 41 == 40 ? 20 : 0);
+		s[i].y = TOUCHFILT_BENCH_Y + noise();
+		s[i].ref_x = path(x0, x1, ms,
+				  s[i].t + TOUCHFILT_BENCH_LATENCY_MS);
+		s[i].ref_y = TOUCHFILT_BENCH_Y;
+		s[i].pressed = 1;
+	}
+	s[n] = s[n - 1];
+	s[n].t += TOUCHFILT_BENCH_PERIOD_MS;
+	s[n].pressed = 0;
+
+	return n + 1;
+}
+
+/* Reference of a recorded trace: smoothed, then one latency ahead */
+static void reference(struct sample *s, uint32_t n)
+{
+	uint32_t start;
+	uint32_t end;
+	uint32_t i;
+	uint32_t j;
+	int32_t sx;
+	int32_t sy;
+
+	for (start = 0; start < n; start = end + 1) {
+		for (end = start; end < n && s[end].pressed; end++) {
+		}
+		for (i = start; i < end; i++) {
+			sx = sy = 0;
+			for (j = LV_MAX(start + 3, i) - 3;
+			     j <= LV_MIN(i + 3, end - 1); j++) {
+				sx += s[j].x;
+				sy += s[j].y;
+			}
+			j = LV_MIN(i + 3, end - 1) - (LV_MAX(start + 3, i) - 3) + 1;
+			s[i].ref_x = sx / (int32_t)j;
+			s[i].ref_y = sy / (int32_t)j;
+		}
+		for (i = start; i < end; i++) {
+			for (j = i; j + 1 < end && s[j].t <
+			     s[i].t + TOUCHFILT_BENCH_LATENCY_MS; j++) {
+			}
+			s[i].ref_x = s[j].ref_x;
+			s[i].ref_y = s[j].ref_y;
+		}
+	}
+}
+
+static uint32_t load(struct sample *s, const char *file)
+{
+	unsigned int t;
+	int x;
+	int y;
+	int pressed;
+	uint32_t n = 0;
+	FILE *fp;
+
+	fp = fopen(file, "r");
+	if (!fp) {
+		return 0;
+	}
+	while (n < TOUCHFILT_BENCH_MAX_SAMPLES &&
+	       fscanf(fp, "%u %d %d %d", &t, &x, &y, &pressed) == 4) {
+		s[n].t = t;
+		s[n].x = x;
+		s[n].y = y;
+		s[n].pressed = pressed != 0;
+		n++;
+	}
+	fclose(fp);
+	reference(s, n);
+
+	return n;
+}
+
+static void bench_read_cb(lv_indev_t *indev, lv_indev_data_t *data)
+{
+	data->point.x = bench.cur->x;
+	data->point.y = bench.cur->y;
+	data->state = bench.cur->pressed ? LV_INDEV_STATE_PRESSED
+					 : LV_INDEV_STATE_RELEASED;
+	filter(data, bench.cur->t);
+}
+
+static void bench_slider_cb(lv_event_t *e)
+{
+	bench.callbacks++;
+}
+
+static void bench_replay(lv_indev_t *indev, lv_obj_t *slider,
+			 const struct trace *tr, const char *name,
+			 const struct touchfilt_cfg *cfg)
+{
+	uint64_t err_sum = 0;
+	uint32_t err_max = 0;
+	uint32_t pressed = 0;
+	uint32_t err;
+	lv_point_t p;
+	char label[48];
+	uint32_t i;
+
+	setup(indev, cfg);
+	lv_slider_set_value(slider, 0, LV_ANIM_OFF);
+	bench.callbacks = 0;
+	for (i = 0; i < tr->n; i++) {
+		bench.cur = &tr->s[i];
+		lv_indev_read(indev);
+		if (!tr->s[i].pressed) {
+			continue;
+		}
+		lv_indev_get_point(indev, &p);
+		err = LV_MAX(LV_ABS(p.x - tr->s[i].ref_x),
+			     LV_ABS(p.y - tr->s[i].ref_y));
+		err_sum += err;
+		err_max = LV_MAX(err_max, err);
+		pressed++;
+	}
+
+	snprintf(label, sizeof(label), "%s, %s", tr->name, name);
+	printf("%-32s %9u %8.1f %8u\n", label, bench.callbacks,
+	       pressed ? (double)err_sum / pressed : 0.0, err_max);
+}
+
+int touchfilt_bench(void)
+{
+	static const struct {
+		const char *name;
+		struct touchfilt_cfg cfg;
+	} filters[] = {
+		{ "raw", { 0, 256, 0, 0 } },
+		{ "median+iir", { 1, 96, 0, 0 } },
+		{ "+deadband", { 1, 96, 24, 0 } },
+		{ "+predict", { 1, 96, 24, TOUCHFILT_BENCH_LATENCY_MS } },
+	};
+	static struct sample s[4][TOUCHFILT_BENCH_MAX_SAMPLES];
+	struct trace traces[4];
+	lv_display_t *disp;
+	lv_indev_t *indev;
+	lv_obj_t *slider;
+	unsigned int t;
+	unsigned int f;
+	int ntraces = 3;
+
+	bench.seed = 1;
+	traces[0] = (struct trace){ "slow drag", s[0],
+				    synth(s[0], 70, 250, 1000) };
+	traces[1] = (struct trace){ "flick", s[1], synth(s[1], 80, 240, 250) };
+	traces[2] = (struct trace){ "hold", s[2], synth(s[2], 160, 160, 800) };
+	if (tune.touch_record[0]) {
+		traces[3] = (struct trace){ "recorded", s[3],
+					    load(s[3], tune.touch_record) };
+		ntraces += traces[3].n != 0;
+	}
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	slider = lv_slider_create(lv_display_get_screen_active(disp));
+	lv_obj_set_size(slider, 200, 50);
+	lv_obj_center(slider);
+	lv_obj_add_event_cb(slider, bench_slider_cb, LV_EVENT_VALUE_CHANGED,
+			    NULL);
+	indev = lv_indev_create();
+	lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
+	lv_indev_set_display(indev, disp);
+	lv_indev_set_mode(indev, LV_INDEV_MODE_EVENT);
+	lv_indev_set_read_cb(indev, bench_read_cb);
+
+	printf("%-32s %9s %8s %8s\n", "trace, filter", "callbacks",
+	       "err [px]", "max");
+	for (t = 0; t < (unsigned int)ntraces; t++) {
+		for (f = 0; f < LV_ARRAY_SIZE(filters); f++) {
+			bench_replay(indev, slider, &traces[t],
+				     filters[f].name, &filters[f].cfg);
+		}
+	}
+
+	lv_indev_delete(indev);
+	bench_display_delete(disp);
+
+	return 0;
+}
@@ -0,0 +1,42 @@
+/*
+ * Touch filtering and motion prediction between evdev and LVGL
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef TOUCHFILT_H
+#define TOUCHFILT_H
+
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+struct touchfilt_cfg {
+	uint32_t median;	// median of the last three samples
+	uint32_t iir;		// [1/256] weight of a new sample, 256: off
+	uint32_t deadband;	// [1/16 px] smaller moves are held back
+	uint32_t predict_ms;	// lead of the reported point, 0: off
+};
+
+struct touchfilt_stats {
+	uint64_t samples;	// pressed reads
+	uint64_t moves;		// reads that moved the reported point
+	uint64_t held;		// moves below the deadband
+};
+
+/*
+ * Filter the points that the read callback of indev reports. record, if
+ * not NULL, gets the raw pressed samples appended as "ms x y pressed"
+ * lines, the trace format that the touchfilt bench replays.
+ */
+int touchfilt_init(lv_indev_t *indev, const struct touchfilt_cfg *cfg,
+		   const char *record);
+void touchfilt_deinit(void);
+void touchfilt_get_stats(struct touchfilt_stats *stats);
+
+int touchfilt_bench(void);
+
+#endif /* TOUCHFILT_H */
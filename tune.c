@@ -0,0 +1,341 @@
+/*
+ * Runtime tuning profile
+ *
+ * A profile is a plain text file of "key = value" lines. Blank lines and
+ * anything after '#' are ignored. Keys that map onto compile-time limits in
+ * lv_conf.h are accepted, but only reported, since they need a rebuild.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <ctype.h>
+#include <errno.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "areamerge.h"
+#include "asyncimg.h"
+#include "tune.h"
+
+struct tune tune = {
+	.drm_device = "",
+	.input_device = "/dev/input/event1",
+	.refr_period = LV_DEF_REFR_PERIOD,
+	.indev_period = LV_DEF_REFR_PERIOD,
+	.loop_period = 100,
+	.antialias = 1,
+	.rotation = 0,
+	.rotation_offload = 1,
+	.image_cache_size = LV_CACHE_DEF_SIZE,
+	.image_header_cache_cnt = LV_IMAGE_HEADER_CACHE_DEF_CNT,
+	.asyncimg_queue = 4,
+	.governor = 0,
+	.governor_budget = 0,
+	.governor_degrade_frames = 3,
+	.governor_restore_frames = 60,
+	.areamerge_tx_ns = AREAMERGE_SPI32_TX_NS,
+	.areamerge_px_ns = AREAMERGE_SPI32_PX_NS,
+	.touch_iir = 256,
+	.mirror_queue = 4,
+};
+
+enum tune_type {
+	TUNE_TYPE_U32,
+	TUNE_TYPE_STR,
+};
+
+struct tune_key {
+	const char *name;
+	enum tune_type type;
+	size_t offset;
+	size_t size;
+	uint32_t min;
+	uint32_t max;
+};
+
+#define TUNE_U32(n, f, lo, hi) \
+	{ n, TUNE_TYPE_U32, offsetof(struct tune, f), \
+	  sizeof(((struct tune *)0)->f), lo, hi }
+#define TUNE_STR(n, f) \
+	{ n, TUNE_TYPE_STR, offsetof(struct tune, f), \
+	  sizeof(((struct tune *)0)->f), 0, 0 }
+
+static const struct tune_key keys[] = {
+	TUNE_STR("drm_device", drm_device),
+	TUNE_STR("input_device", input_device),
+	TUNE_U32("refr_period", refr_period, 1, 1000),
+	TUNE_U32("indev_period", indev_period, 1, 1000),
+	TUNE_U32("loop_period", loop_period, 1, 1000),
+	TUNE_U32("antialias", antialias, 0, 1),
+	TUNE_U32("rotation", rotation, 0, 270),
+	TUNE_U32("rotation_offload", rotation_offload, 0, 1),
+	TUNE_U32("image_cache_size", image_cache_size, 0, UINT32_MAX),
+	TUNE_U32("image_header_cache_cnt", image_header_cache_cnt, 0, 4096),
+	TUNE_U32("drawbuf_arena", drawbuf_arena, 0, 256 * 1024 * 1024),
+	TUNE_U32("drawbuf_huge", drawbuf_huge, 0, 1),
+	TUNE_U32("drawbuf_mlock", drawbuf_mlock, 0, 1),
+	TUNE_U32("layer_pool", layer_pool, 0, 64 * 1024 * 1024),
+	TUNE_U32("primcache", primcache, 0, 64 * 1024 * 1024),
+	TUNE_U32("kbdinc", kbdinc, 0, 64 * 1024 * 1024),
+	TUNE_U32("style_cache", style_cache, 0, 1),
+	TUNE_U32("asyncimg_threads", asyncimg_threads, 0, ASYNCIMG_THREADS_MAX),
+	TUNE_U32("asyncimg_queue", asyncimg_queue, 1, ASYNCIMG_JOBS),
+	TUNE_U32("asyncimg_lowres", asyncimg_lowres, 0, 16),
+	TUNE_U32("governor", governor, 0, 1),
+	TUNE_U32("governor_budget", governor_budget, 0, 1000),
+	TUNE_U32("governor_degrade_frames", governor_degrade_frames, 1, 1000),
+	TUNE_U32("governor_restore_frames", governor_restore_frames, 1, 10000),
+	TUNE_U32("layoutinc", layoutinc, 0, 2),
+	TUNE_U32("rt_mlock", rt_mlock, 0, 1),
+	TUNE_U32("rt_prefault", rt_prefault, 0, 1),
+	TUNE_U32("rt_ui_prio", rt_ui_prio, 0, 99),
+	TUNE_U32("rt_ui_cpus", rt_ui_cpus, 0, UINT32_MAX),
+	TUNE_U32("rt_draw_prio", rt_draw_prio, 0, 99),
+	TUNE_U32("rt_draw_cpus", rt_draw_cpus, 0, UINT32_MAX),
+	TUNE_U32("rt_input_thread", rt_input_thread, 0, 1),
+	TUNE_U32("rt_input_prio", rt_input_prio, 0, 99),
+	TUNE_U32("rt_input_cpus", rt_input_cpus, 0, UINT32_MAX),
+	TUNE_U32("touch_median", touch_median, 0, 1),
+	TUNE_U32("touch_iir", touch_iir, 1, 256),
+	TUNE_U32("touch_deadband", touch_deadband, 0, 1024),
+	TUNE_U32("touch_predict", touch_predict, 0, 200),
+	TUNE_STR("touch_record", touch_record),
+	TUNE_U32("rt_jitter", rt_jitter, 0, 3600),
+	TUNE_U32("vsync", vsync, 0, 2),
+	TUNE_U32("vsync_crtc", vsync_crtc, 0, 31),
+	TUNE_U32("vsync_fake_hz", vsync_fake_hz, 0, 1000),
+	TUNE_STR("panel2_drm_device", panel2_drm_device),
+	TUNE_STR("panel2_input_device", panel2_input_device),
+	TUNE_U32("panel2_refr_period", panel2_refr_period, 0, 1000),
+	TUNE_U32("vscroll", vscroll, 0, 1),
+	TUNE_U32("areamerge", areamerge, 0, 1),
+	TUNE_U32("areamerge_tx_ns", areamerge_tx_ns, 0, 10000000),
+	TUNE_U32("areamerge_px_ns", areamerge_px_ns, 0, 1000000),
+	TUNE_STR("shmpub_socket", shmpub_socket),
+	TUNE_STR("mirror_socket", mirror_socket),
+	TUNE_U32("mirror_queue", mirror_queue, 1, 16),
+	TUNE_STR("capture_socket", capture_socket),
+	TUNE_STR("capture_dir", capture_dir),
+	TUNE_U32("capture_ppm", capture_ppm, 0, 1),
+	TUNE_U32("refrstat", refrstat, 0, 3600),
+	TUNE_STR("refrstat_csv", refrstat_csv),
+};
+
+/* Settings that are fixed when LVGL is built */
+struct tune_fixed {
+	const char *name;
+	const char *macro;
+	long value;
+};
+
+static const struct tune_fixed fixed[] = {
+	{ "mem_size", "LV_MEM_SIZE", LV_MEM_SIZE },
+	{ "draw_unit_cnt", "LV_DRAW_SW_DRAW_UNIT_CNT", LV_DRAW_SW_DRAW_UNIT_CNT },
+	{ "layer_simple_buf_size", "LV_DRAW_LAYER_SIMPLE_BUF_SIZE",
+	  LV_DRAW_LAYER_SIMPLE_BUF_SIZE },
+	{ "layer_max_memory", "LV_DRAW_LAYER_MAX_MEMORY",
+	  LV_DRAW_LAYER_MAX_MEMORY },
+	{ "circle_cache_size", "LV_DRAW_SW_CIRCLE_CACHE_SIZE",
+	  LV_DRAW_SW_CIRCLE_CACHE_SIZE },
+	{ "shadow_cache_size", "LV_DRAW_SW_SHADOW_CACHE_SIZE",
+	  LV_DRAW_SW_SHADOW_CACHE_SIZE },
+	{ "draw_thread_stack_size", "LV_DRAW_THREAD_STACK_SIZE",
+	  LV_DRAW_THREAD_STACK_SIZE },
+	{ "draw_sw_complex", "LV_DRAW_SW_COMPLEX", LV_DRAW_SW_COMPLEX },
+	{ "obj_style_cache", "LV_OBJ_STYLE_CACHE", LV_OBJ_STYLE_CACHE },
+};
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+
+static char *trim(char *s)
+{
+	char *end;
+
+	while (isspace((unsigned char)*s)) {
+		s++;
+	}
+	end = s + strlen(s);
+	while (end > s && isspace((unsigned char)end[-1])) {
+		*--end = '\0';
+	}
+
+	return s;
+}
+
+static int set_key(const struct tune_key *key, const char *value)
+{
+	char *field = (char *)&tune + key->offset;
+	unsigned long v;
+	char *end;
+
+	switch (key->type) {
+	case TUNE_TYPE_STR:
+		if (strlen(value) >= key->size) {
+			return -ENAMETOOLONG;
+		}
+		strcpy(field, value);
+		return 0;
+	case TUNE_TYPE_U32:
+		errno = 0;
+		v = strtoul(value, &end, 0);
+		if (errno || end == value || *end != '\0') {
+			return -EINVAL;
+		}
+		if (v < key->min || v > key->max) {
+			return -ERANGE;
+		}
+		*(uint32_t *)field = v;
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+static int set_fixed(const struct tune_fixed *f, const char *value)
+{
+	long v = strtol(value, NULL, 0);
+
+	if (v != f->value) {
+		fprintf(stderr, "tune: %s = %ld ignored, bound at build time by "
+			"%s = %ld (edit lv_conf.h and rebuild)\n",
+			f->name, v, f->macro, f->value);
+		return -EPERM;
+	}
+
+	return 0;
+}
+
+static int parse_line(char *line)
+{
+	char *name;
+	char *value;
+	char *p;
+	size_t i;
+
+	p = strchr(line, '#');
+	if (p) {
+		*p = '\0';
+	}
+	name = trim(line);
+	if (*name == '\0') {
+		return 0;
+	}
+	p = strchr(name, '=');
+	if (!p) {
+		return -EINVAL;
+	}
+	*p = '\0';
+	name = trim(name);
+	value = trim(p + 1);
+
+	for (i = 0; i < ARRAY_SIZE(keys); i++) {
+		if (!strcmp(name, keys[i].name)) {
+			return set_key(&keys[i], value);
+		}
+	}
+	for (i = 0; i < ARRAY_SIZE(fixed); i++) {
+		if (!strcmp(name, fixed[i].name)) {
+			set_fixed(&fixed[i], value);
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "tune: unknown key '%s'\n", name);
+	return 0;
+}
+
+/*
+ * Load a profile. A missing file is only an error when the caller asked for
+ * one explicitly (path != NULL); otherwise TUNE_DEFAULT_PATH is optional.
+ */
+int tune_load(const char *path)
+{
+	const char *file = path ? path : TUNE_DEFAULT_PATH;
+	char line[PATH_MAX + 64];
+	unsigned int n = 0;
+	int errors = 0;
+	FILE *fp;
+	int ret;
+
+	fp = fopen(file, "r");
+	if (!fp) {
+		if (!path && errno == ENOENT) {
+			return 0;
+		}
+		fprintf(stderr, "tune: %s: %s\n", file, strerror(errno));
+		return -errno;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		n++;
+		ret = parse_line(line);
+		if (ret) {
+			fprintf(stderr, "tune: %s:%u: %s\n", file, n,
+				strerror(-ret));
+			errors++;
+		}
+	}
+	fclose(fp);
+
+	if (tune.rotation % 90) {
+		fprintf(stderr, "tune: rotation %u is not a multiple of 90\n",
+			tune.rotation);
+		tune.rotation = 0;
+		errors++;
+	}
+
+	return errors ? -EINVAL : 0;
+}
+
+/* Must be called after the display and input device exist, before the first
+ * lv_timer_handler(), so that the very first frame uses the profile. */
+void tune_apply(lv_display_t *disp, lv_indev_t *indev)
+{
+	lv_timer_t *timer;
+
+	timer = lv_display_get_refr_timer(disp);
+	if (timer) {
+		lv_timer_set_period(timer, tune.refr_period);
+	}
+	if (indev) {
+		timer = lv_indev_get_read_timer(indev);
+		if (timer) {
+			lv_timer_set_period(timer, tune.indev_period);
+		}
+	}
+
+	lv_display_set_antialiasing(disp, tune.antialias);
+	lv_display_set_rotation(disp, tune.rotation / 90);
+
+	lv_image_cache_resize(tune.image_cache_size, true);
+	lv_image_header_cache_resize(tune.image_header_cache_cnt, true);
+}
+
+void tune_report(void)
+{
+	const char *field;
+	size_t i;
+
+	fprintf(stderr, "tune: runtime settings\n");
+	for (i = 0; i < ARRAY_SIZE(keys); i++) {
+		field = (const char *)&tune + keys[i].offset;
+		if (keys[i].type == TUNE_TYPE_STR) {
+			fprintf(stderr, "  %-24s %s\n", keys[i].name,
+				*field ? field : "(auto)");
+		} else {
+			fprintf(stderr, "  %-24s %u\n", keys[i].name,
+				*(const uint32_t *)field);
+		}
+	}
+
+	fprintf(stderr, "tune: build time limits\n");
+	for (i = 0; i < ARRAY_SIZE(fixed); i++) {
+		fprintf(stderr, "  %-24s %ld (%s)\n", fixed[i].name,
+			fixed[i].value, fixed[i].macro);
+	}
+}
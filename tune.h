@@ -0,0 +1,91 @@
+/*
+ * Runtime tuning profile
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef TUNE_H
+#define TUNE_H
+
+#include <limits.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+#define TUNE_DEFAULT_PATH "/etc/ili9341.conf"
+
+/*
+ * Knobs that LVGL (or this program) can honour without a rebuild. The
+ * defaults mirror lv_conf.h and the values main.c used to hard-code.
+ */
+struct tune {
+	char drm_device[PATH_MAX];	// empty: lv_linux_drm_find_device_path()
+	char input_device[PATH_MAX];
+	uint32_t refr_period;		// [ms] display refresh timer
+	uint32_t indev_period;		// [ms] input device read timer
+	uint32_t loop_period;		// [ms] upper bound on main loop sleep
+	uint32_t antialias;
+	uint32_t rotation;		// [degrees] 0, 90, 180 or 270
+	uint32_t rotation_offload;	// let the DRM plane rotate where it can
+	uint32_t image_cache_size;	// [bytes]
+	uint32_t image_header_cache_cnt;
+	uint32_t drawbuf_arena;		// [bytes] aligned draw buffer arena, 0: off
+	uint32_t drawbuf_huge;		// back the arena with huge pages
+	uint32_t drawbuf_mlock;
+	uint32_t layer_pool;		// [bytes] layer buffer budget, 0: LVGL heap
+	uint32_t primcache;		// [bytes] corner/shadow bitmaps, 0: off
+	uint32_t kbdinc;		// [bytes] cached key faces, 0: off
+	uint32_t style_cache;		// cache resolved style properties
+	uint32_t asyncimg_threads;	// image decode workers, 0: in place
+	uint32_t asyncimg_queue;	// decodes queued or running at a time
+	uint32_t asyncimg_lowres;	// preview at 1/n resolution, 0: off
+	uint32_t governor;		// adapt render quality to frame time
+	uint32_t governor_budget;	// [ms] 0: refr_period
+	uint32_t governor_degrade_frames;
+	uint32_t governor_restore_frames;
+	uint32_t layoutinc;		// 1: count flex/grid passes, 2: skip unchanged
+	uint32_t rt_mlock;		// mlockall() current and future pages
+	uint32_t rt_prefault;		// touch LVGL heap, draw buffers, stack
+	uint32_t rt_ui_prio;		// SCHED_FIFO priority, 0: SCHED_OTHER
+	uint32_t rt_ui_cpus;		// CPU mask, 0: unchanged
+	uint32_t rt_draw_prio;
+	uint32_t rt_draw_cpus;
+	uint32_t rt_input_thread;	// read evdev from its own thread
+	uint32_t rt_input_prio;
+	uint32_t rt_input_cpus;
+	uint32_t touch_median;		// median of three pointer samples
+	uint32_t touch_iir;		// [1/256] new sample weight, 256: off
+	uint32_t touch_deadband;	// [1/16 px] hold back smaller moves
+	uint32_t touch_predict;		// [ms] lead of the reported point
+	char touch_record[PATH_MAX];	// raw drag trace, empty: off
+	uint32_t rt_jitter;		// [s] wake-up jitter report period, 0: off
+	uint32_t vsync;			// 1: present statistics, 2: vblank pacing
+	uint32_t vsync_crtc;		// DRM CRTC index of the panel
+	uint32_t vsync_fake_hz;		// timer instead of DRM vblank events
+	char panel2_drm_device[PATH_MAX];	// second panel, empty: none
+	char panel2_input_device[PATH_MAX];
+	uint32_t panel2_refr_period;	// [ms] 0: refr_period
+	uint32_t vscroll;		// move framebuffer rows on vertical scrolls
+	uint32_t areamerge;		// merge dirty areas by bus cost
+	uint32_t areamerge_tx_ns;	// [ns] per CASET/PASET/RAMWR transfer
+	uint32_t areamerge_px_ns;	// [ns] per pixel
+	char shmpub_socket[PATH_MAX];	// empty: no external producers
+	char mirror_socket[PATH_MAX];	// empty: no remote viewer
+	uint32_t mirror_queue;		// frames buffered for the encoder
+	char capture_socket[PATH_MAX];	// empty: no screenshot socket
+	char capture_dir[PATH_MAX];	// SIGUSR1 screenshots, empty: off
+	uint32_t capture_ppm;		// SIGUSR1 writes PPM instead of PNG
+	uint32_t refrstat;		// [s] overdraw report period, 0: off
+	char refrstat_csv[PATH_MAX];	// per-frame log, empty: off
+};
+
+extern struct tune tune;
+
+int tune_load(const char *path);
+void tune_apply(lv_display_t *disp, lv_indev_t *indev);
+void tune_report(void);
+
+#endif /* TUNE_H */
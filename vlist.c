@@ -0,0 +1,476 @@
+/*
+ * Virtualized list/table for large datasets
+ *
+ * lv_table and lv_list keep every cell or child alive, so a few thousand
+ * rows exhaust LV_MEM_SIZE and creation and layout grow with the data. Here
+ * only a pool of row objects sized to the viewport (plus VLIST_MARGIN rows
+ * on each side) exists. Data row r is bound to pool slot r % pool size, so
+ * while scrolling only the slots whose row left the window are rebound
+ * through the cell callback. A transparent spacer at the last row's
+ * position gives the container its full scroll range.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <stdio.h>
+
+#include "bench.h"
+#include "vlist.h"
+
+#define VLIST_MARGIN 2
+#define VLIST_ROW_PAD 4
+
+struct vlist {
+	vlist_cell_cb_t cell_cb;
+	void *ctx;
+	uint32_t rows;
+	uint32_t cols;
+	int32_t row_h;
+	int32_t *col_w;		// 0: share of the remaining width
+	lv_obj_t *spacer;
+	lv_obj_t **pool;
+	uint32_t *pool_row;	// UINT32_MAX: unbound
+	uint32_t pool_n;
+	uint64_t binds;
+};
+
+static lv_style_t row_style;
+static lv_style_t row_pressed_style;
+static bool styles_ready;
+
+static void init_styles(void)
+{
+	if (styles_ready) {
+		return;
+	}
+	lv_style_init(&row_style);
+	lv_style_set_border_width(&row_style, 1);
+	lv_style_set_border_side(&row_style, LV_BORDER_SIDE_BOTTOM);
+	lv_style_set_border_color(&row_style,
+				  lv_palette_lighten(LV_PALETTE_GREY, 2));
+	lv_style_set_pad_hor(&row_style, VLIST_ROW_PAD);
+
+	lv_style_init(&row_pressed_style);
+	lv_style_set_bg_opa(&row_pressed_style, LV_OPA_COVER);
+	lv_style_set_bg_color(&row_pressed_style,
+			      lv_palette_lighten(LV_PALETTE_GREY, 3));
+	styles_ready = true;
+}
+
+static void bind(struct vlist *vl, uint32_t slot, uint32_t row)
+{
+	lv_obj_t *obj = vl->pool[slot];
+	char buf[VLIST_CELL_MAX];
+	uint32_t col;
+
+	if (row >= vl->rows) {
+		lv_obj_add_flag(obj, LV_OBJ_FLAG_HIDDEN);
+		vl->pool_row[slot] = UINT32_MAX;
+		return;
+	}
+
+	lv_obj_remove_flag(obj, LV_OBJ_FLAG_HIDDEN);
+	lv_obj_set_y(obj, (int32_t)row * vl->row_h);
+	lv_obj_set_user_data(obj, (void *)(uintptr_t)(row + 1));
+	for (col = 0; col < vl->cols; col++) {
+		buf[0] = '\0';
+		vl->cell_cb(vl->ctx, row, col, buf, sizeof(buf));
+		lv_label_set_text(lv_obj_get_child(obj, col), buf);
+	}
+	vl->pool_row[slot] = row;
+	vl->binds++;
+}
+
+static void update(struct vlist *vl, lv_obj_t *obj, bool force)
+{
+	int32_t top = lv_obj_get_scroll_y(obj);
+	uint32_t first = top > 0 ? top / vl->row_h : 0;
+	uint32_t row;
+	uint32_t slot;
+
+	if (!vl->pool_n) {
+		return;
+	}
+	first = first > VLIST_MARGIN ? first - VLIST_MARGIN : 0;
+	for (row = first; row < first + vl->pool_n; row++) {
+		slot = row % vl->pool_n;
+		if (force || vl->pool_row[slot] != row) {
+			bind(vl, slot, row);
+		}
+	}
+}
+
+static void layout_cols(struct vlist *vl, lv_obj_t *obj)
+{
+	int32_t w = lv_obj_get_content_width(obj);
+	int32_t rest = w - 2 * VLIST_ROW_PAD;
+	int32_t share;
+	int32_t x;
+	uint32_t flex = 0;
+	uint32_t col;
+	uint32_t i;
+
+	for (col = 0; col < vl->cols; col++) {
+		if (vl->col_w[col]) {
+			rest -= vl->col_w[col];
+		} else {
+			flex++;
+		}
+	}
+	share = flex && rest > 0 ? rest / (int32_t)flex : 0;
+
+	for (i = 0; i < vl->pool_n; i++) {
+		lv_obj_set_width(vl->pool[i], w);
+		for (col = 0, x = 0; col < vl->cols; col++) {
+			lv_obj_t *label = lv_obj_get_child(vl->pool[i], col);
+			int32_t cw = vl->col_w[col] ? vl->col_w[col] : share;
+
+			lv_obj_set_width(label, cw);
+			lv_obj_align(label, LV_ALIGN_LEFT_MID, x, 0);
+			x += cw;
+		}
+	}
+}
+
+static lv_obj_t *create_row(struct vlist *vl, lv_obj_t *obj)
+{
+	lv_obj_t *row = lv_obj_create(obj);
+	lv_obj_t *label;
+	uint32_t col;
+
+	lv_obj_remove_style_all(row);
+	lv_obj_add_style(row, &row_style, 0);
+	lv_obj_add_style(row, &row_pressed_style, LV_STATE_PRESSED);
+	lv_obj_remove_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+	lv_obj_add_flag(row, LV_OBJ_FLAG_EVENT_BUBBLE |
+			LV_OBJ_FLAG_HIDDEN);
+	lv_obj_set_height(row, vl->row_h);
+	for (col = 0; col < vl->cols; col++) {
+		label = lv_label_create(row);
+		lv_label_set_long_mode(label, LV_LABEL_LONG_MODE_CLIP);
+	}
+
+	return row;
+}
+
+static void resize_pool(struct vlist *vl, lv_obj_t *obj)
+{
+	int32_t h = lv_obj_get_content_height(obj);
+	uint32_t n = (h > 0 ? h / vl->row_h : 0) + 2 + 2 * VLIST_MARGIN;
+	lv_obj_t **pool;
+	uint32_t *pool_row;
+	uint32_t i;
+
+	if (n == vl->pool_n) {
+		layout_cols(vl, obj);
+		return;
+	}
+
+	for (i = n; i < vl->pool_n; i++) {
+		lv_obj_delete(vl->pool[i]);
+	}
+	pool = lv_realloc(vl->pool, n * sizeof(*pool));
+	pool_row = lv_realloc(vl->pool_row, n * sizeof(*pool_row));
+	if (pool) {
+		vl->pool = pool;
+	}
+	if (pool_row) {
+		vl->pool_row = pool_row;
+	}
+	if (!pool || !pool_row) {
+		vl->pool_n = LV_MIN(vl->pool_n, n);
+		return;
+	}
+	for (i = vl->pool_n; i < n; i++) {
+		vl->pool[i] = create_row(vl, obj);
+	}
+	vl->pool_n = n;
+	for (i = 0; i < n; i++) {
+		vl->pool_row[i] = UINT32_MAX;
+	}
+
+	layout_cols(vl, obj);
+	update(vl, obj, true);
+}
+
+static void vlist_event_cb(lv_event_t *e)
+{
+	lv_obj_t *obj = lv_event_get_current_target_obj(e);
+	struct vlist *vl = lv_event_get_user_data(e);
+
+	switch (lv_event_get_code(e)) {
+	case LV_EVENT_SCROLL:
+		update(vl, obj, false);
+		break;
+	case LV_EVENT_SIZE_CHANGED:
+		resize_pool(vl, obj);
+		break;
+	case LV_EVENT_DELETE:
+		lv_free(vl->pool);
+		lv_free(vl->pool_row);
+		lv_free(vl->col_w);
+		lv_free(vl);
+		break;
+	default:
+		break;
+	}
+}
+
+lv_obj_t *vlist_create(lv_obj_t *parent, uint32_t cols, int32_t row_height,
+		       vlist_cell_cb_t cell_cb, void *ctx)
+{
+	struct vlist *vl;
+	lv_obj_t *obj;
+
+	vl = lv_malloc_zeroed(sizeof(*vl));
+	if (!vl) {
+		return NULL;
+	}
+	vl->cols = cols ? cols : 1;
+	vl->col_w = lv_malloc_zeroed(vl->cols * sizeof(*vl->col_w));
+	if (!vl->col_w) {
+		lv_free(vl);
+		return NULL;
+	}
+	vl->row_h = row_height > 0 ? row_height : 1;
+	vl->cell_cb = cell_cb;
+	vl->ctx = ctx;
+	init_styles();
+
+	obj = lv_obj_create(parent);
+	lv_obj_set_scroll_dir(obj, LV_DIR_VER);
+
+	vl->spacer = lv_obj_create(obj);
+	lv_obj_remove_style_all(vl->spacer);
+	lv_obj_remove_flag(vl->spacer, LV_OBJ_FLAG_CLICKABLE);
+	lv_obj_set_size(vl->spacer, 1, vl->row_h);
+	lv_obj_add_flag(vl->spacer, LV_OBJ_FLAG_HIDDEN);
+
+	lv_obj_add_event_cb(obj, vlist_event_cb, LV_EVENT_ALL, vl);
+	lv_obj_set_user_data(obj, vl);
+
+	return obj;
+}
+
+void vlist_set_row_count(lv_obj_t *obj, uint32_t rows)
+{
+	struct vlist *vl = lv_obj_get_user_data(obj);
+
+	/* the scroll range must stay within the coordinate space */
+	vl->rows = LV_MIN(rows, (uint32_t)(LV_COORD_MAX / vl->row_h));
+	if (vl->rows) {
+		lv_obj_set_y(vl->spacer, (int32_t)(vl->rows - 1) * vl->row_h);
+		lv_obj_remove_flag(vl->spacer, LV_OBJ_FLAG_HIDDEN);
+	} else {
+		lv_obj_add_flag(vl->spacer, LV_OBJ_FLAG_HIDDEN);
+	}
+	update(vl, obj, true);
+	lv_obj_scroll_by_bounded(obj, 0, 0, LV_ANIM_OFF);
+}
+
+void vlist_set_col_width(lv_obj_t *obj, uint32_t col, int32_t width)
+{
+	struct vlist *vl = lv_obj_get_user_data(obj);
+
+	if (col < vl->cols) {
+		vl->col_w[col] = width;
+		layout_cols(vl, obj);
+	}
+}
+
+/* Rebind the rows in the window, after the data behind them changed */
+void vlist_refresh(lv_obj_t *obj)
+{
+	update(lv_obj_get_user_data(obj), obj, true);
+}
+
+void vlist_scroll_to_row(lv_obj_t *obj, uint32_t row, lv_anim_enable_t anim)
+{
+	struct vlist *vl = lv_obj_get_user_data(obj);
+
+	lv_obj_scroll_to_y(obj, (int32_t)row * vl->row_h, anim);
+}
+
+/* Data row of a row object (event target), -1 if not bound */
+int32_t vlist_get_row(lv_obj_t *row_obj)
+{
+	uintptr_t row = (uintptr_t)lv_obj_get_user_data(row_obj);
+
+	return row ? (int32_t)(row - 1) : -1;
+}
+
+void vlist_get_stats(lv_obj_t *obj, struct vlist_stats *stats)
+{
+	struct vlist *vl = lv_obj_get_user_data(obj);
+
+	stats->pool = vl->pool_n;
+	stats->binds = vl->binds;
+}
+
+/*
+ * Benchmark: a three column log table at 100, 10k and 1M rows. lv_table and
+ * lv_list are filled until the LVGL heap runs low (they are stopped early
+ * rather than hitting the allocation assert), the virtualized table always
+ * gets every row. Reported are creation time up to the first frame, LVGL
+ * heap taken and frame time while scrolling down.
+ */
+#define VLIST_BENCH_ROW_H	20
+#define VLIST_BENCH_FRAMES	120
+#define VLIST_BENCH_STEP	23
+#define VLIST_BENCH_HEAP_MIN	4096
+
+enum { BENCH_TABLE, BENCH_LIST, BENCH_VLIST };
+
+static const char *const vlist_bench_names[] = { "lv_table", "lv_list",
+						 "vlist" };
+
+static void bench_cell(void *ctx, uint32_t row, uint32_t col, char *buf,
+		       size_t size)
+{
+	switch (col) {
+	case 0:
+		lv_snprintf(buf, size, "%u", row);
+		break;
+	case 1:
+		lv_snprintf(buf, size, "%02u:%02u:%02u", row / 3600 % 24,
+			    row / 60 % 60, row % 60);
+		break;
+	default:
+		lv_snprintf(buf, size, "event %u", row * 7919 % 1000);
+		break;
+	}
+}
+
+static size_t heap_free(void)
+{
+	lv_mem_monitor_t mon;
+
+	lv_mem_monitor(&mon);
+
+	return mon.free_size;
+}
+
+static size_t heap_free_biggest(void)
+{
+	lv_mem_monitor_t mon;
+
+	lv_mem_monitor(&mon);
+
+	return mon.free_biggest_size;
+}
+
+static lv_obj_t *bench_create(lv_obj_t *scr, int kind, uint32_t rows,
+			      uint32_t *filled)
+{
+	char buf[VLIST_CELL_MAX];
+	lv_obj_t *obj;
+	uint32_t row;
+	uint32_t col;
+
+	if (kind == BENCH_VLIST) {
+		obj = vlist_create(scr, 3, VLIST_BENCH_ROW_H, bench_cell, NULL);
+		if (obj) {
+			lv_obj_set_size(obj, BENCH_HOR_RES, BENCH_VER_RES);
+			vlist_set_row_count(obj, rows);
+		}
+		*filled = rows;
+		return obj;
+	}
+
+	obj = kind == BENCH_TABLE ? lv_table_create(scr) : lv_list_create(scr);
+	lv_obj_set_size(obj, BENCH_HOR_RES, BENCH_VER_RES);
+	if (kind == BENCH_TABLE) {
+		lv_table_set_column_count(obj, 3);
+	}
+	for (row = 0; row < rows; row++) {
+		/* the table reallocates its cell array as it grows */
+		if (heap_free() < VLIST_BENCH_HEAP_MIN ||
+		    (kind == BENCH_TABLE && heap_free_biggest() <
+		     2 * (row + 1) * 3 * sizeof(char *) + VLIST_BENCH_HEAP_MIN)) {
+			break;
+		}
+		if (kind == BENCH_LIST) {
+			bench_cell(NULL, row, 2, buf, sizeof(buf));
+			lv_list_add_button(obj, NULL, buf);
+			continue;
+		}
+		for (col = 0; col < 3; col++) {
+			bench_cell(NULL, row, col, buf, sizeof(buf));
+			lv_table_set_cell_value(obj, row, col, buf);
+		}
+	}
+	*filled = row;
+
+	return obj;
+}
+
+int vlist_bench(void)
+{
+	static const uint32_t counts[] = { 100, 10000, 1000000 };
+	struct bench_frames frames;
+	struct vlist_stats stats;
+	lv_display_t *disp;
+	lv_obj_t *scr;
+	lv_obj_t *obj;
+	uint32_t filled;
+	uint64_t t0;
+	uint64_t create_us;
+	size_t heap0;
+	size_t heap;
+	size_t i;
+	int kind;
+	int n;
+	char label[32];
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	scr = lv_display_get_screen_active(disp);
+	lv_refr_now(disp);
+
+	for (i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+		for (kind = BENCH_TABLE; kind <= BENCH_VLIST; kind++) {
+			heap0 = heap_free();
+			t0 = bench_now_us();
+			obj = bench_create(scr, kind, counts[i], &filled);
+			if (!obj) {
+				return -1;
+			}
+			lv_refr_now(disp);
+			create_us = bench_now_us() - t0;
+			heap = heap0 - heap_free();
+
+			bench_frames_reset(&frames);
+			for (n = 0; n < VLIST_BENCH_FRAMES; n++) {
+				lv_obj_scroll_by_bounded(obj, 0,
+					-VLIST_BENCH_STEP, LV_ANIM_OFF);
+				t0 = bench_now_us();
+				lv_refr_now(disp);
+				bench_frames_add(&frames, bench_now_us() - t0);
+			}
+
+			lv_snprintf(label, sizeof(label), "%s %u",
+				    vlist_bench_names[kind], counts[i]);
+			printf("%-24s create %9.3f ms  heap %6zu B  rows %u%s\n",
+			       label, create_us / 1000.0, heap, filled,
+			       filled < counts[i] ? " (heap exhausted)" : "");
+			bench_frames_print("", &frames);
+			if (kind == BENCH_VLIST) {
+				vlist_get_stats(obj, &stats);
+				printf("%-24s pool %u rows, %llu binds\n", "",
+				       stats.pool,
+				       (unsigned long long)stats.binds);
+			}
+
+			lv_obj_delete(obj);
+		}
+	}
+
+	bench_display_delete(disp);
+
+	return 0;
+}
@@ -0,0 +1,45 @@
+/*
+ * Virtualized list/table for large datasets
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef VLIST_H
+#define VLIST_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+#define VLIST_CELL_MAX 64
+
+/* Fill buf (size bytes, pre-cleared) with the text of one cell */
+typedef void (*vlist_cell_cb_t)(void *ctx, uint32_t row, uint32_t col,
+				char *buf, size_t size);
+
+struct vlist_stats {
+	uint32_t pool;		// row objects alive
+	uint64_t binds;		// rows (re)materialized
+};
+
+/*
+ * cols == 1 gives a list, more gives a table. Rows are row_height pixels
+ * high; row objects bubble their events to the returned container, and
+ * vlist_get_row() maps an event target back to its data row.
+ */
+lv_obj_t *vlist_create(lv_obj_t *parent, uint32_t cols, int32_t row_height,
+		       vlist_cell_cb_t cell_cb, void *ctx);
+void vlist_set_row_count(lv_obj_t *obj, uint32_t rows);
+void vlist_set_col_width(lv_obj_t *obj, uint32_t col, int32_t width);
+void vlist_refresh(lv_obj_t *obj);
+void vlist_scroll_to_row(lv_obj_t *obj, uint32_t row, lv_anim_enable_t anim);
+int32_t vlist_get_row(lv_obj_t *row_obj);
+void vlist_get_stats(lv_obj_t *obj, struct vlist_stats *stats);
+
+int vlist_bench(void);
+
+#endif /* VLIST_H */
@@ -0,0 +1,679 @@
+/*
+ * Vertical scroll acceleration
+ *
+ * Scrolling an lv_list or lv_tileview invalidates the whole object, so every
+ * scroll step redraws and retransmits the full viewport. For objects attached
+ * here, the rows that are already on the panel are moved instead (ILI9341
+ * VSCRSADD, or a row copy in the DRM framebuffer) and only the newly exposed
+ * strip is drawn.
+ *
+ * The scroll step is picked up from LV_EVENT_SCROLL, and the invalidation
+ * LVGL issues right after it is shrunk to the exposed strip in the display's
+ * LV_EVENT_INVALIDATE_AREA. Anything else invalidated inside the viewport in
+ * the same frame is invalidated again at its shifted position when the frame
+ * starts. Whatever cannot be handled (horizontal scrolling, two objects at
+ * once, steps larger than the viewport, a panel that refuses) falls back to
+ * the normal full redraw.
+ *
+ * The attached object must not be overlapped by other objects, because the
+ * moved rows would carry them along.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "lvgl/src/display/lv_display_private.h"
+#include "lvgl/src/misc/lv_ll.h"
+
+#include "bench.h"
+#include "ili9341.h"
+#include "vscroll.h"
+
+#define VSCROLL_MAX_RECORDS	16
+#define VSCROLL_MAX_BANDS	8
+#define VSCROLL_MIN_ROWS	8
+
+struct vscroll_obj {
+	int32_t scroll_x;
+	int32_t scroll_y;
+};
+
+struct vscroll_record {
+	lv_area_t area;
+	int32_t dy;	// scroll already applied when it was invalidated
+};
+
+static struct {
+	lv_display_t *disp;
+	const struct vscroll_panel *panel;
+	lv_obj_t *obj;
+	lv_area_t region;
+	int32_t dy;
+	bool expect;
+	bool cancel;
+	bool guard;
+	bool in_refr;
+	bool shift_ready;
+	bool shifted;
+	lv_area_t shift_region;
+	int32_t shift_dy;
+	struct vscroll_record rec[VSCROLL_MAX_RECORDS];
+	uint32_t rec_cnt;
+	lv_area_t band[VSCROLL_MAX_BANDS];
+	uint32_t band_cnt;
+	struct vscroll_stats stats;
+} vs;
+
+static bool get_region(lv_obj_t *obj, lv_area_t *region)
+{
+	lv_area_t screen = {
+		0, 0,
+		lv_display_get_horizontal_resolution(vs.disp) - 1,
+		lv_display_get_vertical_resolution(vs.disp) - 1,
+	};
+	int32_t inset;
+
+	// Keep borders and rounded corners out of the moved rows
+	inset = LV_MAX(lv_obj_get_style_border_width(obj, LV_PART_MAIN),
+		       lv_obj_get_style_radius(obj, LV_PART_MAIN));
+	lv_obj_get_coords(obj, region);
+	region->y1 += inset;
+	region->y2 -= inset;
+
+	if (!lv_area_intersect(region, region, &screen)) {
+		return false;
+	}
+	if (vs.panel->full_width &&
+	    (region->x1 != screen.x1 || region->x2 != screen.x2)) {
+		return false;
+	}
+
+	return lv_area_get_height(region) >= VSCROLL_MIN_ROWS;
+}
+
+static void add_band(int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+	if (x1 > x2 || y1 > y2) {
+		return;
+	}
+	if (vs.band_cnt == VSCROLL_MAX_BANDS) {
+		vs.cancel = true;
+		return;
+	}
+	vs.band[vs.band_cnt++] = (lv_area_t){ x1, y1, x2, y2 };
+}
+
+/* Replace the object's own invalidation with the rows scrolled into view */
+static bool shrink(lv_area_t *area)
+{
+	const lv_area_t *r = &vs.region;
+
+	if (LV_ABS(vs.dy) >= lv_area_get_height(r)) {
+		return false;
+	}
+
+	add_band(area->x1, area->y1, area->x2, r->y1 - 1);
+	add_band(area->x1, r->y2 + 1, area->x2, area->y2);
+	add_band(area->x1, r->y1, r->x1 - 1, r->y2);
+	add_band(r->x2 + 1, r->y1, area->x2, r->y2);
+
+	*area = *r;
+	if (vs.dy < 0) {
+		area->y1 = r->y2 + vs.dy + 1;
+	} else {
+		area->y2 = r->y1 + vs.dy - 1;
+	}
+
+	return true;
+}
+
+static void scroll_event_cb(lv_event_t *e)
+{
+	lv_obj_t *obj = lv_event_get_current_target_obj(e);
+	struct vscroll_obj *vo = lv_event_get_user_data(e);
+	int32_t x;
+	int32_t y;
+	int32_t step;
+
+	if (lv_event_get_code(e) == LV_EVENT_DELETE) {
+		if (vs.obj == obj) {
+			vs.obj = NULL;
+			vs.expect = false;
+			vs.cancel = false;
+		}
+		free(vo);
+		return;
+	}
+
+	x = lv_obj_get_scroll_x(obj);
+	y = lv_obj_get_scroll_y(obj);
+	step = vo->scroll_y - y;
+	if (x != vo->scroll_x) {
+		vs.cancel = true;
+	}
+	vo->scroll_x = x;
+	vo->scroll_y = y;
+
+	// Scrolls from the layout pass of a running refresh are drawn in full
+	if (!step || vs.cancel || vs.in_refr) {
+		return;
+	}
+	if (vs.obj && vs.obj != obj) {
+		vs.cancel = true;
+		return;
+	}
+	if (!vs.obj) {
+		vs.obj = obj;
+		vs.dy = 0;
+		if (!get_region(obj, &vs.region)) {
+			vs.cancel = true;
+			return;
+		}
+	}
+	if (vs.expect) {
+		vs.cancel = true;
+		return;
+	}
+
+	vs.dy += step;
+	vs.expect = true;
+}
+
+static void frame_start(void)
+{
+	lv_area_t hor;
+	lv_area_t ver;
+	lv_area_t a;
+	uint32_t i;
+	int ret;
+
+	if (vs.expect) {
+		vs.cancel = true;
+	}
+	if (!vs.cancel && vs.dy) {
+		ret = vs.panel->begin(vs.panel->ctx, vs.disp, &vs.region);
+		if (ret) {
+			vs.cancel = true;
+		}
+		if (ret > 0) {
+			vs.guard = true;
+			lv_obj_invalidate(lv_display_get_screen_active(vs.disp));
+			vs.guard = false;
+		}
+	}
+
+	vs.guard = true;
+	if (vs.cancel) {
+		lv_obj_invalidate(vs.obj);
+		vs.stats.fallbacks++;
+	} else if (vs.dy) {
+		for (i = 0; i < vs.band_cnt; i++) {
+			lv_inv_area(vs.disp, &vs.band[i]);
+		}
+		lv_obj_get_scrollbar_area(vs.obj, &hor, &ver);
+		if (lv_area_get_width(&ver) > 0) {
+			a = (lv_area_t){ ver.x1, vs.region.y1, ver.x2, vs.region.y2 };
+			lv_inv_area(vs.disp, &a);
+		}
+		for (i = 0; i < vs.rec_cnt; i++) {
+			a = vs.rec[i].area;
+			lv_area_move(&a, 0, vs.dy - vs.rec[i].dy);
+			if (lv_area_intersect(&a, &a, &vs.region)) {
+				lv_inv_area(vs.disp, &a);
+			}
+		}
+		vs.shift_region = vs.region;
+		vs.shift_dy = vs.dy;
+		vs.shift_ready = true;
+	}
+	vs.guard = false;
+}
+
+static void display_event_cb(lv_event_t *e)
+{
+	lv_area_t *area;
+
+	switch (lv_event_get_code(e)) {
+	case LV_EVENT_INVALIDATE_AREA:
+		area = lv_event_get_param(e);
+		if (vs.guard) {
+			break;
+		}
+		if (vs.expect && !vs.cancel &&
+		    lv_area_is_in(&vs.region, area, 0)) {
+			vs.expect = false;
+			if (!shrink(area)) {
+				vs.cancel = true;
+			}
+			break;
+		}
+		if (vs.rec_cnt < VSCROLL_MAX_RECORDS) {
+			vs.rec[vs.rec_cnt].area = *area;
+			vs.rec[vs.rec_cnt].dy = vs.dy;
+			vs.rec_cnt++;
+		} else if (vs.obj) {
+			vs.cancel = true;
+		}
+		break;
+	case LV_EVENT_REFR_START:
+		if (vs.obj) {
+			frame_start();
+		}
+		vs.obj = NULL;
+		vs.dy = 0;
+		vs.expect = false;
+		vs.cancel = false;
+		vs.band_cnt = 0;
+		vs.rec_cnt = 0;
+		vs.in_refr = true;
+		break;
+	case LV_EVENT_RENDER_START:
+		if (vs.shift_ready) {
+			vs.panel->shift(vs.panel->ctx, vs.disp, &vs.shift_region,
+					vs.shift_dy);
+			vs.stats.frames++;
+			vs.stats.rows_shifted += lv_area_get_height(&vs.shift_region) -
+						 LV_ABS(vs.shift_dy);
+			vs.shift_ready = false;
+			vs.shifted = true;
+		}
+		break;
+	case LV_EVENT_REFR_READY:
+		vs.in_refr = false;
+		if (vs.shifted) {
+			vs.panel->commit(vs.panel->ctx, vs.disp, &vs.shift_region);
+			vs.shifted = false;
+		}
+		vs.shift_ready = false;
+		break;
+	default:
+		break;
+	}
+}
+
+void vscroll_init(lv_display_t *disp, const struct vscroll_panel *panel)
+{
+	memset(&vs, 0, sizeof(vs));
+	vs.disp = disp;
+	vs.panel = panel;
+
+	lv_display_add_event_cb(disp, display_event_cb, LV_EVENT_ALL, NULL);
+}
+
+void vscroll_attach(lv_obj_t *obj)
+{
+	struct vscroll_obj *vo;
+
+	vo = calloc(1, sizeof(*vo));
+	if (!vo) {
+		return;
+	}
+	vo->scroll_x = lv_obj_get_scroll_x(obj);
+	vo->scroll_y = lv_obj_get_scroll_y(obj);
+
+	lv_obj_add_event_cb(obj, scroll_event_cb, LV_EVENT_SCROLL, vo);
+	lv_obj_add_event_cb(obj, scroll_event_cb, LV_EVENT_DELETE, vo);
+}
+
+void vscroll_get_stats(struct vscroll_stats *stats)
+{
+	*stats = vs.stats;
+}
+
+/*
+ * DRM backend: LVGL draws straight into the dumb buffers (direct mode). The
+ * rows are copied from the buffer on screen into the one being drawn, so the
+ * result is the same with one or two buffers. With two, the moved region is
+ * also queued for LVGL's buffer sync, because LVGL itself only syncs the
+ * areas it rendered.
+ */
+static int drm_begin(void *ctx, lv_display_t *disp, const lv_area_t *region)
+{
+	LV_UNUSED(ctx);
+	LV_UNUSED(region);
+
+	if (disp->render_mode != LV_DISPLAY_RENDER_MODE_DIRECT ||
+	    lv_display_get_rotation(disp) != LV_DISPLAY_ROTATION_0) {
+		return -1;
+	}
+
+	return 0;
+}
+
+static void drm_shift(void *ctx, lv_display_t *disp, const lv_area_t *r,
+		      int32_t dy)
+{
+	lv_draw_buf_t *dst = disp->buf_act;
+	lv_draw_buf_t *src = dst;
+	uint32_t stride = dst->header.stride;
+	uint32_t px_size = lv_color_format_get_size(dst->header.cf);
+	size_t ofs = r->x1 * px_size;
+	size_t len = lv_area_get_width(r) * px_size;
+	int32_t y;
+
+	LV_UNUSED(ctx);
+
+	if (disp->buf_2) {
+		src = dst == disp->buf_1 ? disp->buf_2 : disp->buf_1;
+	}
+
+	if (dy < 0) {
+		for (y = r->y1; y <= r->y2 + dy; y++) {
+			memmove(dst->data + y * stride + ofs,
+				src->data + (y - dy) * stride + ofs, len);
+		}
+	} else {
+		for (y = r->y2; y >= r->y1 + dy; y--) {
+			memmove(dst->data + y * stride + ofs,
+				src->data + (y - dy) * stride + ofs, len);
+		}
+	}
+}
+
+static void drm_commit(void *ctx, lv_display_t *disp, const lv_area_t *region)
+{
+	lv_area_t *sync;
+
+	LV_UNUSED(ctx);
+
+	if (!disp->buf_2) {
+		return;
+	}
+	sync = lv_ll_ins_tail(&disp->sync_areas);
+	if (sync) {
+		*sync = *region;
+	}
+}
+
+const struct vscroll_panel vscroll_drm_panel = {
+	.full_width = false,
+	.begin = drm_begin,
+	.shift = drm_shift,
+	.commit = drm_commit,
+};
+
+/*
+ * ILI9341 backend: the region becomes the panel's vertical scroll area
+ * (VSCRDEF), the shift only moves the start address (VSCRSADD) and the flush
+ * path writes through ili9341_write(), which maps rows into GRAM.
+ */
+static int ili9341_begin(void *ctx, lv_display_t *disp,
+			 const lv_area_t *region)
+{
+	struct ili9341 *lcd = ctx;
+
+	if (lv_display_get_rotation(disp) != LV_DISPLAY_ROTATION_0 ||
+	    lcd->rotation != LV_DISPLAY_ROTATION_0) {
+		return -1;
+	}
+	if (lcd->tfa != region->y1 || lcd->vsa != lv_area_get_height(region)) {
+		ili9341_set_scroll_area(lcd, region->y1,
+					lv_area_get_height(region));
+		return 1;
+	}
+
+	return 0;
+}
+
+static void ili9341_shift(void *ctx, lv_display_t *disp,
+			  const lv_area_t *region, int32_t dy)
+{
+	LV_UNUSED(disp);
+	LV_UNUSED(region);
+
+	ili9341_scroll(ctx, dy);
+}
+
+static void ili9341_done(void *ctx, lv_display_t *disp,
+			 const lv_area_t *region)
+{
+	LV_UNUSED(disp);
+	LV_UNUSED(region);
+
+	ili9341_commit(ctx);
+}
+
+void vscroll_ili9341_panel(struct vscroll_panel *panel, struct ili9341 *lcd)
+{
+	panel->full_width = true;
+	panel->begin = ili9341_begin;
+	panel->shift = ili9341_shift;
+	panel->commit = ili9341_done;
+	panel->ctx = lcd;
+}
+
+/*
+ * Validation: a mock ILI9341 decodes the command stream into its own GRAM and
+ * scroll registers. The same list is scrolled on it (accelerated) and on a
+ * plain headless display (full redraw); after every frame what the mock
+ * panel would show must match the reference framebuffer exactly.
+ */
+struct mock_panel {
+	struct ili9341 lcd;
+	uint8_t *gram;
+	uint32_t px_size;
+	uint16_t col[2];
+	uint16_t page[2];
+	uint16_t tfa;
+	uint16_t vsa;
+	uint16_t vsp;
+	uint32_t cmds;
+	uint64_t bytes;
+	uint64_t pixels;
+};
+
+static void mock_send(void *ctx, uint8_t cmd, const uint8_t *param,
+		      size_t len)
+{
+	struct mock_panel *m = ctx;
+	uint32_t x;
+	uint32_t y;
+	size_t i;
+
+	m->cmds++;
+	m->bytes += 1 + len;
+
+	switch (cmd) {
+	case ILI9341_CASET:
+		m->col[0] = param[0] << 8 | param[1];
+		m->col[1] = param[2] << 8 | param[3];
+		break;
+	case ILI9341_PASET:
+		m->page[0] = param[0] << 8 | param[1];
+		m->page[1] = param[2] << 8 | param[3];
+		break;
+	case ILI9341_RAMWR:
+		x = m->col[0];
+		y = m->page[0];
+		for (i = 0; i + m->px_size <= len; i += m->px_size) {
+			memcpy(m->gram + (y * BENCH_HOR_RES + x) * m->px_size,
+			       param + i, m->px_size);
+			if (++x > m->col[1]) {
+				x = m->col[0];
+				if (++y > m->page[1]) {
+					y = m->page[0];
+				}
+			}
+		}
+		m->pixels += len / m->px_size;
+		break;
+	case ILI9341_VSCRDEF:
+		m->tfa = param[0] << 8 | param[1];
+		m->vsa = param[2] << 8 | param[3];
+		break;
+	case ILI9341_VSCRSADD:
+		m->vsp = param[0] << 8 | param[1];
+		break;
+	default:
+		break;
+	}
+}
+
+static const uint8_t *mock_row(const struct mock_panel *m, uint32_t row)
+{
+	if (row >= m->tfa && row < (uint32_t)m->tfa + m->vsa) {
+		row = m->tfa + (m->vsp - m->tfa + row - m->tfa) % m->vsa;
+	}
+
+	return m->gram + row * BENCH_HOR_RES * m->px_size;
+}
+
+static void mock_flush_cb(lv_display_t *disp, const lv_area_t *area,
+			  uint8_t *px_map)
+{
+	struct mock_panel *m = lv_display_get_user_data(disp);
+	uint32_t stride = lv_draw_buf_width_to_stride(lv_area_get_width(area),
+				lv_display_get_color_format(disp));
+
+	ili9341_write(&m->lcd, area, px_map, stride);
+	lv_display_flush_ready(disp);
+}
+
+static lv_obj_t *vscroll_bench_screen(lv_obj_t *scr)
+{
+	lv_obj_t *label;
+	lv_obj_t *list;
+	char text[16];
+	int i;
+
+	label = lv_label_create(scr);
+	lv_label_set_text(label, "Header");
+	lv_obj_align(label, LV_ALIGN_TOP_MID, 0, 2);
+
+	list = lv_list_create(scr);
+	lv_obj_set_size(list, BENCH_HOR_RES, 200);
+	lv_obj_set_pos(list, 0, 20);
+	for (i = 0; i < 80; i++) {
+		lv_snprintf(text, sizeof(text), "Item %d", i);
+		lv_list_add_button(list, NULL, text);
+	}
+
+	return list;
+}
+
+static const int32_t vscroll_bench_steps[] = {
+	-1, -2, -3, -5, -8, -13, -21, -34, -4, -4, -4, -4, 7, 11, -60, 3,
+	-150, 2, 9, -17, 40, 1, -1, 25, -25, -90, 100, -6, -6, -6,
+};
+
+int vscroll_bench(void)
+{
+	static struct mock_panel mock;
+	struct vscroll_panel panel;
+	struct vscroll_stats stats;
+	struct bench_frames ref_frames;
+	struct bench_frames acc_frames;
+	lv_display_t *ref;
+	lv_display_t *acc;
+	lv_obj_t *ref_list;
+	lv_obj_t *acc_list;
+	uint8_t *ref_fb;
+	uint8_t *buf;
+	uint32_t ref_stride;
+	uint32_t buf_size;
+	uint32_t bad_frames = 0;
+	uint64_t bad_px = 0;
+	uint64_t frame_bad;
+	uint64_t ref_px;
+	uint64_t t0;
+	size_t n;
+	uint32_t x;
+	uint32_t y;
+	int round;
+
+	ref = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!ref) {
+		return -1;
+	}
+	ref_list = vscroll_bench_screen(lv_display_get_screen_active(ref));
+	ref_fb = bench_display_framebuffer(ref, &ref_stride);
+
+	acc = lv_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	mock.px_size = lv_color_format_get_size(lv_display_get_color_format(acc));
+	mock.gram = calloc(BENCH_VER_RES, BENCH_HOR_RES * mock.px_size);
+	buf_size = ref_stride * 40;
+	buf = aligned_alloc(64, buf_size);
+	if (!mock.gram || !buf) {
+		return -1;
+	}
+	ili9341_init(&mock.lcd, BENCH_HOR_RES, BENCH_VER_RES, mock.px_size,
+		     mock_send, &mock);
+	mock.vsa = BENCH_VER_RES;
+	lv_display_set_user_data(acc, &mock);
+	lv_display_set_flush_cb(acc, mock_flush_cb);
+	lv_display_set_buffers(acc, buf, NULL, buf_size,
+			       LV_DISPLAY_RENDER_MODE_PARTIAL);
+	acc_list = vscroll_bench_screen(lv_display_get_screen_active(acc));
+
+	vscroll_ili9341_panel(&panel, &mock.lcd);
+	vscroll_init(acc, &panel);
+	vscroll_attach(acc_list);
+
+	lv_refr_now(ref);
+	lv_refr_now(acc);
+	ref_px = bench_display_flushed_px(ref);
+	mock.pixels = 0;
+	mock.cmds = 0;
+
+	bench_frames_reset(&ref_frames);
+	bench_frames_reset(&acc_frames);
+	for (round = 0; round < 4; round++) {
+		for (n = 0; n < sizeof(vscroll_bench_steps) /
+				sizeof(vscroll_bench_steps[0]); n++) {
+			lv_obj_scroll_by_bounded(ref_list, 0,
+				vscroll_bench_steps[n], LV_ANIM_OFF);
+			lv_obj_scroll_by_bounded(acc_list, 0,
+				vscroll_bench_steps[n], LV_ANIM_OFF);
+
+			t0 = bench_now_us();
+			lv_refr_now(ref);
+			bench_frames_add(&ref_frames, bench_now_us() - t0);
+			t0 = bench_now_us();
+			lv_refr_now(acc);
+			bench_frames_add(&acc_frames, bench_now_us() - t0);
+
+			frame_bad = 0;
+			for (y = 0; y < BENCH_VER_RES; y++) {
+				const uint8_t *a = mock_row(&mock, y);
+				const uint8_t *b = ref_fb + y * ref_stride;
+
+				for (x = 0; x < BENCH_HOR_RES; x++) {
+					if (memcmp(a + x * mock.px_size,
+						   b + x * mock.px_size,
+						   mock.px_size)) {
+						frame_bad++;
+					}
+				}
+			}
+			if (frame_bad && !bad_frames++) {
+				printf("first mismatch at step %zu of round %d\n",
+				       n, round);
+			}
+			bad_px += frame_bad;
+		}
+	}
+	vscroll_get_stats(&stats);
+
+	bench_frames_print("full redraw", &ref_frames);
+	bench_frames_print("hardware scroll", &acc_frames);
+	printf("pixels sent: full redraw %llu, hardware scroll %llu (%u commands)\n",
+	       (unsigned long long)(bench_display_flushed_px(ref) - ref_px),
+	       (unsigned long long)mock.pixels, mock.cmds);
+	printf("shifted frames %u, fallbacks %u, rows reused %llu\n",
+	       stats.frames, stats.fallbacks,
+	       (unsigned long long)stats.rows_shifted);
+	printf("mismatching frames %u, pixels %llu\n", bad_frames,
+	       (unsigned long long)bad_px);
+
+	lv_display_delete(acc);
+	free(buf);
+	free(mock.gram);
+	bench_display_delete(ref);
+
+	return bad_px ? -1 : 0;
+}
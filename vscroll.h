@@ -0,0 +1,52 @@
+/*
+ * Vertical scroll acceleration
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef VSCROLL_H
+#define VSCROLL_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "lvgl/lvgl.h"
+
+struct ili9341;
+
+/*
+ * A panel backend moves rows that are already on the panel. begin() is asked
+ * before the first shift of a region and may refuse (< 0), or ask for a full
+ * redraw first (> 0) when the panel had to be reconfigured. shift() runs at
+ * LV_EVENT_RENDER_START, before the exposed strip is drawn; commit() runs at
+ * LV_EVENT_REFR_READY, after it has been flushed.
+ */
+struct vscroll_panel {
+	bool full_width;	// only whole panel rows can be moved
+	int (*begin)(void *ctx, lv_display_t *disp, const lv_area_t *region);
+	void (*shift)(void *ctx, lv_display_t *disp, const lv_area_t *region,
+		      int32_t dy);
+	void (*commit)(void *ctx, lv_display_t *disp, const lv_area_t *region);
+	void *ctx;
+};
+
+struct vscroll_stats {
+	uint32_t frames;	// frames drawn with a shift
+	uint32_t fallbacks;	// scrolls redrawn in full
+	uint64_t rows_shifted;
+};
+
+extern const struct vscroll_panel vscroll_drm_panel;
+
+void vscroll_ili9341_panel(struct vscroll_panel *panel, struct ili9341 *lcd);
+
+void vscroll_init(lv_display_t *disp, const struct vscroll_panel *panel);
+void vscroll_attach(lv_obj_t *obj);
+void vscroll_get_stats(struct vscroll_stats *stats);
+
+int vscroll_bench(void);
+
+#endif /* VSCROLL_H */
@@ -0,0 +1,444 @@
+/*
+ * Vertical blank paced presentation and frame pacing statistics
+ *
+ * The display refresh timer renders whenever it expires, with no relation
+ * to the panel's refresh: frames land at uneven points of the scan-out,
+ * two may reach the same vblank (one is never seen) and the next gap is
+ * then twice as long. The DRM driver commits each frame with a page flip
+ * and waits for the previous flip first, but nothing decides when to start
+ * rendering.
+ *
+ * Here a thread waits for vertical blank completions, from DRM vblank
+ * events requested on a descriptor of its own (the driver's descriptor,
+ * and with it the flip events, is private to LVGL) or from a fake source
+ * ticking at a given rate. A frame counts as presented at the first vblank
+ * after its REFR_READY. Kept are present-to-present intervals, in time and
+ * in vblanks, frames that missed the vblank after the one they started in,
+ * and frames replaced before they could be shown.
+ *
+ * With pacing the same thread renders, under lv_lock(), right after a
+ * vblank when something is invalid or animating and no frame is queued, so
+ * at most one frame waits for the flip. It inherits the scheduling of the
+ * thread that starts it. Each DRM vblank event is requested after the last
+ * one arrived; if that request fails, the refresh timer gets its period back
+ * and renders until a retry, once per poll timeout, succeeds.
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/timerfd.h>
+
+#include <xf86drm.h>
+
+#include "lvgl/src/display/lv_display_private.h"
+#include "lvgl/src/misc/lv_timer_private.h"
+
+#include "bench.h"
+#include "vsync.h"
+
+#define VSYNC_POLL_MS		100
+#define VSYNC_IDLE_VBLANKS	8	// longer gaps are idle, not pacing
+
+static struct {
+	lv_display_t *disp;
+	struct vsync_source *src;
+	bool pace;
+	atomic_bool run;
+	pthread_t thread;
+	uint32_t refr_period;
+	bool rendering;
+	bool queued;		// rendered, waiting for a vblank
+	uint32_t frame_seq;	// vblank before RENDER_START
+	uint32_t start_seq;	// ... of the queued frame
+	uint64_t ready_us;
+	uint32_t last_seq;	// last present
+	uint64_t last_us;
+	struct vsync_stats stats;
+} vs;
+
+static void vblank_handler(int fd, unsigned int seq, unsigned int sec,
+			   unsigned int usec, void *data)
+{
+	struct vsync_source *src = data;
+
+	src->seq = seq;
+	src->us = (uint64_t)sec * 1000000 + usec;
+	src->got = true;
+}
+
+static int drm_arm(struct vsync_source *src)
+{
+	drmVBlank vbl;
+
+	memset(&vbl, 0, sizeof(vbl));
+	vbl.request.type = DRM_VBLANK_RELATIVE | DRM_VBLANK_EVENT;
+	if (src->crtc == 1) {
+		vbl.request.type |= DRM_VBLANK_SECONDARY;
+	} else if (src->crtc > 1) {
+		vbl.request.type |= (src->crtc << DRM_VBLANK_HIGH_CRTC_SHIFT) &
+				    DRM_VBLANK_HIGH_CRTC_MASK;
+	}
+	vbl.request.sequence = 1;
+	vbl.request.signal = (unsigned long)src;
+
+	src->armed = !drmWaitVBlank(src->fd, &vbl);
+
+	return src->armed ? 0 : -errno;
+}
+
+int vsync_source_open_drm(struct vsync_source *src, const char *device,
+			  uint32_t crtc)
+{
+	int ret;
+
+	memset(src, 0, sizeof(*src));
+	src->crtc = crtc;
+	src->fd = open(device, O_RDWR | O_CLOEXEC);
+	if (src->fd < 0) {
+		fprintf(stderr, "vsync: %s: %s\n", device, strerror(errno));
+		return -errno;
+	}
+	ret = drm_arm(src);
+	if (ret) {
+		fprintf(stderr, "vsync: %s: vblank events: %s\n", device,
+			strerror(-ret));
+		close(src->fd);
+		src->fd = -1;
+	}
+
+	return ret;
+}
+
+int vsync_source_open_fake(struct vsync_source *src, uint32_t hz)
+{
+	struct itimerspec its;
+	struct timespec now;
+	uint64_t period;
+
+	memset(src, 0, sizeof(*src));
+	if (!hz) {
+		return -EINVAL;
+	}
+	src->hz = hz;
+	src->fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (src->fd < 0) {
+		return -errno;
+	}
+	period = 1000000000ULL / hz;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	src->t0_ns = (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+	its.it_interval.tv_sec = period / 1000000000;
+	its.it_interval.tv_nsec = period % 1000000000;
+	its.it_value.tv_sec = (src->t0_ns + period) / 1000000000;
+	its.it_value.tv_nsec = (src->t0_ns + period) % 1000000000;
+	if (timerfd_settime(src->fd, TFD_TIMER_ABSTIME, &its, NULL)) {
+		close(src->fd);
+		src->fd = -1;
+		return -errno;
+	}
+	src->armed = true;
+
+	return 0;
+}
+
+int vsync_source_read(struct vsync_source *src)
+{
+	drmEventContext ev = {
+		.version = 2,
+		.vblank_handler = vblank_handler,
+	};
+	uint32_t seq = src->seq;
+	uint64_t n;
+
+	if (src->hz) {
+		if (read(src->fd, &n, sizeof(n)) != sizeof(n)) {
+			return 0;
+		}
+		src->seq += n;
+		src->us = (src->t0_ns + src->seq * (1000000000ULL / src->hz)) /
+			  1000;
+		return n;
+	}
+
+	src->got = false;
+	drmHandleEvent(src->fd, &ev);
+	if (!src->got) {
+		return 0;
+	}
+	// On failure src->armed stays false and the caller retries
+	drm_arm(src);
+
+	return seq ? src->seq - seq : 1;
+}
+
+void vsync_source_close(struct vsync_source *src)
+{
+	if (src->fd >= 0) {
+		close(src->fd);
+	}
+	src->fd = -1;
+}
+
+static void present(void)
+{
+	uint32_t vblanks = vs.src->seq - vs.last_seq;
+	uint32_t us = vs.src->us - vs.last_us;
+
+	if (vs.last_us && vblanks && vblanks <= VSYNC_IDLE_VBLANKS) {
+		vs.stats.hist[LV_MIN(vblanks, VSYNC_HIST) - 1]++;
+		vs.stats.interval_us += us;
+		vs.stats.interval_min_us = vs.stats.interval_min_us ?
+					   LV_MIN(vs.stats.interval_min_us, us) :
+					   us;
+		vs.stats.interval_max_us = LV_MAX(vs.stats.interval_max_us, us);
+	}
+	vs.stats.frames++;
+	vs.stats.missed += vs.src->seq - vs.start_seq > 1;
+	vs.last_seq = vs.src->seq;
+	vs.last_us = vs.src->us;
+	vs.queued = false;
+}
+
+/* Paced: the refresh timer is parked while vblanks wake this thread */
+static void park_timer(bool park)
+{
+	lv_timer_t *timer = lv_display_get_refr_timer(vs.disp);
+
+	if (vs.pace && timer) {
+		lv_timer_set_period(timer, park ? UINT32_MAX : vs.refr_period);
+	}
+}
+
+static void *vsync_thread(void *arg)
+{
+	struct pollfd pfd = { .fd = vs.src->fd, .events = POLLIN };
+	int n;
+
+	while (atomic_load(&vs.run)) {
+		if (!vs.src->armed && !drm_arm(vs.src)) {
+			lv_lock();
+			park_timer(true);
+			lv_unlock();
+		}
+		if (poll(&pfd, 1, VSYNC_POLL_MS) <= 0) {
+			continue;
+		}
+		lv_lock();
+		n = vsync_source_read(vs.src);
+		if (!vs.src->armed) {
+			vs.stats.arm_failures++;
+			park_timer(false);
+		}
+		if (n > 0) {
+			vs.stats.vblanks += n;
+			if (vs.queued && vs.ready_us <= vs.src->us) {
+				present();
+			}
+			if (vs.pace && !vs.queued &&
+			    (vs.disp->inv_p || lv_anim_count_running())) {
+				lv_refr_now(vs.disp);
+			}
+		}
+		lv_unlock();
+	}
+
+	return NULL;
+}
+
+static void vsync_event_cb(lv_event_t *e)
+{
+	switch (lv_event_get_code(e)) {
+	case LV_EVENT_RENDER_START:
+		if (!vs.rendering) {
+			vs.rendering = true;
+			vs.frame_seq = vs.src->seq;
+		}
+		break;
+	case LV_EVENT_REFR_READY:
+		if (!vs.rendering) {
+			break;
+		}
+		vs.rendering = false;
+		vs.stats.dropped += vs.queued;
+		vs.queued = true;
+		vs.start_seq = vs.frame_seq;
+		vs.ready_us = bench_now_us();
+		break;
+	default:
+		break;
+	}
+}
+
+int vsync_start(lv_display_t *disp, struct vsync_source *src, bool pace)
+{
+	lv_timer_t *timer = lv_display_get_refr_timer(disp);
+	int ret;
+
+	if (vs.disp || src->fd < 0) {
+		return -1;
+	}
+	memset(&vs.stats, 0, sizeof(vs.stats));
+	vs.disp = disp;
+	vs.src = src;
+	vs.pace = pace;
+	vs.rendering = false;
+	vs.queued = false;
+	vs.last_us = 0;
+	lv_display_add_event_cb(disp, vsync_event_cb, LV_EVENT_ALL, NULL);
+	if (pace && timer) {
+		// Still resumed by invalidations, but never due
+		vs.refr_period = timer->period;
+		park_timer(true);
+	}
+
+	atomic_store(&vs.run, true);
+	ret = pthread_create(&vs.thread, NULL, vsync_thread, NULL);
+	if (ret) {
+		atomic_store(&vs.run, false);
+		vsync_stop();
+		return -ret;
+	}
+
+	return 0;
+}
+
+void vsync_stop(void)
+{
+	if (atomic_exchange(&vs.run, false)) {
+		pthread_join(vs.thread, NULL);
+	} else if (!vs.disp) {
+		return;
+	}
+	lv_display_remove_event_cb_with_user_data(vs.disp, vsync_event_cb,
+						  NULL);
+	park_timer(false);
+	vs.disp = NULL;
+}
+
+void vsync_get_stats(struct vsync_stats *stats)
+{
+	lv_lock();
+	*stats = vs.stats;
+	lv_unlock();
+}
+
+void vsync_reset(void)
+{
+	lv_lock();
+	memset(&vs.stats, 0, sizeof(vs.stats));
+	vs.last_us = 0;
+	lv_unlock();
+}
+
+static void print_stats(FILE *fp, const char *label,
+			const struct vsync_stats *st, double secs)
+{
+	uint32_t n = 0;
+	int i;
+
+	for (i = 0; i < VSYNC_HIST; i++) {
+		n += st->hist[i];
+	}
+	fprintf(fp, "%-24s %6.1f fps, interval %5.1f/%5.1f/%5.1f ms, "
+		"%u missed, %u dropped\n", label,
+		secs > 0 ? st->frames / secs : 0.0,
+		st->interval_min_us / 1000.0,
+		n ? st->interval_us / 1000.0 / n : 0.0,
+		st->interval_max_us / 1000.0, st->missed, st->dropped);
+	fprintf(fp, "  vblanks between presents: 1: %u, 2: %u, 3: %u, 4+: %u\n",
+		st->hist[0], st->hist[1], st->hist[2], st->hist[3]);
+	if (st->arm_failures) {
+		fprintf(fp, "  %u vblank requests failed, refresh timer "
+			"resumed\n", st->arm_failures);
+	}
+}
+
+void vsync_report(FILE *fp)
+{
+	struct vsync_stats st;
+
+	vsync_get_stats(&st);
+	print_stats(fp, "vsync:", &st, 0);
+}
+
+/*
+ * Benchmark: a panel sliding back and forth over a label, against a fake
+ * 60 Hz source, with the main.c loop (lv_timer_handler(), then sleep until
+ * the next timer). The refresh timer at 33 and 16 ms is compared with
+ * vblank pacing; min/mean/max present intervals and how many vblanks each
+ * one spans show the bunching.
+ */
+#define VSYNC_BENCH_HZ		60
+#define VSYNC_BENCH_MS		2000
+
+static int bench_pass(const char *label, uint32_t refr_ms, bool pace)
+{
+	struct vsync_source src;
+	struct vsync_stats st;
+	lv_display_t *disp;
+	lv_obj_t *scr;
+	lv_obj_t *obj;
+	lv_anim_t a;
+	uint64_t t0;
+	uint32_t idle;
+
+	disp = bench_display_create(BENCH_HOR_RES, BENCH_VER_RES);
+	if (!disp) {
+		return -1;
+	}
+	lv_timer_set_period(lv_display_get_refr_timer(disp), refr_ms);
+	scr = lv_display_get_screen_active(disp);
+	obj = lv_label_create(scr);
+	lv_label_set_text(obj, "Light and Versatile Graphics Library");
+	lv_obj_center(obj);
+	obj = lv_obj_create(scr);
+	lv_obj_set_size(obj, 100, 80);
+	lv_anim_init(&a);
+	lv_anim_set_var(&a, obj);
+	lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_obj_set_x);
+	lv_anim_set_values(&a, 0, BENCH_HOR_RES - 100);
+	lv_anim_set_duration(&a, 1000);
+	lv_anim_set_reverse_duration(&a, 1000);
+	lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
+	lv_anim_start(&a);
+	lv_refr_now(disp);
+
+	if (vsync_source_open_fake(&src, VSYNC_BENCH_HZ) ||
+	    vsync_start(disp, &src, pace)) {
+		vsync_source_close(&src);
+		bench_display_delete(disp);
+		return -1;
+	}
+	t0 = bench_now_us();
+	while (bench_now_us() - t0 < VSYNC_BENCH_MS * 1000) {
+		idle = lv_timer_handler();
+		lv_delay_ms(LV_MIN(idle, 100));
+	}
+	vsync_stop();
+	vsync_source_close(&src);
+	vsync_get_stats(&st);
+	print_stats(stdout, label, &st, VSYNC_BENCH_MS / 1000.0);
+
+	lv_anim_delete(obj, NULL);
+	bench_display_delete(disp);
+
+	return 0;
+}
+
+int vsync_bench(void)
+{
+	return bench_pass("timer 33 ms", 33, false) ||
+	       bench_pass("timer 16 ms", 16, false) ||
+	       bench_pass("vblank paced", LV_DEF_REFR_PERIOD, true) ? -1 : 0;
+}
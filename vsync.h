@@ -0,0 +1,68 @@
+/*
+ * Vertical blank paced presentation and frame pacing statistics
+ *
+ * Copyright (C) 2026, Derald D. Woods <woods.technical@gmail.com>
+ *
+ * This file is made available under the terms of the GNU General Public
+ * License version 3.
+ */
+
+#ifndef VSYNC_H
+#define VSYNC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "lvgl/lvgl.h"
+
+#define VSYNC_HIST	4	// present intervals of 1, 2, 3 and 4+ vblanks
+
+/* Where vertical blank completions come from */
+struct vsync_source {
+	int fd;			// readable when completions are pending
+	uint32_t hz;		// fake source rate, 0: DRM vblank events
+	uint32_t crtc;		// DRM CRTC index
+	uint32_t seq;		// last completion
+	uint64_t us;		// [us] CLOCK_MONOTONIC of the last completion
+	uint64_t t0_ns;		// fake: time of completion 0
+	bool got;
+	bool armed;		// the next completion is requested
+};
+
+struct vsync_stats {
+	uint32_t vblanks;
+	uint32_t frames;	// presented
+	uint32_t missed;	// presented after the vblank following their start
+	uint32_t dropped;	// replaced by a newer frame before being shown
+	uint32_t arm_failures;	// vblank event requests that failed
+	uint32_t hist[VSYNC_HIST];
+	uint64_t interval_us;	// sum of present-to-present intervals
+	uint32_t interval_min_us;
+	uint32_t interval_max_us;
+};
+
+/* DRM vblank events of crtc, requested on a descriptor of our own */
+int vsync_source_open_drm(struct vsync_source *src, const char *device,
+			  uint32_t crtc);
+/* A timerfd standing in for the panel: hz completions per second */
+int vsync_source_open_fake(struct vsync_source *src, uint32_t hz);
+/* Consume pending completions; returns how many vblanks passed */
+int vsync_source_read(struct vsync_source *src);
+void vsync_source_close(struct vsync_source *src);
+
+/*
+ * Account presentation of disp against src from a thread of its own. With
+ * pace, that thread also renders: once per vblank, only when something is
+ * invalid or animating, and never while a frame is still queued. The
+ * display refresh timer is then stopped.
+ */
+int vsync_start(lv_display_t *disp, struct vsync_source *src, bool pace);
+void vsync_stop(void);
+void vsync_get_stats(struct vsync_stats *stats);
+void vsync_reset(void);
+void vsync_report(FILE *fp);
+
+int vsync_bench(void);
+
+#endif /* VSYNC_H */